@@ -0,0 +1,27 @@
+#pragma once
+
+#include <hardcore.hpp>
+
+#include <string>
+#include <vector>
+
+//requests the same file through the asset registry under different spellings and types, and checks which requests
+//share an asset
+class asset_dedup_layer : public hc::Layer
+{
+public:
+	asset_dedup_layer();
+
+	~asset_dedup_layer();
+
+	void tick() override;
+
+private:
+	hc::asset<std::string> load_text(const char* filepath);
+	void check(bool passed, const char* what);
+
+	hc::u32 text_loads = 0;
+	hc::u32 bytes_loads = 0;
+	hc::u32 failures = 0;
+	bool checked = false;
+};
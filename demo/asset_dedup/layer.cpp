@@ -0,0 +1,93 @@
+#include "layer.hpp"
+
+#include <filesystem>
+#include <fstream>
+
+const char* const directory = "asset_dedup";
+const char* const sample_path = "asset_dedup/sample.txt";
+const char* const contents = "asset registry deduplication sample";
+
+asset_dedup_layer::asset_dedup_layer()
+{
+	//written by the demo itself, so that it runs from any directory
+	std::filesystem::create_directories(directory);
+	std::ofstream(sample_path, std::ios::out | std::ios::binary | std::ios::trunc) << contents;
+}
+
+asset_dedup_layer::~asset_dedup_layer()
+{
+	std::error_code error;
+	std::filesystem::remove_all(directory, error);
+}
+
+void asset_dedup_layer::tick()
+{
+	//the checks run once, on the first frame
+	if (checked) return;
+	checked = true;
+
+	{
+		const hc::asset<std::string> first = load_text(sample_path);
+		check(first.valid() && *first == contents, "the file is loaded");
+		if (!first.valid())
+		{
+			hc::shutdown();
+			return;
+		}
+
+		//same type, same file once the path is normalized
+		const hc::asset<std::string> again = load_text(sample_path);
+		const hc::asset<std::string> respelled = load_text("./asset_dedup/../asset_dedup/sample.txt");
+		const hc::asset<std::string> absolute = load_text(std::filesystem::absolute(sample_path).string().c_str());
+		check(&again.get() == &first.get(), "a second request returns the same asset");
+		check(&respelled.get() == &first.get(), "a relative spelling of the path returns the same asset");
+		check(&absolute.get() == &first.get(), "the absolute path returns the same asset");
+		check(text_loads == 1, "the file is loaded once");
+
+		//another type is another asset, even from the same file
+		const hc::asset<std::vector<char>> bytes = hc::asset_registry::load<std::vector<char>>(sample_path,
+			[this](const void* data, std::size_t size)
+			{
+				bytes_loads++;
+				return std::vector<char>(static_cast<const char*>(data), static_cast<const char*>(data) + size);
+			});
+		check(bytes.valid() && static_cast<const void*>(&bytes.get()) != static_cast<const void*>(&first.get()),
+			"a different type returns a different asset");
+		check(bytes_loads == 1 && text_loads == 1, "the different type is loaded separately");
+	}
+
+	//the asset expired with its last handle, the file is loaded again
+	const hc::asset<std::string> reloaded = load_text(sample_path);
+	check(reloaded.valid() && text_loads == 2, "an expired asset is loaded again");
+
+	if (failures)
+	{
+		LOGF_ERROR("[ASSETS] {0} checks failed", failures);
+	}
+	else
+	{
+		LOG_INFO("[ASSETS] All checks passed");
+	}
+	hc::shutdown();
+}
+
+hc::asset<std::string> asset_dedup_layer::load_text(const char* filepath)
+{
+	return hc::asset_registry::load<std::string>(filepath, [this](const void* data, std::size_t size)
+		{
+			text_loads++;
+			return std::string(static_cast<const char*>(data), size);
+		});
+}
+
+void asset_dedup_layer::check(bool passed, const char* what)
+{
+	if (passed)
+	{
+		LOG_INFO("[ASSETS] Passed: " << what);
+		return;
+	}
+
+	LOG_ERROR("[ASSETS] Failed: " << what);
+	failures++;
+}
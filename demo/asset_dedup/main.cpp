@@ -0,0 +1,19 @@
+#include <hardcore/core/entry_point.hpp>
+
+#include <layer.hpp>
+
+class asset_dedup_demo : public hc::client
+{
+public:
+	//headless, the assets are plain values and nothing is drawn
+	asset_dedup_demo() : client("AssetDedupDemo", 0, 0, 0, true)
+	{
+		hc::log::set_log_mask_flags(0xff);
+		push_layer(new asset_dedup_layer());
+	}
+};
+
+hc::client* hc::start()
+{
+	return new asset_dedup_demo();
+}
@@ -15,8 +15,6 @@ public:
 
 private:
 	hc::mesh obj;
-	hc::uniform vertex_input;
-	hc::uniform frag_input;
 	hc::render_pipeline pipeline;
 
 	struct
@@ -16,12 +16,10 @@ fractal_layer::fractal_layer()
 	hc::data_layout vert_layout(1);
 	vert_layout.set_type(0, hc::data_layout::type::VEC3, hc::data_layout::component_type::FLOAT32);
 	obj = hc::mesh(verts, sizeof(verts), idx, sizeof(idx), hc::mesh::index_format::UINT16, vert_layout);
-	vertex_input = hc::uniform(hc::data_layout::create<float, float, float, float>(), 1);
-	frag_input = hc::uniform(hc::data_layout::create<hc::u32, hc::u32, hc::u32, hc::u32, float>(), 1);
 	pipeline = hc::render_pipeline(hc::shader_library::get("resources/shaders/shader.vert.spv"),
 		hc::shader_library::get("resources/shaders/shader.frag.spv"));
 
-	pipeline.add(obj).set_descriptor(0, vertex_input).set_descriptor(1, frag_input);
+	pipeline.add(obj);
 	hc::window::get_dimensions(&w, &h);
 	v_inputs.ratio = static_cast<float>(w) / h;
 }
@@ -33,8 +31,9 @@ void fractal_layer::tick()
 {
 	if (animate) time += hc::delta_time();
 	f_inputs.frame = std::sin(time);
-	vertex_input[0].set(&v_inputs);
-	frag_input[0].set(&f_inputs);
+	//the inputs are bumped from the frame's transient ring, and bound again every frame
+	pipeline.set_descriptor(obj, 0, hc::transient_uniform(&v_inputs, sizeof(v_inputs)))
+		.set_descriptor(1, hc::transient_uniform(&f_inputs, sizeof(f_inputs)));
 }
 
 bool fractal_layer::handleEvent(const hc::Event & e)
@@ -0,0 +1,31 @@
+#pragma once
+
+#include <hardcore.hpp>
+
+#include <random>
+#include <vector>
+
+//allocates and frees random sized meshes and storage arrays every frame, and logs how the device memory pools hold up
+class memory_churn_layer : public hc::Layer
+{
+public:
+	memory_churn_layer();
+
+	~memory_churn_layer();
+
+	void tick() override;
+
+private:
+	void allocate();
+	void free();
+	void report();
+
+	std::vector<hc::mesh> meshes;
+	std::vector<hc::storage_array> arrays;
+	hc::data_layout vertex_layout;
+	hc::data_layout element_layout;
+
+	std::mt19937 rng;
+	hc::u32 frame = 0;
+	hc::u32 peak_pools = 0;
+};
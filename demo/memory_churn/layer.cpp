@@ -0,0 +1,89 @@
+#include "layer.hpp"
+
+const hc::u32 frames = 3000;
+const hc::u32 report_interval = 100;
+const hc::u32 operations_per_frame = 16;
+const std::size_t target_objects = 512; //allocations and frees balance around this many live objects
+const hc::u32 max_vertices = 4096;
+const hc::u32 max_elements = 8192;
+
+//contents do not matter, only the sizes
+const std::vector<float> vertex_data(max_vertices * 3, 0.0f);
+const std::vector<hc::u16> index_data(max_vertices * 3, 0);
+
+memory_churn_layer::memory_churn_layer() :
+	vertex_layout(1), element_layout(hc::data_layout::create<float, float, float, float>()), rng(42)
+{
+	vertex_layout.set_type(0, hc::data_layout::type::VEC3, hc::data_layout::component_type::FLOAT32);
+	meshes.reserve(target_objects);
+	arrays.reserve(target_objects);
+}
+
+memory_churn_layer::~memory_churn_layer()
+{}
+
+void memory_churn_layer::tick()
+{
+	for (hc::u32 i = 0; i < operations_per_frame; i++)
+	{
+		//allocations dominate below the target, frees above it
+		const std::size_t live = meshes.size() + arrays.size();
+		std::uniform_int_distribution<std::size_t> pick(0, 2 * target_objects);
+		if (pick(rng) >= live) allocate();
+		else free();
+	}
+
+	frame++;
+	if (frame % report_interval == 0) report();
+
+	if (frame == frames)
+	{
+		LOGF_INFO("[CHURN] Done after {0} frames, peak of {1} pools", frames, peak_pools);
+		hc::shutdown();
+	}
+}
+
+void memory_churn_layer::allocate()
+{
+	if (rng() % 2)
+	{
+		const hc::u32 n_vertices = std::uniform_int_distribution<hc::u32>(3, max_vertices)(rng);
+		const hc::u32 n_indexes = std::uniform_int_distribution<hc::u32>(1, n_vertices)(rng) * 3;
+		meshes.push_back(hc::mesh(vertex_data.data(), n_vertices * 3 * sizeof(float),
+			index_data.data(), n_indexes * sizeof(hc::u16), hc::mesh::index_format::UINT16, vertex_layout));
+	}
+	else
+	{
+		const hc::u32 n_elements = std::uniform_int_distribution<hc::u32>(1, max_elements)(rng);
+		arrays.push_back(hc::storage_array(element_layout, n_elements));
+	}
+}
+
+void memory_churn_layer::free()
+{
+	//freed out of allocation order, so holes open all over the pools
+	if (!meshes.empty() && (arrays.empty() || rng() % 2))
+	{
+		std::swap(meshes[rng() % meshes.size()], meshes.back());
+		meshes.pop_back();
+	}
+	else if (!arrays.empty())
+	{
+		std::swap(arrays[rng() % arrays.size()], arrays.back());
+		arrays.pop_back();
+	}
+}
+
+void memory_churn_layer::report()
+{
+	const hc::renderer::memory_stats stats = hc::renderer::memory_statistics();
+	peak_pools = std::max(peak_pools, stats.pools);
+
+	LOGF_INFO("[CHURN] frame {0}: {1} objects, {2} pools ({3} KB), {4} KB used, {5} KB free in {6} ranges "
+		"(largest {7} KB), {8} KB pending, fragmentation {9}",
+		frame, meshes.size() + arrays.size(), stats.pools, stats.pool_size / 1024, stats.used / 1024, stats.free / 1024,
+		stats.free_ranges, stats.largest_free_range / 1024, stats.pending / 1024, stats.fragmentation);
+	LOGF_INFO("[CHURN] {0} device allocations ({1} MB), main heap {2} / {3} MB, {4} KB relocated",
+		stats.device_allocations, stats.reserved / (1024 * 1024), stats.budget_usage / (1024 * 1024),
+		stats.budget / (1024 * 1024), stats.relocated / 1024);
+}
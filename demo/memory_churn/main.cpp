@@ -0,0 +1,19 @@
+#include <hardcore/core/entry_point.hpp>
+
+#include <layer.hpp>
+
+class memory_churn_demo : public hc::client
+{
+public:
+	//headless, the benchmark only allocates and frees, nothing is drawn
+	memory_churn_demo() : client("MemoryChurnDemo", 0, 0, 0, true)
+	{
+		hc::log::set_log_mask_flags(0xff);
+		push_layer(new memory_churn_layer());
+	}
+};
+
+hc::client* hc::start()
+{
+	return new memory_churn_demo();
+}
@@ -3,3 +3,5 @@
 #include "static_client.hpp"
 #include "layer.hpp"
 #include "window.hpp"
+#include "timer.hpp"
+#include "replay.hpp"
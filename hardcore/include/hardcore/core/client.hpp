@@ -4,15 +4,24 @@
 #include "layer.hpp"
 #include "time.hpp"
 #include "static_client.hpp"
+#include "timer.hpp"
+#include "replay.hpp"
+
+#include <vector>
 
 namespace ENGINE_NAMESPACE
 {
+	class timer_wheel;
+	class event_recorder;
+	class event_replayer;
+
 	class ENGINE_API client
 	{
 	public:
 		client() = delete;
 		client(const client& other) = delete;
-		client(const char* name, const unsigned int major_version, const unsigned int minor_version, const unsigned int patch_version);
+		client(const char* name, const unsigned int major_version, const unsigned int minor_version, const unsigned int patch_version, 
+			bool headless = false);
 		virtual ~client();
 
 		client& operator=(const client& other) = delete;
@@ -20,10 +29,12 @@ namespace ENGINE_NAMESPACE
 		void push_event(Event&& e);
 		void push_window_size(int width, int height);
 
-		Layer* push_layer(Layer* layer);
+		layer_handle push_layer(Layer* layer, layer_tick_fn tick = &tick_layer<Layer>);
 		void pop_layer();
-		Layer* push_overlay(Layer* layer);
+		layer_handle push_overlay(Layer* layer, layer_tick_fn tick = &tick_layer<Layer>);
 		void pop_overlay();
+		void remove_layer(layer_handle handle);
+		Layer* get_layer(layer_handle handle) const;
 		void clear_layers();
 
 		void run();
@@ -36,29 +47,65 @@ namespace ENGINE_NAMESPACE
 
 	private:
 		void handle_event();
+		void enqueue_event(const Event& e);
+
+		enum class layer_op_type : u8
+		{
+			PUSH_LAYER = 0,
+			PUSH_OVERLAY,
+			POP_LAYER,
+			POP_OVERLAY,
+			REMOVE,
+			CLEAR,
+		};
+
+		struct layer_op
+		{
+			layer_op_type type;
+			layer_handle handle;
+			std::unique_ptr<Layer> layer; //owned by the op until it is applied
+		};
+
+		struct layer_slot
+		{
+			Layer* layer;
+			layer_tick_fn tick;
+			u32 generation;
+		};
+
+		struct tick_entry
+		{
+			layer_tick_fn tick;
+			Layer* layer;
+		};
+
+		layer_handle queue_push(layer_op_type type, Layer* layer, layer_tick_fn tick);
+		void apply_layer_ops();
+		void erase_layers(std::size_t first, std::size_t last);
 
 
 		program_id client_id;
 
-		Layer** layer_stack;
-		index_t layer_stack_capacity;
-		index_t n_layers;
-		index_t n_overlays;
+		std::vector<std::unique_ptr<Layer>> layer_stack; //layers then overlays, bottom to top
+		std::vector<layer_handle> stack_handles; //handle of each layer in layer_stack
+		std::size_t n_layers;
 
-		index_t pop_layer_buffer;
-		index_t pop_overlay_buffer;
-		Layer** push_layer_buffer;
-		index_t push_layer_capacity;
-		index_t push_layer_size;
-		Layer** push_overlay_buffer;
-		index_t push_overlay_capacity;
-		index_t push_overlay_size;
+		std::vector<tick_entry> tick_list; //rebuilt only when the stack changes
+		std::vector<layer_slot> layer_slots;
+		std::vector<u32> free_layer_slots;
+		std::vector<layer_op> pending_layer_ops; //applied once per frame, in order
 
 		bool running;
 
-		time_t delta_time = 0;
+		duration delta_time;
 		duration elapsed_time;
 
+		std::unique_ptr<timer_wheel> timers;
+
+		std::unique_ptr<event_recorder> recorder;
+		std::unique_ptr<event_replayer> replayer;
+		std::vector<Event> replay_events;
+
 		Event event_buffer[event_buffer_capacity] = {};
 		index_t event_buffer_size;
 		index_t event_start; //Inclusive
@@ -72,14 +119,24 @@ namespace ENGINE_NAMESPACE
 		static client* instance; //There will be only one Client class instance during runtime
 		static program_id engine_id;
 
-		friend Layer* ENGINE_NAMESPACE::push_layer(Layer* layer);
+		friend layer_handle ENGINE_NAMESPACE::push_layer(Layer*, layer_tick_fn);
 		friend void ENGINE_NAMESPACE::pop_layer();
-		friend Layer* ENGINE_NAMESPACE::push_overlay(Layer* layer);
+		friend layer_handle ENGINE_NAMESPACE::push_overlay(Layer*, layer_tick_fn);
 		friend void ENGINE_NAMESPACE::pop_overlay();
+		friend void ENGINE_NAMESPACE::remove_layer(layer_handle);
+		friend Layer* ENGINE_NAMESPACE::get_layer(layer_handle);
 		friend void ENGINE_NAMESPACE::clear_layers();
 		friend void ENGINE_NAMESPACE::shutdown();
 		friend time_t ENGINE_NAMESPACE::delta_time();
 		friend duration ENGINE_NAMESPACE::elapsed_time();
+		friend timer_handle ENGINE_NAMESPACE::schedule(const duration&, std::function<void()>, timer_target);
+		friend timer_handle ENGINE_NAMESPACE::schedule_recurring(const duration&, std::function<void()>, timer_target);
+		friend bool ENGINE_NAMESPACE::cancel_timer(timer_handle);
+		friend void ENGINE_NAMESPACE::replay::start_recording(const char*);
+		friend void ENGINE_NAMESPACE::replay::stop_recording();
+		friend void ENGINE_NAMESPACE::replay::start_replay(const char*, const duration&, bool);
+		friend void ENGINE_NAMESPACE::replay::stop_replay();
+		friend bool ENGINE_NAMESPACE::replay::replaying();
 	};
 
 	//Should be defined in client
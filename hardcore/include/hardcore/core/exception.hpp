@@ -29,5 +29,14 @@ namespace ENGINE_NAMESPACE
 			closed_queue(const std::string& message) : std::logic_error(message)
 			{}
 		};
+
+		class io_error : public std::runtime_error
+		{
+		public:
+			io_error(const char* message) : std::runtime_error(message)
+			{}
+			io_error(const std::string& message) : std::runtime_error(message)
+			{}
+		};
 	}
 }
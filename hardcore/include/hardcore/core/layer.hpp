@@ -3,6 +3,8 @@
 #include "core.hpp"
 #include "event.hpp"
 
+#include <type_traits>
+
 namespace ENGINE_NAMESPACE
 {
 	class ENGINE_API Layer
@@ -16,4 +18,31 @@ namespace ENGINE_NAMESPACE
 
 		virtual bool handleEvent(const Event &e);
 	};
-}
\ No newline at end of file
+
+	/**
+	 * @brief Stable reference to a pushed layer, stays valid until the layer is removed and is never reused.
+	*/
+	typedef u64 layer_handle;
+
+	static constexpr layer_handle invalid_layer = 0;
+
+	typedef void (*layer_tick_fn)(Layer*);
+
+	/**
+	 * @brief Tick entry stored in the client tick array. Layers of a final type are ticked without going through the vtable.
+	 * @tparam Type Static type of the layer when it was pushed.
+	*/
+	template<typename Type>
+	void tick_layer(Layer* layer)
+	{
+		static_assert(std::is_base_of_v<Layer, Type>, "Type must derive from Layer");
+		if constexpr (std::is_final_v<Type>)
+		{
+			static_cast<Type*>(layer)->Type::tick();
+		}
+		else
+		{
+			layer->tick();
+		}
+	}
+}
@@ -0,0 +1,43 @@
+#pragma once
+
+#include "core.hpp"
+#include "time.hpp"
+
+namespace ENGINE_NAMESPACE
+{
+	namespace replay
+	{
+		/**
+		 * @brief Starts recording every event delivered to the layers, along with the frame delta times, into a binary
+		 * file. Any recording in progress is stopped first.
+		 * @param filepath File to write the recording to, overwritten if it exists.
+		*/
+		ENGINE_API void start_recording(const char* filepath);
+
+		/**
+		 * @brief Stops the current recording and flushes it to its file.
+		*/
+		ENGINE_API void stop_recording();
+
+		/**
+		 * @brief Replays a recording, starting next frame. The recorded events are injected on the same frames they were
+		 * recorded on, and live window events are ignored, apart from closing the window.
+		 * @param filepath Recording to replay.
+		 * @param fixed_delta If non zero, used as the delta time of every frame instead of the recorded ones.
+		 * @param shutdown_on_end Shuts the client down once the whole recording has been replayed.
+		*/
+		ENGINE_API void start_replay(const char* filepath, const duration& fixed_delta = duration(),
+			bool shutdown_on_end = true);
+
+		/**
+		 * @brief Stops the current replay, returning to live input.
+		*/
+		ENGINE_API void stop_replay();
+
+		/**
+		 * @brief Checks if a replay is in progress.
+		 * @return True if a replay is in progress.
+		*/
+		ENGINE_API bool replaying();
+	}
+}
@@ -6,12 +6,45 @@
 
 namespace ENGINE_NAMESPACE
 {
-	ENGINE_API Layer* push_layer(Layer* layer);
+	/**
+	 * @brief Pushes a layer on top of the other layers, below the overlays. The client takes ownership of the layer,
+	 * which is inserted at the end of the current frame.
+	 * @param layer Heap allocated layer.
+	 * @param tick Function called each frame to tick the layer.
+	 * @return Handle to the layer.
+	*/
+	ENGINE_API layer_handle push_layer(Layer* layer, layer_tick_fn tick = &tick_layer<Layer>);
 	ENGINE_API void pop_layer();
-	ENGINE_API Layer* push_overlay(Layer* layer);
+	ENGINE_API layer_handle push_overlay(Layer* layer, layer_tick_fn tick = &tick_layer<Layer>);
 	ENGINE_API void pop_overlay();
+
+	/**
+	 * @brief Removes a layer or overlay at the end of the current frame, wherever it is in the stack.
+	 * @param handle Handle returned when pushing the layer, stale handles are ignored.
+	*/
+	ENGINE_API void remove_layer(layer_handle handle);
+
+	/**
+	 * @brief Gets a layer from its handle, layers pushed this frame are returned as well.
+	 * @param handle Handle returned when pushing the layer.
+	 * @return The layer, or nullptr if it has been removed.
+	*/
+	ENGINE_API Layer* get_layer(layer_handle handle);
+
 	ENGINE_API void clear_layers();
 	ENGINE_API void shutdown();
 	ENGINE_API time_t delta_time();
 	ENGINE_API duration elapsed_time();
+
+	template<typename Type>
+	inline layer_handle push_layer(Type* layer)
+	{
+		return push_layer(layer, &tick_layer<Type>);
+	}
+
+	template<typename Type>
+	inline layer_handle push_overlay(Type* layer)
+	{
+		return push_overlay(layer, &tick_layer<Type>);
+	}
 }
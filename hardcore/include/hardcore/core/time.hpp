@@ -6,9 +6,9 @@
 #include <utility>
 #include <ostream>
 #include <string>
-#include <stdexcept>
+#include <chrono>
+#include <cmath>
 
-//#define USE_SYMMETRIC_BINARY_OPERATORS
 #define DURATION_COMPATIBLE_TYPES std::enable_if_t<std::is_integral<Type>::value || std::is_floating_point<Type>::value, bool> = true
 
 namespace ENGINE_NAMESPACE
@@ -16,354 +16,194 @@ namespace ENGINE_NAMESPACE
 	typedef double time_t;
 
 	/**
-	 * @brief This class defines a duration of time. All related operator functions take arguments in seconds, regardless of type.
+	 * @brief This class defines a duration of time, stored as a signed integer amount of nanoseconds.
+	 * Operator functions taking arithmetic types take them in seconds, regardless of type. Durations can be implicitly
+	 * converted from and to std::chrono durations.
 	*/
 	class ENGINE_API duration
 	{ //the class doesn't need to be exported as it's header only, but it is being exported to hide compiler warnings
-	private:
-		typedef unsigned long long second_t;
-
 	public:
-		duration() noexcept : seconds(0), decimal(0) {}
+		typedef i64 rep;
+		typedef std::nano period;
+		typedef std::chrono::duration<rep, period> chrono_t;
+
+		static constexpr rep ns_per_second = 1000000000;
+
+		constexpr duration() noexcept : ns(0) {}
 
 		template<typename Type, std::enable_if_t<std::is_integral<Type>::value, bool> = true>
-		duration(Type seconds) noexcept : seconds(static_cast<second_t>(seconds)), decimal(0) {}
+		constexpr duration(Type seconds) noexcept : ns(static_cast<rep>(seconds) * ns_per_second) {}
 
 		template<typename Type, std::enable_if_t<std::is_floating_point<Type>::value, bool> = true>
-		duration(Type seconds)
+		constexpr duration(Type seconds) noexcept : ns(static_cast<rep>(seconds * static_cast<Type>(ns_per_second))) {}
+
+		template<typename Rep, typename Period>
+		constexpr duration(const std::chrono::duration<Rep, Period>& d) noexcept :
+			ns(std::chrono::duration_cast<chrono_t>(d).count())
+		{}
+
+		/**
+		 * @brief Creates a duration from an amount of nanoseconds.
+		 * @param ns Number of nanoseconds.
+		 * @return The created duration.
+		*/
+		static constexpr duration from_nanoseconds(rep ns) noexcept
 		{
-			this->seconds = static_cast<second_t>(seconds);
-			this->decimal = seconds - this->seconds;
+			duration res;
+			res.ns = ns;
+			return res;
 		}
 
-		duration(const duration& other) noexcept : seconds(other.seconds), decimal(other.decimal) {}
-		duration(duration&& other) noexcept : seconds(std::exchange(other.seconds, 0)), decimal(std::exchange(other.decimal, 0)) {}
-
-		duration& operator=(const duration& other) noexcept
+		/**
+		 * @brief Retrieves the exact duration.
+		 * @return Number of nanoseconds.
+		*/
+		constexpr rep count() const noexcept { return ns; }
+
+		/**
+		 * @brief Converts the duration to seconds. Precision is lost for very long durations.
+		 * @return Number of seconds.
+		*/
+		constexpr time_t seconds() const noexcept
 		{
-			seconds = other.seconds;
-			decimal = other.decimal;
-			return *this;
+			//split to keep the fractional part exact for long durations
+			return static_cast<time_t>(ns / ns_per_second) + static_cast<time_t>(ns % ns_per_second) / ns_per_second;
 		}
 
-		duration& operator=(duration&& other) noexcept
+		constexpr operator chrono_t() const noexcept { return chrono_t(ns); }
+
+		constexpr duration& operator+=(const duration& d) noexcept
 		{
-			seconds = std::exchange(other.seconds, 0);
-			decimal = std::exchange(other.decimal, 0);
+			ns += d.ns;
 			return *this;
 		}
 
-		inline duration& operator+=(const duration& d) noexcept
+		constexpr duration& operator-=(const duration& d) noexcept
 		{
-			this->decimal += d.decimal;
-			if (this->decimal >= 1)
-			{
-				this->decimal -= 1;
-				this->seconds += 1 + d.seconds;
-			}
-			else
-			{
-				this->seconds += d.seconds;
-			}
+			ns -= d.ns;
 			return *this;
 		}
 
 		template<typename Type, std::enable_if_t<std::is_integral<Type>::value, bool> = true>
-		inline duration& operator+=(const Type seconds) noexcept
+		constexpr duration& operator*=(const Type mult) noexcept
 		{
-			if (seconds < 0) { return this->operator-=(-seconds); }
-			this->seconds += static_cast<second_t>(seconds);
+			ns *= static_cast<rep>(mult);
 			return *this;
 		}
 
 		template<typename Type, std::enable_if_t<std::is_floating_point<Type>::value, bool> = true>
-		inline duration& operator+=(const Type seconds) noexcept
-		{
-			if (seconds < 0) { return this->operator-=(-seconds); }
-			const second_t t = static_cast<second_t>(seconds);
-			this->decimal += seconds - t;
-			if (this->decimal >= 1)
-			{
-				this->decimal -= 1;
-				this->seconds += 1 + t;
-			}
-			else
-			{
-				this->seconds += t;
-			}
-			return *this;
-		}
-
-		inline duration& operator-=(const duration& d) noexcept
+		constexpr duration& operator*=(const Type mult) noexcept
 		{
-			second_t sub = d.seconds;
-			this->decimal -= d.decimal;
-			if (this->decimal < 0)
-			{
-				this->decimal += 1;
-				sub++;
-			}
-			if (this->seconds < sub)
-			{
-				this->seconds = 0;
-				this->decimal = 0;
-			}
-			else
-			{
-				this->seconds -= sub;
-			}
+			ns = static_cast<rep>(static_cast<Type>(ns) * mult);
 			return *this;
 		}
 
 		template<typename Type, std::enable_if_t<std::is_integral<Type>::value, bool> = true>
-		inline duration& operator-=(const Type seconds) noexcept
+		constexpr duration& operator/=(const Type div) noexcept
 		{
-			if (seconds < 0) { return this->operator+=(-seconds); }
-			const second_t sub = static_cast<second_t>(seconds);
-			if (this->seconds < sub)
-			{
-				this->seconds = 0;
-				this->decimal = 0;
-			}
-			else
-			{
-				this->seconds -= sub;
-			}
+			ns /= static_cast<rep>(div);
 			return *this;
 		}
 
 		template<typename Type, std::enable_if_t<std::is_floating_point<Type>::value, bool> = true>
-		inline duration& operator-=(const Type seconds) noexcept
-		{
-			if (seconds < 0) { return this->operator+=(-seconds); }
-			second_t sub = static_cast<second_t>(seconds);
-			this->decimal -= (seconds - sub);
-			if (this->decimal < 0)
-			{
-				this->decimal += 1;
-				sub++;
-			}
-			if (this->seconds < sub)
-			{
-				this->seconds = 0;
-				this->decimal = 0;
-			}
-			else
-			{
-				this->seconds -= sub;
-			}
-			return *this;
-		}
-
-		template<typename Type, std::enable_if_t<std::is_integral<Type>::value, bool> = true>
-		inline duration& operator*=(const Type mult)
+		constexpr duration& operator/=(const Type div) noexcept
 		{
-			if (mult < 0) { throw std::invalid_argument("multiplier cannot be negative"); }
-			this->seconds *= mult;
-			const time_t dec = this->decimal * mult;
-			if (dec >= 1)
-			{
-				const second_t sec = static_cast<second_t>(dec);
-				this->seconds += sec;
-				this->decimal = dec - sec;
-			}
-			else
-			{
-				this->decimal = dec;
-			}
+			ns = static_cast<rep>(static_cast<Type>(ns) / div);
 			return *this;
 		}
 
-		template<typename Type, std::enable_if_t<std::is_floating_point<Type>::value, bool> = true>
-		inline duration& operator*=(const Type mult)
+		constexpr duration& operator%=(const duration& d) noexcept
 		{
-			if (mult < 0) { throw std::invalid_argument("multiplier cannot be negative"); }
-			const time_t cmult = static_cast<time_t>(mult);
-			const time_t sec = cmult * this->seconds;
-			this->seconds = static_cast<second_t>(sec);
-			const time_t dec = cmult * this->decimal + (sec - this->seconds);
-			if (dec >= 1)
-			{
-				const second_t sub = static_cast<second_t>(dec);
-				this->seconds += sub;
-				this->decimal = dec - sub;
-			}
-			else
-			{
-				this->decimal = dec;
-			}
+			ns %= d.ns;
 			return *this;
 		}
 
 		template<typename Type, std::enable_if_t<std::is_integral<Type>::value, bool> = true>
-		inline duration& operator/=(const Type div)
+		constexpr time_t operator%(const Type mod) const noexcept
 		{
-			if (div < 0) { throw std::invalid_argument("divisor cannot be negative"); }
-			this->seconds /= div;
-			const time_t dec = (this->decimal + (this->seconds % div)) / div;
-			if (dec >= 1)
-			{
-				const second_t sec = static_cast<second_t>(dec);
-				this->seconds += sec;
-				this->decimal = dec - sec;
-			}
-			else
-			{
-				this->decimal = dec;
-			}
-			return *this;
+			return duration::from_nanoseconds(ns % (static_cast<rep>(mod) * ns_per_second)).seconds();
 		}
 
 		template<typename Type, std::enable_if_t<std::is_floating_point<Type>::value, bool> = true>
-		inline duration& operator/=(const Type div)
-		{
-			if (div < 0) { throw std::invalid_argument("divisor cannot be negative"); }
-			const time_t cdiv = static_cast<time_t>(div);
-			const time_t sec = static_cast<time_t>(this->seconds) / cdiv;
-			this->seconds = static_cast<second_t>(sec);
-			const time_t dec = this->decimal / cdiv + (sec - this->seconds);
-			if (dec >= 1)
-			{
-				const second_t sub = static_cast<second_t>(dec);
-				this->seconds += sub;
-				this->decimal = dec - sub;
-			}
-			else
-			{
-				this->decimal = dec;
-			}
-			return *this;
-		}
-
-		template<typename Type, std::enable_if_t<std::is_integral<Type>::value, bool> = true>
 		inline time_t operator%(const Type mod) const noexcept
 		{
-#ifdef DISABLE_MODULO_CORRECTION
-			return static_cast<time_t>(seconds % static_cast<second_t>(mod)) + decimal;
-#else
-			const time_t res = static_cast<time_t>(seconds % static_cast<second_t>(mod)) + decimal;
-			return res + (mod < 0 && res) ? mod : 0;
-#endif // DISABLE_MODULO_CORRECTION
+			return std::fmod(seconds(), static_cast<time_t>(mod));
 		}
 
-		template<typename Type, std::enable_if_t<std::is_floating_point<Type>::value, bool> = true>
-		inline time_t operator%(const Type mod) const
+		static constexpr i8 cmp(const duration& l, const duration& r) noexcept
 		{
-#ifdef DISABLE_MODULO_CORRECTION
-			const time_t cmod = static_cast<time_t>(mod);
-			return std::fmod(std::fmod(static_cast<time_t>(seconds), cmod) + std::fmod(decimal, cmod), cmod);
-#else
-			const time_t cmod = static_cast<time_t>(mod);
-			const time_t res = std::fmod(std::fmod(static_cast<time_t>(seconds), cmod) + std::fmod(decimal, cmod), cmod);
-			return res + (cmod < 0 && std::abs(res) >= std::numeric_limits<double>::epsilon()) ? cmod : 0;
-#endif // DISABLE_MODULO_CORRECTION
+			return l.ns == r.ns ? 0 : (l.ns < r.ns ? -1 : 1);
 		}
 
-		inline static i8 cmp(const duration& l, const duration& r) noexcept
-		{
-			if (l.seconds == r.seconds)
-			{
-				if (l.decimal == r.decimal)
-				{
-					return 0;
-				}
-				else if (l.decimal < r.decimal)
-				{
-					return -1;
-				}
-				else
-				{
-					return 1;
-				}
-			}
-			else
-			{
-				if (l.seconds < r.seconds)
-				{
-					return -1;
-				}
-				else
-				{
-					return 1;
-				}
-			}
-		}
+	private:
+		static const int text_precision = 4;
 
-		template<typename Type, std::enable_if_t<std::is_integral<Type>::value, bool> = true>
-		inline static i8 cmp(const duration& l, const Type r) noexcept
+		rep ns;
+
+		friend std::string to_string(const duration&);
+	};
+
+	/**
+	 * @brief Monotonic point in time, stored as a signed integer amount of nanoseconds since an unspecified epoch.
+	 * Timestamps are only comparable with other timestamps taken during the same run.
+	*/
+	class ENGINE_API timestamp
+	{
+	public:
+		constexpr timestamp() noexcept : since_epoch() {}
+		constexpr explicit timestamp(const duration& since_epoch) noexcept : since_epoch(since_epoch) {}
+
+		/**
+		 * @brief Reads the engine's monotonic clock. Uses the calibrated TSC where available, otherwise the
+		 * steady clock (CLOCK_MONOTONIC on linux).
+		 * @return The current time.
+		*/
+		static timestamp now() noexcept;
+
+		constexpr const duration& time_since_epoch() const noexcept { return since_epoch; }
+
+		constexpr timestamp& operator+=(const duration& d) noexcept
 		{
-			if (l.seconds == r)
-			{
-				if (l.decimal == 0)
-				{
-					return 0;
-				}
-				else
-				{
-					return 1;
-				}
-			}
-			else
-			{
-				if (l.seconds < r)
-				{
-					return -1;
-				}
-				else
-				{
-					return 1;
-				}
-			}
+			since_epoch += d;
+			return *this;
 		}
 
-		template<typename Type, std::enable_if_t<std::is_floating_point<Type>::value, bool> = true>
-		inline static i8 cmp(const duration& l, const Type r) noexcept
+		constexpr timestamp& operator-=(const duration& d) noexcept
 		{
-			const second_t r_seconds = static_cast<second_t>(r);
-			const time_t r_decimal = static_cast<time_t>(r) - r_seconds;
-			if (l.seconds == r_seconds)
-			{
-				if (l.decimal == r_decimal)
-				{
-					return 0;
-				}
-				else if (l.decimal < r_decimal)
-				{
-					return -1;
-				}
-				else
-				{
-					return 1;
-				}
-			}
-			else
-			{
-				if (l.seconds < r_seconds)
-				{
-					return -1;
-				}
-				else
-				{
-					return 1;
-				}
-			}
+			since_epoch -= d;
+			return *this;
 		}
 
 	private:
-		static const int text_precision = 4;
+		duration since_epoch;
+	};
 
-		second_t seconds;
-		time_t decimal;
+	/**
+	 * @brief std::chrono compatible clock wrapping timestamp::now, so it can be used with the standard library.
+	*/
+	struct clock
+	{
+		typedef ENGINE_NAMESPACE::duration::rep rep;
+		typedef ENGINE_NAMESPACE::duration::period period;
+		typedef std::chrono::duration<rep, period> duration;
+		typedef std::chrono::time_point<clock> time_point;
+		static constexpr bool is_steady = true;
 
-		friend std::string to_string(const duration&);
-		friend std::ostream& operator<<(std::ostream&, const duration&);
+		static inline time_point now() noexcept
+		{
+			return time_point(duration(timestamp::now().time_since_epoch().count()));
+		}
 	};
 
 	inline std::string to_string(const duration& d)
 	{
-		const std::string dec_string = std::to_string(d.decimal);
-		const std::size_t i = dec_string.find('.', 0);
-		return std::to_string(d.seconds).append(dec_string.substr(i, duration::text_precision + 1)); //as the function is defined in the header without an export, it should be fine to return the string, it shouldn't cross the dll boundary
+		//integer formatting, so the printed value is exact
+		const duration::rep abs_ns = d.ns < 0 ? -d.ns : d.ns;
+		const duration::rep decimal_div = duration::ns_per_second / 10000; //10^(9 - text_precision)
+		std::string dec_string = std::to_string(abs_ns % duration::ns_per_second / decimal_div);
+		dec_string.insert(0, duration::text_precision - dec_string.size(), '0');
+		std::string res = d.ns < 0 ? "-" : "";
+		return res.append(std::to_string(abs_ns / duration::ns_per_second)).append(".").append(dec_string); //as the function is defined in the header without an export, it should be fine to return the string, it shouldn't cross the dll boundary
 	}
 
 	inline std::ostream& operator<<(std::ostream& os, const duration& d)
@@ -372,99 +212,81 @@ namespace ENGINE_NAMESPACE
 		return os;
 	}
 
-	inline duration operator+(duration d, const duration& o)
+	//arithmetic types convert implicitly to seconds, so these also cover mixed duration and scalar operands
+	constexpr duration operator+(duration d, const duration& o) noexcept
 	{
 		d += o;
 		return d;
 	}
-	
-	template<typename Type, DURATION_COMPATIBLE_TYPES>
-	inline duration operator+(duration d, const Type seconds)
+
+	constexpr duration operator-(duration d, const duration& o) noexcept
 	{
-		d += seconds;
+		d -= o;
 		return d;
 	}
 
-	inline duration operator-(duration d, const duration& o)
+	constexpr duration operator-(const duration& d) noexcept
 	{
-		d -= o;
+		return duration::from_nanoseconds(-d.count());
+	}
+
+	constexpr duration operator%(duration d, const duration& o) noexcept
+	{
+		d %= o;
 		return d;
 	}
 
 	template<typename Type, DURATION_COMPATIBLE_TYPES>
-	inline duration operator-(duration d, const Type seconds)
+	constexpr duration operator*(duration d, const Type mult) noexcept
 	{
-		d -= seconds;
+		d *= mult;
 		return d;
 	}
 
 	template<typename Type, DURATION_COMPATIBLE_TYPES>
-	inline duration operator*(duration d, const Type mult)
+	constexpr duration operator*(const Type mult, duration d) noexcept
 	{
 		d *= mult;
 		return d;
 	}
 
 	template<typename Type, DURATION_COMPATIBLE_TYPES>
-	inline duration operator/(duration d, const Type div)
+	constexpr duration operator/(duration d, const Type div) noexcept
 	{
 		d /= div;
 		return d;
 	}
 
-#ifdef USE_SYMMETRIC_BINARY_OPERATORS
+	constexpr bool operator==(const duration& lhs, const duration& rhs) noexcept { return duration::cmp(lhs, rhs) == 0; }
+	constexpr bool operator!=(const duration& lhs, const duration& rhs) noexcept { return duration::cmp(lhs, rhs) != 0; }
+	constexpr bool operator< (const duration& lhs, const duration& rhs) noexcept { return duration::cmp(lhs, rhs) <  0; }
+	constexpr bool operator> (const duration& lhs, const duration& rhs) noexcept { return duration::cmp(lhs, rhs) >  0; }
+	constexpr bool operator<=(const duration& lhs, const duration& rhs) noexcept { return duration::cmp(lhs, rhs) <= 0; }
+	constexpr bool operator>=(const duration& lhs, const duration& rhs) noexcept { return duration::cmp(lhs, rhs) >= 0; }
 
-	template<typename Type, DURATION_COMPATIBLE_TYPES>
-	inline duration operator+(const Type seconds, duration d)
+	constexpr timestamp operator+(timestamp t, const duration& d) noexcept
 	{
-		d += seconds;
-		return d;
+		t += d;
+		return t;
 	}
 
-	template<typename Type, DURATION_COMPATIBLE_TYPES>
-	inline duration operator-(const Type seconds, duration d)
+	constexpr timestamp operator-(timestamp t, const duration& d) noexcept
 	{
-		duration n(seconds);
-		n -= d;
-		return n;
+		t -= d;
+		return t;
 	}
 
-#endif // USE_SYMMETRIC_BINARY_OPERATORS
-#undef USE_SYMMETRIC_BINARY_OPERATORS
-
-	inline bool operator==(const duration& lhs, const duration& rhs) noexcept { return duration::cmp(lhs, rhs) == 0; }
-	inline bool operator!=(const duration& lhs, const duration& rhs) noexcept { return duration::cmp(lhs, rhs) != 0; }
-	inline bool operator< (const duration& lhs, const duration& rhs) noexcept { return duration::cmp(lhs, rhs) <  0; }
-	inline bool operator> (const duration& lhs, const duration& rhs) noexcept { return duration::cmp(lhs, rhs) >  0; }
-	inline bool operator<=(const duration& lhs, const duration& rhs) noexcept { return duration::cmp(lhs, rhs) <= 0; }
-	inline bool operator>=(const duration& lhs, const duration& rhs) noexcept { return duration::cmp(lhs, rhs) >= 0; }
-
-	template<typename Type, DURATION_COMPATIBLE_TYPES>
-	inline bool operator==(const duration& lhs, const Type rhs) noexcept { return duration::cmp(lhs, rhs) == 0; }
-	template<typename Type, DURATION_COMPATIBLE_TYPES>
-	inline bool operator!=(const duration& lhs, const Type rhs) noexcept { return duration::cmp(lhs, rhs) != 0; }
-	template<typename Type, DURATION_COMPATIBLE_TYPES>
-	inline bool operator< (const duration& lhs, const Type rhs) noexcept { return duration::cmp(lhs, rhs) <  0; }
-	template<typename Type, DURATION_COMPATIBLE_TYPES>
-	inline bool operator> (const duration& lhs, const Type rhs) noexcept { return duration::cmp(lhs, rhs) >  0; }
-	template<typename Type, DURATION_COMPATIBLE_TYPES>
-	inline bool operator<=(const duration& lhs, const Type rhs) noexcept { return duration::cmp(lhs, rhs) <= 0; }
-	template<typename Type, DURATION_COMPATIBLE_TYPES>
-	inline bool operator>=(const duration& lhs, const Type rhs) noexcept { return duration::cmp(lhs, rhs) >= 0; }
-
-	template<typename Type, DURATION_COMPATIBLE_TYPES>
-	inline bool operator==(const Type lhs, const duration& rhs) noexcept { return duration::cmp(rhs, lhs) == 0; }
-	template<typename Type, DURATION_COMPATIBLE_TYPES>
-	inline bool operator!=(const Type lhs, const duration& rhs) noexcept { return duration::cmp(rhs, lhs) != 0; }
-	template<typename Type, DURATION_COMPATIBLE_TYPES>
-	inline bool operator< (const Type lhs, const duration& rhs) noexcept { return duration::cmp(rhs, lhs) >  0; }
-	template<typename Type, DURATION_COMPATIBLE_TYPES>
-	inline bool operator> (const Type lhs, const duration& rhs) noexcept { return duration::cmp(rhs, lhs) <  0; }
-	template<typename Type, DURATION_COMPATIBLE_TYPES>
-	inline bool operator<=(const Type lhs, const duration& rhs) noexcept { return duration::cmp(rhs, lhs) >= 0; }
-	template<typename Type, DURATION_COMPATIBLE_TYPES>
-	inline bool operator>=(const Type lhs, const duration& rhs) noexcept { return duration::cmp(rhs, lhs) <= 0; }
+	constexpr duration operator-(const timestamp& lhs, const timestamp& rhs) noexcept
+	{
+		return lhs.time_since_epoch() - rhs.time_since_epoch();
+	}
 
+	constexpr bool operator==(const timestamp& lhs, const timestamp& rhs) noexcept { return lhs.time_since_epoch() == rhs.time_since_epoch(); }
+	constexpr bool operator!=(const timestamp& lhs, const timestamp& rhs) noexcept { return lhs.time_since_epoch() != rhs.time_since_epoch(); }
+	constexpr bool operator< (const timestamp& lhs, const timestamp& rhs) noexcept { return lhs.time_since_epoch() <  rhs.time_since_epoch(); }
+	constexpr bool operator> (const timestamp& lhs, const timestamp& rhs) noexcept { return lhs.time_since_epoch() >  rhs.time_since_epoch(); }
+	constexpr bool operator<=(const timestamp& lhs, const timestamp& rhs) noexcept { return lhs.time_since_epoch() <= rhs.time_since_epoch(); }
+	constexpr bool operator>=(const timestamp& lhs, const timestamp& rhs) noexcept { return lhs.time_since_epoch() >= rhs.time_since_epoch(); }
 }
 
 #undef DURATION_COMPATIBLE_TYPES
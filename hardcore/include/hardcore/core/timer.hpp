@@ -0,0 +1,51 @@
+#pragma once
+
+#include "core.hpp"
+#include "time.hpp"
+
+#include <functional>
+
+namespace ENGINE_NAMESPACE
+{
+	typedef u64 timer_handle;
+
+	static constexpr timer_handle invalid_timer = 0;
+
+	/**
+	 * @brief Where the callback of a timer is executed.
+	*/
+	enum class timer_target : u8
+	{
+		MAIN_THREAD = 0,	//called by the client loop, right before the layers tick
+		WORKER,				//posted to the immediate worker pool
+	};
+
+	/**
+	 * @brief Schedules a callback to be called once, after a delay. Must be called from the main thread.
+	 * Timers have a resolution of 1ms and are checked once per frame, so they may fire up to a frame late.
+	 * @param delay Time to wait before the callback is called.
+	 * @param callback Function to call.
+	 * @param target Thread the callback is executed on.
+	 * @return Handle to the timer, which can be used to cancel it.
+	*/
+	ENGINE_API timer_handle schedule(const duration& delay, std::function<void()> callback,
+		timer_target target = timer_target::MAIN_THREAD);
+
+	/**
+	 * @brief Schedules a callback to be called periodically, until cancelled. Must be called from the main thread.
+	 * @param interval Time between each call, the first call happens after one interval.
+	 * @param callback Function to call.
+	 * @param target Thread the callback is executed on.
+	 * @return Handle to the timer, which can be used to cancel it.
+	*/
+	ENGINE_API timer_handle schedule_recurring(const duration& interval, std::function<void()> callback,
+		timer_target target = timer_target::MAIN_THREAD);
+
+	/**
+	 * @brief Cancels a pending timer. Must be called from the main thread. Cancelling a timer from its own callback
+	 * is allowed, and stops a recurring timer.
+	 * @param handle Handle returned when scheduling the timer.
+	 * @return True if the timer was still pending, false if it had already fired or been cancelled.
+	*/
+	ENGINE_API bool cancel_timer(timer_handle handle);
+}
@@ -1,6 +1,7 @@
 #pragma once
 
 #include "core.hpp"
+#include "event.hpp"
 
 namespace ENGINE_NAMESPACE
 {
@@ -26,5 +27,20 @@ namespace ENGINE_NAMESPACE
 		 * @param num 
 		*/
 		ENGINE_API void set_icon(const char** files, unsigned int num);
+
+		/**
+		 * @brief Checks if the engine is running without a window or display.
+		 * In headless mode there is no GLFW window, the renderer draws into offscreen images and nothing is presented.
+		 * @return True if running headless.
+		*/
+		ENGINE_API bool headless();
+
+		/**
+		 * @brief Pushes an event into the client's event queue, as if it was generated by the window.
+		 * Meant for headless runs and automated tests. Injecting a WindowResize event in headless mode also resizes the
+		 * offscreen render target.
+		 * @param e Event to inject.
+		*/
+		ENGINE_API void inject_event(Event&& e);
 	}
 }
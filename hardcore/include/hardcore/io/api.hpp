@@ -1,3 +1,8 @@
 #pragma once
 
 #include "file.hpp"
+#include "file_stream.hpp"
+#include "mapped_file.hpp"
+#include "async.hpp"
+#include "compression.hpp"
+#include "pak.hpp"
@@ -0,0 +1,44 @@
+#pragma once
+
+#include <hardcore/core/core.hpp>
+#include <hardcore/core/exception.hpp>
+
+#include <future>
+#include <vector>
+
+namespace ENGINE_NAMESPACE
+{
+	namespace io
+	{
+		struct read_request
+		{
+			const char* filepath;
+			u64 offset = 0;
+			std::size_t size = 0; //0 reads up to the end of the file
+		};
+
+		struct read_result
+		{
+			std::unique_ptr<u8[]> data;
+			std::size_t size = 0; //may be smaller than requested if the end of the file was reached
+		};
+
+		/**
+		 * @brief Reads a file, or part of it, asynchronously. Reads are submitted through io_uring when the platform
+		 * supports it, otherwise they are executed by the background worker threads.
+		 * @param filepath File to read, copied before the function returns.
+		 * @param offset Offset in bytes of the first byte to read.
+		 * @param size Number of bytes to read, 0 to read up to the end of the file.
+		 * @return std::future object which will contain the data once it has been read, or an exception::io_error.
+		*/
+		ENGINE_API std::future<read_result> read_async(const char* filepath, u64 offset = 0, std::size_t size = 0);
+
+		/**
+		 * @brief Submits several reads at once, which is cheaper than calling read_async for each of them.
+		 * @param requests Reads to submit.
+		 * @param n_requests Number of reads.
+		 * @return One future per request, in the same order.
+		*/
+		ENGINE_API std::vector<std::future<read_result>> read_batch(const read_request* requests, std::size_t n_requests);
+	}
+}
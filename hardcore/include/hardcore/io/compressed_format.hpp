@@ -0,0 +1,54 @@
+#pragma once
+
+#include <hardcore/core/core.hpp>
+
+namespace ENGINE_NAMESPACE
+{
+	/*
+	 * Compressed container (.hcz) layout, all values are stored in native (little endian) byte order:
+	 *	header:	u32 magic | u16 version | u8 codec | u8 reserved | u32 block size | u32 block count | u64 size
+	 *	index:	block[block count], in file order
+	 *	block:	u64 data offset | u32 compressed size | u32 flags
+	 *	data:	compressed blocks
+	 * Every block decompresses to block size bytes, apart from the last one which holds the remainder of size.
+	 * Blocks are compressed independently of each other, so they can be decompressed in parallel. A block which
+	 * does not compress is stored as is, flagged with STORED_BIT.
+	*/
+	namespace compressed_format
+	{
+		const u32 magic = 0x5A434848; //"HHCZ"
+		const u16 version = 1;
+		const u32 default_block_size = KILOBYTES(256);
+
+		enum codec_t : u8
+		{
+			NONE = 0,
+			LZ4, //LZ4 block format
+		};
+
+		enum block_flag_bits : u32
+		{
+			STORED_BIT = BIT(0),
+		};
+
+		struct header
+		{
+			u32 magic;
+			u16 version;
+			u8 codec;
+			u8 reserved;
+			u32 block_size;
+			u32 n_blocks;
+			u64 size;
+		};
+
+		struct block
+		{
+			u64 offset;
+			u32 compressed_size;
+			u32 flags;
+		};
+
+		static_assert(sizeof(header) == 24 && sizeof(block) == 16, "Container structures must not contain padding");
+	}
+}
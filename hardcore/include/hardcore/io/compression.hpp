@@ -0,0 +1,36 @@
+#pragma once
+
+#include <hardcore/core/core.hpp>
+
+#include "compressed_format.hpp"
+
+namespace ENGINE_NAMESPACE
+{
+	namespace io
+	{
+		/**
+		 * @brief Checks if data starts with a compressed container (.hcz) header.
+		 * @param data Data to check, such as a mapped file or a pak entry.
+		 * @param size Size of the data.
+		 * @return True if the data is a compressed container.
+		*/
+		ENGINE_API bool is_compressed(const void* data, std::size_t size) noexcept;
+
+		/**
+		 * @brief Gets the size of the data stored in a compressed container.
+		 * @return Decompressed size, or 0 if the data is not a compressed container.
+		*/
+		ENGINE_API u64 decompressed_size(const void* data, std::size_t size) noexcept;
+
+		/**
+		 * @brief Decompresses a container straight into a destination buffer, such as mapped staging memory. Blocks are
+		 * decoded in parallel by the immediate workers, the calling thread takes part and returns once all are done.
+		 * @param src Compressed container.
+		 * @param src_size Size of the container.
+		 * @param dst Destination of the decompressed data.
+		 * @param dst_size Size of the destination, at least decompressed_size() bytes.
+		 * @return False if the container is corrupted or does not fit in the destination.
+		*/
+		ENGINE_API bool decompress(const void* src, std::size_t src_size, void* dst, std::size_t dst_size);
+	}
+}
@@ -4,5 +4,19 @@
 
 namespace ENGINE_NAMESPACE
 {
+	/**
+	 * @brief Reads a whole file into a buffer allocated with malloc. Compressed containers (.hcz) are recognized and
+	 * returned decompressed.
+	 * @param filepath File to read.
+	 * @param out_filesize Size of the returned buffer.
+	 * @return Buffer holding the file contents, to be freed with std::free, or nullptr on failure.
+	*/
 	ENGINE_API void* read_binary_file(const char* filepath, std::size_t& out_filesize);
+
+	/**
+	 * @brief Same as read_binary_file, but a file that can't be read is not fatal, e.g. one being saved while it is
+	 * reloaded.
+	 * @return Buffer holding the file contents, to be freed with std::free, or nullptr on any failure.
+	*/
+	ENGINE_API void* try_read_binary_file(const char* filepath, std::size_t& out_filesize) noexcept;
 }
@@ -0,0 +1,88 @@
+#pragma once
+
+#include <hardcore/core/core.hpp>
+
+#include <memory>
+
+namespace ENGINE_NAMESPACE
+{
+	namespace io
+	{
+		using stream_flag_t = u8;
+		enum stream_flag_bits : stream_flag_t
+		{
+			DIRECT_BIT = BIT(0), //bypass the OS page cache, falls back to buffered reads if unsupported
+		};
+
+		/**
+		 * @brief Chunk of a streamed file, valid until the next call to file_stream::next().
+		*/
+		struct stream_chunk
+		{
+			const u8* data = nullptr;
+			std::size_t size = 0;
+			u64 offset = 0; //relative to the start of the streamed range
+		};
+
+		/**
+		 * @brief Reads a file front to back through a fixed ring of aligned buffers, so memory use is bounded by
+		 * chunk_size * n_buffers regardless of the file size. A producer thread reads ahead into the free buffers while
+		 * the consumer processes the current chunk.
+		*/
+		class ENGINE_API file_stream
+		{
+		public:
+			static constexpr std::size_t default_chunk_size = MEGABYTES(1);
+			static constexpr u32 default_buffer_count = 4;
+			static constexpr std::size_t alignment = KILOBYTES(4); //buffer and unbuffered read alignment
+
+			/**
+			 * @brief Opens a file and starts reading ahead, check is_open() to know if it succeeded.
+			 * @param filepath File to stream.
+			 * @param offset Position in the file to start streaming from.
+			 * @param size Number of bytes to stream, 0 streams until the end of the file.
+			 * @param chunk_size Size of each buffer, rounded up to the alignment.
+			 * @param n_buffers Number of buffers in the ring, at least 2 are needed to overlap reading and processing.
+			 * @param flags Bitmask of stream_flag_bits.
+			*/
+			file_stream(const char* filepath, u64 offset = 0, u64 size = 0, std::size_t chunk_size = default_chunk_size,
+				u32 n_buffers = default_buffer_count, stream_flag_t flags = 0);
+			file_stream() = default;
+
+			file_stream(const file_stream&) = delete;
+			file_stream(file_stream&& other) noexcept;
+			~file_stream();
+
+			file_stream& operator=(const file_stream&) = delete;
+			file_stream& operator=(file_stream&& other) noexcept;
+
+			/**
+			 * @brief Stops the producer thread and releases the buffers.
+			*/
+			void close() noexcept;
+
+			/**
+			 * @brief Releases the previous chunk back to the producer and waits for the next one.
+			 * @param out_chunk Next chunk of the file.
+			 * @return False once the whole range has been streamed, or if reading failed.
+			*/
+			bool next(stream_chunk& out_chunk);
+
+			/**
+			 * @brief Checks if next() can return without waiting for the producer.
+			 * @return True if the next chunk has been read, or if the stream has ended.
+			*/
+			bool ready() const noexcept;
+
+			bool failed() const noexcept;
+
+			inline bool is_open() const noexcept { return state != nullptr; }
+			inline u64 size() const noexcept { return range_size; }
+
+		private:
+			struct shared_state;
+			std::unique_ptr<shared_state> state;
+			u64 range_size = 0;
+		};
+	}
+}
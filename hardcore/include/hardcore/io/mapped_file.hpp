@@ -0,0 +1,99 @@
+#pragma once
+
+#include <hardcore/core/core.hpp>
+
+#include <span>
+
+namespace ENGINE_NAMESPACE
+{
+	namespace io
+	{
+		using map_hint_flag_t = u8;
+
+		enum class map_mode : u8
+		{
+			READ_ONLY = 0,
+			COPY_ON_WRITE,	//pages can be written to, changes are private and never reach the file
+		};
+
+		enum map_hint_flag_bits : map_hint_flag_t
+		{
+			SEQUENTIAL_BIT =	BIT(0),	//read ahead aggressively, pages behind the cursor can be dropped early
+			RANDOM_BIT =		BIT(1),	//disable read ahead
+			WILLNEED_BIT =		BIT(2),	//start paging the whole file in right away
+			HUGEPAGES_BIT =		BIT(3),	//back the mapping with huge pages if the platform allows it
+		};
+
+		/**
+		 * @brief Read only view of a file mapped in memory, the file contents are paged in on access instead of being
+		 * copied into a heap buffer. The mapping stays valid until the object is destroyed or closed.
+		*/
+		class ENGINE_API mapped_file
+		{
+		public:
+			mapped_file() noexcept = default;
+
+			/**
+			 * @brief Maps a whole file in memory. Check is_open() to know if the mapping succeeded.
+			 * @param filepath File to map.
+			 * @param mode Access mode of the mapping.
+			 * @param hints Combination of map_hint_flag_bits.
+			*/
+			mapped_file(const char* filepath, map_mode mode = map_mode::READ_ONLY, map_hint_flag_t hints = 0);
+
+			mapped_file(const mapped_file&) = delete;
+			mapped_file(mapped_file&& other) noexcept;
+			~mapped_file();
+
+			mapped_file& operator=(const mapped_file&) = delete;
+			mapped_file& operator=(mapped_file&& other) noexcept;
+
+			/**
+			 * @brief Unmaps the file, pointers into the mapping become invalid.
+			*/
+			void close() noexcept;
+
+			/**
+			 * @brief Gives access pattern hints for the whole mapping, or a range of it.
+			 * @param hints Combination of map_hint_flag_bits.
+			 * @param offset Offset in bytes of the range, rounded down to a page boundary.
+			 * @param size Size in bytes of the range, 0 to advise up to the end of the file.
+			*/
+			void advise(map_hint_flag_t hints, std::size_t offset = 0, std::size_t size = 0) const noexcept;
+
+			inline bool is_open() const noexcept { return valid; }
+			inline explicit operator bool() const noexcept { return is_open(); }
+
+			inline const u8* data() const noexcept { return ptr; }
+			inline std::size_t size() const noexcept { return length; }
+			inline bool empty() const noexcept { return length == 0; }
+			inline map_mode mode() const noexcept { return _mode; }
+
+			inline const u8* begin() const noexcept { return ptr; }
+			inline const u8* end() const noexcept { return ptr + length; }
+
+			/**
+			 * @brief Gets writable access to a copy on write mapping.
+			 * @return Pointer to the mapped data, nullptr if the file is mapped read only.
+			*/
+			inline u8* mutable_data() noexcept { return _mode == map_mode::COPY_ON_WRITE ? ptr : nullptr; }
+
+			inline std::span<const u8> view() const noexcept { return std::span<const u8>(ptr, length); }
+			inline std::span<const u8> view(std::size_t offset, std::size_t size) const noexcept
+			{
+				return view().subspan(offset, size);
+			}
+
+		private:
+			u8* ptr = nullptr;
+			std::size_t length = 0;
+			map_mode _mode = map_mode::READ_ONLY;
+			bool valid = false; //empty files are valid, but can't be mapped
+
+#ifdef _MSC_VER
+			void* file_handle = nullptr;
+			void* mapping_handle = nullptr;
+#endif // _MSC_VER
+		};
+	}
+}
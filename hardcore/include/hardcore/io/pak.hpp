@@ -0,0 +1,90 @@
+#pragma once
+
+#include <hardcore/core/core.hpp>
+
+#include "pak_format.hpp"
+#include "mapped_file.hpp"
+#include "async.hpp"
+
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace ENGINE_NAMESPACE
+{
+	namespace io
+	{
+		typedef pak_format::entry pak_entry;
+
+		class native_file;
+
+		/**
+		 * @brief Read only access to a packed archive (.hcpak), built with the hcpak tool. Opening an archive reads its
+		 * table of contents once, entries are then looked up in memory and read with positional reads, so any number
+		 * of entries only costs one open. Reading is thread safe.
+		*/
+		class ENGINE_API pak
+		{
+		public:
+			pak() = default;
+
+			/**
+			 * @brief Opens an archive, check is_open() to know if it succeeded.
+			 * @param filepath Archive to open.
+			 * @param map Also maps the whole archive in memory, so entries can be accessed with view().
+			*/
+			pak(const char* filepath, bool map = false);
+
+			pak(const pak&) = delete;
+			pak(pak&& other) noexcept;
+			~pak();
+
+			pak& operator=(const pak&) = delete;
+			pak& operator=(pak&& other) noexcept;
+
+			/**
+			 * @brief Looks up an entry.
+			 * @param name Path of the file relative to the packed directory, using forward slashes.
+			 * @return The entry, or nullptr if the archive does not contain it.
+			*/
+			const pak_entry* find(std::string_view name) const noexcept;
+
+			std::string_view name(const pak_entry& entry) const noexcept;
+
+			/**
+			 * @brief Reads an entry straight into a buffer, such as mapped staging memory, with no intermediate copy.
+			 * @param entry Entry to read.
+			 * @param dst Destination, at least entry.size bytes large.
+			 * @return True if the whole entry was read.
+			*/
+			bool read(const pak_entry& entry, void* dst) const noexcept;
+
+			/**
+			 * @brief Reads an entry asynchronously through the I/O service, using the handle opened with the archive.
+			 * The archive may be closed before the read completes.
+			 * @param entry Entry to read.
+			 * @return std::future object which will contain the data once it has been read.
+			*/
+			std::future<read_result> read_async(const pak_entry& entry) const;
+
+			/**
+			 * @brief Gets the data of an entry from the mapping of the archive.
+			 * @param entry Entry to access.
+			 * @return View of the entry data, empty if the archive was not mapped.
+			*/
+			std::span<const u8> view(const pak_entry& entry) const noexcept;
+
+			inline bool is_open() const noexcept { return file != nullptr; }
+			inline std::size_t size() const noexcept { return entries.size(); }
+			inline const pak_entry* begin() const noexcept { return entries.data(); }
+			inline const pak_entry* end() const noexcept { return entries.data() + entries.size(); }
+
+		private:
+			std::string filepath;
+			std::vector<pak_entry> entries;
+			std::vector<char> names;
+			std::shared_ptr<native_file> file; //shared with the asynchronous reads still in flight
+			mapped_file mapping;
+		};
+	}
+}
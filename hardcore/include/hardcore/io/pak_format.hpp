@@ -0,0 +1,67 @@
+#pragma once
+
+#include <hardcore/core/core.hpp>
+
+#include <string_view>
+
+namespace ENGINE_NAMESPACE
+{
+	/*
+	 * Packed archive (.hcpak) layout, all values are stored in native (little endian) byte order:
+	 *	header:	u32 magic | u16 version | u16 reserved | u32 entry count | u32 data alignment | u64 names size
+	 *	table:	entry[entry count], sorted by name hash, then by name
+	 *	entry:	u64 name hash | u64 data offset | u64 data size | u32 name offset | u32 name size
+	 *	names:	names of all entries, not null terminated
+	 *	data:	entries data, each starting on a data alignment boundary
+	 * The header, table and names are read in one go when opening the archive. Entry names are relative paths
+	 * using forward slashes.
+	*/
+	namespace pak_format
+	{
+		const u32 magic = 0x4B415048; //"HPAK"
+		const u16 version = 1;
+		const u32 default_alignment = KILOBYTES(4);
+
+		struct header
+		{
+			u32 magic;
+			u16 version;
+			u16 reserved;
+			u32 n_entries;
+			u32 alignment;
+			u64 names_size;
+		};
+
+		struct entry
+		{
+			u64 hash;
+			u64 offset;
+			u64 size;
+			u32 name_offset;
+			u32 name_size;
+		};
+
+		static_assert(sizeof(header) == 24 && sizeof(entry) == 32, "Archive structures must not contain padding");
+
+		/**
+		 * @brief Hashes an entry name, FNV-1a 64.
+		 * @param name Entry name.
+		 * @return Hash of the name.
+		*/
+		constexpr u64 hash(std::string_view name) noexcept
+		{
+			u64 h = 0xcbf29ce484222325ULL;
+			for (const char c : name)
+			{
+				h ^= static_cast<u8>(c);
+				h *= 0x100000001b3ULL;
+			}
+			return h;
+		}
+
+		constexpr u64 align_up(u64 offset, u64 alignment) noexcept
+		{
+			return (offset + alignment - 1) & ~(alignment - 1);
+		}
+	}
+}
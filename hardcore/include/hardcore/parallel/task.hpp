@@ -59,8 +59,10 @@ namespace ENGINE_NAMESPACE
 		{
 			std::promise<Type>* promise = new std::promise<Type>();
 			func_t<Type>* func = new func_t<Type>(std::move(task));
+			//the future must be retrieved before submitting, the promise is deleted once the task has been executed
+			std::future<Type> future = promise->get_future();
 			internal::submit_immediate_task(internal::execute<Type>, func, promise);
-			return promise->get_future();
+			return future;
 		}
 
 		/**
@@ -74,8 +76,10 @@ namespace ENGINE_NAMESPACE
 		{
 			std::promise<Type>* promise = new std::promise<Type>();
 			func_t<Type>* func = new func_t<Type>(std::move(task));
+			//the future must be retrieved before submitting, the promise is deleted once the task has been executed
+			std::future<Type> future = promise->get_future();
 			internal::submit_background_task(internal::execute<Type>, func, promise);
-			return promise->get_future();
+			return future;
 		}
 	}
 }
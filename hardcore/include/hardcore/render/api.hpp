@@ -4,3 +4,4 @@
 #include "shader_library.hpp"
 #include "pipeline.hpp"
 #include "resource.hpp"
+#include "asset.hpp"
@@ -0,0 +1,130 @@
+#pragma once
+
+#include <hardcore/core/core.hpp>
+
+#include <functional>
+#include <memory>
+#include <typeinfo>
+#include <vector>
+
+namespace ENGINE_NAMESPACE
+{
+	struct asset_entry;
+
+	/**
+	 * @brief Untyped handle to an asset of the asset registry. Handles are reference counted, the asset (and the
+	 * resources it owns) is destroyed along with its last handle.
+	*/
+	class ENGINE_API asset_base
+	{
+	public:
+		asset_base() = default;
+
+		inline bool valid() const noexcept { return entry != nullptr; }
+
+		/**
+		 * @brief Number of times the asset has been rebuilt since it was loaded, lets its users notice changes.
+		*/
+		u32 generation() const noexcept;
+
+	protected:
+		explicit asset_base(std::shared_ptr<asset_entry>&& entry) noexcept : entry(std::move(entry)) { }
+
+		const void* value() const noexcept;
+
+		std::shared_ptr<asset_entry> entry;
+
+		friend class asset_registry;
+	};
+
+	/**
+	 * @brief Handle to an asset of the asset registry. The value is rebuilt in place (by move assignment) on reloads,
+	 * so references to it stay valid, but anything built from its previous contents must be rebuilt as well, ideally
+	 * as a derived asset.
+	 * @tparam Type Type of the asset, usually a resource.
+	*/
+	template<typename Type>
+	class asset final : public asset_base
+	{
+	public:
+		asset() = default;
+
+		inline const Type& get() const noexcept { return *static_cast<const Type*>(value()); }
+		inline const Type& operator*() const noexcept { return get(); }
+		inline const Type* operator->() const noexcept { return &get(); }
+
+	private:
+		explicit asset(asset_base&& base) noexcept : asset_base(std::move(base)) { }
+
+		friend class asset_registry;
+	};
+
+	/**
+	 * @brief Records which file every asset is loaded from and which assets are built from other assets. Loading the
+	 * same file as the same type twice returns the same asset, and with hot reload enabled, a changed file rebuilds
+	 * the assets loaded from it and then every asset downstream of them, in dependency order.
+	*/
+	class ENGINE_API asset_registry
+	{
+	public:
+		using loader_t = std::function<std::shared_ptr<void>(const void* data, std::size_t size)>;
+		using builder_t = std::function<std::shared_ptr<void>()>;
+		using assign_t = void(*)(void* dst, void* src);
+
+		/**
+		 * @brief Loads an asset from a file, or returns the live asset of the same type already loaded from it.
+		 * @param filepath File to load, compressed containers are decompressed before reaching the loader.
+		 * @param loader Builds the asset from the file contents, also called on every reload of the file.
+		 * @return Handle to the asset, invalid if the file could not be read.
+		*/
+		template<typename Type>
+		static inline asset<Type> load(const char* filepath, std::function<Type(const void* data, std::size_t size)> loader)
+		{
+			return asset<Type>(load_file(filepath, typeid(Type).name(),
+				[loader = std::move(loader)](const void* data, std::size_t size) -> std::shared_ptr<void>
+				{
+					return std::make_shared<Type>(loader(data, size));
+				}, &assign<Type>));
+		}
+
+		/**
+		 * @brief Creates an asset built from other assets, or returns the live asset of the same type and name.
+		 * @param name Unique name of the asset.
+		 * @param dependencies Assets the builder reads, kept alive as long as this asset.
+		 * @param build Builds the asset, also called whenever any of the dependencies is rebuilt.
+		 * @return Handle to the asset.
+		*/
+		template<typename Type>
+		static inline asset<Type> derive(const char* name, const std::vector<asset_base>& dependencies,
+			std::function<Type()> build)
+		{
+			return asset<Type>(derive_asset(name, typeid(Type).name(), dependencies,
+				[build = std::move(build)]() -> std::shared_ptr<void>
+				{
+					return std::make_shared<Type>(build());
+				}, &assign<Type>));
+		}
+
+		/**
+		 * @brief Watches the files of every asset. Changed files are read in the background and their assets are
+		 * rebuilt between frames.
+		 * @param enable Starts watching if true, stops otherwise.
+		*/
+		static void hot_reload(bool enable = true);
+
+	protected:
+		static void apply_reloads();
+		static void clear();
+
+	private:
+		template<typename Type>
+		static void assign(void* dst, void* src)
+		{
+			*static_cast<Type*>(dst) = std::move(*static_cast<Type*>(src));
+		}
+
+		static asset_base load_file(const char* filepath, const char* type, loader_t&& loader, assign_t assign);
+		static asset_base derive_asset(const char* name, const char* type, const std::vector<asset_base>& dependencies,
+			builder_t&& builder, assign_t assign);
+	};
+}
@@ -0,0 +1,87 @@
+#pragma once
+
+#include <hardcore/core/core.hpp>
+
+namespace ENGINE_NAMESPACE
+{
+	/*
+	 * Binary mesh (.hcmesh) layout, all values are stored in native (little endian) byte order:
+	 *	header:		u32 magic | u16 version | u8 index format | u8 attribute count | u32 vertex count | u32 index count |
+	 *				u32 vertex stride | u32 reserved | u64 vertex data offset | u64 index data offset
+	 *	attributes:	attribute[attribute count], the serialized vertex data_layout
+	 *	attribute:	u8 type | u8 component type
+	 *	vertices:	vertex count * vertex stride bytes, starting on a data alignment boundary
+	 *	indexes:	index count * index size bytes, starting on a data alignment boundary, absent without index format
+	 * Vertices and indexes are stored exactly as uploaded, so a mapping of the file can be handed to the device memory
+	 * as is.
+	*/
+	namespace mesh_format
+	{
+		const u32 magic = 0x48534D48; //"HMSH"
+		const u16 version = 1;
+		const u32 data_alignment = 16;
+
+		//same values as data_layout::type, data_layout::component_type and mesh::index_format, repeated here so that
+		//tools only need this header
+		enum class attribute_type : u8
+		{
+			SCALAR = 0,
+			VEC2,
+			VEC3,
+			VEC4,
+			MAT2,
+			MAT3,
+			MAT4,
+		};
+
+		enum class component_type : u8
+		{
+			FLOAT32 = 0,
+			FLOAT64,
+			FLOAT16,
+			INT8,
+			INT16,
+			INT32,
+			INT64,
+			UINT8,
+			UINT16,
+			UINT32,
+			UINT64,
+		};
+
+		enum class index_type : u8
+		{
+			NONE = 0,
+			UINT8,
+			UINT16,
+			UINT32,
+		};
+
+		struct header
+		{
+			u32 magic;
+			u16 version;
+			u8 index_format;
+			u8 n_attributes;
+			u32 n_vertices;
+			u32 n_indexes;
+			u32 vertex_stride;
+			u32 reserved;
+			u64 vertex_offset;
+			u64 index_offset;
+		};
+
+		struct attribute
+		{
+			u8 type;
+			u8 component_type;
+		};
+
+		static_assert(sizeof(header) == 40 && sizeof(attribute) == 2, "Mesh structures must not contain padding");
+
+		constexpr u64 align_up(u64 offset, u64 alignment) noexcept
+		{
+			return (offset + alignment - 1) & ~(alignment - 1);
+		}
+	}
+}
@@ -44,6 +44,8 @@ namespace ENGINE_NAMESPACE
 		volatile_pipeline_task_ref<PipelineType>& set_descriptor(u32 descriptor_idx, const dynamic_storage_array& buffer);
 		volatile_pipeline_task_ref<PipelineType>& set_descriptor(u32 descriptor_idx, const storage_vector& buffer);
 		volatile_pipeline_task_ref<PipelineType>& set_descriptor(u32 descriptor_idx, const dynamic_storage_vector& buffer);
+		volatile_pipeline_task_ref<PipelineType>& set_descriptor(u32 descriptor_idx, const transient_uniform& buffer);
+		volatile_pipeline_task_ref<PipelineType>& set_descriptor(u32 descriptor_idx, const transient_storage& buffer);
 
 	private:
 		volatile_pipeline_task_ref(void* pipeline_p, std::size_t task_id) noexcept : 
@@ -53,7 +55,7 @@ namespace ENGINE_NAMESPACE
 		}
 
 		template<typename Resource,
-			std::enable_if_t<std::is_base_of<resource, Resource>::value && std::is_final<Resource>::value, bool> = true>
+			std::enable_if_t<is_descriptor_buffer<Resource>::value, bool> = true>
 		volatile_pipeline_task_ref<PipelineType>& t_set_descriptor(u32 descriptor_idx, const Resource& buffer);
 
 		void* pipeline_p;
@@ -119,5 +121,12 @@ namespace ENGINE_NAMESPACE
 		vptr_t set_descriptor(const mesh& object, u32 descriptor_idx, const dynamic_storage_array& buffer);
 		vptr_t set_descriptor(const mesh& object, u32 descriptor_idx, const storage_vector& buffer);
 		vptr_t set_descriptor(const mesh& object, u32 descriptor_idx, const dynamic_storage_vector& buffer);
+
+		/**
+		 * @brief Binds transient data to an object for the current frame, it must be set again every frame it is drawn
+		 * with. Only the dynamic offset changes from frame to frame, the descriptor sets are not rewritten.
+		*/
+		vptr_t set_descriptor(const mesh& object, u32 descriptor_idx, const transient_uniform& buffer);
+		vptr_t set_descriptor(const mesh& object, u32 descriptor_idx, const transient_storage& buffer);
 	};
 }
@@ -4,5 +4,113 @@
 
 namespace ENGINE_NAMESPACE
 {
-	
-}
+	class unmapped_resource;
+
+	namespace renderer
+	{
+		/**
+		 * @brief Snapshot of the device memory pools of the rendering device, in bytes.
+		*/
+		struct memory_stats
+		{
+			u32 pools = 0;
+			u64 pool_size = 0;          //memory held by all pools
+			u64 used = 0;
+			u64 free = 0;
+			u64 largest_free_range = 0; //largest allocation that fits without a new pool, ignoring alignment
+			u32 free_ranges = 0;
+			u64 pending = 0;            //freed, waiting for the frames in flight before being reused
+
+			//share of free memory outside the largest free range of its pool, 0 when every pool's free memory is
+			//contiguous
+			float fragmentation = 0.0f;
+
+			u32 device_allocations = 0; //memory blocks, the pools are sub-allocated from them
+			u64 reserved = 0;           //memory held by all blocks
+			u64 budget = 0;             //budget of the main heap, as reported by VK_EXT_memory_budget or estimated
+			u64 budget_usage = 0;
+
+			u64 relocated = 0;          //bytes moved by the defragmenter since the renderer was initialized
+		};
+
+		/**
+		 * @brief Measures the pools of the rendering device, walks every pool so it is not meant for every frame.
+		 * @return Memory statistics, all zero before the renderer is initialized.
+		*/
+		ENGINE_API memory_stats memory_statistics();
+
+		/**
+		 * @brief Sequence number given to uploads in the order they are committed, an upload is complete once its
+		 * ticket and every ticket before it are.
+		*/
+		using upload_ticket = u64;
+
+		/**
+		 * @brief Hands the uploads staged in place by the calling thread over to the next frame, once their data has been
+		 * written. Uploads staged by the render thread are committed when the frame is drawn, the other threads keep
+		 * theirs pending until they call this function.
+		 * @return Ticket of the last upload committed, to be polled with upload_complete.
+		*/
+		ENGINE_API upload_ticket commit_staging();
+
+		/**
+		 * @brief Ticket of the last upload committed by any thread, uploads made through the resources' update functions
+		 * are committed right away.
+		*/
+		ENGINE_API upload_ticket last_upload_ticket();
+
+		/**
+		 * @brief Checks, without waiting, whether the transfer queue has finished the uploads up to the ticket.
+		*/
+		ENGINE_API bool upload_complete(upload_ticket ticket);
+
+		/**
+		 * @brief Transfer commands recorded by the calling thread into its own secondary command buffer, e.g. by a loader
+		 * moving data between the resources it created. They are executed on the transfer queue by the next frame's
+		 * upload, after the staged uploads. An object is used by the thread that created it only.
+		*/
+		class ENGINE_API transfer_commands
+		{
+		public:
+			/**
+			 * @brief Begins recording from the calling thread's command pool.
+			*/
+			transfer_commands();
+
+			/**
+			 * @brief Submits the commands if submit has not been called.
+			*/
+			~transfer_commands();
+
+			transfer_commands(const transfer_commands&) = delete;
+			transfer_commands& operator=(const transfer_commands&) = delete;
+
+			/**
+			 * @brief Records a copy between two resources. Their locations are resolved now, and neither is moved by the
+			 * defragmenter until the commands have been executed.
+			 * @param src Resource to copy from.
+			 * @param dst Resource to copy to.
+			 * @param size Number of bytes to copy.
+			 * @param src_offset Position in the source to copy from.
+			 * @param dst_offset Position in the destination to copy to.
+			*/
+			void copy(const unmapped_resource& src, unmapped_resource& dst, std::size_t size, std::size_t src_offset = 0,
+				std::size_t dst_offset = 0);
+
+			/**
+			 * @brief Ends the recording and queues the commands for the next frame, no copy can be recorded afterwards.
+			 * @return Ticket of the commands, the destinations are ready once it is complete.
+			*/
+			upload_ticket submit();
+
+		private:
+			void* m_cmd_buffer = nullptr; //null once submitted, or if there is no device
+		};
+
+		/**
+		 * @brief Sets how many frames after being copied the downloads are delivered, between 1 and the frames in flight,
+		 * which is the default. A shorter latency waits on the frame the downloads were copied in.
+		*/
+		ENGINE_API void set_download_latency(u8 frames);
+	}
+}
\ No newline at end of file
@@ -5,10 +5,19 @@
 
 #include <hardcore/core/core.hpp>
 
+#include <type_traits>
 #include <utility>
+#include <span>
+#include <future>
+#include <vector>
 
 namespace ENGINE_NAMESPACE
 {
+	namespace renderer
+	{
+		class transfer_commands;
+	}
+
 	class ENGINE_API resource
 	{
 	public:
@@ -16,6 +25,12 @@ namespace ENGINE_NAMESPACE
 
 		inline bool valid() const { return ref.valid(); }
 
+		/**
+		 * @brief Checks, without waiting, whether the data staged or uploaded into the resource has reached the device.
+		 * Objects using a resource that is not ready yet are skipped when drawn.
+		*/
+		bool ready() const;
+
 		resource(const resource&) = delete;
 		resource& operator=(const resource&) = delete;
 
@@ -56,6 +71,7 @@ namespace ENGINE_NAMESPACE
 
 	private:
 		friend struct std::hash<resource>;
+		friend class renderer::transfer_commands;
 	};
 
 	class ENGINE_API mesh : public resource
@@ -116,6 +132,37 @@ namespace ENGINE_NAMESPACE
 			return mesh(vertex_data_size, data_layout::create<Types...>());
 		}
 
+		/**
+		 * @brief Loads a binary mesh (.hcmesh) file, see mesh_format. The file is mapped and its vertex and index data
+		 * are uploaded as stored, without any conversion.
+		 * @param filepath File to load, compressed containers are decompressed first.
+		 * @return The mesh, invalid if the file could not be read or is not a valid mesh file.
+		*/
+		static mesh load(const char* filepath);
+
+		/**
+		 * @brief Loads a binary mesh from the contents of a .hcmesh file.
+		 * @param data File contents.
+		 * @param size Size of the file contents.
+		 * @return The mesh, invalid if the data is not a valid mesh file.
+		*/
+		static mesh load(const void* data, std::size_t size);
+
+		/**
+		 * @brief Reserves staging memory for part of the vertex data, to be written in place instead of copied from
+		 * another buffer. It is uploaded with the next frame, or once renderer::commit_staging is called when staged from
+		 * another thread than the render thread.
+		 * @param size Number of bytes to write.
+		 * @param offset Position in the vertex data to write them to.
+		 * @return Memory to write the data to, valid until it is uploaded.
+		*/
+		std::span<std::byte> stage_vertices(std::size_t size, std::size_t offset = 0);
+
+		/**
+		 * @brief Reserves staging memory for part of the index data, like stage_vertices.
+		*/
+		std::span<std::byte> stage_indexes(std::size_t size, std::size_t offset = 0);
+
 		mesh(mesh&& other) noexcept : resource(std::move(other)), index_ref(std::move(other.index_ref)),
 			index_t(std::exchange(other.index_t, index_format::NONE)), n_indexes(std::exchange(other.n_indexes, 0))
 		{ }
@@ -129,6 +176,11 @@ namespace ENGINE_NAMESPACE
 			return *this;
 		}
 
+		/**
+		 * @brief Checks, without waiting, whether both the vertex and index data have reached the device.
+		*/
+		bool ready() const;
+
 		inline index_format index_type() const noexcept { return index_t; }
 		inline u32 index_count() const noexcept { return n_indexes; }
 		inline u32 draw_count() const noexcept { return index_t == index_format::NONE ? n_elements : n_indexes; }
@@ -164,6 +216,46 @@ namespace ENGINE_NAMESPACE
 
 	public:
 		virtual void update(void* data, std::size_t size, std::size_t offset) = 0;
+
+		/**
+		 * @brief Reserves staging memory for part of the resource, so producers such as decoders can write the data in
+		 * place instead of handing a buffer to update. It is uploaded with the next frame, or once
+		 * renderer::commit_staging is called when staged from another thread than the render thread.
+		 * @param size Number of bytes to write.
+		 * @param offset Position in the resource to write them to.
+		 * @return Memory to write the data to, valid until it is uploaded.
+		*/
+		std::span<std::byte> stage(std::size_t size, std::size_t offset = 0);
+
+		/**
+		 * @brief Reads part of the resource back from the device without waiting, e.g. data written by shaders. The copy
+		 * is made after the next frame's draws, and its data is delivered a few frames later, see
+		 * renderer::set_download_latency.
+		 * @param size Number of bytes to read.
+		 * @param offset Position in the resource to read them from.
+		 * @return Future receiving the data, empty if the resource was destroyed before it was copied.
+		*/
+		std::future<std::vector<std::byte>> download(std::size_t size, std::size_t offset = 0);
+
+		/**
+		 * @brief Uploads part of a file into the resource over the next frames, reading it chunk by chunk instead of
+		 * loading it whole in memory.
+		 * @param filepath File to read the data from.
+		 * @param file_offset Position in the file to start reading from.
+		 * @param size Number of bytes to upload, 0 uploads the rest of the file.
+		 * @param offset Position in the resource to write the data to.
+		*/
+		void stream(const char* filepath, u64 file_offset = 0, std::size_t size = 0, std::size_t offset = 0);
+
+		/**
+		 * @brief Decompresses a compressed container (.hcz) straight into staging memory for the resource, with no
+		 * intermediate buffer, see stage.
+		 * @param filepath Compressed container to read.
+		 * @param offset Position in the resource to write the decompressed data to.
+		 * @return False if the file can't be read or does not fit in the resource, the staged range is zeroed if the
+		 * container turns out to be corrupted.
+		*/
+		bool stage_compressed(const char* filepath, std::size_t offset = 0);
 	};
 
 	class ENGINE_API resource_ref;
@@ -340,6 +432,50 @@ namespace ENGINE_NAMESPACE
 	private:
 
 	};
+
+	/**
+	 * @brief Buffer data that only lives for the frame it is allocated in. It is bumped from a ring shared by every
+	 * transient buffer, and recycled once the frame has been rendered, so it is cheap enough to be allocated per draw.
+	 * It must be written and set as a descriptor during the frame it is allocated in, and is never freed.
+	*/
+	class ENGINE_API transient_buffer
+	{
+	public:
+		inline bool valid() const noexcept { return host_ptr != nullptr; }
+
+		inline void* data() const noexcept { return host_ptr; }
+		inline std::size_t size() const noexcept { return n_bytes; }
+
+	protected:
+		transient_buffer() = default;
+
+		void* host_ptr = nullptr;
+		std::size_t n_bytes = 0;
+		u32 ring = 0;
+		u64 offset = 0;
+		u64 frame = 0;
+	};
+
+	class ENGINE_API transient_uniform final : public transient_buffer
+	{
+	public:
+		transient_uniform() = default;
+		transient_uniform(std::size_t size);
+		transient_uniform(const void* data, std::size_t size);
+	};
+
+	class ENGINE_API transient_storage final : public transient_buffer
+	{
+	public:
+		transient_storage() = default;
+		transient_storage(std::size_t size);
+		transient_storage(const void* data, std::size_t size);
+	};
+
+	//final resources and transient buffers, the types that can be set as descriptors
+	template<typename Type>
+	struct is_descriptor_buffer : std::bool_constant<(std::is_base_of<resource, Type>::value ||
+		std::is_base_of<transient_buffer, Type>::value) && std::is_final<Type>::value> {};
 }
 
 template<>
@@ -56,20 +56,20 @@ namespace ENGINE_NAMESPACE
 		shader(shader&& other) noexcept : data(std::exchange(other.data, nullptr)), size(std::exchange(other.size, 0)),
 			stage(std::exchange(other.stage, shader_t::NONE)), entry_point(std::exchange(other.entry_point, nullptr)),
 			_inputs(std::move(other._inputs)), _descriptors(std::move(other._descriptors)),
-			_name(std::exchange(other._name, nullptr))
+			_name(std::exchange(other._name, nullptr)), _source(std::exchange(other._source, nullptr))
 		{ }
 
 		shader& operator=(shader&& other) noexcept
 		{
-			this->~shader();
-
-			data = std::exchange(other.data, nullptr);
-			size = std::exchange(other.size, 0);
-			stage = std::exchange(other.stage, shader_t::NONE);
-			entry_point = std::exchange(other.entry_point, nullptr);
-			_inputs = std::move(other._inputs);
-			_descriptors = std::move(other._descriptors);
-			_name = std::exchange(other._name, nullptr);
+			//swapped rather than destroyed in place, the previous contents are freed along with other
+			std::swap(data, other.data);
+			std::swap(size, other.size);
+			std::swap(stage, other.stage);
+			std::swap(entry_point, other.entry_point);
+			std::swap(_inputs, other._inputs);
+			std::swap(_descriptors, other._descriptors);
+			std::swap(_name, other._name);
+			std::swap(_source, other._source);
 			return *this;
 		}
 
@@ -77,6 +77,8 @@ namespace ENGINE_NAMESPACE
 		shader& operator=(const shader&) = delete;
 
 		const char* name() const noexcept { return _name; }
+		//file the shader was created from, nullptr for shaders compiled from code in memory
+		const char* source() const noexcept { return _source; }
 		const data_layout* inputs(std::size_t& out_size) const noexcept;
 
 		//uniform types
@@ -116,9 +118,18 @@ namespace ENGINE_NAMESPACE
 		std::vector<data_layout> _inputs;
 		std::vector<descriptor_data> _descriptors;
 
+		/**
+		 * @brief Builds this (empty) shader from a file without crashing or breaking on errors, used to reload shaders
+		 * whose source is expected to be mid edit.
+		 * @return True on success, this shader is left empty otherwise.
+		*/
+		bool load_source(const char* filename, const char* entry_point, const char* name, shader_t stage);
+
 	private:
 		char* _name = nullptr;
+		char* _source = nullptr;
 
+		bool compile_cached(const char* code, std::size_t code_size, const char* error_name, bool reloading = false);
 		void reflect();
 	};
 }
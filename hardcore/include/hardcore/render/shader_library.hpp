@@ -9,5 +9,13 @@ namespace ENGINE_NAMESPACE
 		ENGINE_API const shader& add(shader&& s);
 		ENGINE_API const shader& get(const char* name);
 		ENGINE_API bool has(const char* name);
+
+		/**
+		 * @brief Watches the files the library shaders were created from. Changed shaders are rebuilt in the background
+		 * and swapped into the pipelines using them between frames. Changes to the inputs or descriptors of a shader
+		 * cannot be applied to existing pipelines, so those reloads are rejected.
+		 * @param enable Starts watching if true, stops otherwise.
+		*/
+		ENGINE_API void hot_reload(bool enable = true);
 	};
 }
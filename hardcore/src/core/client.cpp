@@ -3,6 +3,8 @@
 #include <core/client.hpp>
 #include <core/window.hpp>
 #include <core/window_internal.hpp>
+#include <core/timer_wheel.hpp>
+#include <core/replay_internal.hpp>
 
 #include <render/renderer_internal.hpp>
 #include <debug/log_internal.hpp>
@@ -18,30 +20,25 @@ namespace ENGINE_NAMESPACE
 
 	client* client::instance = nullptr;
 
-	std::chrono::high_resolution_clock::time_point last_frame;
+	timestamp last_frame;
 
-	client::client(const char* name, const unsigned int major_version, const unsigned int minor_version, const unsigned int patch_version) //TODO: might want to consider giving an absolute size to the layerstack and move it to the stack memory space instead of heap
+	client::client(const char* name, const unsigned int major_version, const unsigned int minor_version, const unsigned int patch_version,
+		bool headless)
 	{
 		instance = this;
-		layer_stack = t_malloc<Layer*>(initial_stack_capacity);
-		layer_stack_capacity = initial_stack_capacity;
+		layer_stack.reserve(initial_stack_capacity);
+		stack_handles.reserve(initial_stack_capacity);
+		tick_list.reserve(initial_stack_capacity);
+		layer_slots.reserve(initial_stack_capacity);
+		pending_layer_ops.reserve(initial_stack_capacity);
 		n_layers = 0;
-		n_overlays = 0;
-
-		pop_layer_buffer = 0;
-		pop_overlay_buffer = 0;
-		push_layer_buffer = t_malloc<Layer*>(initial_stack_capacity);
-		push_layer_capacity = initial_stack_capacity;
-		push_layer_size = 0;
-		push_overlay_buffer = t_malloc<Layer*>(initial_stack_capacity);
-		push_overlay_capacity = initial_stack_capacity;
-		push_overlay_size = 0;
 
 		running = true;
-		last_frame = std::chrono::high_resolution_clock::now();
+		last_frame = timestamp::now();
+		timers = std::make_unique<timer_wheel>(timestamp()); //driven by elapsed_time, so replays stay deterministic
 
 		window::init(std::bind(&client::push_event, this, std::placeholders::_1), 
-			std::bind(&client::push_window_size, this, std::placeholders::_1, std::placeholders::_2));
+			std::bind(&client::push_window_size, this, std::placeholders::_1, std::placeholders::_2), headless);
 		window::get_dimensions(&window_width, &window_height);
 		window_size_changed = false;
 
@@ -59,22 +56,22 @@ namespace ENGINE_NAMESPACE
 
 	client::~client()
 	{
-		const index_t total = n_layers + n_overlays;
-		index_t i;
-		for (i = 1; i < total + 1; i++)
-		{
-			delete layer_stack[total - i];
-		}
+		pending_layer_ops.clear();
+		erase_layers(0, layer_stack.size());
 		renderer::terminate();
 		window::terminate();
-		std::free(layer_stack);
-		std::free(push_layer_buffer);
-		std::free(push_overlay_buffer);
 	}
 
 	static std::mutex event_mutex;
 
 	void client::push_event(Event&& e)
+	{
+		//live input is ignored during replays, closing the window is still allowed
+		if (replayer && e.type != EventType::WindowClose) return;
+		enqueue_event(e);
+	}
+
+	void client::enqueue_event(const Event& e)
 	{
 		std::lock_guard<std::mutex> lock(event_mutex);
 		if (event_buffer_size < event_buffer_capacity)
@@ -96,50 +93,140 @@ namespace ENGINE_NAMESPACE
 		window_size_changed = true;
 	}
 
-	Layer* client::push_layer(Layer *layer)
+	layer_handle client::queue_push(layer_op_type type, Layer* layer, layer_tick_fn tick)
 	{
-		if (push_layer_size + 1 > push_layer_capacity)
+		u32 idx;
+		if (free_layer_slots.size())
+		{
+			idx = free_layer_slots.back();
+			free_layer_slots.pop_back();
+		}
+		else
 		{
-			push_layer_capacity += initial_stack_capacity;
-			push_layer_buffer = t_realloc<Layer*>(push_layer_buffer, push_layer_capacity);
+			idx = static_cast<u32>(layer_slots.size());
+			layer_slots.push_back({ nullptr, nullptr, 0 });
 		}
-		push_layer_buffer[push_layer_size] = layer;
-		push_layer_size++;
-		return layer;
+
+		layer_slot& slot = layer_slots[idx];
+		slot.layer = layer;
+		slot.tick = tick;
+		slot.generation = slot.generation + 1 ? slot.generation + 1 : 1; //generation is never 0, neither is a valid handle
+
+		const layer_handle handle = (static_cast<u64>(slot.generation) << 32) | idx;
+		pending_layer_ops.push_back({ type, handle, std::unique_ptr<Layer>(layer) });
+		return handle;
+	}
+
+	layer_handle client::push_layer(Layer* layer, layer_tick_fn tick)
+	{
+		return queue_push(layer_op_type::PUSH_LAYER, layer, tick);
 	}
 
 	void client::pop_layer()
 	{
-		pop_layer_buffer++;
+		pending_layer_ops.push_back({ layer_op_type::POP_LAYER, invalid_layer, nullptr });
 	}
 
-	Layer* client::push_overlay(Layer *layer)
+	layer_handle client::push_overlay(Layer* layer, layer_tick_fn tick)
 	{
-		if (push_overlay_size + 1 > push_overlay_capacity)
-		{
-			push_overlay_capacity += initial_stack_capacity;
-			push_overlay_buffer = t_realloc<Layer*>(push_overlay_buffer, push_overlay_capacity);
-		}
-		push_overlay_buffer[push_overlay_size] = layer;
-		push_overlay_size++;
-		return layer;
+		return queue_push(layer_op_type::PUSH_OVERLAY, layer, tick);
 	}
 
 	void client::pop_overlay()
 	{
-		pop_overlay_buffer++;
+		pending_layer_ops.push_back({ layer_op_type::POP_OVERLAY, invalid_layer, nullptr });
+	}
+
+	void client::remove_layer(layer_handle handle)
+	{
+		pending_layer_ops.push_back({ layer_op_type::REMOVE, handle, nullptr });
+	}
+
+	Layer* client::get_layer(layer_handle handle) const
+	{
+		const u32 idx = static_cast<u32>(handle & std::numeric_limits<u32>::max());
+		if (idx >= layer_slots.size() || layer_slots[idx].generation != static_cast<u32>(handle >> 32)) return nullptr;
+		return layer_slots[idx].layer;
 	}
 
 	void client::clear_layers()
 	{
-		pop_layer_buffer = n_layers;
+		pending_layer_ops.push_back({ layer_op_type::CLEAR, invalid_layer, nullptr });
+	}
+
+	void client::erase_layers(std::size_t first, std::size_t last)
+	{
+		//top to bottom, mirroring the push order
+		for (std::size_t i = last; i > first; i--)
+		{
+			const u32 idx = static_cast<u32>(stack_handles[i - 1] & std::numeric_limits<u32>::max());
+			layer_stack[i - 1].reset();
+			layer_slots[idx].layer = nullptr;
+			layer_slots[idx].generation++;
+			free_layer_slots.push_back(idx);
+		}
+		layer_stack.erase(layer_stack.begin() + first, layer_stack.begin() + last);
+		stack_handles.erase(stack_handles.begin() + first, stack_handles.begin() + last);
+		if (first < n_layers) n_layers -= std::min(last, n_layers) - first;
+	}
+
+	void client::apply_layer_ops()
+	{
+		if (pending_layer_ops.empty()) return;
+
+		//indexed loop, layer destructors are allowed to queue more operations
+		for (std::size_t i = 0; i < pending_layer_ops.size(); i++)
+		{
+			layer_op op = std::move(pending_layer_ops[i]);
+			switch (op.type)
+			{
+			case layer_op_type::PUSH_LAYER:
+				layer_stack.insert(layer_stack.begin() + n_layers, std::move(op.layer));
+				stack_handles.insert(stack_handles.begin() + n_layers, op.handle);
+				n_layers++;
+				break;
+			case layer_op_type::PUSH_OVERLAY:
+				layer_stack.push_back(std::move(op.layer));
+				stack_handles.push_back(op.handle);
+				break;
+			case layer_op_type::POP_LAYER:
+				if (n_layers) erase_layers(n_layers - 1, n_layers);
+				else LOG_INTERNAL_WARN("Tried to pop a layer from an empty layer stack");
+				break;
+			case layer_op_type::POP_OVERLAY:
+				if (layer_stack.size() > n_layers) erase_layers(layer_stack.size() - 1, layer_stack.size());
+				else LOG_INTERNAL_WARN("Tried to pop an overlay with no overlay pushed");
+				break;
+			case layer_op_type::REMOVE:
+			{
+				const auto it = std::find(stack_handles.begin(), stack_handles.end(), op.handle);
+				if (it != stack_handles.end())
+				{
+					const std::size_t position = it - stack_handles.begin();
+					erase_layers(position, position + 1);
+				}
+				break;
+			}
+			case layer_op_type::CLEAR:
+				erase_layers(0, n_layers);
+				break;
+			}
+		}
+		pending_layer_ops.clear();
+
+		tick_list.clear();
+		for (std::size_t i = 0; i < layer_stack.size(); i++)
+		{
+			const u32 idx = static_cast<u32>(stack_handles[i] & std::numeric_limits<u32>::max());
+			tick_list.push_back({ layer_slots[idx].tick, layer_stack[i].get() });
+		}
 	}
 
 	void client::handle_event()
 	{
-		for (index_t i = n_layers + n_overlays - 1; i != std::numeric_limits<index_t>::max(); i--)
+		for (std::size_t i = layer_stack.size(); i > 0; i--)
 		{
-			if (layer_stack[i]->handleEvent(event_buffer[event_start]))
+			if (layer_stack[i - 1]->handleEvent(event_buffer[event_start]))
 			{
 				return;
 			}
@@ -153,20 +240,26 @@ namespace ENGINE_NAMESPACE
 
 	void client::run()
 	{
-		index_t i, n;
-		Layer** t = nullptr;
-		std::chrono::high_resolution_clock::time_point current_frame;
+		timestamp current_frame;
 		while (running)
 		{
-			current_frame = std::chrono::high_resolution_clock::now();
-			delta_time = std::chrono::duration_cast<std::chrono::duration<time_t, std::chrono::seconds::period>>(current_frame - last_frame).count();
-			last_frame = std::move(current_frame);
+			current_frame = timestamp::now();
+			delta_time = current_frame - last_frame;
+			last_frame = current_frame;
+
+			if (replayer && !replayer->next_frame(delta_time, replay_events))
+			{
+				if (replayer->shutdown_on_end()) running = false;
+				replayer.reset();
+			}
 
 			elapsed_time += delta_time;
 
-			for (i = 0; i < n_layers + n_overlays; i++)
+			timers->advance(timestamp(elapsed_time));
+
+			for (const tick_entry& entry : tick_list)
 			{
-				layer_stack[i]->tick();
+				entry.tick(entry.layer);
 			}
 
 			window::tick();
@@ -177,61 +270,21 @@ namespace ENGINE_NAMESPACE
 				push_event(Event::windowResize(window_width, window_height));
 				window_size_changed = false;
 			}
+
+			for (const Event& e : replay_events) enqueue_event(e);
+			replay_events.clear();
 			
 			while (event_buffer_size > 0)
 			{
+				if (recorder) recorder->record(event_buffer[event_start]);
 				handle_event();
 				event_start = (event_start + 1) % event_buffer_capacity;
 				event_buffer_size--;
 			}
 
-			if (pop_overlay_buffer)
-			{
-				n = n_layers + n_overlays;
-				for (i = n - pop_overlay_buffer; i < n; i++) 
-				{
-					delete layer_stack[i];
-				}
-				n_overlays -= pop_overlay_buffer;
-				pop_overlay_buffer = 0;
-			}
-
-			if (pop_layer_buffer)
-			{
-				for (i = n_layers - pop_overlay_buffer; i < n_layers; i++)
-				{
-					delete layer_stack[i];
-				}
-				n_layers -= pop_layer_buffer;
-				std::memmove(&layer_stack[n_layers], &layer_stack[n_layers + pop_layer_buffer], sizeof(Layer*) * n_overlays);
-				pop_layer_buffer = 0;
-			}
-
-			if (push_layer_size || push_overlay_size)
-			{
-				n = push_layer_size + push_overlay_size + n_layers + n_overlays;
-				if (n > layer_stack_capacity)
-				{
-					layer_stack_capacity = (n / initial_stack_capacity + 1) * initial_stack_capacity;
-					layer_stack = t_realloc<Layer*>(layer_stack, layer_stack_capacity);
-				}
-
-				if (push_layer_size)
-				{
-					std::memmove(&layer_stack[n_layers + push_layer_size], &layer_stack[n_layers], sizeof(Layer*) * n_overlays);
-					std::memcpy(&layer_stack[n_layers], push_layer_buffer, sizeof(Layer*) * push_layer_size);
-					n_layers += push_layer_size;
-					push_layer_size = 0;
-				}
+			apply_layer_ops();
 
-				if (push_overlay_size)
-				{
-					n = n_layers + n_overlays;
-					std::memcpy(&layer_stack[n_layers + n_overlays], push_overlay_buffer, sizeof(Layer*) * push_overlay_size);
-					n_overlays += push_overlay_size;
-					push_overlay_size = 0;
-				}
-			}
+			if (recorder) recorder->end_frame(delta_time);
 		}
 	}
 
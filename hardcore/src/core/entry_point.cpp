@@ -18,8 +18,10 @@
 #endif // NDEBUG
 
 #include <core/entry_point_internal.hpp>
+#include <core/time_internal.hpp>
 
 #include <parallel/thread_manager.hpp>
+#include <io/async_internal.hpp>
 #include <debug/log_internal.hpp>
 
 #ifdef NDEBUG
@@ -49,12 +51,15 @@ namespace ENGINE_NAMESPACE
 		void init()
 		{
 			ENABLE_MEM_CHECKING;
+			calibrate_clock(); //before any other thread can read the clock
 			parallel::launch_threads();
 			ENGINE_NAMESPACE::log::init();
+			io::internal::init();
 		}
 
 		void terminate()
 		{
+			io::internal::terminate();
 			parallel::terminate_threads();
 			ENGINE_NAMESPACE::log::flush();
 			ENGINE_NAMESPACE::log::shutdown();
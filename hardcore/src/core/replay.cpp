@@ -0,0 +1,149 @@
+#include <pch.hpp>
+
+#include <core/replay_internal.hpp>
+
+#include <cstring>
+
+#include <debug/log_internal.hpp>
+
+namespace ENGINE_NAMESPACE
+{
+	template<typename Type>
+	inline void write_value(std::vector<u8>& buffer, Type value)
+	{
+		const std::size_t offset = buffer.size();
+		buffer.resize(offset + sizeof(Type));
+		std::memcpy(buffer.data() + offset, &value, sizeof(Type));
+	}
+
+	template<typename Type>
+	inline Type read_value(const u8* data, std::size_t& cursor)
+	{
+		Type value;
+		std::memcpy(&value, data + cursor, sizeof(Type));
+		cursor += sizeof(Type);
+		return value;
+	}
+
+	event_recorder::event_recorder(const char* filepath) : file(filepath, std::ios::out | std::ios::binary | std::ios::trunc)
+	{
+		if (!file.is_open())
+		{
+			LOG_INTERNAL_ERROR("Failed to open recording file: " << filepath);
+			return;
+		}
+
+		buffer.reserve(flush_threshold + KILOBYTES(4));
+		write_value<u32>(buffer, replay_format::magic);
+		write_value<u16>(buffer, replay_format::version);
+		write_value<u16>(buffer, 0);
+
+		LOG_INTERNAL_INFO("Recording events to: " << filepath);
+	}
+
+	event_recorder::~event_recorder()
+	{
+		flush();
+		if (file.is_open())
+		{
+			file.close();
+			LOG_INTERNAL_INFO("Recorded " << n_frames << " frames");
+		}
+	}
+
+	void event_recorder::record(const Event& e)
+	{
+		frame_events.push_back(e);
+	}
+
+	void event_recorder::end_frame(const duration& delta_time)
+	{
+		write_value<i64>(buffer, delta_time.count());
+		write_value<u16>(buffer, static_cast<u16>(frame_events.size()));
+		for (const Event& e : frame_events)
+		{
+			write_value<u16>(buffer, static_cast<u16>(e.type));
+			write_value<u16>(buffer, e.categories);
+			write_value<u64>(buffer, e.x.u);
+			write_value<u64>(buffer, e.y.u);
+		}
+		frame_events.clear();
+		n_frames++;
+
+		if (buffer.size() >= flush_threshold) flush();
+	}
+
+	void event_recorder::flush()
+	{
+		if (file.is_open() && !buffer.empty())
+		{
+			file.write(reinterpret_cast<const char*>(buffer.data()), buffer.size());
+		}
+		buffer.clear();
+	}
+
+	event_replayer::event_replayer(const char* filepath, const duration& fixed_delta, bool shutdown_on_end) :
+		fixed_delta(fixed_delta), end_shutdown(shutdown_on_end)
+	{
+		std::ifstream file(filepath, std::ios::in | std::ios::binary | std::ios::ate);
+		if (!file.is_open())
+		{
+			LOG_INTERNAL_ERROR("Failed to open recording file: " << filepath);
+			return;
+		}
+
+		data.resize(static_cast<std::size_t>(file.tellg()));
+		file.seekg(0);
+		file.read(reinterpret_cast<char*>(data.data()), data.size());
+		size = static_cast<std::size_t>(file.gcount());
+
+		if (size < replay_format::header_size || read_value<u32>(data.data(), cursor) != replay_format::magic)
+		{
+			LOG_INTERNAL_ERROR("Not a recording file: " << filepath);
+			cursor = size;
+			return;
+		}
+
+		const u16 version = read_value<u16>(data.data(), cursor);
+		cursor += sizeof(u16); //reserved
+		if (version != replay_format::version)
+		{
+			LOG_INTERNAL_ERROR("Unsupported recording version " << version << ": " << filepath);
+			cursor = size;
+			return;
+		}
+
+		LOG_INTERNAL_INFO("Replaying events from: " << filepath);
+	}
+
+	bool event_replayer::next_frame(duration& out_delta_time, std::vector<Event>& out_events)
+	{
+		if (size - cursor < replay_format::frame_header_size)
+		{
+			LOG_INTERNAL_INFO("Replay finished after " << n_frames << " frames");
+			return false;
+		}
+
+		const duration recorded_delta = duration::from_nanoseconds(read_value<i64>(data.data(), cursor));
+		const u16 n_events = read_value<u16>(data.data(), cursor);
+		if (size - cursor < n_events * replay_format::event_size)
+		{
+			LOG_INTERNAL_ERROR("Truncated recording, replay stopped after " << n_frames << " frames");
+			cursor = size;
+			return false;
+		}
+
+		out_delta_time = fixed_delta.count() ? fixed_delta : recorded_delta;
+		for (u16 i = 0; i < n_events; i++)
+		{
+			Event e;
+			e.type = static_cast<EventType>(read_value<u16>(data.data(), cursor));
+			e.categories = read_value<u16>(data.data(), cursor);
+			e.x.u = read_value<u64>(data.data(), cursor);
+			e.y.u = read_value<u64>(data.data(), cursor);
+			out_events.push_back(e);
+		}
+		n_frames++;
+		return true;
+	}
+}
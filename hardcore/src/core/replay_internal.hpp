@@ -0,0 +1,78 @@
+#pragma once
+
+#include <core/core.hpp>
+#include <core/time.hpp>
+#include <core/event.hpp>
+
+#include <fstream>
+#include <vector>
+
+namespace ENGINE_NAMESPACE
+{
+	/*
+	 * Recording file layout, all values are stored in native (little endian) byte order:
+	 *	header:	u32 magic | u16 version | u16 reserved
+	 *	frame:	i64 delta time in nanoseconds | u16 event count | event[event count]
+	 *	event:	u16 type | u16 categories | u64 x | u64 y
+	*/
+	namespace replay_format
+	{
+		const u32 magic = 0x50524348; //"HCRP"
+		const u16 version = 1;
+
+		const std::size_t header_size = sizeof(u32) + sizeof(u16) * 2;
+		const std::size_t frame_header_size = sizeof(i64) + sizeof(u16);
+		const std::size_t event_size = sizeof(u16) * 2 + sizeof(u64) * 2;
+	}
+
+	class event_recorder
+	{
+	public:
+		event_recorder(const char* filepath);
+		~event_recorder();
+
+		event_recorder(const event_recorder&) = delete;
+		event_recorder& operator=(const event_recorder&) = delete;
+
+		void record(const Event& e);
+		void end_frame(const duration& delta_time);
+
+	private:
+		static constexpr std::size_t flush_threshold = KILOBYTES(64);
+
+		std::ofstream file;
+		std::vector<u8> buffer;
+		std::vector<Event> frame_events;
+		u64 n_frames = 0;
+
+		void flush();
+	};
+
+	class event_replayer
+	{
+	public:
+		event_replayer(const char* filepath, const duration& fixed_delta, bool shutdown_on_end);
+
+		event_replayer(const event_replayer&) = delete;
+		event_replayer& operator=(const event_replayer&) = delete;
+
+		/**
+		 * @brief Reads the next recorded frame.
+		 * @param[out] out_delta_time Delta time to use for the frame.
+		 * @param[out] out_events Events to inject during the frame.
+		 * @return False if the recording has ended (or is invalid).
+		*/
+		bool next_frame(duration& out_delta_time, std::vector<Event>& out_events);
+
+		inline bool shutdown_on_end() const noexcept { return end_shutdown; }
+
+	private:
+		std::vector<u8> data;
+		std::size_t size = 0;
+		std::size_t cursor = 0;
+		u64 n_frames = 0;
+
+		duration fixed_delta;
+		bool end_shutdown;
+	};
+}
@@ -3,12 +3,14 @@
 #include <core/static_client.hpp>
 
 #include <core/client.hpp>
+#include <core/timer_wheel.hpp>
+#include <core/replay_internal.hpp>
 
 namespace ENGINE_NAMESPACE
 {
-	Layer* push_layer(Layer* layer)
+	layer_handle push_layer(Layer* layer, layer_tick_fn tick)
 	{
-		return client::instance->push_layer(layer);
+		return client::instance->push_layer(layer, tick);
 	}
 
 	void pop_layer()
@@ -16,9 +18,9 @@ namespace ENGINE_NAMESPACE
 		client::instance->pop_layer();
 	}
 
-	Layer* push_overlay(Layer* layer)
+	layer_handle push_overlay(Layer* layer, layer_tick_fn tick)
 	{
-		return client::instance->push_overlay(layer);
+		return client::instance->push_overlay(layer, tick);
 	}
 
 	void pop_overlay()
@@ -26,6 +28,16 @@ namespace ENGINE_NAMESPACE
 		client::instance->pop_overlay();
 	}
 
+	void remove_layer(layer_handle handle)
+	{
+		client::instance->remove_layer(handle);
+	}
+
+	Layer* get_layer(layer_handle handle)
+	{
+		return client::instance->get_layer(handle);
+	}
+
 	void clear_layers()
 	{
 		client::instance->clear_layers();
@@ -38,11 +50,55 @@ namespace ENGINE_NAMESPACE
 
 	time_t delta_time()
 	{
-		return client::instance->delta_time;
+		return client::instance->delta_time.seconds();
 	}
 
 	duration elapsed_time()
 	{
 		return client::instance->elapsed_time;
 	}
+
+	timer_handle schedule(const duration& delay, std::function<void()> callback, timer_target target)
+	{
+		return client::instance->timers->add(delay, 0, std::move(callback), target);
+	}
+
+	timer_handle schedule_recurring(const duration& interval, std::function<void()> callback, timer_target target)
+	{
+		return client::instance->timers->add(interval, interval, std::move(callback), target);
+	}
+
+	bool cancel_timer(timer_handle handle)
+	{
+		return client::instance->timers->cancel(handle);
+	}
+
+	namespace replay
+	{
+		void start_recording(const char* filepath)
+		{
+			client::instance->recorder.reset();
+			client::instance->recorder = std::make_unique<event_recorder>(filepath);
+		}
+
+		void stop_recording()
+		{
+			client::instance->recorder.reset();
+		}
+
+		void start_replay(const char* filepath, const duration& fixed_delta, bool shutdown_on_end)
+		{
+			client::instance->replayer = std::make_unique<event_replayer>(filepath, fixed_delta, shutdown_on_end);
+		}
+
+		void stop_replay()
+		{
+			client::instance->replayer.reset();
+		}
+
+		bool replaying()
+		{
+			return client::instance->replayer != nullptr;
+		}
+	}
 }
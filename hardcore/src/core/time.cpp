@@ -0,0 +1,121 @@
+#include <pch.hpp>
+
+#include <core/time.hpp>
+#include <core/time_internal.hpp>
+
+#include <debug/log_internal.hpp>
+
+#if defined(__x86_64__) || defined(_M_X64)
+#define TSC_CLOCK_AVAILABLE
+#ifdef _MSC_VER
+#include <intrin.h>
+#else
+#include <x86intrin.h>
+#include <cpuid.h>
+#endif // _MSC_VER
+#endif
+
+namespace ENGINE_NAMESPACE
+{
+	inline duration::rep steady_now() noexcept
+	{
+		return std::chrono::duration_cast<duration::chrono_t>(std::chrono::steady_clock::now().time_since_epoch()).count();
+	}
+
+#ifdef TSC_CLOCK_AVAILABLE
+	//ns = base_ns + (tsc - base_tsc) * tsc_mult / 2^32, tsc_mult == 0 means the TSC isn't used
+	u64 tsc_mult = 0;
+	u64 tsc_base = 0;
+	duration::rep tsc_base_ns = 0;
+
+	const auto tsc_calibration_time = std::chrono::milliseconds(20);
+
+	inline bool invariant_tsc() noexcept
+	{
+		//CPUID.80000007H:EDX[8], the TSC runs at a constant rate across P, C and T states
+#ifdef _MSC_VER
+		int regs[4];
+		__cpuid(regs, 0x80000000);
+		if (static_cast<u32>(regs[0]) < 0x80000007) return false;
+		__cpuid(regs, 0x80000007);
+		return regs[3] & BIT(8);
+#else
+		unsigned int eax, ebx, ecx, edx;
+		if (__get_cpuid_max(0x80000000, nullptr) < 0x80000007) return false;
+		__get_cpuid(0x80000007, &eax, &ebx, &ecx, &edx);
+		return edx & BIT(8);
+#endif // _MSC_VER
+	}
+
+	/**
+	 * @brief Samples the TSC and steady clock as close together as possible.
+	 * @param[out] out_ns Steady clock time at the moment the TSC was read.
+	 * @return TSC value.
+	*/
+	inline u64 paired_sample(duration::rep& out_ns) noexcept
+	{
+		duration::rep best_window = std::numeric_limits<duration::rep>::max();
+		u64 res = 0;
+		for (int i = 0; i < 8; i++)
+		{
+			const duration::rep before = steady_now();
+			const u64 tsc = __rdtsc();
+			const duration::rep after = steady_now();
+			if (after - before < best_window)
+			{
+				best_window = after - before;
+				out_ns = before + (after - before) / 2;
+				res = tsc;
+			}
+		}
+		return res;
+	}
+#endif // TSC_CLOCK_AVAILABLE
+
+	namespace internal
+	{
+		void calibrate_clock()
+		{
+#ifdef TSC_CLOCK_AVAILABLE
+			if (!invariant_tsc())
+			{
+				LOG_INTERNAL_INFO("No invariant TSC, using the steady clock");
+				return;
+			}
+
+			duration::rep start_ns, end_ns;
+			const u64 start_tsc = paired_sample(start_ns);
+			std::this_thread::sleep_for(tsc_calibration_time);
+			const u64 end_tsc = paired_sample(end_ns);
+
+			const long double ns_per_tick = end_tsc > start_tsc ?
+				static_cast<long double>(end_ns - start_ns) / (end_tsc - start_tsc) : 1.0L;
+			if (ns_per_tick >= 1.0L)
+			{
+				//below 1GHz the low half product in timestamp::now could overflow, the steady clock is good enough there
+				LOG_INTERNAL_INFO("Unsuitable TSC frequency, using the steady clock");
+				return;
+			}
+
+			tsc_base = paired_sample(tsc_base_ns);
+			tsc_mult = static_cast<u64>(ns_per_tick * BIT(32));
+
+			LOGF_INTERNAL_INFO("Calibrated TSC clock: {0} MHz", static_cast<double>(1000.0L / ns_per_tick));
+#endif // TSC_CLOCK_AVAILABLE
+		}
+	}
+
+	timestamp timestamp::now() noexcept
+	{
+#ifdef TSC_CLOCK_AVAILABLE
+		if (tsc_mult)
+		{
+			//split multiplication, keeps 64 bit arithmetic without overflowing for any sane uptime
+			const u64 delta = __rdtsc() - tsc_base;
+			const u64 ns = (delta >> 32) * tsc_mult + (((delta & 0xffffffff) * tsc_mult) >> 32);
+			return timestamp(duration::from_nanoseconds(tsc_base_ns + static_cast<duration::rep>(ns)));
+		}
+#endif // TSC_CLOCK_AVAILABLE
+		return timestamp(duration::from_nanoseconds(steady_now()));
+	}
+}
@@ -0,0 +1,15 @@
+#pragma once
+
+#include <core/core.hpp>
+
+namespace ENGINE_NAMESPACE
+{
+	namespace internal
+	{
+		/**
+		 * @brief Calibrates the TSC against the steady clock, if the TSC is invariant. Until this is called
+		 * timestamp::now reads the steady clock directly.
+		*/
+		void calibrate_clock();
+	}
+}
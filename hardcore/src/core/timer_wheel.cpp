@@ -0,0 +1,223 @@
+#include <pch.hpp>
+
+#include <core/timer_wheel.hpp>
+#include <parallel/task.hpp>
+
+#include <debug/log_internal.hpp>
+
+namespace ENGINE_NAMESPACE
+{
+	timer_wheel::timer_wheel(const timestamp& origin) : origin(origin)
+	{
+		slots.fill(invalid_node);
+	}
+
+	timer_wheel::~timer_wheel()
+	{
+		if (n_pending)
+		{
+			LOG_INTERNAL_INFO("Destroying timer wheel with " << n_pending << " pending timer(s)");
+		}
+	}
+
+	timer_wheel::node_idx_t timer_wheel::alloc_node()
+	{
+		node_idx_t idx;
+		if (free_head != invalid_node)
+		{
+			idx = free_head;
+			free_head = at(idx).next;
+		}
+		else
+		{
+			if ((n_nodes & (chunk_size - 1)) == 0)
+			{
+				chunks.push_back(std::make_unique<node[]>(chunk_size));
+			}
+			idx = n_nodes++;
+			at(idx).generation = 0;
+		}
+
+		node& n = at(idx);
+		n.generation = n.generation + 1 ? n.generation + 1 : 1;
+		n.prev = invalid_node;
+		n.next = invalid_node;
+		return idx;
+	}
+
+	void timer_wheel::free_node(node_idx_t idx)
+	{
+		node& n = at(idx);
+		n.callback = nullptr;
+		n.state = node_state::FREE;
+		n.next = free_head;
+		free_head = idx;
+		n_pending--;
+	}
+
+	void timer_wheel::link(node_idx_t idx)
+	{
+		node& n = at(idx);
+
+		//expiry is always at least one tick ahead when linking
+		const u64 delta = std::min(n.expiry - current_tick, max_delta);
+
+		u32 level = 0;
+		while (level < n_levels - 1 && delta >= BIT(level_bits * (level + 1))) level++;
+
+		const u64 slot_tick = delta == max_delta ? current_tick + max_delta : n.expiry;
+		n.slot = static_cast<u16>(level * slots_per_level + ((slot_tick >> (level * level_bits)) & slot_mask));
+
+		node_idx_t& head = slots[n.slot];
+		n.prev = invalid_node;
+		n.next = head;
+		if (head != invalid_node) at(head).prev = idx;
+		head = idx;
+		n.state = node_state::LINKED;
+	}
+
+	void timer_wheel::unlink(node_idx_t idx)
+	{
+		node& n = at(idx);
+		if (n.prev != invalid_node) at(n.prev).next = n.next;
+		else slots[n.slot] = n.next;
+		if (n.next != invalid_node) at(n.next).prev = n.prev;
+	}
+
+	timer_handle timer_wheel::add(const duration& delay, const duration& interval, std::function<void()>&& callback,
+		timer_target target)
+	{
+		const node_idx_t idx = alloc_node();
+		node& n = at(idx);
+
+		const i64 delay_ticks = std::max<i64>(delay.count() / resolution.count(), 1);
+		n.expiry = current_tick + static_cast<u64>(delay_ticks);
+		n.interval = interval.count() > 0 ? static_cast<u64>(std::max<i64>(interval.count() / resolution.count(), 1)) : 0;
+		n.callback = std::move(callback);
+		n.target = target;
+
+		link(idx);
+		n_pending++;
+		return make_handle(idx, n.generation);
+	}
+
+	bool timer_wheel::cancel(timer_handle handle)
+	{
+		const node_idx_t idx = static_cast<node_idx_t>(handle & std::numeric_limits<u32>::max());
+		const u32 generation = static_cast<u32>(handle >> 32);
+		if (idx >= n_nodes) return false;
+
+		node& n = at(idx);
+		if (n.generation != generation) return false;
+
+		switch (n.state)
+		{
+		case node_state::LINKED:
+			unlink(idx);
+			free_node(idx);
+			return true;
+		case node_state::FIRING:
+			n.state = node_state::CANCELLED;
+			return true;
+		default:
+			return false;
+		}
+	}
+
+	void timer_wheel::cascade(u32 level)
+	{
+		node_idx_t idx = slots[level * slots_per_level + ((current_tick >> (level * level_bits)) & slot_mask)];
+		slots[level * slots_per_level + ((current_tick >> (level * level_bits)) & slot_mask)] = invalid_node;
+		while (idx != invalid_node)
+		{
+			const node_idx_t next = at(idx).next;
+			if (at(idx).expiry <= current_tick)
+			{
+				//only possible for timers clamped into the last level
+				at(idx).state = node_state::FIRING;
+				expired.push_back(idx);
+			}
+			else
+			{
+				link(idx);
+			}
+			idx = next;
+		}
+	}
+
+	void timer_wheel::fire(node_idx_t idx)
+	{
+		node& n = at(idx);
+		if (n.state == node_state::FIRING)
+		{
+			if (n.target == timer_target::MAIN_THREAD)
+			{
+				n.callback();
+			}
+			else if (n.interval)
+			{
+				(void)parallel::immediate_async<void>(n.callback);
+			}
+			else
+			{
+				(void)parallel::immediate_async<void>(std::move(n.callback));
+			}
+		}
+
+		//the callback may have cancelled the timer
+		if (n.state == node_state::FIRING && n.interval)
+		{
+			n.expiry += n.interval;
+			if (n.expiry <= current_tick) n.expiry = current_tick + 1; //skip missed periods instead of bursting
+			link(idx);
+		}
+		else
+		{
+			free_node(idx);
+		}
+	}
+
+	void timer_wheel::advance(const timestamp& now)
+	{
+		const i64 elapsed = (now - origin).count() / resolution.count();
+		const u64 target_tick = elapsed > 0 ? static_cast<u64>(elapsed) : 0;
+
+		if (!n_pending)
+		{
+			current_tick = std::max(current_tick, target_tick);
+			return;
+		}
+
+		while (current_tick < target_tick)
+		{
+			current_tick++;
+
+			//cascade higher levels down once the lower level wraps around
+			for (u32 level = 1; level < n_levels; level++)
+			{
+				if ((current_tick >> ((level - 1) * level_bits)) & slot_mask) break;
+				cascade(level);
+			}
+
+			node_idx_t idx = slots[current_tick & slot_mask];
+			slots[current_tick & slot_mask] = invalid_node;
+			while (idx != invalid_node)
+			{
+				node& n = at(idx);
+				n.state = node_state::FIRING;
+				expired.push_back(idx);
+				idx = n.next;
+			}
+
+			//callbacks run after the slot is detached, so they are free to add or cancel any timer
+			for (std::size_t i = 0; i < expired.size(); i++) fire(expired[i]);
+			expired.clear();
+
+			if (!n_pending)
+			{
+				current_tick = target_tick;
+				break;
+			}
+		}
+	}
+}
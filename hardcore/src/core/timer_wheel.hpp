@@ -0,0 +1,103 @@
+#pragma once
+
+#include <core/core.hpp>
+#include <core/time.hpp>
+#include <core/timer.hpp>
+
+#include <memory>
+
+namespace ENGINE_NAMESPACE
+{
+	/**
+	 * @brief Hierarchical timer wheel (4 levels of 256 slots, 1ms ticks), insertion and cancellation are O(1).
+	 * Timers further away than the wheel span (~49 days) are parked in the last level and cascaded again.
+	 * Not thread safe, owned and advanced by the client loop.
+	*/
+	class timer_wheel
+	{
+	public:
+		timer_wheel(const timestamp& origin);
+		~timer_wheel();
+
+		timer_wheel(const timer_wheel&) = delete;
+		timer_wheel& operator=(const timer_wheel&) = delete;
+
+		timer_handle add(const duration& delay, const duration& interval, std::function<void()>&& callback,
+			timer_target target);
+		bool cancel(timer_handle handle);
+
+		/**
+		 * @brief Advances the wheel up to the given time, firing all expired timers.
+		 * @param now Current time.
+		*/
+		void advance(const timestamp& now);
+
+		inline u32 pending() const noexcept { return n_pending; }
+
+		static constexpr duration resolution = std::chrono::milliseconds(1);
+
+	private:
+		typedef u32 node_idx_t;
+		static constexpr node_idx_t invalid_node = std::numeric_limits<node_idx_t>::max();
+
+		static constexpr u32 level_bits = 8;
+		static constexpr u32 n_levels = 4;
+		static constexpr u32 slots_per_level = BIT(level_bits);
+		static constexpr u64 slot_mask = slots_per_level - 1;
+		static constexpr u64 max_delta = BIT(level_bits * n_levels) - 1;
+
+		//nodes are stored in fixed size chunks, so their addresses stay valid while callbacks add new timers
+		static constexpr u32 chunk_bits = 10;
+		static constexpr u32 chunk_size = BIT(chunk_bits);
+
+		enum class node_state : u8
+		{
+			FREE = 0,
+			LINKED,
+			FIRING,
+			CANCELLED, //cancelled while firing, freed once the callback returns
+		};
+
+		struct node
+		{
+			u64 expiry;
+			u64 interval; //in ticks, 0 for one shot timers
+			std::function<void()> callback;
+			node_idx_t prev;
+			node_idx_t next; //also used for the free list
+			u32 generation;
+			u16 slot;
+			node_state state;
+			timer_target target;
+		};
+
+		std::vector<std::unique_ptr<node[]>> chunks;
+		node_idx_t n_nodes = 0;
+		node_idx_t free_head = invalid_node;
+		u32 n_pending = 0;
+
+		std::array<node_idx_t, n_levels * slots_per_level> slots;
+
+		timestamp origin;
+		u64 current_tick = 0;
+
+		std::vector<node_idx_t> expired;
+
+		inline node& at(node_idx_t idx) noexcept { return chunks[idx >> chunk_bits][idx & (chunk_size - 1)]; }
+
+		node_idx_t alloc_node();
+		void free_node(node_idx_t idx);
+
+		void link(node_idx_t idx);
+		void unlink(node_idx_t idx);
+
+		void cascade(u32 level);
+		void fire(node_idx_t idx);
+
+		static inline timer_handle make_handle(node_idx_t idx, u32 generation) noexcept
+		{
+			//the generation is never 0, so a valid handle is never equal to invalid_timer
+			return (static_cast<u64>(generation) << 32) | idx;
+		}
+	};
+}
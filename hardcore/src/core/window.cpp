@@ -3,6 +3,8 @@
 #include <core/window.hpp>
 #include <core/window_internal.hpp>
 
+#include <cstring>
+
 #include <debug/log_internal.hpp>
 
 #include <GLFW/glfw3.h>
@@ -14,19 +16,34 @@ namespace ENGINE_NAMESPACE
 {
 	namespace window
 	{
-		GLFWwindow* window;
+		GLFWwindow* window = nullptr;
 		event_callback_t event_callback;
 		size_callback_t size_callback;
 
+		bool is_headless = false;
+		int headless_width = default_headless_width;
+		int headless_height = default_headless_height;
+
 		void errorCallback(int error, const char* description)
 		{
 			LOGF_INTERNAL_ERROR("GLFW Error ({0}): {1}", error, description);
 		}
 
-		void init(event_callback_t&& ec, size_callback_t&& sc)
+		void init(event_callback_t&& ec, size_callback_t&& sc, bool headless)
 		{
 			event_callback = ec;
 			size_callback = sc;
+
+			//set to anything but empty or 0, so HARDCORE_HEADLESS=0 keeps the window
+			const char* headless_var = std::getenv("HARDCORE_HEADLESS");
+			is_headless = headless || (headless_var && *headless_var && std::strcmp(headless_var, "0") != 0);
+			if (is_headless)
+			{
+				//no display connection is needed, GLFW is never initialized
+				LOGF_INTERNAL_INFO("Running headless ({0}x{1} offscreen target)", headless_width, headless_height);
+				return;
+			}
+
 			int init = glfwInit();
 			//SPRL_CORE_DEBUG("Attempted to initialize GLFW, code ({0})", init); //code 1 = good
 			glfwSetErrorCallback(errorCallback);
@@ -101,13 +118,15 @@ namespace ENGINE_NAMESPACE
 
 		void terminate()
 		{
+			if (is_headless) return;
 			glfwDestroyWindow(window);
 			glfwTerminate();
+			window = nullptr;
 		}
 
 		void tick()
 		{
-			glfwPollEvents();
+			if (!is_headless) glfwPollEvents();
 		}
 
 		GLFWwindow* get_handle()
@@ -117,12 +136,18 @@ namespace ENGINE_NAMESPACE
 
 		void get_dimensions(int* out_width, int* out_height)
 		{
+			if (is_headless)
+			{
+				*out_width = headless_width;
+				*out_height = headless_height;
+				return;
+			}
 			glfwGetFramebufferSize(window, out_width, out_height);
 		}
 
 		void set_title(const char* title)
 		{
-			glfwSetWindowTitle(window, title);
+			if (!is_headless) glfwSetWindowTitle(window, title);
 		}
 
 		void set_icon(const char** files, unsigned int num)
@@ -140,5 +165,22 @@ namespace ENGINE_NAMESPACE
 				stbi_image_free(images[i].pixels);
 			}*/
 		}
+
+		bool headless()
+		{
+			return is_headless;
+		}
+
+		void inject_event(Event&& e)
+		{
+			if (is_headless && e.type == EventType::WindowResize)
+			{
+				headless_width = static_cast<int>(e.x.i);
+				headless_height = static_cast<int>(e.y.i);
+				size_callback(headless_width, headless_height); //the client pushes the resize event itself
+				return;
+			}
+			event_callback(std::move(e));
+		}
 	}
 }
@@ -13,12 +13,19 @@ namespace ENGINE_NAMESPACE
 		typedef std::function<void(Event&&)> event_callback_t;
 		typedef std::function<void(int, int)> size_callback_t;
 
-		/**TODO
-		 * @brief 
-		 * @param ec 
-		 * @param sc 
+		//dimensions of the offscreen render target when running headless
+		const int default_headless_width = 1080;
+		const int default_headless_height = 720;
+
+		/**
+		 * @brief Initializes the window, or the null window if running headless.
+		 * Headless mode is used if requested, or if the HARDCORE_HEADLESS environment variable is set to
+		 * anything but 0 or an empty value.
+		 * @param ec Callback receiving window and input events.
+		 * @param sc Callback receiving window size changes.
+		 * @param headless Skips GLFW entirely and runs without a window or display.
 		*/
-		void init(event_callback_t&& ec, size_callback_t&& sc);
+		void init(event_callback_t&& ec, size_callback_t&& sc, bool headless = false);
 
 		/**TODO
 		 * @brief 
@@ -30,9 +37,9 @@ namespace ENGINE_NAMESPACE
 		*/
 		void tick();
 
-		/**TODO
-		 * @brief 
-		 * @return 
+		/**
+		 * @brief Retrieves the GLFW window handle.
+		 * @return The window handle, nullptr if running headless.
 		*/
 		GLFWwindow* get_handle();
 	}
@@ -0,0 +1,454 @@
+#include <pch.hpp>
+
+#include <io/async.hpp>
+#include <io/async_internal.hpp>
+#include <io/native_file.hpp>
+#include <parallel/task.hpp>
+
+#include <cstring>
+
+#include <debug/log_internal.hpp>
+
+#if defined(__linux__) && __has_include(<linux/io_uring.h>)
+#define IO_URING_AVAILABLE
+#include <linux/io_uring.h>
+#include <unistd.h>
+#include <sys/eventfd.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#endif
+
+namespace ENGINE_NAMESPACE
+{
+	namespace io
+	{
+		struct pending_read
+		{
+			std::string filepath;
+			u64 offset;
+			std::size_t size;
+			std::promise<read_result> promise;
+
+			std::shared_ptr<const native_file> file; //opened by the I/O service unless the caller already had it open
+
+			read_result result;
+			std::size_t done = 0;
+		};
+
+		inline void complete(pending_read* read)
+		{
+			read->result.size = read->done;
+			read->promise.set_value(std::move(read->result));
+			delete read;
+		}
+
+		inline void fail(pending_read* read, const char* message)
+		{
+			LOG_INTERNAL_ERROR(message << ": " << read->filepath);
+			read->promise.set_exception(std::make_exception_ptr(exception::io_error(message + (": " + read->filepath))));
+			delete read;
+		}
+
+		/**
+		 * @brief Clamps the requested range to the file size and allocates the destination buffer.
+		 * @return False if there is nothing to read.
+		*/
+		inline bool prepare(pending_read* read, u64 filesize)
+		{
+			const u64 available = read->offset < filesize ? filesize - read->offset : 0;
+			if (!read->size || read->size > available) read->size = static_cast<std::size_t>(available);
+			if (!read->size) return false;
+
+			read->result.data = std::unique_ptr<u8[]>(new u8[read->size]);
+			return true;
+		}
+
+		//fallback path, executed by a background worker
+		void read_blocking(pending_read* read)
+		{
+			if (!read->file) read->file = std::make_shared<const native_file>(read->filepath.c_str(), true);
+			if (!read->file->is_open())
+			{
+				fail(read, "Failed to open file");
+				return;
+			}
+
+			if (prepare(read, read->file->size()))
+			{
+				const i64 n_read = read->file->read_at(read->result.data.get(), read->size, read->offset);
+				if (n_read < 0)
+				{
+					fail(read, "Failed to read file");
+					return;
+				}
+				read->done = static_cast<std::size_t>(n_read);
+			}
+			complete(read);
+		}
+
+#ifdef IO_URING_AVAILABLE
+		/**
+		 * @brief Owns an io_uring instance and the thread submitting reads to it and reaping their completions.
+		 * Files are opened on the service thread, the reads themselves are fully asynchronous.
+		*/
+		class uring_service
+		{
+		public:
+			bool init(u32 n_entries);
+			void terminate();
+
+			void submit(std::vector<pending_read*>& reads);
+
+		private:
+			static constexpr u64 wake_tag = 0; //user_data of the eventfd read, reads use their address
+			static constexpr std::size_t max_chunk = GIGABYTES(1); //a single read is limited to 32 bits
+
+			int ring_fd = -1;
+			int event_fd = -1;
+			u64 event_value = 0;
+
+			void* sq_ring = MAP_FAILED;
+			std::size_t sq_ring_size = 0;
+			void* cq_ring = MAP_FAILED;
+			std::size_t cq_ring_size = 0;
+			io_uring_sqe* sqes = static_cast<io_uring_sqe*>(MAP_FAILED);
+			std::size_t sqes_size = 0;
+
+			u32* sq_head = nullptr;
+			u32* sq_tail = nullptr;
+			u32 sq_mask = 0;
+			u32* sq_array = nullptr;
+			u32 sq_entries = 0;
+			u32* cq_head = nullptr;
+			u32* cq_tail = nullptr;
+			u32 cq_mask = 0;
+			io_uring_cqe* cqes = nullptr;
+
+			u32 local_tail = 0;
+			u32 to_submit = 0;
+			u32 in_flight = 0;
+
+			std::thread thread;
+			std::mutex access;
+			std::vector<pending_read*> incoming;
+			std::vector<pending_read*> backlog;
+			std::atomic<bool> running = false;
+
+			void run();
+			void wake();
+			bool probe_read();
+
+			io_uring_sqe* next_sqe();
+			void push_wake_read();
+			bool issue(pending_read* read);
+			void reap(const io_uring_cqe& cqe);
+		};
+
+		bool uring_service::init(u32 n_entries)
+		{
+			io_uring_params params = {};
+			ring_fd = static_cast<int>(syscall(__NR_io_uring_setup, n_entries, &params));
+			if (ring_fd < 0) return false;
+
+			//IORING_OP_READ needs linux 5.6, older kernels can set up a ring but also reject the probe
+			if (!probe_read())
+			{
+				terminate();
+				return false;
+			}
+
+			sq_ring_size = params.sq_off.array + params.sq_entries * sizeof(u32);
+			cq_ring_size = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+			sqes_size = params.sq_entries * sizeof(io_uring_sqe);
+
+			sq_ring = mmap(nullptr, sq_ring_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring_fd, IORING_OFF_SQ_RING);
+			cq_ring = mmap(nullptr, cq_ring_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring_fd, IORING_OFF_CQ_RING);
+			sqes = static_cast<io_uring_sqe*>(mmap(nullptr, sqes_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+				ring_fd, IORING_OFF_SQES));
+			event_fd = eventfd(0, EFD_CLOEXEC);
+			if (sq_ring == MAP_FAILED || cq_ring == MAP_FAILED || sqes == MAP_FAILED || event_fd < 0)
+			{
+				terminate();
+				return false;
+			}
+
+			u8* sq = static_cast<u8*>(sq_ring);
+			sq_head = reinterpret_cast<u32*>(sq + params.sq_off.head);
+			sq_tail = reinterpret_cast<u32*>(sq + params.sq_off.tail);
+			sq_mask = *reinterpret_cast<u32*>(sq + params.sq_off.ring_mask);
+			sq_array = reinterpret_cast<u32*>(sq + params.sq_off.array);
+			sq_entries = params.sq_entries;
+
+			u8* cq = static_cast<u8*>(cq_ring);
+			cq_head = reinterpret_cast<u32*>(cq + params.cq_off.head);
+			cq_tail = reinterpret_cast<u32*>(cq + params.cq_off.tail);
+			cq_mask = *reinterpret_cast<u32*>(cq + params.cq_off.ring_mask);
+			cqes = reinterpret_cast<io_uring_cqe*>(cq + params.cq_off.cqes);
+
+			running = true;
+			thread = std::thread(&uring_service::run, this);
+			return true;
+		}
+
+		bool uring_service::probe_read()
+		{
+			constexpr u32 n_ops = 256;
+			std::vector<u8> buffer(sizeof(io_uring_probe) + n_ops * sizeof(io_uring_probe_op));
+			io_uring_probe* probe = reinterpret_cast<io_uring_probe*>(buffer.data());
+			if (syscall(__NR_io_uring_register, ring_fd, IORING_REGISTER_PROBE, probe, n_ops) < 0) return false;
+
+			return IORING_OP_READ <= probe->last_op && (probe->ops[IORING_OP_READ].flags & IO_URING_OP_SUPPORTED);
+		}
+
+		void uring_service::terminate()
+		{
+			if (thread.joinable())
+			{
+				running = false;
+				wake();
+				thread.join();
+			}
+
+			if (sqes != MAP_FAILED) munmap(sqes, sqes_size);
+			if (cq_ring != MAP_FAILED) munmap(cq_ring, cq_ring_size);
+			if (sq_ring != MAP_FAILED) munmap(sq_ring, sq_ring_size);
+			if (event_fd >= 0) ::close(event_fd);
+			if (ring_fd >= 0) ::close(ring_fd);
+			sqes = static_cast<io_uring_sqe*>(MAP_FAILED);
+			cq_ring = MAP_FAILED;
+			sq_ring = MAP_FAILED;
+			event_fd = -1;
+			ring_fd = -1;
+		}
+
+		void uring_service::submit(std::vector<pending_read*>& reads)
+		{
+			{
+				std::lock_guard<std::mutex> lock(access);
+				incoming.insert(incoming.end(), reads.begin(), reads.end());
+			}
+			wake();
+		}
+
+		void uring_service::wake()
+		{
+			const u64 value = 1;
+			while (write(event_fd, &value, sizeof(value)) < 0 && errno == EINTR);
+		}
+
+		io_uring_sqe* uring_service::next_sqe()
+		{
+			//the service thread is the only producer, and in_flight never exceeds the ring size
+			const u32 idx = local_tail & sq_mask;
+			sq_array[idx] = idx;
+			local_tail++;
+			to_submit++;
+
+			io_uring_sqe* sqe = &sqes[idx];
+			std::memset(sqe, 0, sizeof(io_uring_sqe));
+			in_flight++;
+			return sqe;
+		}
+
+		void uring_service::push_wake_read()
+		{
+			io_uring_sqe* sqe = next_sqe();
+			sqe->opcode = IORING_OP_READ;
+			sqe->fd = event_fd;
+			sqe->addr = reinterpret_cast<u64>(&event_value);
+			sqe->len = sizeof(event_value);
+			sqe->user_data = wake_tag;
+		}
+
+		bool uring_service::issue(pending_read* read)
+		{
+			if (in_flight >= sq_entries) return false;
+
+			//first issue of this read, later ones continue a short read
+			if (!read->result.data)
+			{
+				if (!read->file) read->file = std::make_shared<const native_file>(read->filepath.c_str(), true);
+				if (!read->file->is_open())
+				{
+					fail(read, "Failed to open file");
+					return true;
+				}
+
+				if (!prepare(read, read->file->size()))
+				{
+					complete(read);
+					return true;
+				}
+			}
+
+			io_uring_sqe* sqe = next_sqe();
+			sqe->opcode = IORING_OP_READ;
+			sqe->fd = read->file->native_handle();
+			sqe->off = read->offset + read->done;
+			sqe->addr = reinterpret_cast<u64>(read->result.data.get() + read->done);
+			sqe->len = static_cast<u32>(std::min(read->size - read->done, max_chunk));
+			sqe->user_data = reinterpret_cast<u64>(read);
+			return true;
+		}
+
+		void uring_service::reap(const io_uring_cqe& cqe)
+		{
+			in_flight--;
+
+			if (cqe.user_data == wake_tag)
+			{
+				{
+					std::lock_guard<std::mutex> lock(access);
+					backlog.insert(backlog.end(), incoming.begin(), incoming.end());
+					incoming.clear();
+				}
+				if (running) push_wake_read();
+				return;
+			}
+
+			pending_read* read = reinterpret_cast<pending_read*>(cqe.user_data);
+			if (cqe.res < 0 && cqe.res != -EINTR && cqe.res != -EAGAIN)
+			{
+				fail(read, "Failed to read file");
+				return;
+			}
+
+			if (cqe.res > 0) read->done += static_cast<std::size_t>(cqe.res);
+			if (cqe.res == 0 || read->done == read->size)
+			{
+				complete(read);
+				return;
+			}
+
+			//short read, the rest is submitted again
+			backlog.push_back(read);
+		}
+
+		void uring_service::run()
+		{
+			LOG_INTERNAL_INFO("Launched io_uring thread (ID: " << std::this_thread::get_id() << ")");
+
+			local_tail = *sq_tail;
+			push_wake_read();
+			std::size_t first = 0;
+			while (true)
+			{
+				while (first < backlog.size() && issue(backlog[first])) first++;
+				if (first == backlog.size())
+				{
+					backlog.clear();
+					first = 0;
+				}
+
+				//the eventfd read is only left disarmed once stopping, then everything submitted has completed
+				if (!in_flight && backlog.empty()) break;
+
+				std::atomic_ref<u32>(*sq_tail).store(local_tail, std::memory_order_release);
+				const int submitted = static_cast<int>(syscall(__NR_io_uring_enter, ring_fd, to_submit, 1,
+					IORING_ENTER_GETEVENTS, nullptr, 0));
+				if (submitted < 0)
+				{
+					if (errno == EINTR || errno == EAGAIN || errno == EBUSY) continue;
+					CRASH("io_uring_enter failed");
+				}
+				to_submit -= static_cast<u32>(submitted);
+
+				u32 head = *cq_head;
+				const u32 tail = std::atomic_ref<u32>(*cq_tail).load(std::memory_order_acquire);
+				while (head != tail)
+				{
+					reap(cqes[head & cq_mask]);
+					head++;
+				}
+				std::atomic_ref<u32>(*cq_head).store(head, std::memory_order_release);
+			}
+
+			LOG_INTERNAL_INFO("io_uring thread exiting (ID: " << std::this_thread::get_id() << ")");
+		}
+
+		uring_service* uring = nullptr;
+#endif // IO_URING_AVAILABLE
+
+		void submit(std::vector<pending_read*>& reads)
+		{
+#ifdef IO_URING_AVAILABLE
+			if (uring)
+			{
+				uring->submit(reads);
+				return;
+			}
+#endif // IO_URING_AVAILABLE
+			for (pending_read* read : reads)
+			{
+				(void)parallel::background_async<void>([read]() { read_blocking(read); });
+			}
+		}
+
+		std::future<read_result> read_async(const char* filepath, u64 offset, std::size_t size)
+		{
+			const read_request request = { filepath, offset, size };
+			return std::move(read_batch(&request, 1)[0]);
+		}
+
+		std::future<read_result> read_async(std::shared_ptr<const native_file> file, const char* filepath, u64 offset,
+			std::size_t size)
+		{
+			pending_read* read = new pending_read{ filepath, offset, size };
+			read->file = std::move(file);
+			std::future<read_result> future = read->promise.get_future();
+			std::vector<pending_read*> reads(1, read);
+			submit(reads);
+			return future;
+		}
+
+		std::vector<std::future<read_result>> read_batch(const read_request* requests, std::size_t n_requests)
+		{
+			std::vector<std::future<read_result>> futures;
+			std::vector<pending_read*> reads;
+			futures.reserve(n_requests);
+			reads.reserve(n_requests);
+			for (std::size_t i = 0; i < n_requests; i++)
+			{
+				pending_read* read = new pending_read{ requests[i].filepath, requests[i].offset, requests[i].size };
+				futures.push_back(read->promise.get_future());
+				reads.push_back(read);
+			}
+			submit(reads);
+			return futures;
+		}
+
+		namespace internal
+		{
+			void init()
+			{
+#ifdef IO_URING_AVAILABLE
+				if (std::getenv("HARDCORE_NO_IO_URING"))
+				{
+					LOG_INTERNAL_INFO("io_uring disabled, file reads are executed by the background workers");
+					return;
+				}
+
+				uring = new uring_service();
+				if (!uring->init(256))
+				{
+					LOG_INTERNAL_WARN("io_uring is not available, file reads are executed by the background workers");
+					delete uring;
+					uring = nullptr;
+				}
+#endif // IO_URING_AVAILABLE
+			}
+
+			void terminate()
+			{
+#ifdef IO_URING_AVAILABLE
+				if (uring)
+				{
+					uring->terminate();
+					delete uring;
+					uring = nullptr;
+				}
+#endif // IO_URING_AVAILABLE
+			}
+		}
+	}
+}
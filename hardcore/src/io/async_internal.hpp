@@ -0,0 +1,38 @@
+#pragma once
+
+#include <core/core.hpp>
+#include <io/async.hpp>
+
+namespace ENGINE_NAMESPACE
+{
+	namespace io
+	{
+		class native_file;
+
+		/**
+		 * @brief Reads part of an already open file asynchronously, without opening it again.
+		 * @param file Open file, kept alive until the read completes.
+		 * @param filepath Path of the file, only used in error messages.
+		 * @param offset Offset in bytes of the first byte to read.
+		 * @param size Number of bytes to read, 0 to read up to the end of the file.
+		 * @return std::future object which will contain the data once it has been read, or an exception::io_error.
+		*/
+		std::future<read_result> read_async(std::shared_ptr<const native_file> file, const char* filepath, u64 offset,
+			std::size_t size);
+
+		namespace internal
+		{
+			/**
+			 * @brief Starts the asynchronous I/O service, using io_uring if available.
+			 * The HARDCORE_NO_IO_URING environment variable forces the worker thread fallback.
+			*/
+			void init();
+
+			/**
+			 * @brief Completes all submitted reads, then stops the asynchronous I/O service.
+			 * Must be called before the worker threads are terminated.
+			*/
+			void terminate();
+		}
+	}
+}
@@ -0,0 +1,193 @@
+#include <pch.hpp>
+
+#include <io/compression.hpp>
+#include <parallel/task.hpp>
+#include <parallel/thread_manager.hpp>
+
+#include <cstring>
+
+#include <debug/log_internal.hpp>
+
+namespace ENGINE_NAMESPACE
+{
+	namespace io
+	{
+		//bounds checked LZ4 block decoder, fails instead of reading or writing out of range on corrupted input
+		inline bool lz4_decompress_block(const u8* src, std::size_t src_size, u8* dst, std::size_t dst_size) noexcept
+		{
+			const u8* ip = src;
+			const u8* const iend = src + src_size;
+			u8* op = dst;
+			u8* const oend = dst + dst_size;
+
+			auto read_length = [&](std::size_t length) -> std::size_t
+				{
+					u8 byte;
+					do
+					{
+						if (ip == iend) return std::numeric_limits<std::size_t>::max();
+						byte = *ip++;
+						length += byte;
+					} while (byte == 255);
+					return length;
+				};
+
+			while (ip < iend)
+			{
+				const u8 token = *ip++;
+
+				std::size_t n_literals = token >> 4;
+				if (n_literals == 15) n_literals = read_length(n_literals);
+				if (n_literals > static_cast<std::size_t>(iend - ip) || n_literals > static_cast<std::size_t>(oend - op))
+					return false;
+				std::memcpy(op, ip, n_literals);
+				ip += n_literals;
+				op += n_literals;
+
+				//the last sequence only holds literals
+				if (ip == iend) break;
+
+				if (iend - ip < 2) return false;
+				const std::size_t match_offset = ip[0] | (static_cast<std::size_t>(ip[1]) << 8);
+				ip += 2;
+				if (!match_offset || match_offset > static_cast<std::size_t>(op - dst)) return false;
+
+				std::size_t match_length = token & 15;
+				if (match_length == 15) match_length = read_length(match_length);
+				if (match_length == std::numeric_limits<std::size_t>::max()) return false;
+				match_length += 4;
+				if (match_length > static_cast<std::size_t>(oend - op)) return false;
+
+				const u8* match = op - match_offset;
+				if (match_offset >= match_length)
+				{
+					std::memcpy(op, match, match_length);
+					op += match_length;
+				}
+				else
+				{
+					//overlapping match, repeats the last match_offset bytes
+					for (std::size_t i = 0; i < match_length; i++) *op++ = *match++;
+				}
+			}
+			return op == oend;
+		}
+
+		struct decompress_job
+		{
+			const u8* src;
+			std::size_t src_size;
+			u8* dst;
+			compressed_format::header header;
+			const u8* index;
+
+			std::atomic<u32> next_block = 0;
+			std::atomic<u32> n_done = 0;
+			std::atomic<bool> failed = false;
+
+			bool decode(u32 idx) const noexcept
+			{
+				//the index is not necessarily aligned within the source
+				compressed_format::block b;
+				std::memcpy(&b, index + static_cast<std::size_t>(idx) * sizeof(b), sizeof(b));
+				const u64 dst_offset = static_cast<u64>(idx) * header.block_size;
+				const std::size_t dst_size = static_cast<std::size_t>(std::min<u64>(header.block_size, header.size - dst_offset));
+				if (b.offset > src_size || b.compressed_size > src_size - b.offset) return false;
+
+				if (b.flags & compressed_format::STORED_BIT)
+				{
+					if (b.compressed_size != dst_size) return false;
+					std::memcpy(dst + dst_offset, src + b.offset, dst_size);
+					return true;
+				}
+				return lz4_decompress_block(src + b.offset, b.compressed_size, dst + dst_offset, dst_size);
+			}
+
+			//shared by the workers and the calling thread, blocks are claimed one at a time
+			void run() noexcept
+			{
+				u32 idx;
+				while ((idx = next_block.fetch_add(1, std::memory_order_relaxed)) < header.n_blocks)
+				{
+					if (!failed.load(std::memory_order_relaxed) && !decode(idx))
+						failed.store(true, std::memory_order_relaxed);
+					if (n_done.fetch_add(1, std::memory_order_acq_rel) + 1 == header.n_blocks) n_done.notify_all();
+				}
+			}
+		};
+
+		inline bool read_header(const void* data, std::size_t size, compressed_format::header& out_header) noexcept
+		{
+			if (size < sizeof(compressed_format::header)) return false;
+			std::memcpy(&out_header, data, sizeof(compressed_format::header));
+			return out_header.magic == compressed_format::magic;
+		}
+
+		bool is_compressed(const void* data, std::size_t size) noexcept
+		{
+			compressed_format::header header;
+			return read_header(data, size, header);
+		}
+
+		u64 decompressed_size(const void* data, std::size_t size) noexcept
+		{
+			compressed_format::header header;
+			return read_header(data, size, header) ? header.size : 0;
+		}
+
+		bool decompress(const void* src, std::size_t src_size, void* dst, std::size_t dst_size)
+		{
+			std::shared_ptr<decompress_job> job = std::make_shared<decompress_job>();
+			if (!read_header(src, src_size, job->header))
+			{
+				LOG_INTERNAL_ERROR("Data is not a compressed container");
+				return false;
+			}
+
+			const compressed_format::header& header = job->header;
+			const u64 index_end = sizeof(header) + static_cast<u64>(header.n_blocks) * sizeof(compressed_format::block);
+			if (header.version != compressed_format::version || header.codec != compressed_format::LZ4 ||
+				!header.block_size || index_end > src_size ||
+				static_cast<u64>(header.n_blocks) * header.block_size < header.size ||
+				(header.n_blocks && static_cast<u64>(header.n_blocks - 1) * header.block_size >= header.size))
+			{
+				LOG_INTERNAL_ERROR("Unsupported or corrupted compressed container (version " << header.version << ", codec "
+					<< static_cast<u32>(header.codec) << ')');
+				return false;
+			}
+			if (header.size > dst_size)
+			{
+				LOG_INTERNAL_ERROR("Decompressed data (" << header.size << " bytes) does not fit in destination ("
+					<< dst_size << " bytes)");
+				return false;
+			}
+			if (!header.n_blocks) return true;
+
+			job->src = static_cast<const u8*>(src);
+			job->src_size = src_size;
+			job->dst = static_cast<u8*>(dst);
+			job->index = job->src + sizeof(header);
+
+			//workers which start after all blocks were claimed return straight away, the job outlives them
+			const u32 n_helpers = std::min(header.n_blocks - 1, parallel::immediate_worker_count());
+			for (u32 i = 0; i < n_helpers; i++)
+			{
+				(void)parallel::immediate_async<void>([job]() { job->run(); });
+			}
+			job->run();
+
+			u32 n_done;
+			while ((n_done = job->n_done.load(std::memory_order_acquire)) < header.n_blocks)
+			{
+				job->n_done.wait(n_done, std::memory_order_acquire);
+			}
+
+			if (job->failed.load(std::memory_order_relaxed))
+			{
+				LOG_INTERNAL_ERROR("Corrupted block in compressed container");
+				return false;
+			}
+			return true;
+		}
+	}
+}
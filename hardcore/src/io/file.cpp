@@ -1,31 +1,82 @@
 #include <pch.hpp>
 
 #include <io/file.hpp>
+#include <io/file_internal.hpp>
+#include <io/mapped_file.hpp>
+#include <io/compression.hpp>
+
+#include <sstream>
 
 #include <debug/log_internal.hpp>
 
+#ifdef _MSC_VER
+#include <process.h>
+#else
+#include <unistd.h>
+#endif // _MSC_VER
+
 namespace ENGINE_NAMESPACE
 {
-	void* read_binary_file(const char* filepath, std::size_t& out_filesize)
+	//compressed containers are decompressed straight from a mapping of the file, so only the output is allocated
+	static void* read_compressed_file(const char* filepath, std::size_t& out_filesize, bool fatal)
+	{
+		out_filesize = 0;
+
+		io::mapped_file compressed(filepath, io::map_mode::READ_ONLY, io::SEQUENTIAL_BIT);
+		if (!compressed.is_open())
+		{
+			if (fatal) { CRASH("Failed to map file"); }
+			return nullptr;
+		}
+
+		const u64 size = io::decompressed_size(compressed.data(), compressed.size());
+		if (std::numeric_limits<std::size_t>::max() < size)
+		{
+			if (!fatal) return nullptr;
+			CRASH("File too big");
+		}
+
+		char* filedata = t_malloc<char>(static_cast<std::size_t>(size));
+		if (!io::decompress(compressed.data(), compressed.size(), filedata, static_cast<std::size_t>(size)))
+		{
+			LOG_INTERNAL_ERROR("Failed to decompress file: " << filepath);
+			if (fatal) DEBUG_BREAK;
+			std::free(filedata);
+			return nullptr;
+		}
+
+		out_filesize = static_cast<std::size_t>(size);
+		return filedata;
+	}
+
+	//fatal failures crash, otherwise every failure returns nullptr
+	static void* read_file(const char* filepath, std::size_t& out_filesize, bool fatal)
 	{
 		std::filesystem::path path(filepath);
+		out_filesize = 0;
 
-		if (!std::filesystem::is_regular_file(path))
+		std::error_code error;
+		if (!std::filesystem::is_regular_file(path, error))
 		{
+			if (!fatal) return nullptr;
 			LOG_INTERNAL_ERROR("Path is not a regular file, or does not exist: " << filepath);
 			DEBUG_BREAK;
-			out_filesize = 0;
 			return nullptr;
 		}
 
-		const std::uintmax_t filesize_mt = std::filesystem::file_size(path);
+		const std::uintmax_t filesize_mt = std::filesystem::file_size(path, error);
+		if (error) 
+		{
+			if (fatal) { CRASH("Failed to get file size"); }
+			return nullptr;
+		}
 
 		if (std::numeric_limits<std::size_t>::max() < filesize_mt)
 		{
 			//This function is meant to read a whole files contents and put them into a single buffer in memory,
 			//if a file is larger than the maximum size_t, then a different method to read the file should probably be
 			//used anyways
-			DEBUG_BREAK;
+			if (!fatal) return nullptr;
 			CRASH("File too big");
 		}
 
@@ -34,22 +85,110 @@ namespace ENGINE_NAMESPACE
 		std::ifstream file(path, std::ios::in | std::ios::binary);
 		if (!file.is_open())
 		{
-			CRASH("Failed to open file");
+			if (fatal) { CRASH("Failed to open file"); }
+			return nullptr;
+		}
+
+		compressed_format::header header;
+		if (filesize >= sizeof(header) && file.read(reinterpret_cast<char*>(&header), sizeof(header)) &&
+			header.magic == compressed_format::magic)
+		{
+			file.close();
+			return read_compressed_file(filepath, out_filesize, fatal);
 		}
+		file.clear();
+		file.seekg(0);
 
 		char* filedata = t_malloc<char>(filesize);
 
 		constexpr std::size_t streamsize_max = std::numeric_limits<std::streamsize>::max();
 		std::size_t offset = 0;
 
-		while (file.read(filedata + offset, streamsize_max))
-			offset += streamsize_max;
-
-		INTERNAL_ASSERT(file.eof(), "Did not reach end of file");
+		while (offset < filesize)
+		{
+			const std::size_t chunk = std::min(filesize - offset, streamsize_max);
+			if (!file.read(filedata + offset, static_cast<std::streamsize>(chunk)))
+			{
+				break;
+			}
+			offset += chunk;
+		}
 
 		file.close();
 
+		//the file may have been truncated since its size was read
+		if (offset != filesize)
+		{
+			INTERNAL_ASSERT(!fatal, "Did not reach end of file");
+			std::free(filedata);
+			return nullptr;
+		}
+
 		out_filesize = filesize;
 		return filedata;
 	}
+
+	void* read_binary_file(const char* filepath, std::size_t& out_filesize)
+	{
+		return read_file(filepath, out_filesize, true);
+	}
+
+	void* try_read_binary_file(const char* filepath, std::size_t& out_filesize) noexcept
+	{
+		try
+		{
+			return read_file(filepath, out_filesize, false);
+		}
+		catch (const std::exception&)
+		{
+			out_filesize = 0;
+			return nullptr;
+		}
+	}
+
+	namespace io
+	{
+		bool write_file_atomic(const std::filesystem::path& path, const void* data, std::size_t size)
+		{
+			std::error_code error;
+			if (path.has_parent_path()) std::filesystem::create_directories(path.parent_path(), error);
+
+			//unique per process, thread and call, so concurrent writers of the same file never share a temporary file
+#ifdef _MSC_VER
+			const int process_id = _getpid();
+#else
+			const int process_id = static_cast<int>(getpid());
+#endif // _MSC_VER
+			std::stringstream tmp_name;
+			tmp_name << path.filename().string() << '.' << process_id << '.' << std::this_thread::get_id() << '.'
+				<< std::chrono::steady_clock::now().time_since_epoch().count() << ".tmp";
+			const std::filesystem::path tmp_path = path.parent_path() / tmp_name.str();
+
+			bool written;
+			{
+				std::ofstream file(tmp_path, std::ios::out | std::ios::binary | std::ios::trunc);
+				written = file.is_open() && file.write(static_cast<const char*>(data), static_cast<std::streamsize>(size));
+			}
+
+			if (written) std::filesystem::rename(tmp_path, path, error);
+			if (!written || error)
+			{
+				LOG_INTERNAL_WARN("Failed to write file: " << path.string());
+				std::filesystem::remove(tmp_path, error);
+				return false;
+			}
+			return true;
+		}
+
+		std::filesystem::path cache_path(const char* variable, const char* fallback)
+		{
+			const char* path = std::getenv(variable);
+			return std::filesystem::path(path ? path : fallback);
+		}
+
+		bool cache_enabled(const char* disable_variable)
+		{
+			return !std::getenv(disable_variable);
+		}
+	}
 }
@@ -0,0 +1,34 @@
+#pragma once
+
+#include <core/core.hpp>
+
+#include <filesystem>
+
+namespace ENGINE_NAMESPACE
+{
+	namespace io
+	{
+		/**
+		 * @brief Replaces a file by writing a unique temporary file next to it, then renaming it over the file, so that
+		 * readers, other processes included, never see it partially written. Missing parent directories are created.
+		 * @param path File to write.
+		 * @param data Contents of the file.
+		 * @param size Number of bytes to write.
+		 * @return True if the file was replaced, a warning is logged otherwise.
+		*/
+		bool write_file_atomic(const std::filesystem::path& path, const void* data, std::size_t size);
+
+		/**
+		 * @brief Location of an on disk cache, which can be overridden through an environment variable.
+		 * @param variable Environment variable holding the location.
+		 * @param fallback Location used when the variable is not set.
+		*/
+		std::filesystem::path cache_path(const char* variable, const char* fallback);
+
+		/**
+		 * @brief Checks whether an on disk cache is used, setting its environment variable disables it.
+		 * @param disable_variable Environment variable disabling the cache.
+		*/
+		bool cache_enabled(const char* disable_variable);
+	}
+}
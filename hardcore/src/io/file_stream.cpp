@@ -0,0 +1,198 @@
+#include <pch.hpp>
+
+#include <io/file_stream.hpp>
+#include <io/native_file.hpp>
+
+#include <condition_variable>
+#include <new>
+
+#include <debug/log_internal.hpp>
+
+namespace ENGINE_NAMESPACE
+{
+	namespace io
+	{
+		struct file_stream::shared_state
+		{
+			native_file file;
+			u8* buffers = nullptr;
+			std::size_t chunk_size = 0;
+			u32 n_buffers = 0;
+
+			u64 read_begin = 0; //aligned down for unbuffered reads
+			u64 range_begin = 0;
+			u64 range_end = 0;
+			u64 n_chunks = 0;
+
+			std::mutex mutex;
+			std::condition_variable produced_cv;
+			std::condition_variable released_cv;
+			u64 n_produced = 0;
+			u64 n_released = 0; //index of the chunk held by the consumer, if any
+			bool holding = false;
+			bool failed = false;
+			bool stop = false;
+
+			std::thread producer;
+
+			~shared_state()
+			{
+				::operator delete[](buffers, std::align_val_t(alignment));
+			}
+
+			inline u64 chunk_position(u64 idx) const noexcept { return read_begin + idx * chunk_size; }
+
+			void produce()
+			{
+				for (u64 idx = 0; idx < n_chunks; idx++)
+				{
+					{
+						std::unique_lock<std::mutex> lock(mutex);
+						released_cv.wait(lock, [&]() { return stop || idx - n_released < n_buffers; });
+						if (stop) return;
+					}
+
+					//chunk boundaries are aligned, only the end of the range may need rounding up for unbuffered reads
+					const u64 position = chunk_position(idx);
+					const std::size_t needed = static_cast<std::size_t>(std::min<u64>(chunk_size, range_end - position));
+					const std::size_t request = file.is_unbuffered() ?
+						static_cast<std::size_t>(std::min<u64>(chunk_size, (needed + alignment - 1) & ~(alignment - 1))) :
+						needed;
+
+					u8* const dst = buffers + (idx % n_buffers) * chunk_size;
+					const i64 n_read = file.read_at(dst, request, position);
+
+					std::lock_guard<std::mutex> lock(mutex);
+					if (n_read < static_cast<i64>(needed))
+					{
+						failed = true;
+						produced_cv.notify_all();
+						return;
+					}
+					n_produced++;
+					produced_cv.notify_all();
+				}
+			}
+		};
+
+		file_stream::file_stream(const char* filepath, u64 offset, u64 size, std::size_t chunk_size, u32 n_buffers,
+			stream_flag_t flags)
+		{
+			std::unique_ptr<shared_state> s = std::make_unique<shared_state>();
+
+			if (flags & DIRECT_BIT)
+			{
+				s->file = native_file(filepath, true, true);
+				if (!s->file.is_open())
+				{
+					LOG_INTERNAL_WARN("Unbuffered reads unsupported, streaming with buffered reads: " << filepath);
+				}
+			}
+			if (!s->file.is_open()) s->file = native_file(filepath, true);
+			if (!s->file.is_open())
+			{
+				LOG_INTERNAL_ERROR("Failed to open file for streaming: " << filepath);
+				return;
+			}
+
+			const u64 filesize = s->file.size();
+			if (offset > filesize)
+			{
+				LOG_INTERNAL_ERROR("Stream offset " << offset << " is past the end of file: " << filepath);
+				return;
+			}
+
+			s->chunk_size = (std::max<std::size_t>(chunk_size, 1) + alignment - 1) & ~(alignment - 1);
+			s->n_buffers = std::max<u32>(n_buffers, 1);
+			s->range_begin = offset;
+			s->range_end = size ? std::min(offset + size, filesize) : filesize;
+			s->read_begin = s->file.is_unbuffered() ? offset & ~static_cast<u64>(alignment - 1) : offset;
+			s->n_chunks = (s->range_end - s->read_begin + s->chunk_size - 1) / s->chunk_size;
+			if (s->range_end == s->range_begin) s->n_chunks = 0;
+
+			s->buffers = static_cast<u8*>(::operator new[](s->chunk_size * s->n_buffers, std::align_val_t(alignment)));
+
+			range_size = s->range_end - s->range_begin;
+			state = std::move(s);
+			state->producer = std::thread(&shared_state::produce, state.get());
+		}
+
+		file_stream::file_stream(file_stream&& other) noexcept :
+			state(std::move(other.state)), range_size(std::exchange(other.range_size, 0))
+		{}
+
+		file_stream::~file_stream()
+		{
+			close();
+		}
+
+		file_stream& file_stream::operator=(file_stream&& other) noexcept
+		{
+			if (this != &other)
+			{
+				close();
+				state = std::move(other.state);
+				range_size = std::exchange(other.range_size, 0);
+			}
+			return *this;
+		}
+
+		void file_stream::close() noexcept
+		{
+			if (!state) return;
+			{
+				std::lock_guard<std::mutex> lock(state->mutex);
+				state->stop = true;
+			}
+			state->released_cv.notify_all();
+			state->producer.join();
+			state.reset();
+			range_size = 0;
+		}
+
+		bool file_stream::next(stream_chunk& out_chunk)
+		{
+			if (!state) return false;
+
+			std::unique_lock<std::mutex> lock(state->mutex);
+			if (state->holding)
+			{
+				state->holding = false;
+				state->n_released++;
+				state->released_cv.notify_one();
+			}
+
+			state->produced_cv.wait(lock, [&]()
+				{ return state->failed || state->n_produced > state->n_released || state->n_released == state->n_chunks; });
+			if (state->n_produced == state->n_released) return false;
+
+			const u64 idx = state->n_released;
+			const u64 position = state->chunk_position(idx);
+			const u64 begin = std::max(position, state->range_begin);
+			const u64 end = std::min(position + state->chunk_size, state->range_end);
+
+			out_chunk.data = state->buffers + (idx % state->n_buffers) * state->chunk_size + (begin - position);
+			out_chunk.size = static_cast<std::size_t>(end - begin);
+			out_chunk.offset = begin - state->range_begin;
+			state->holding = true;
+			return true;
+		}
+
+		bool file_stream::ready() const noexcept
+		{
+			if (!state) return true;
+
+			std::lock_guard<std::mutex> lock(state->mutex);
+			const u64 next_idx = state->n_released + (state->holding ? 1 : 0);
+			return state->failed || state->n_produced > next_idx || next_idx == state->n_chunks;
+		}
+
+		bool file_stream::failed() const noexcept
+		{
+			if (!state) return true;
+
+			std::lock_guard<std::mutex> lock(state->mutex);
+			return state->failed;
+		}
+	}
+}
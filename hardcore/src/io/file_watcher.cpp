@@ -0,0 +1,106 @@
+#include <pch.hpp>
+
+#include <io/file_watcher.hpp>
+
+#if defined(__linux__) && __has_include(<sys/inotify.h>)
+#define INOTIFY_AVAILABLE
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+#include <debug/log_internal.hpp>
+
+namespace ENGINE_NAMESPACE
+{
+	namespace io
+	{
+		file_watcher::file_watcher()
+		{
+#ifdef INOTIFY_AVAILABLE
+			fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+			if (fd < 0)
+			{
+				LOG_INTERNAL_WARN("Failed to initialise inotify, file changes will not be detected");
+				return;
+			}
+#else
+			last_poll = std::chrono::steady_clock::now();
+#endif // INOTIFY_AVAILABLE
+			open = true;
+		}
+
+		file_watcher::~file_watcher()
+		{
+#ifdef INOTIFY_AVAILABLE
+			if (fd >= 0) close(fd); //also removes every watch
+#endif // INOTIFY_AVAILABLE
+		}
+
+		void file_watcher::watch(const std::filesystem::path& path)
+		{
+			if (!open || !files.insert(path.string()).second) return;
+
+#ifdef INOTIFY_AVAILABLE
+			//directories are watched instead of files, editors often save by renaming over the original
+			const std::filesystem::path directory = path.parent_path();
+			for (const auto& [wd, watched] : directories)
+				if (watched == directory) return;
+
+			const int wd = inotify_add_watch(fd, directory.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO);
+			if (wd < 0)
+			{
+				LOG_INTERNAL_WARN("Failed to watch directory: " << directory.string());
+				return;
+			}
+			directories[wd] = directory;
+#else
+			std::error_code error;
+			write_times[path.string()] = std::filesystem::last_write_time(path, error);
+#endif // INOTIFY_AVAILABLE
+		}
+
+		void file_watcher::poll(std::set<std::string>& out_changed)
+		{
+			if (!open) return;
+
+#ifdef INOTIFY_AVAILABLE
+			alignas(inotify_event) char buffer[4096];
+			ssize_t length;
+			while ((length = read(fd, buffer, sizeof(buffer))) > 0)
+			{
+				for (char* p = buffer; p < buffer + length; p += sizeof(inotify_event) + reinterpret_cast<inotify_event*>(p)->len)
+				{
+					const inotify_event* event = reinterpret_cast<const inotify_event*>(p);
+					auto it = directories.find(event->wd);
+					if (!event->len || it == directories.end()) continue;
+
+					std::string file = (it->second / event->name).lexically_normal().string();
+					if (files.count(file)) out_changed.insert(std::move(file));
+				}
+			}
+#else
+			const auto now = std::chrono::steady_clock::now();
+			if (now - last_poll < poll_interval) return;
+			last_poll = now;
+
+			for (auto& [file, write_time] : write_times)
+			{
+				std::error_code error;
+				const std::filesystem::file_time_type current = std::filesystem::last_write_time(file, error);
+				if (!error && current != write_time)
+				{
+					write_time = current;
+					out_changed.insert(file);
+				}
+			}
+#endif // INOTIFY_AVAILABLE
+		}
+
+		std::filesystem::path file_watcher::normalize(const std::filesystem::path& path)
+		{
+			std::error_code error;
+			const std::filesystem::path absolute = std::filesystem::absolute(path, error);
+			return (error ? path : absolute).lexically_normal();
+		}
+	}
+}
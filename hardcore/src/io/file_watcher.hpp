@@ -0,0 +1,60 @@
+#pragma once
+
+#include <core/core.hpp>
+
+#include <filesystem>
+#include <set>
+#include <unordered_map>
+
+namespace ENGINE_NAMESPACE
+{
+	namespace io
+	{
+		/**
+		 * @brief Reports writes to a set of files. Uses inotify on the parent directories where available, so files
+		 * replaced by a rename (as most editors save) are still reported, and polls modification times otherwise.
+		 * Not thread safe.
+		*/
+		class file_watcher
+		{
+		public:
+			file_watcher();
+			~file_watcher();
+
+			file_watcher(const file_watcher&) = delete;
+			file_watcher& operator=(const file_watcher&) = delete;
+
+			inline bool is_open() const noexcept { return open; }
+
+			/**
+			 * @brief Starts watching a file, does nothing if it is already watched.
+			 * @param path Normalized path of the file, see normalize.
+			*/
+			void watch(const std::filesystem::path& path);
+
+			/**
+			 * @brief Collects the watched files written since the last call.
+			 * @param out_changed Normalized paths of the changed files, each reported once.
+			*/
+			void poll(std::set<std::string>& out_changed);
+
+			/**
+			 * @brief Makes a path absolute and lexically normal, so that different spellings of a file compare equal.
+			*/
+			static std::filesystem::path normalize(const std::filesystem::path& path);
+
+		private:
+			bool open = false;
+			std::set<std::string> files;
+
+#if defined(__linux__) && __has_include(<sys/inotify.h>)
+			int fd = -1;
+			std::unordered_map<int, std::filesystem::path> directories;
+#else
+			static constexpr std::chrono::milliseconds poll_interval = std::chrono::milliseconds(250);
+			std::unordered_map<std::string, std::filesystem::file_time_type> write_times;
+			std::chrono::steady_clock::time_point last_poll;
+#endif
+		};
+	}
+}
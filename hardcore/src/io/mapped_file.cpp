@@ -0,0 +1,194 @@
+#include <pch.hpp>
+
+#include <io/mapped_file.hpp>
+
+#include <debug/log_internal.hpp>
+
+#ifdef _MSC_VER
+#include <Windows.h>
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif // _MSC_VER
+
+namespace ENGINE_NAMESPACE
+{
+	namespace io
+	{
+		mapped_file::mapped_file(const char* filepath, map_mode mode, map_hint_flag_t hints) : _mode(mode)
+		{
+#ifdef _MSC_VER
+			DWORD flags = FILE_ATTRIBUTE_NORMAL;
+			if (hints & SEQUENTIAL_BIT) flags |= FILE_FLAG_SEQUENTIAL_SCAN;
+			else if (hints & RANDOM_BIT) flags |= FILE_FLAG_RANDOM_ACCESS;
+
+			HANDLE file = CreateFileA(filepath, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, flags, nullptr);
+			if (file == INVALID_HANDLE_VALUE)
+			{
+				LOG_INTERNAL_ERROR("Failed to open file: " << filepath);
+				return;
+			}
+
+			LARGE_INTEGER filesize;
+			if (!GetFileSizeEx(file, &filesize))
+			{
+				LOG_INTERNAL_ERROR("Failed to get the size of file: " << filepath);
+				CloseHandle(file);
+				return;
+			}
+
+			length = static_cast<std::size_t>(filesize.QuadPart);
+			if (!length)
+			{
+				CloseHandle(file);
+				valid = true;
+				return;
+			}
+
+			const DWORD protection = mode == map_mode::COPY_ON_WRITE ? PAGE_WRITECOPY : PAGE_READONLY;
+			HANDLE mapping = CreateFileMappingA(file, nullptr, protection, 0, 0, nullptr);
+			if (!mapping)
+			{
+				LOG_INTERNAL_ERROR("Failed to create a mapping of file: " << filepath);
+				CloseHandle(file);
+				length = 0;
+				return;
+			}
+
+			const DWORD access = mode == map_mode::COPY_ON_WRITE ? FILE_MAP_COPY : FILE_MAP_READ;
+			ptr = static_cast<u8*>(MapViewOfFile(mapping, access, 0, 0, 0));
+			if (!ptr)
+			{
+				LOG_INTERNAL_ERROR("Failed to map file: " << filepath);
+				CloseHandle(mapping);
+				CloseHandle(file);
+				length = 0;
+				return;
+			}
+
+			file_handle = file;
+			mapping_handle = mapping;
+#else
+			const int fd = ::open(filepath, O_RDONLY | O_CLOEXEC);
+			if (fd < 0)
+			{
+				LOG_INTERNAL_ERROR("Failed to open file: " << filepath);
+				return;
+			}
+
+			struct stat file_stat;
+			if (fstat(fd, &file_stat) != 0 || !S_ISREG(file_stat.st_mode))
+			{
+				LOG_INTERNAL_ERROR("Path is not a regular file: " << filepath);
+				::close(fd);
+				return;
+			}
+
+			length = static_cast<std::size_t>(file_stat.st_size);
+			if (!length)
+			{
+				::close(fd);
+				valid = true;
+				return;
+			}
+
+			const int protection = mode == map_mode::COPY_ON_WRITE ? PROT_READ | PROT_WRITE : PROT_READ;
+			void* mapping = mmap(nullptr, length, protection, MAP_PRIVATE, fd, 0);
+			::close(fd); //the mapping keeps its own reference to the file
+			if (mapping == MAP_FAILED)
+			{
+				LOG_INTERNAL_ERROR("Failed to map file: " << filepath);
+				length = 0;
+				return;
+			}
+
+			ptr = static_cast<u8*>(mapping);
+#endif // _MSC_VER
+
+			valid = true;
+			if (hints) advise(hints);
+		}
+
+		mapped_file::mapped_file(mapped_file&& other) noexcept : ptr(other.ptr), length(other.length), _mode(other._mode),
+			valid(other.valid)
+#ifdef _MSC_VER
+			, file_handle(other.file_handle), mapping_handle(other.mapping_handle)
+#endif // _MSC_VER
+		{
+			other.ptr = nullptr;
+			other.length = 0;
+			other.valid = false;
+#ifdef _MSC_VER
+			other.file_handle = nullptr;
+			other.mapping_handle = nullptr;
+#endif // _MSC_VER
+		}
+
+		mapped_file::~mapped_file()
+		{
+			close();
+		}
+
+		mapped_file& mapped_file::operator=(mapped_file&& other) noexcept
+		{
+			if (this != &other)
+			{
+				close();
+				std::swap(ptr, other.ptr);
+				std::swap(length, other.length);
+				std::swap(_mode, other._mode);
+				std::swap(valid, other.valid);
+#ifdef _MSC_VER
+				std::swap(file_handle, other.file_handle);
+				std::swap(mapping_handle, other.mapping_handle);
+#endif // _MSC_VER
+			}
+			return *this;
+		}
+
+		void mapped_file::close() noexcept
+		{
+#ifdef _MSC_VER
+			if (ptr) UnmapViewOfFile(ptr);
+			if (mapping_handle) CloseHandle(mapping_handle);
+			if (file_handle) CloseHandle(file_handle);
+			file_handle = nullptr;
+			mapping_handle = nullptr;
+#else
+			if (ptr) munmap(ptr, length);
+#endif // _MSC_VER
+			ptr = nullptr;
+			length = 0;
+			valid = false;
+		}
+
+		void mapped_file::advise(map_hint_flag_t hints, std::size_t offset, std::size_t size) const noexcept
+		{
+			if (!ptr || offset >= length) return;
+			if (!size || size > length - offset) size = length - offset;
+
+#ifdef _MSC_VER
+			//access pattern hints are given to CreateFile, and file mappings can't use large pages
+			if (hints & WILLNEED_BIT)
+			{
+				WIN32_MEMORY_RANGE_ENTRY range = { ptr + offset, size };
+				PrefetchVirtualMemory(GetCurrentProcess(), 1, &range, 0);
+			}
+#else
+			static const std::size_t page_size = static_cast<std::size_t>(sysconf(_SC_PAGESIZE));
+			const std::size_t aligned_offset = offset & ~(page_size - 1);
+			u8* const start = ptr + aligned_offset;
+			size += offset - aligned_offset;
+
+			if (hints & SEQUENTIAL_BIT) madvise(start, size, MADV_SEQUENTIAL);
+			else if (hints & RANDOM_BIT) madvise(start, size, MADV_RANDOM);
+			if (hints & WILLNEED_BIT) madvise(start, size, MADV_WILLNEED);
+#ifdef MADV_HUGEPAGE
+			if (hints & HUGEPAGES_BIT) madvise(start, size, MADV_HUGEPAGE);
+#endif // MADV_HUGEPAGE
+#endif // _MSC_VER
+		}
+	}
+}
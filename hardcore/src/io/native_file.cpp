@@ -0,0 +1,128 @@
+#include <pch.hpp>
+
+#include <io/native_file.hpp>
+
+#ifdef _MSC_VER
+#include <Windows.h>
+#else
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif // _MSC_VER
+
+namespace ENGINE_NAMESPACE
+{
+	namespace io
+	{
+		native_file::native_file(const char* filepath, bool sequential, bool unbuffered)
+		{
+#ifdef _MSC_VER
+			DWORD flags = sequential ? FILE_FLAG_SEQUENTIAL_SCAN : FILE_ATTRIBUTE_NORMAL;
+			if (unbuffered) flags |= FILE_FLAG_NO_BUFFERING;
+			HANDLE file = CreateFileA(filepath, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, flags, nullptr);
+			LARGE_INTEGER size;
+			if (file == INVALID_HANDLE_VALUE || !GetFileSizeEx(file, &size))
+			{
+				if (file != INVALID_HANDLE_VALUE) CloseHandle(file);
+				return;
+			}
+			handle = file;
+			filesize = static_cast<u64>(size.QuadPart);
+#else
+			int open_flags = O_RDONLY | O_CLOEXEC;
+			if (unbuffered)
+			{
+#ifdef O_DIRECT
+				open_flags |= O_DIRECT;
+#else
+				return;
+#endif // O_DIRECT
+			}
+			const int fd = ::open(filepath, open_flags);
+			struct stat file_stat;
+			if (fd < 0 || fstat(fd, &file_stat) != 0 || !S_ISREG(file_stat.st_mode))
+			{
+				if (fd >= 0) ::close(fd);
+				return;
+			}
+#ifdef POSIX_FADV_SEQUENTIAL
+			if (sequential) posix_fadvise(fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+#endif // POSIX_FADV_SEQUENTIAL
+			handle = fd;
+			filesize = static_cast<u64>(file_stat.st_size);
+#endif // _MSC_VER
+			this->unbuffered = unbuffered;
+		}
+
+		native_file::native_file(native_file&& other) noexcept :
+			handle(std::exchange(other.handle, invalid_handle)), filesize(std::exchange(other.filesize, 0)),
+			unbuffered(std::exchange(other.unbuffered, false))
+		{}
+
+		native_file::~native_file()
+		{
+			close();
+		}
+
+		native_file& native_file::operator=(native_file&& other) noexcept
+		{
+			if (this != &other)
+			{
+				close();
+				handle = std::exchange(other.handle, invalid_handle);
+				filesize = std::exchange(other.filesize, 0);
+				unbuffered = std::exchange(other.unbuffered, false);
+			}
+			return *this;
+		}
+
+		void native_file::close() noexcept
+		{
+			if (handle == invalid_handle) return;
+#ifdef _MSC_VER
+			CloseHandle(handle);
+#else
+			::close(handle);
+#endif // _MSC_VER
+			handle = invalid_handle;
+			filesize = 0;
+			unbuffered = false;
+		}
+
+		i64 native_file::read_at(void* dst, std::size_t size, u64 offset) const noexcept
+		{
+			u8* const bytes = static_cast<u8*>(dst);
+			std::size_t done = 0;
+			while (done < size)
+			{
+#ifdef _MSC_VER
+				const u64 position = offset + done;
+				OVERLAPPED overlapped = {};
+				overlapped.Offset = static_cast<DWORD>(position);
+				overlapped.OffsetHigh = static_cast<DWORD>(position >> 32);
+
+				const DWORD chunk = static_cast<DWORD>(std::min<std::size_t>(size - done, GIGABYTES(1)));
+				DWORD n_read = 0;
+				if (!ReadFile(handle, bytes + done, chunk, &n_read, &overlapped))
+				{
+					if (GetLastError() == ERROR_HANDLE_EOF) break;
+					return -1;
+				}
+#else
+				const ssize_t n_read = pread(handle, bytes + done, size - done, static_cast<off_t>(offset + done));
+				if (n_read < 0)
+				{
+					if (errno == EINTR) continue;
+					return -1;
+				}
+#endif // _MSC_VER
+				if (!n_read) break;
+				done += static_cast<std::size_t>(n_read);
+
+				//a short unbuffered read means the end of the file was reached, reading on from an unaligned offset fails
+				if (unbuffered && done < size && (done & (KILOBYTES(4) - 1))) break;
+			}
+			return static_cast<i64>(done);
+		}
+	}
+}
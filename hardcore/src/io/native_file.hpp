@@ -0,0 +1,64 @@
+#pragma once
+
+#include <core/core.hpp>
+
+namespace ENGINE_NAMESPACE
+{
+	namespace io
+	{
+		/**
+		 * @brief Read only OS file handle supporting positional reads, safe to share between threads.
+		*/
+		class native_file
+		{
+		public:
+			native_file() = default;
+
+			/**
+			 * @brief Opens a file, check is_open() to know if it succeeded.
+			 * @param filepath File to open.
+			 * @param sequential Hints the OS that the file will be read front to back.
+			 * @param unbuffered Bypasses the OS page cache (O_DIRECT / FILE_FLAG_NO_BUFFERING), reads must then use
+			 * offsets, sizes and destinations aligned to the device sector size. Opening fails if unsupported.
+			*/
+			native_file(const char* filepath, bool sequential = false, bool unbuffered = false);
+
+			native_file(const native_file&) = delete;
+			native_file(native_file&& other) noexcept;
+			~native_file();
+
+			native_file& operator=(const native_file&) = delete;
+			native_file& operator=(native_file&& other) noexcept;
+
+			void close() noexcept;
+
+			/**
+			 * @brief Reads from an absolute position, without moving any shared file cursor.
+			 * @param dst Destination of the data.
+			 * @param size Number of bytes to read.
+			 * @param offset Position in the file to read from.
+			 * @return Number of bytes read, less than size only if the end of the file was reached, or -1 on failure.
+			*/
+			i64 read_at(void* dst, std::size_t size, u64 offset) const noexcept;
+
+			inline bool is_open() const noexcept { return handle != invalid_handle; }
+			inline u64 size() const noexcept { return filesize; }
+			inline bool is_unbuffered() const noexcept { return unbuffered; }
+
+#ifdef _MSC_VER
+			typedef void* handle_t;
+			static inline handle_t const invalid_handle = reinterpret_cast<handle_t>(-1);
+#else
+			typedef int handle_t;
+			static constexpr handle_t invalid_handle = -1;
+#endif // _MSC_VER
+
+			inline handle_t native_handle() const noexcept { return handle; }
+
+		private:
+			handle_t handle = invalid_handle;
+			u64 filesize = 0;
+			bool unbuffered = false;
+		};
+	}
+}
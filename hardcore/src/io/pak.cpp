@@ -0,0 +1,133 @@
+#include <pch.hpp>
+
+#include <io/pak.hpp>
+#include <io/native_file.hpp>
+#include <io/async_internal.hpp>
+
+#include <debug/log_internal.hpp>
+
+namespace ENGINE_NAMESPACE
+{
+	namespace io
+	{
+		pak::pak(const char* filepath, bool map) : filepath(filepath)
+		{
+			native_file archive(filepath);
+			if (!archive.is_open())
+			{
+				LOG_INTERNAL_ERROR("Failed to open archive: " << filepath);
+				return;
+			}
+
+			pak_format::header header;
+			if (archive.read_at(&header, sizeof(header), 0) != sizeof(header) || header.magic != pak_format::magic)
+			{
+				LOG_INTERNAL_ERROR("Not an archive: " << filepath);
+				return;
+			}
+
+			if (header.version != pak_format::version)
+			{
+				LOG_INTERNAL_ERROR("Unsupported archive version " << header.version << ": " << filepath);
+				return;
+			}
+
+			//table and names are contiguous, but are kept in separate buffers to keep the entries aligned
+			const u64 table_size = static_cast<u64>(header.n_entries) * sizeof(pak_entry);
+			const u64 archive_size = archive.size();
+			const u64 table_space = archive_size - sizeof(header);
+			if (table_size > table_space || header.names_size > table_space - table_size)
+			{
+				LOG_INTERNAL_ERROR("Truncated archive table: " << filepath);
+				return;
+			}
+
+			entries.resize(header.n_entries);
+			names.resize(header.names_size);
+			if (archive.read_at(entries.data(), table_size, sizeof(header)) != static_cast<i64>(table_size) ||
+				archive.read_at(names.data(), names.size(), sizeof(header) + table_size) != static_cast<i64>(names.size()))
+			{
+				LOG_INTERNAL_ERROR("Truncated archive table: " << filepath);
+				entries.clear();
+				names.clear();
+				return;
+			}
+
+			//the table is trusted from here on, a corrupted entry would read out of the name blob or past the data
+			for (const pak_entry& entry : entries)
+			{
+				if (static_cast<u64>(entry.name_offset) + entry.name_size > names.size() ||
+					entry.size > archive_size || entry.offset > archive_size - entry.size)
+				{
+					LOG_INTERNAL_ERROR("Corrupted archive table: " << filepath);
+					entries.clear();
+					names.clear();
+					return;
+				}
+			}
+
+			if (map)
+			{
+				mapping = mapped_file(filepath, map_mode::READ_ONLY, RANDOM_BIT);
+			}
+
+			file = std::make_shared<native_file>(std::move(archive));
+			LOG_INTERNAL_INFO("Opened archive " << filepath << " (" << entries.size() << " entries)");
+		}
+
+		pak::pak(pak&& other) noexcept = default;
+
+		pak::~pak() = default;
+
+		pak& pak::operator=(pak&& other) noexcept = default;
+
+		const pak_entry* pak::find(std::string_view name) const noexcept
+		{
+			const u64 hash = pak_format::hash(name);
+			auto it = std::lower_bound(entries.begin(), entries.end(), hash,
+				[](const pak_entry& entry, u64 hash) { return entry.hash < hash; });
+
+			//hash collisions are stored next to each other, in name order
+			for (; it != entries.end() && it->hash == hash; ++it)
+			{
+				if (this->name(*it) == name) return &*it;
+			}
+			return nullptr;
+		}
+
+		std::string_view pak::name(const pak_entry& entry) const noexcept
+		{
+			return std::string_view(names.data() + entry.name_offset, entry.name_size);
+		}
+
+		bool pak::read(const pak_entry& entry, void* dst) const noexcept
+		{
+			if (!file) return false;
+			return file->read_at(dst, static_cast<std::size_t>(entry.size), entry.offset) == static_cast<i64>(entry.size);
+		}
+
+		std::future<read_result> pak::read_async(const pak_entry& entry) const
+		{
+			if (!file)
+			{
+				std::promise<read_result> promise;
+				promise.set_exception(std::make_exception_ptr(exception::io_error("Archive is not open: " + filepath)));
+				return promise.get_future();
+			}
+			//a size of 0 would read up to the end of the archive
+			if (entry.size == 0)
+			{
+				std::promise<read_result> promise;
+				promise.set_value(read_result());
+				return promise.get_future();
+			}
+			return io::read_async(file, filepath.c_str(), entry.offset, static_cast<std::size_t>(entry.size));
+		}
+
+		std::span<const u8> pak::view(const pak_entry& entry) const noexcept
+		{
+			if (!mapping.is_open() || entry.offset + entry.size > mapping.size()) return std::span<const u8>();
+			return mapping.view(static_cast<std::size_t>(entry.offset), static_cast<std::size_t>(entry.size));
+		}
+	}
+}
@@ -49,15 +49,19 @@ namespace ENGINE_NAMESPACE
 			LOG_INTERNAL_INFO("Lauched master thread (ID: " << std::this_thread::get_id() << ")");
 
 			task t;
+			thread_idx_t next_immediate = 0;
+			thread_idx_t next_background = 0;
 			while (run_master.test_and_set())
 			{
 				if (immediate_tasks.try_pop(t))
 				{
-					immediate_queues[0].push(std::move(t));
+					immediate_queues[next_immediate].push(std::move(t));
+					next_immediate = (next_immediate + 1) % n_immediate_workers;
 				}
 				if (background_tasks.try_pop(t))
 				{
-
+					background_queues[next_background].push(std::move(t));
+					next_background = (next_background + 1) % n_background_workers;
 				}
 				std::unique_lock<std::mutex> lock(task_signal_access);
 				if (!(immediate_tasks.unsafe_size() || background_tasks.unsafe_size()))
@@ -168,6 +172,11 @@ namespace ENGINE_NAMESPACE
 			logger.join();
 		}
 
+		u32 immediate_worker_count() noexcept
+		{
+			return n_immediate_workers;
+		}
+
 		namespace internal
 		{
 			void submit_immediate_task(void(*aux)(void*, void*), void* func_ptr, void* promise_ptr)
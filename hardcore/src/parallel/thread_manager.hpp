@@ -16,5 +16,7 @@ namespace ENGINE_NAMESPACE
 		void terminate_threads();
 
 		void logger_wait();
+
+		u32 immediate_worker_count() noexcept;
 	}
 }
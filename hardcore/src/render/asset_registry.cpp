@@ -0,0 +1,272 @@
+#include <pch.hpp>
+
+#include <render/asset.hpp>
+#include <io/file.hpp>
+#include <io/file_watcher.hpp>
+#include <parallel/task.hpp>
+
+#include <unordered_map>
+
+#include <debug/log_internal.hpp>
+
+namespace ENGINE_NAMESPACE
+{
+	struct asset_entry
+	{
+		std::string key;
+		std::string name;   //file or derived asset name, for messages
+		std::string source; //normalized path of the file the asset is loaded from, empty for derived assets
+		u64 order;          //creation order, an asset is always created after its dependencies
+
+		asset_registry::loader_t loader;
+		asset_registry::builder_t builder;
+		asset_registry::assign_t assign;
+
+		std::shared_ptr<void> value;
+		u32 generation = 0;
+
+		std::vector<std::shared_ptr<asset_entry>> dependencies;
+		std::vector<std::weak_ptr<asset_entry>> dependents;
+	};
+
+	struct file_contents
+	{
+		std::shared_ptr<void> data;
+		std::size_t size = 0;
+	};
+
+	struct pending_read
+	{
+		std::string source;
+		std::future<file_contents> contents;
+	};
+
+	struct registry_state
+	{
+		//key => asset, entries are owned by the handles and expire with the last one
+		std::unordered_map<std::string, std::weak_ptr<asset_entry>> entries;
+		u64 next_order = 0;
+
+		std::unique_ptr<io::file_watcher> files;
+		std::vector<pending_read> pending;
+	};
+
+	registry_state registry;
+
+	inline file_contents read_contents(const char* filepath)
+	{
+		file_contents contents;
+
+		//reloads read files that may be halfway through a save, a failed read is skipped until the next change
+		void* data = try_read_binary_file(filepath, contents.size);
+		if (data) contents.data = std::shared_ptr<void>(data, [](void* p) { std::free(p); });
+		return contents;
+	}
+
+	inline std::shared_ptr<asset_entry> find_entry(const std::string& key)
+	{
+		auto it = registry.entries.find(key);
+		if (it == registry.entries.end()) return nullptr;
+
+		std::shared_ptr<asset_entry> entry = it->second.lock();
+		if (!entry) registry.entries.erase(it);
+		return entry;
+	}
+
+	//adds every live asset downstream of entry, dependents are pruned of expired assets on the way
+	void collect_dependents(asset_entry& entry, std::vector<std::shared_ptr<asset_entry>>& out_affected)
+	{
+		for (std::size_t i = 0; i < entry.dependents.size();)
+		{
+			std::shared_ptr<asset_entry> dependent = entry.dependents[i].lock();
+			if (!dependent)
+			{
+				entry.dependents.erase(entry.dependents.begin() + i);
+				continue;
+			}
+			i++;
+
+			if (std::find(out_affected.begin(), out_affected.end(), dependent) != out_affected.end()) continue;
+			collect_dependents(*dependent, out_affected);
+			out_affected.push_back(std::move(dependent));
+		}
+	}
+
+	//the value is only replaced if the rebuild succeeds, otherwise the asset keeps its previous contents
+	template<typename Func>
+	bool rebuild(asset_entry& entry, Func&& build)
+	{
+		std::shared_ptr<void> value;
+		try
+		{
+			value = build();
+		}
+		catch (const std::exception& e)
+		{
+			LOG_INTERNAL_WARN("Failed to rebuild asset:\t" << entry.name << " (" << e.what() << ')');
+			return false;
+		}
+
+		entry.assign(entry.value.get(), value.get());
+		entry.generation++;
+		return true;
+	}
+
+	u32 asset_base::generation() const noexcept
+	{
+		return entry ? entry->generation : 0;
+	}
+
+	const void* asset_base::value() const noexcept
+	{
+		return entry->value.get();
+	}
+
+	asset_base asset_registry::load_file(const char* filepath, const char* type, loader_t&& loader, assign_t assign)
+	{
+		const std::filesystem::path path = io::file_watcher::normalize(filepath);
+		std::string key = std::string(type) + '|' + path.string();
+		if (std::shared_ptr<asset_entry> existing = find_entry(key)) return asset_base(std::move(existing));
+
+		file_contents contents = read_contents(path.string().c_str());
+		if (!contents.data)
+		{
+			LOG_INTERNAL_ERROR("Failed to load asset: " << filepath);
+			return asset_base();
+		}
+
+		std::shared_ptr<asset_entry> entry = std::make_shared<asset_entry>();
+		entry->key = std::move(key);
+		entry->name = filepath;
+		entry->source = path.string();
+		entry->order = registry.next_order++;
+		entry->loader = std::move(loader);
+		entry->assign = assign;
+		entry->value = entry->loader(contents.data.get(), contents.size);
+
+		registry.entries[entry->key] = entry;
+		if (registry.files) registry.files->watch(path);
+		return asset_base(std::move(entry));
+	}
+
+	asset_base asset_registry::derive_asset(const char* name, const char* type, const std::vector<asset_base>& dependencies,
+		builder_t&& builder, assign_t assign)
+	{
+		std::string key = std::string(type) + '#' + name;
+		if (std::shared_ptr<asset_entry> existing = find_entry(key)) return asset_base(std::move(existing));
+
+		std::shared_ptr<asset_entry> entry = std::make_shared<asset_entry>();
+		entry->key = std::move(key);
+		entry->name = name;
+		entry->order = registry.next_order++;
+		entry->builder = std::move(builder);
+		entry->assign = assign;
+
+		for (const asset_base& dependency : dependencies)
+		{
+			INTERNAL_ASSERT(dependency.valid(), "Invalid asset dependency");
+			entry->dependencies.push_back(dependency.entry);
+			dependency.entry->dependents.push_back(entry);
+		}
+		entry->value = entry->builder();
+
+		registry.entries[entry->key] = entry;
+		return asset_base(std::move(entry));
+	}
+
+	void asset_registry::hot_reload(bool enable)
+	{
+		if (enable == static_cast<bool>(registry.files)) return;
+
+		if (enable)
+		{
+			registry.files = std::make_unique<io::file_watcher>();
+			if (!registry.files->is_open())
+			{
+				LOG_INTERNAL_WARN("Asset hot reload disabled");
+				registry.files.reset();
+				return;
+			}
+
+			for (const auto& [key, weak_entry] : registry.entries)
+			{
+				std::shared_ptr<asset_entry> entry = weak_entry.lock();
+				if (entry && !entry->source.empty()) registry.files->watch(entry->source);
+			}
+			LOG_INTERNAL_INFO("Asset hot reload enabled");
+		}
+		else
+		{
+			//files still being read are dropped
+			registry.files.reset();
+			registry.pending.clear();
+		}
+	}
+
+	void asset_registry::apply_reloads()
+	{
+		if (!registry.files) return;
+
+		std::set<std::string> changed;
+		registry.files->poll(changed);
+		for (const std::string& source : changed)
+		{
+			LOG_INTERNAL_INFO("Reloading asset file:\t" << source);
+			registry.pending.push_back({ source, parallel::background_async<file_contents>([source]()
+				{
+					return read_contents(source.c_str());
+				}) });
+		}
+
+		std::vector<std::shared_ptr<asset_entry>> affected;
+		for (std::size_t i = 0; i < registry.pending.size();)
+		{
+			if (registry.pending[i].contents.wait_for(std::chrono::seconds(0)) != std::future_status::ready)
+			{
+				i++;
+				continue;
+			}
+
+			pending_read read = std::move(registry.pending[i]);
+			registry.pending.erase(registry.pending.begin() + i);
+
+			//superseded by a more recent change to the same file
+			const auto is_newer = [&read](const pending_read& p) { return p.source == read.source; };
+			if (std::any_of(registry.pending.begin() + i, registry.pending.end(), is_newer)) continue;
+
+			file_contents contents = read.contents.get();
+			if (!contents.data)
+			{
+				LOG_INTERNAL_WARN("Failed to read asset file:\t" << read.source);
+				continue;
+			}
+
+			//a file may be loaded as several types
+			for (auto it = registry.entries.begin(); it != registry.entries.end();)
+			{
+				std::shared_ptr<asset_entry> entry = it->second.lock();
+				if (!entry)
+				{
+					it = registry.entries.erase(it);
+					continue;
+				}
+				it++;
+
+				if (entry->source != read.source) continue;
+				if (rebuild(*entry, [&]() { return entry->loader(contents.data.get(), contents.size); }))
+					collect_dependents(*entry, affected);
+			}
+		}
+
+		//dependencies are always older than their dependents, creation order is a valid rebuild order
+		std::sort(affected.begin(), affected.end(),
+			[](const std::shared_ptr<asset_entry>& a, const std::shared_ptr<asset_entry>& b) { return a->order < b->order; });
+		for (const std::shared_ptr<asset_entry>& entry : affected) rebuild(*entry, entry->builder);
+	}
+
+	void asset_registry::clear()
+	{
+		hot_reload(false);
+		registry.entries.clear();
+	}
+}
@@ -2,6 +2,7 @@
 
 #include <render/device.hpp>
 #include <render/shader_library.hpp>
+#include <core/window.hpp>
 
 #include <debug/log_internal.hpp>
 
@@ -30,7 +31,8 @@ namespace ENGINE_NAMESPACE
 				}
 
 				VkBool32 presentSupport = false;
-				vkGetPhysicalDeviceSurfaceSupportKHR(physical_handle, i, surface, &presentSupport);
+				if (surface != VK_NULL_HANDLE) //headless devices have no present queue
+					vkGetPhysicalDeviceSurfaceSupportKHR(physical_handle, i, surface, &presentSupport);
 				if (present_score < 10 && presentSupport)
 				{
 					present_idx = i;
@@ -101,7 +103,7 @@ namespace ENGINE_NAMESPACE
 	inline void create_logical_device(VkPhysicalDevice& physical_handle, VkDevice& handle,
 		VkQueue* graphics_queue, VkQueue* present_queue, VkQueue* compute_queue, VkQueue* transfer_queue,
 		u32 graphics_idx, u32 present_idx, u32 compute_idx, u32 transfer_idx, 
-		u32 invalid_idx)
+		u32 invalid_idx, bool headless)
 	{
 		std::set<u32> unique_queue_families = { graphics_idx, present_idx, compute_idx, transfer_idx };
 		VkDeviceQueueCreateInfo* queue_create_infos = t_calloc<VkDeviceQueueCreateInfo>(unique_queue_families.size());
@@ -128,8 +130,21 @@ namespace ENGINE_NAMESPACE
 		createInfo.pQueueCreateInfos = queue_create_infos;
 		createInfo.queueCreateInfoCount = count;
 		createInfo.pEnabledFeatures = &device_features;
-		createInfo.enabledExtensionCount = static_cast<uint32_t>(device_extensions.size());
-		createInfo.ppEnabledExtensionNames = device_extensions.data();
+		//lets device memory report upload completion without waiting on the frame fences
+		VkPhysicalDeviceTimelineSemaphoreFeatures timeline_features = {};
+		timeline_features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_TIMELINE_SEMAPHORE_FEATURES;
+		timeline_features.timelineSemaphore = VK_TRUE;
+		if (device_memory::timeline_supported(physical_handle))
+			createInfo.pNext = &timeline_features;
+		std::vector<const char*> extensions;
+		if (!headless)
+			extensions.insert(extensions.end(), device_extensions.begin(), device_extensions.end());
+		//lets the heap manager size its blocks to the budget the driver reports
+		if (device_heap_manager::memory_budget_supported(physical_handle))
+			extensions.push_back(VK_EXT_MEMORY_BUDGET_EXTENSION_NAME);
+
+		createInfo.enabledExtensionCount = static_cast<uint32_t>(extensions.size());
+		createInfo.ppEnabledExtensionNames = extensions.data();
 		if (enable_validation_layers)
 		{
 			createInfo.enabledLayerCount = static_cast<uint32_t>(validation_layers.size());
@@ -209,12 +224,14 @@ namespace ENGINE_NAMESPACE
 		//TODO: verify extension compatibility
 
 		create_logical_device(physical_handle, handle, &graphics_queue, &present_queue, &compute_queue, &transfer_queue,
-			graphics_idx, present_idx, compute_idx, transfer_idx, invalid_queue_idx);
+			graphics_idx, present_idx, compute_idx, transfer_idx, invalid_queue_idx, surface == VK_NULL_HANDLE);
 
 		create_command_buffers(handle, command_parallelism, graphics_idx, &graphics_command_pools, &graphics_command_buffers);
 
+		pipelines_cache.init(handle, properties);
+
 		memory.init(physical_handle, handle, transfer_idx, &properties.limits, &current_frame);
-		memory.map_ranges(handle, current_frame);
+		memory.select_frame(current_frame);
 		pipeline_stacks.resize(1);
 	}
 
@@ -237,6 +254,11 @@ namespace ENGINE_NAMESPACE
 			vkDeviceWaitIdle(handle);
 			//Pipelines must be destroyed before anything else
 			graphics_pipelines.clear();
+			while (!old_pipelines.empty())
+			{
+				vkDestroyPipeline(handle, old_pipelines.front().handle, nullptr);
+				old_pipelines.pop();
+			}
 			for (std::size_t i = 0; i < main_swapchain.size(); i++)
 				vkDestroyFramebuffer(handle, framebuffers[i], nullptr);
 			std::free(framebuffers);
@@ -255,6 +277,7 @@ namespace ENGINE_NAMESPACE
 		{
 			vkDeviceWaitIdle(handle);
 			memory.terminate(handle, current_frame);
+			pipelines_cache.terminate(handle);
 			for (std::size_t i = 0; i < command_parallelism; i++)
 			{
 				//Destroying a command pool frees all of its buffers as well
@@ -274,7 +297,8 @@ namespace ENGINE_NAMESPACE
 
 	void device::create_swapchain()
 	{
-		main_swapchain.init(physical_handle, handle, *surface, graphics_idx, present_idx);
+		if (*surface == VK_NULL_HANDLE) main_swapchain.init_offscreen(physical_handle, handle);
+		else main_swapchain.init(physical_handle, handle, *surface, graphics_idx, present_idx);
 		has_swapchain = true;
 
 		VkSemaphoreCreateInfo semaphore_info = {};
@@ -300,7 +324,8 @@ namespace ENGINE_NAMESPACE
 		attachment.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
 		attachment.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
 		attachment.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
-		attachment.finalLayout = VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;	//define pixel layout of VkImages in memory
+		attachment.finalLayout = main_swapchain.offscreen() ? VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL : 
+			VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;	//define pixel layout of VkImages in memory
 
 		VkAttachmentReference attachment_ref = {};
 		attachment_ref.attachment = 0;
@@ -416,10 +441,20 @@ namespace ENGINE_NAMESPACE
 		const u8 previous_frame = (current_frame - 1 + max_frames_in_flight) % max_frames_in_flight;
 
 		vkWaitForFences(handle, 1, &frame_fences[current_frame], VK_TRUE, UINT64_MAX);
+		memory.complete_downloads(current_frame);
+		memory.reclaim(current_frame); //the frame's uploads were waited on by sync at the end of the previous draw
+		const u8 download_latency = memory.download_latency();
+		if (download_latency < max_frames_in_flight)
+		{
+			//a shorter latency waits on the more recent frame its downloads were recorded in
+			const u8 download_frame = (current_frame + max_frames_in_flight - download_latency) % max_frames_in_flight;
+			vkWaitForFences(handle, 1, &frame_fences[download_frame], VK_TRUE, UINT64_MAX);
+			memory.complete_downloads(download_frame);
+		}
 		for (auto& pipeline : graphics_pipelines) pipeline.update_descriptor_sets(previous_frame, current_frame, next_frame); //TODO consider parallelizing this
 		
+		memory.stream_uploads();
 		memory.flush_ranges(handle, current_frame);
-		memory.unmap_ranges(handle, current_frame);
 		const bool uploaded = memory.upload(handle, transfer_queue, transfer_idx, current_frame);
 		
 		main_swapchain.check_destroy_old(handle, current_frame);
@@ -434,18 +469,41 @@ namespace ENGINE_NAMESPACE
 				old_framebuffers.pop();
 			}
 		}
+		while (!old_pipelines.empty() && old_pipelines.front().deletion_frame == current_frame)
+		{
+			vkDestroyPipeline(handle, old_pipelines.front().handle, nullptr);
+			old_pipelines.pop();
+		}
+
+		const bool offscreen = main_swapchain.offscreen();
 
 		u32 imageIndex;
-		VkResult result = vkAcquireNextImageKHR(handle, main_swapchain.vk_handle(), UINT64_MAX, image_available_semaphores[current_frame], VK_NULL_HANDLE, &imageIndex);
-		if (result == VK_ERROR_OUT_OF_DATE_KHR)
+		VkResult result = VK_SUCCESS;
+		if (offscreen)
 		{
-			recreate_swapchain();
-			return true; //Skip this frame
+			//offscreen targets have one image per frame in flight, there is nothing to acquire
+			int width, height;
+			window::get_dimensions(&width, &height);
+			if (static_cast<u32>(width) != main_swapchain.extent().width || 
+				static_cast<u32>(height) != main_swapchain.extent().height)
+			{
+				recreate_swapchain();
+			}
+			imageIndex = current_frame;
 		}
-		else if (result != VK_SUCCESS && result != VK_SUBOPTIMAL_KHR)
+		else
 		{
-			DEBUG_BREAK;
-			return false;
+			result = vkAcquireNextImageKHR(handle, main_swapchain.vk_handle(), UINT64_MAX, image_available_semaphores[current_frame], VK_NULL_HANDLE, &imageIndex);
+			if (result == VK_ERROR_OUT_OF_DATE_KHR)
+			{
+				recreate_swapchain();
+				return true; //Skip this frame
+			}
+			else if (result != VK_SUCCESS && result != VK_SUBOPTIMAL_KHR)
+			{
+				DEBUG_BREAK;
+				return false;
+			}
 		}
 		
 		VkCommandBuffer& primary_buffer = graphics_command_buffers[current_frame * (command_parallelism + 1)];
@@ -488,52 +546,66 @@ namespace ENGINE_NAMESPACE
 		vkCmdExecuteCommands(primary_buffer, command_parallelism, &graphics_command_buffers[(command_parallelism + 1) * current_frame + 1]);
 
 		vkCmdEndRenderPass(primary_buffer);
+		memory.record_downloads(primary_buffer, current_frame);
 
 		VK_CRASH_CHECK(vkEndCommandBuffer(primary_buffer), "Failed to end primary graphics command buffer");
 
 		std::vector<VkSemaphore> pre_render_semaphores;
+		std::vector<VkPipelineStageFlags> wait_stages;
 		pre_render_semaphores.reserve(2);
-		pre_render_semaphores.push_back(image_available_semaphores[current_frame]);
-		if (uploaded) pre_render_semaphores.push_back(memory.upload_semaphore(current_frame));
+		wait_stages.reserve(2);
+		if (!offscreen)
+		{
+			pre_render_semaphores.push_back(image_available_semaphores[current_frame]);
+			wait_stages.push_back(VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT);
+		}
+		if (uploaded)
+		{
+			pre_render_semaphores.push_back(memory.upload_semaphore(current_frame));
+			wait_stages.push_back(VK_PIPELINE_STAGE_TRANSFER_BIT);
+		}
 
 		VkSubmitInfo submitInfo = {};
 		submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
-		VkPipelineStageFlags waitStages[] = { VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT };
 		submitInfo.waitSemaphoreCount = static_cast<u32>(pre_render_semaphores.size());
 		submitInfo.pWaitSemaphores = pre_render_semaphores.data();
-		submitInfo.pWaitDstStageMask = waitStages;
+		submitInfo.pWaitDstStageMask = wait_stages.data();
 		submitInfo.commandBufferCount = 1;
 		submitInfo.pCommandBuffers = &primary_buffer;
-		submitInfo.signalSemaphoreCount = 1;
+		//nothing waits on the render semaphore when there is no presentation
+		submitInfo.signalSemaphoreCount = offscreen ? 0 : 1;
 		submitInfo.pSignalSemaphores = &render_finished_semaphores[current_frame];
 
 		vkResetFences(handle, 1, &frame_fences[current_frame]);
 		VK_CRASH_CHECK(vkQueueSubmit(graphics_queue, 1, &submitInfo, frame_fences[current_frame]), "Failed to submit render commands");
 
-		VkPresentInfoKHR presentInfo = {};
-		presentInfo.sType = VK_STRUCTURE_TYPE_PRESENT_INFO_KHR;
-		presentInfo.waitSemaphoreCount = 1;
-		presentInfo.pWaitSemaphores = &render_finished_semaphores[current_frame];
-		VkSwapchainKHR swapchains[] = { main_swapchain.vk_handle() };
-		presentInfo.swapchainCount = 1;
-		presentInfo.pSwapchains = swapchains;
-		presentInfo.pImageIndices = &imageIndex;
-		presentInfo.pResults = nullptr; // Optional
-
-		result = vkQueuePresentKHR(present_queue, &presentInfo);
-		if (result == VK_ERROR_OUT_OF_DATE_KHR || result == VK_SUBOPTIMAL_KHR)
-		{
-			//DEBUG_BREAK;
-			recreate_swapchain();
-		}
-		else if (result != VK_SUCCESS)
+		if (!offscreen)
 		{
-			DEBUG_BREAK;
-			return false;
+			VkPresentInfoKHR presentInfo = {};
+			presentInfo.sType = VK_STRUCTURE_TYPE_PRESENT_INFO_KHR;
+			presentInfo.waitSemaphoreCount = 1;
+			presentInfo.pWaitSemaphores = &render_finished_semaphores[current_frame];
+			VkSwapchainKHR swapchains[] = { main_swapchain.vk_handle() };
+			presentInfo.swapchainCount = 1;
+			presentInfo.pSwapchains = swapchains;
+			presentInfo.pImageIndices = &imageIndex;
+			presentInfo.pResults = nullptr; // Optional
+
+			result = vkQueuePresentKHR(present_queue, &presentInfo);
+			if (result == VK_ERROR_OUT_OF_DATE_KHR || result == VK_SUBOPTIMAL_KHR)
+			{
+				//DEBUG_BREAK;
+				recreate_swapchain();
+			}
+			else if (result != VK_SUCCESS)
+			{
+				DEBUG_BREAK;
+				return false;
+			}
 		}
 		current_frame = next_frame;
 		memory.sync(handle, current_frame); //wait for the "next" frame's data transfers to finish, so nothing can be overwritten by the client
-		memory.map_ranges(handle, current_frame);
+		memory.select_frame(current_frame);
 		return true;
 	}
 
@@ -545,6 +617,18 @@ namespace ENGINE_NAMESPACE
 		return static_cast<u32>(graphics_pipelines.size() - 1);
 	}
 
+	void device::reload_graphics_pipelines(const std::vector<const shader*>& reloaded)
+	{
+		//the previous frame may still use the replaced pipelines, its fence is waited on again in draw before they
+		//are destroyed
+		const u8 previous_frame = (current_frame - 1 + max_frames_in_flight) % max_frames_in_flight;
+		for (graphics_pipeline& pipeline : graphics_pipelines)
+		{
+			VkPipeline old = pipeline.reload(reloaded);
+			if (old != VK_NULL_HANDLE) old_pipelines.push({ old, previous_frame });
+		}
+	}
+
 	void device::add_instanced_graphics_pipeline()
 	{
 
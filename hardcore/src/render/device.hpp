@@ -3,6 +3,7 @@
 #include "render_core.hpp"
 #include "swapchain.hpp"
 #include "graphics_pipeline.hpp"
+#include "pipeline_cache.hpp"
 
 namespace ENGINE_NAMESPACE
 {
@@ -25,6 +26,11 @@ namespace ENGINE_NAMESPACE
 		inline device_memory& get_memory() noexcept { return memory; }
 
 		u32 add_graphics_pipeline(const shader& vertex, const shader& fragment);
+
+		/**
+		 * @brief Recreates the graphics pipelines using any of the reloaded shaders, must be called between frames.
+		*/
+		void reload_graphics_pipelines(const std::vector<const shader*>& reloaded);
 		void add_instanced_graphics_pipeline();
 		void add_indirect_graphics_pipeline();
 
@@ -51,9 +57,11 @@ namespace ENGINE_NAMESPACE
 			framebuffers(std::exchange(other.framebuffers, nullptr)),
 			graphics_command_pools(std::exchange(other.graphics_command_pools, nullptr)),
 			command_parallelism(std::exchange(other.command_parallelism, 0)),
+			pipelines_cache(std::move(other.pipelines_cache)),
 			pipeline_stacks(std::move(other.pipeline_stacks)),
 			graphics_command_buffers(std::exchange(other.graphics_command_buffers, nullptr)),
-			graphics_pipelines(std::move(other.graphics_pipelines))
+			graphics_pipelines(std::move(other.graphics_pipelines)),
+			old_pipelines(std::move(other.old_pipelines))
 		{
 			reset_ownerships();
 		}
@@ -110,12 +118,24 @@ namespace ENGINE_NAMESPACE
 
 		VkCommandPool* graphics_command_pools = nullptr;
 		u32 command_parallelism;
+
+		//shared by every pipeline created on this device
+		pipeline_cache pipelines_cache;
 		std::vector<std::vector<graphics_pipeline*>> pipeline_stacks;
 
 		VkCommandBuffer* graphics_command_buffers = nullptr;
 
 		std::vector<graphics_pipeline> graphics_pipelines;
 
+		struct old_pipeline
+		{
+			VkPipeline handle;
+			u8 deletion_frame;
+		};
+
+		//pipelines replaced by shader reloads, kept until no frame in flight uses them
+		std::queue<old_pipeline> old_pipelines;
+
 		void record_secondary_graphics(VkCommandBuffer& buffer, u32 image_index,
 			std::vector<graphics_pipeline*>& graphics_pipelines);
 
@@ -18,12 +18,25 @@ const VkMemoryPropertyFlags download_required_flags =
 	VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_CACHED_BIT;
 const VkMemoryPropertyFlags download_unwanted_flags = VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT;
 
+const VkDeviceSize max_block_size = MEGABYTES(256);
+const VkDeviceSize min_block_size = MEGABYTES(16);
+const VkDeviceSize heap_block_divisor = 8; //blocks never take more than this share of small heaps
+const VkDeviceSize texture_memory_alignment = KILOBYTES(64); //covers the alignment drivers ask of images
+const float default_budget_share = 0.8f; //share of the heap size budgeted without VK_EXT_memory_budget
+
 namespace ENGINE_NAMESPACE
 {
-	device_heap_manager::device_heap_manager(VkPhysicalDevice physical_device)
+	device_heap_manager::device_heap_manager(VkPhysicalDevice physical_device) : m_physical_device(physical_device)
 	{
 		vkGetPhysicalDeviceMemoryProperties(physical_device, &m_mem_properties);
 
+		VkPhysicalDeviceProperties properties;
+		vkGetPhysicalDeviceProperties(physical_device, &properties);
+		m_granularity = std::max<VkDeviceSize>(properties.limits.bufferImageGranularity, 1);
+		m_atom_size = std::max<VkDeviceSize>(properties.limits.nonCoherentAtomSize, 1);
+
+		m_blocks.resize(m_mem_properties.memoryTypeCount);
+
 		constexpr u32 unassigned_idx = std::numeric_limits<u32>::max();
 		m_main_type_idx = unassigned_idx;
 		m_dynamic_type_idx = unassigned_idx;
@@ -121,6 +134,34 @@ namespace ENGINE_NAMESPACE
 		{
 			LOG_INTERNAL_INFO("[RENDERER] Upload heap is NOT host coherent");
 		}
+
+		if (host_coherent_download_heap())
+		{
+			LOG_INTERNAL_INFO("[RENDERER] Download heap is host coherent");
+		}
+		else
+		{
+			LOG_INTERNAL_INFO("[RENDERER] Download heap is NOT host coherent");
+		}
+
+		m_budget_supported = memory_budget_supported(physical_device);
+		update_budget();
+		const heap_budget main_budget = budget(heap::MAIN);
+		LOG_INTERNAL_INFO("[RENDERER] Main heap budget: " << main_budget.budget / MEGABYTES(1) << " MB, "
+			<< main_budget.usage / MEGABYTES(1) << " MB used" << (m_budget_supported ? "" : " (estimated)"));
+	}
+
+	bool device_heap_manager::memory_budget_supported(VkPhysicalDevice physical_device)
+	{
+		u32 count = 0;
+		vkEnumerateDeviceExtensionProperties(physical_device, nullptr, &count, nullptr);
+		std::vector<VkExtensionProperties> extensions(count);
+		vkEnumerateDeviceExtensionProperties(physical_device, nullptr, &count, extensions.data());
+
+		return std::any_of(extensions.begin(), extensions.end(), [](const VkExtensionProperties& extension)
+			{
+				return std::strcmp(extension.extensionName, VK_EXT_MEMORY_BUDGET_EXTENSION_NAME) == 0;
+			});
 	}
 
 	u32 device_heap_manager::find_memory_type(u32 type_filter, VkMemoryPropertyFlags heap_properties)
@@ -173,7 +214,7 @@ namespace ENGINE_NAMESPACE
 	}
 
 	void device_heap_manager::alloc_buffer(VkDevice device,
-		VkDeviceMemory& memory, VkBuffer& buffer, VkDeviceSize size,
+		device_allocation& allocation, VkBuffer& buffer, VkDeviceSize size,
 		VkBufferUsageFlags usage, heap heap)
 	{
 		VkBufferCreateInfo buffer_info = {};
@@ -187,40 +228,225 @@ namespace ENGINE_NAMESPACE
 		VkMemoryRequirements memory_requirements;
 		vkGetBufferMemoryRequirements(device, buffer, &memory_requirements);
 
-		VkMemoryAllocateInfo memory_info = {};
-		memory_info.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
-		memory_info.allocationSize = memory_requirements.size;
-		memory_info.memoryTypeIndex = get_memory_type_idx(heap, memory_requirements.memoryTypeBits);
+		const u32 type = get_memory_type_idx(heap, memory_requirements.memoryTypeBits);
+		sub_allocate(device, type, memory_requirements.size, memory_requirements.alignment, allocation);
 
-		VK_CRASH_CHECK(vkAllocateMemory(device, &memory_info, nullptr, &memory), "Failed to allocate device memory");
+		VK_CRASH_CHECK(vkBindBufferMemory(device, buffer, allocation.memory, allocation.offset), 
+			"Failed to bind buffer memory");
+	}
 
-		vkBindBufferMemory(device, buffer, memory, 0);
+	u32 device_heap_manager::alloc_texture_memory(VkDevice device, device_allocation& allocation, VkDeviceSize size,
+		heap preferred_heap, u32 memory_type_bits)
+	{
+		//images are bound inside of the range, relative to its start, so the range is aligned for any image
+		const u32 type = get_memory_type_idx(preferred_heap, memory_type_bits);
+		sub_allocate(device, type, size, texture_memory_alignment, allocation);
+		return type;
+	}
 
-		m_allocations++;
+	void device_heap_manager::free(VkDevice device, device_allocation& allocation)
+	{
+		if (allocation.memory == VK_NULL_HANDLE)
+			return;
+
+		std::vector<memory_block>& blocks = m_blocks[allocation.type];
+		memory_block& block = blocks[allocation.block];
+		const bool released = block.allocator.free(allocation.block_offset);
+		INTERNAL_ASSERT(released, "Device allocation not found in its block");
+		m_sub_allocations--;
+
+		//the last block of a type is kept, so that a pool freed and allocated again does not reallocate the block
+		if (!block.allocator.allocations())
+		{
+			const std::size_t live_blocks = std::count_if(blocks.begin(), blocks.end(),
+				[](const memory_block& b) { return b.memory != VK_NULL_HANDLE; });
+			if (live_blocks > 1) free_block(device, allocation.type, allocation.block);
+		}
+
+		allocation = {};
 	}
 
-	u32 device_heap_manager::alloc_texture_memory(VkDevice device, VkDeviceMemory& memory, VkDeviceSize size,
-		heap preferred_heap, u32 memory_type_bits)
+	void device_heap_manager::terminate(VkDevice device)
+	{
+		for (u32 type = 0; type < m_blocks.size(); type++)
+		{
+			for (u32 i = 0; i < m_blocks[type].size(); i++)
+			{
+				if (m_blocks[type][i].memory == VK_NULL_HANDLE) continue;
+
+				INTERNAL_ASSERT(!m_blocks[type][i].allocator.allocations(), "Memory block freed with live allocations");
+				free_block(device, type, i);
+			}
+			m_blocks[type].clear();
+		}
+	}
+
+	heap_budget device_heap_manager::budget(heap heap) const noexcept
+	{
+		u32 type = 0;
+		switch (heap)
+		{
+		case heap::MAIN:		type = m_main_type_idx;		break;
+		case heap::DYNAMIC:		type = m_dynamic_type_idx;	break;
+		case heap::UPLOAD:		type = m_upload_type_idx;	break;
+		case heap::DOWNLOAD:	type = m_download_type_idx;	break;
+		default:
+			return {};
+		}
+		if (type >= m_mem_properties.memoryTypeCount)
+			return {};
+
+		return m_budgets[m_mem_properties.memoryTypes[type].heapIndex];
+	}
+
+	void device_heap_manager::sub_allocate(VkDevice device, u32 type, VkDeviceSize size, VkDeviceSize alignment,
+		device_allocation& out_allocation)
+	{
+		//whole granularity pages and atoms, so that neither resources nor flushed ranges share them across allocations
+		const VkDeviceSize page = std::max(m_granularity, m_atom_size);
+		alignment = std::max(alignment, page);
+		size = (size + page - 1) / page * page;
+
+		std::vector<memory_block>& blocks = m_blocks[type];
+		u32 block_idx = 0;
+		tlsf_allocator::block_idx_t range_idx = tlsf_allocator::invalid_block;
+		VkDeviceSize size_needed = 0;
+		for (; block_idx < blocks.size(); block_idx++)
+		{
+			if (blocks[block_idx].memory == VK_NULL_HANDLE) continue;
+
+			range_idx = blocks[block_idx].allocator.search(size, alignment, size_needed);
+			if (range_idx != tlsf_allocator::invalid_block) break;
+		}
+
+		if (range_idx == tlsf_allocator::invalid_block)
+		{
+			//a new block is a single free range at offset 0, which search could pass over for requests close to the
+			//block size, as it only looks at size classes where every range fits
+			block_idx = alloc_block(device, type, size);
+			range_idx = 0;
+			size_needed = size;
+		}
+
+		memory_block& block = blocks[block_idx];
+		const VkDeviceSize block_offset = block.allocator.allocate(range_idx, size_needed);
+		const VkDeviceSize offset = block_offset + (size_needed - size);
+		m_sub_allocations++;
+
+		out_allocation.memory = block.memory;
+		out_allocation.offset = offset;
+		out_allocation.host_ptr = block.host_ptr ? static_cast<std::byte*>(block.host_ptr) + offset : nullptr;
+		out_allocation.type = type;
+		out_allocation.block = block_idx;
+		out_allocation.block_offset = block_offset;
+	}
+
+	u32 device_heap_manager::alloc_block(VkDevice device, u32 type, VkDeviceSize min_size)
 	{
+		const u32 heap_idx = m_mem_properties.memoryTypes[type].heapIndex;
+		const VkDeviceSize heap_size = m_mem_properties.memoryHeaps[heap_idx].size;
+
+		VkDeviceSize block_size = std::max(std::min(max_block_size, heap_size / heap_block_divisor), min_block_size);
+
+		update_budget();
+		const heap_budget& heap_budget = m_budgets[heap_idx];
+
+		//larger allocations get a block of their own, otherwise the block shrinks as the heap nears its budget
+		if (min_size > block_size / 2)
+			block_size = min_size;
+		else
+			while (block_size / 2 >= std::max(min_size, min_block_size) && heap_budget.usage + block_size > heap_budget.budget)
+				block_size /= 2;
+
+		if (heap_budget.usage + block_size > heap_budget.budget)
+		{
+			LOG_INTERNAL_WARN("[RENDERER] Memory heap " << heap_idx << " over budget: " << heap_budget.usage / MEGABYTES(1)
+				<< " MB used, " << block_size / MEGABYTES(1) << " MB requested, " << heap_budget.budget / MEGABYTES(1)
+				<< " MB budget");
+		}
+
+		memory_block block;
+
 		VkMemoryAllocateInfo memory_info = {};
 		memory_info.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
-		memory_info.allocationSize = size;
-		memory_info.memoryTypeIndex = get_memory_type_idx(preferred_heap, memory_type_bits);
+		memory_info.allocationSize = block_size;
+		memory_info.memoryTypeIndex = type;
+
+		VK_CRASH_CHECK(vkAllocateMemory(device, &memory_info, nullptr, &block.memory), "Failed to allocate device memory");
+
+		if (m_mem_properties.memoryTypes[type].propertyFlags & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT)
+			VK_CRASH_CHECK(vkMapMemory(device, block.memory, 0, VK_WHOLE_SIZE, 0, &block.host_ptr), "Failed to map memory");
 
-		VK_CRASH_CHECK(vkAllocateMemory(device, &memory_info, nullptr, &memory), "Failed to allocate device memory");
+		block.allocator = tlsf_allocator(block_size);
 
 		m_allocations++;
+		m_reserved += block_size;
+		m_heap_reserved[heap_idx] += block_size;
+		update_budget();
 
-		return memory_info.memoryTypeIndex;
+		LOG_INTERNAL_INFO("[RENDERER] Allocated memory block of " << block_size / KILOBYTES(1) << " KB in memory type " 
+			<< type << " (" << m_allocations << " device allocations)");
+
+		//slots of freed blocks are reused, allocations refer to their block by index
+		std::vector<memory_block>& blocks = m_blocks[type];
+		for (u32 i = 0; i < blocks.size(); i++)
+		{
+			if (blocks[i].memory == VK_NULL_HANDLE)
+			{
+				blocks[i] = std::move(block);
+				return i;
+			}
+		}
+		blocks.push_back(std::move(block));
+		return static_cast<u32>(blocks.size() - 1);
 	}
 
-	void device_heap_manager::free(VkDevice device, VkDeviceMemory& memory)
+	void device_heap_manager::free_block(VkDevice device, u32 type, u32 block_idx)
 	{
+		memory_block& block = m_blocks[type][block_idx];
+		const VkDeviceSize block_size = block.allocator.size();
+		const u32 heap_idx = m_mem_properties.memoryTypes[type].heapIndex;
+
+		if (block.host_ptr)
+			vkUnmapMemory(device, block.memory);
+
 		//having to call free from the heap manager instead of freeing the memory directly is a bit silly, but since
 		//the number of allocations will be counted for debugging and profiling, may aswell do it like this
 		//it also falls more inline with the purpose of the heap manager
-		vkFreeMemory(device, memory, nullptr);
-		memory = VK_NULL_HANDLE;
+		vkFreeMemory(device, block.memory, nullptr);
+		block = memory_block();
+
 		m_allocations--;
+		m_reserved -= block_size;
+		m_heap_reserved[heap_idx] -= block_size;
+		update_budget();
+	}
+
+	void device_heap_manager::update_budget()
+	{
+		if (!m_budget_supported)
+		{
+			for (u32 i = 0; i < m_mem_properties.memoryHeapCount; i++)
+			{
+				m_budgets[i].budget = static_cast<VkDeviceSize>(m_mem_properties.memoryHeaps[i].size * default_budget_share);
+				m_budgets[i].usage = m_heap_reserved[i];
+			}
+			return;
+		}
+
+		VkPhysicalDeviceMemoryBudgetPropertiesEXT budget_properties = {};
+		budget_properties.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_MEMORY_BUDGET_PROPERTIES_EXT;
+
+		VkPhysicalDeviceMemoryProperties2 properties = {};
+		properties.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_MEMORY_PROPERTIES_2;
+		properties.pNext = &budget_properties;
+
+		vkGetPhysicalDeviceMemoryProperties2(m_physical_device, &properties);
+
+		for (u32 i = 0; i < m_mem_properties.memoryHeapCount; i++)
+		{
+			m_budgets[i].budget = budget_properties.heapBudget[i];
+			m_budgets[i].usage = budget_properties.heapUsage[i];
+		}
 	}
 }
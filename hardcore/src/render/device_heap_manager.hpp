@@ -1,9 +1,36 @@
 #pragma once
 
 #include "render_core.hpp"
+#include "tlsf_allocator.hpp"
 
 namespace ENGINE_NAMESPACE
 {
+	/**
+	 * @brief Range of a memory block handed out by the heap manager. Resources are bound at memory + offset, and flush
+	 * ranges are offset by it as well.
+	*/
+	struct device_allocation
+	{
+		VkDeviceMemory memory = VK_NULL_HANDLE;
+		VkDeviceSize offset = 0;
+		void* host_ptr = nullptr; //start of the allocation in the persistent mapping of its block, host visible heaps only
+
+		u32 type = std::numeric_limits<u32>::max();
+		u32 block = std::numeric_limits<u32>::max();
+		VkDeviceSize block_offset = 0; //start of the range in the block's allocator, before alignment
+	};
+
+	struct heap_budget
+	{
+		VkDeviceSize budget = 0; //how much the process can allocate from the heap without performance issues
+		VkDeviceSize usage = 0;
+	};
+
+	/**
+	 * @brief Hands out ranges of large memory blocks, so that pools do not each need a vkAllocateMemory call, which are
+	 * slow and capped by maxMemoryAllocationCount. Blocks of host visible memory types are mapped for their whole
+	 * lifetime, as a block can only be mapped once.
+	*/
 	class device_heap_manager
 	{
 	public:
@@ -19,6 +46,12 @@ namespace ENGINE_NAMESPACE
 		device_heap_manager() = default;
 		device_heap_manager(VkPhysicalDevice physical_device);
 
+		/**
+		 * @brief Checks for VK_EXT_memory_budget, which has to be enabled on the logical device for the heap manager to
+		 * use the budgets reported by the driver.
+		*/
+		static bool memory_budget_supported(VkPhysicalDevice physical_device);
+
 		device_heap_manager(const device_heap_manager&) = delete;
 		device_heap_manager& operator=(const device_heap_manager&) = delete;
 
@@ -26,13 +59,27 @@ namespace ENGINE_NAMESPACE
 		device_heap_manager& operator=(device_heap_manager&&) = default;
 
 		void alloc_buffer(VkDevice device,
-			VkDeviceMemory& memory, VkBuffer& buffer, VkDeviceSize size,
+			device_allocation& allocation, VkBuffer& buffer, VkDeviceSize size,
 			VkBufferUsageFlags usage, heap heap);
 
-		u32 alloc_texture_memory(VkDevice device, VkDeviceMemory& memory, VkDeviceSize size,
+		u32 alloc_texture_memory(VkDevice device, device_allocation& allocation, VkDeviceSize size,
 			heap preferred_heap, u32 memory_type_bits);
 
-		void free(VkDevice device, VkDeviceMemory& memory);
+		/**
+		 * @brief Returns the range to its block, an emptied block is freed unless it is the last one of its memory type.
+		*/
+		void free(VkDevice device, device_allocation& allocation);
+
+		/**
+		 * @brief Frees the remaining blocks, every allocation must have been freed first.
+		*/
+		void terminate(VkDevice device);
+
+		/**
+		 * @brief Budget of the memory heap backing one of the heap types, as last queried. Without VK_EXT_memory_budget
+		 * the budget is a share of the heap size and the usage only counts the blocks of the heap manager.
+		*/
+		heap_budget budget(heap heap) const noexcept;
 
 		const VkPhysicalDeviceMemoryProperties& mem_properties() const noexcept { return m_mem_properties; }
 
@@ -46,16 +93,50 @@ namespace ENGINE_NAMESPACE
 			return m_mem_properties.memoryTypes[m_upload_type_idx].propertyFlags & VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
 		}
 
+		inline bool host_coherent_download_heap() const noexcept
+		{
+			return m_mem_properties.memoryTypes[m_download_type_idx].propertyFlags & VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
+		}
+
+		//device memory allocations, one per block
 		u32 allocations() const noexcept { return m_allocations; }
+		u32 sub_allocations() const noexcept { return m_sub_allocations; }
+		VkDeviceSize reserved() const noexcept { return m_reserved; }
 
 	private:
+		struct memory_block
+		{
+			VkDeviceMemory memory = VK_NULL_HANDLE; //null for the slots of freed blocks
+			void* host_ptr = nullptr;
+			tlsf_allocator allocator;
+		};
+
 		u32 find_memory_type(u32 type_filter, VkMemoryPropertyFlags properties);
 		u32 get_memory_type_idx(heap heap, u32 memory_type_bits) const;
 
+		void sub_allocate(VkDevice device, u32 type, VkDeviceSize size, VkDeviceSize alignment,
+			device_allocation& out_allocation);
+		u32 alloc_block(VkDevice device, u32 type, VkDeviceSize min_size);
+		void free_block(VkDevice device, u32 type, u32 block);
+
+		void update_budget();
+
+		VkPhysicalDevice m_physical_device = VK_NULL_HANDLE;
 		VkPhysicalDeviceMemoryProperties m_mem_properties;
 
 		u32 m_main_type_idx, m_dynamic_type_idx, m_upload_type_idx, m_download_type_idx;
 
+		VkDeviceSize m_granularity = 1; //bufferImageGranularity, buffers and images never share a page of that size
+		VkDeviceSize m_atom_size = 1;
+
+		std::vector<std::vector<memory_block>> m_blocks; //memory type => blocks
+
+		bool m_budget_supported = false;
+		std::array<heap_budget, VK_MAX_MEMORY_HEAPS> m_budgets = {};
+		std::array<VkDeviceSize, VK_MAX_MEMORY_HEAPS> m_heap_reserved = {};
+
 		u32 m_allocations = 0;
+		u32 m_sub_allocations = 0;
+		VkDeviceSize m_reserved = 0;
 	};
 }
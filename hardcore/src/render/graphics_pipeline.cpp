@@ -2,6 +2,7 @@
 
 #include <render/device.hpp>
 #include <render/graphics_pipeline.hpp>
+#include <render/renderer_internal.hpp>
 
 #include <debug/log_internal.hpp>
 
@@ -396,13 +397,11 @@ namespace ENGINE_NAMESPACE
 		const VkExtent2D& extent) : graphics_pipeline(owner, shaders, extent, false) {}
 
 	graphics_pipeline::graphics_pipeline(device& owner, const std::vector<const shader*>& shaders, 
-		const VkExtent2D& extent, bool dynamic_viewport) : owner(&owner)
+		const VkExtent2D& extent, bool dynamic_viewport) : owner(&owner), stages(shaders), extent(extent),
+		dynamic_viewport(dynamic_viewport)
 	{
 		LOG_INTERNAL_INFO("Initialising new graphics pipeline..");
 
-		VkPipelineVertexInputStateCreateInfo vertex_input_info = 
-			to_pipeline_inputs(static_cast<const internal_shader*>(shaders[0])->inputs());
-
 		init_descriptors(owner.handle, shaders, n_descriptor_pool_sizes, descriptor_pool_sizes,
 			&n_descriptor_set_layouts, &descriptor_set_layouts, &frame_descriptors[0].descriptor_pool, &descriptor_sets,
 			&n_object_bindings, &object_binding_types);
@@ -423,6 +422,26 @@ namespace ENGINE_NAMESPACE
 			frame_descriptors[i].object_set_cap = frame_descriptors[0].object_set_cap;
 		}
 
+		VkPipelineLayoutCreateInfo pipeline_layout_info = {};
+		pipeline_layout_info.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+		pipeline_layout_info.setLayoutCount = n_descriptor_set_layouts;
+		pipeline_layout_info.pSetLayouts = descriptor_set_layouts;
+		pipeline_layout_info.pushConstantRangeCount = 0;
+		pipeline_layout_info.pPushConstantRanges = nullptr;
+
+		VK_CRASH_CHECK(vkCreatePipelineLayout(owner.handle, &pipeline_layout_info, nullptr, &pipeline_layout),
+			"Failed to create pipeline layout");
+
+		handle = create_handle(shaders);
+
+		objects = object_vector(0, n_object_bindings, n_dynamic_descriptors);
+	}
+
+	VkPipeline graphics_pipeline::create_handle(const std::vector<const shader*>& shaders) const
+	{
+		VkPipelineVertexInputStateCreateInfo vertex_input_info = 
+			to_pipeline_inputs(static_cast<const internal_shader*>(shaders[0])->inputs());
+
 		VkPipelineInputAssemblyStateCreateInfo inputAssembly = {};
 		inputAssembly.sType = VK_STRUCTURE_TYPE_PIPELINE_INPUT_ASSEMBLY_STATE_CREATE_INFO;
 		inputAssembly.topology = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST; //primitives
@@ -510,22 +529,12 @@ namespace ENGINE_NAMESPACE
 		VkDynamicState states_array[2] = { VK_DYNAMIC_STATE_VIEWPORT, VK_DYNAMIC_STATE_SCISSOR };
 		dynamic_state.pDynamicStates = states_array;
 
-		VkPipelineLayoutCreateInfo pipeline_layout_info = {};
-		pipeline_layout_info.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
-		pipeline_layout_info.setLayoutCount = n_descriptor_set_layouts;
-		pipeline_layout_info.pSetLayouts = descriptor_set_layouts;
-		pipeline_layout_info.pushConstantRangeCount = 0;
-		pipeline_layout_info.pPushConstantRanges = nullptr;
-
-		VK_CRASH_CHECK(vkCreatePipelineLayout(owner.handle, &pipeline_layout_info, nullptr, &pipeline_layout),
-			"Failed to create pipeline layout");
-
 		u32 stage_count = 0;
 		VkPipelineShaderStageCreateInfo* shader_stages = t_calloc<VkPipelineShaderStageCreateInfo>(shaders.size());
 		for (const shader* shader : shaders)
 		{
 			shader_stages[stage_count].sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
-			shader_stages[stage_count].module = internal_shader::create_shader_module(*shader, owner.handle, 
+			shader_stages[stage_count].module = internal_shader::create_shader_module(*shader, owner->handle, 
 				&shader_stages[stage_count].stage, &shader_stages[stage_count].pName);
 			stage_count++;
 		}
@@ -543,7 +552,7 @@ namespace ENGINE_NAMESPACE
 		pipeline_info.pColorBlendState = &color_blending;
 		pipeline_info.pDynamicState = dynamic_viewport ? &dynamic_state : nullptr;
 		pipeline_info.layout = pipeline_layout;
-		pipeline_info.renderPass = owner.render_pass;
+		pipeline_info.renderPass = owner->render_pass;
 		pipeline_info.subpass = 0;
 		pipeline_info.basePipelineHandle = VK_NULL_HANDLE; // Optional
 		pipeline_info.basePipelineIndex = -1; // Optional
@@ -551,14 +560,13 @@ namespace ENGINE_NAMESPACE
 		pipeline_info.flags = 0;
 		pipeline_info.pTessellationState = nullptr;
 
-		VK_CRASH_CHECK(vkCreateGraphicsPipelines(owner.handle, VK_NULL_HANDLE, 1, &pipeline_info, nullptr, &handle),
+		VkPipeline pipeline = VK_NULL_HANDLE;
+		VK_CRASH_CHECK(vkCreateGraphicsPipelines(owner->handle, owner->pipelines_cache.handle(), 1, &pipeline_info, nullptr, &pipeline),
 			"Failed to create pipeline");
 
-		objects = object_vector(0, n_object_bindings, n_dynamic_descriptors);
-
 		for (u32 i = 0; i < stage_count; i++)
 		{
-			vkDestroyShaderModule(owner.handle, shader_stages[i].module, nullptr);
+			vkDestroyShaderModule(owner->handle, shader_stages[i].module, nullptr);
 			std::free(const_cast<char*>(shader_stages[i].pName)); //a bit messy, but shouldn't cause issues
 		}
 
@@ -567,6 +575,25 @@ namespace ENGINE_NAMESPACE
 		//ideally these shouldnt be manually allocated
 		std::free(const_cast<VkVertexInputBindingDescription*>(vertex_input_info.pVertexBindingDescriptions)); //a bit messy, but shouldn't cause issues
 		std::free(const_cast<VkVertexInputAttributeDescription*>(vertex_input_info.pVertexAttributeDescriptions)); //a bit messy, but shouldn't cause issues
+
+		return pipeline;
+	}
+
+	VkPipeline graphics_pipeline::reload(const std::vector<const shader*>& reloaded)
+	{
+		const auto is_reloaded = [&reloaded](const shader* s)
+			{ return std::find(reloaded.begin(), reloaded.end(), s) != reloaded.end(); };
+		if (std::none_of(stages.begin(), stages.end(), is_reloaded)) return VK_NULL_HANDLE;
+
+		//stages created outside of the library may no longer exist
+		if (!std::all_of(stages.begin(), stages.end(), shader_library::owns))
+		{
+			LOG_INTERNAL_WARN("Graphics pipeline not reloaded, some of its shaders are not in the shader library");
+			return VK_NULL_HANDLE;
+		}
+
+		LOG_INTERNAL_INFO("Reloading graphics pipeline..");
+		return std::exchange(handle, create_handle(stages));
 	}
 
 	graphics_pipeline::~graphics_pipeline()
@@ -630,10 +657,27 @@ namespace ENGINE_NAMESPACE
 		}
 	}
 
+	bool graphics_pipeline::drawable(device_memory& memory, const object_vector::object_ref& obj) const
+	{
+		const task_properties& props = obj.properties();
+		if (!memory.drawable(props.binding.ref)) return false;
+		if (props.index_t != VK_INDEX_TYPE_NONE_KHR && !memory.drawable(props.index_binding.ref)) return false;
+
+		const buffer_binding_args* bindings = obj.bindings();
+		for (u32 i = 0; i < n_object_bindings; i++)
+			if (!memory.drawable(bindings[i].ref)) return false;
+
+		return true;
+	}
+
 	void graphics_pipeline::record_commands(VkCommandBuffer& buffer, u8 current_frame)
 	{
 		vkCmdBindPipeline(buffer, VK_PIPELINE_BIND_POINT_GRAPHICS, handle);
 
+		//objects whose data is still being uploaded are skipped until it is, the check is skipped when nothing is
+		device_memory& memory = owner->get_memory();
+		const bool check = !memory.all_drawable();
+
 		//pipeline sets
 		if (n_descriptor_pool_sizes[1])
 			vkCmdBindDescriptorSets(buffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline_layout, 0, 1,
@@ -645,6 +689,8 @@ namespace ENGINE_NAMESPACE
 			{
 				for (const auto& obj : objects)
 				{
+					if (check && !drawable(memory, obj)) continue;
+
 					vkCmdPushConstants(buffer, pipeline_layout, push_flags, 0, push_data_size, obj.push_data());
 
 					vkCmdBindDescriptorSets(buffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline_layout, 0, 1, 
@@ -658,6 +704,8 @@ namespace ENGINE_NAMESPACE
 			{
 				for (const auto& obj : objects)
 				{
+					if (check && !drawable(memory, obj)) continue;
+
 					vkCmdBindDescriptorSets(buffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline_layout, 0, 1,
 						&descriptor_sets[obj.properties().descriptor_set_idx + frame_descriptor_count * current_frame], 
 						n_dynamic_descriptors, obj.dynamic_offsets());
@@ -672,6 +720,8 @@ namespace ENGINE_NAMESPACE
 			{
 				for (const auto& obj : objects)
 				{
+					if (check && !drawable(memory, obj)) continue;
+
 					vkCmdPushConstants(buffer, pipeline_layout, push_flags, 0, push_data_size, obj.push_data());
 
 					draw_object(buffer, obj.properties());
@@ -680,7 +730,10 @@ namespace ENGINE_NAMESPACE
 			else
 			{
 				for (const auto& obj : objects)
+				{
+					if (check && !drawable(memory, obj)) continue;
 					draw_object(buffer, obj.properties());
+				}
 			}
 		}
 	}
@@ -768,8 +821,37 @@ namespace ENGINE_NAMESPACE
 		return res;
 	}
 
+	void graphics_pipeline::refresh_bindings(u8 current_frame)
+	{
+		device_memory& memory = owner->get_memory();
+		if (relocations == memory.relocations()) return;
+		relocations = memory.relocations();
+
+		for (std::size_t i = 0; i < objects.size(); i++)
+		{
+			auto obj = objects[i];
+			task_properties& props = obj.properties();
+			memory.refresh_binding(props.binding);
+			if (props.index_t != VK_INDEX_TYPE_NONE_KHR)
+				memory.refresh_binding(props.index_binding);
+
+			buffer_binding_args* bindings = obj.bindings();
+			for (u32 binding_idx = 0; binding_idx < n_object_bindings; binding_idx++)
+			{
+				const VkBuffer previous = bindings[binding_idx].buffer;
+				if (!memory.refresh_binding(bindings[binding_idx])) continue;
+
+				obj.dynamic_offsets()[binding_idx] = static_cast<dynamic_offset_t>(bindings[binding_idx].offset);
+				if (bindings[binding_idx].buffer != previous)
+					frame_descriptors[current_frame].dirty = true;
+			}
+		}
+	}
+
 	void graphics_pipeline::update_descriptor_sets(u8 previous_frame, u8 current_frame, u8 next_frame)
 	{
+		refresh_bindings(current_frame);
+
 		if (!n_descriptor_pool_sizes[0]) return;
 
 		if (frame_descriptors[current_frame].object_set_cap < frame_descriptors[previous_frame].object_set_cap)
@@ -965,12 +1047,21 @@ namespace ENGINE_NAMESPACE
 	{ return owner->get_memory().binding_args(resource); }
 	buffer_binding_args graphics_pipeline::get_binding(const dynamic_storage_vector& resource) const
 	{ return owner->get_memory().binding_args(resource); }
+	buffer_binding_args graphics_pipeline::get_binding(const transient_uniform& buffer) const
+	{ return owner->get_memory().binding_args(buffer); }
+	buffer_binding_args graphics_pipeline::get_binding(const transient_storage& buffer) const
+	{ return owner->get_memory().binding_args(buffer); }
 
 	void graphics_pipeline::set_descriptor(std::size_t object_idx, u32 binding_idx, buffer_binding_args&& binding)
 	{
-		frame_descriptors[owner->current_frame].dirty = true;
 		auto obj = objects[object_idx];
-		obj.bindings()[binding_idx] = binding;
+		buffer_binding_args& current = obj.bindings()[binding_idx];
+
+		//only the dynamic offset changes when the buffer and range stay the same, such as with transient buffers bumped
+		//from the same ring every frame, so the descriptor sets are still valid
+		if (current.buffer != binding.buffer || current.frame_offset != binding.frame_offset || current.size != binding.size)
+			frame_descriptors[owner->current_frame].dirty = true;
+		current = binding;
 		//TODO binding_idx takes textures and other things into account, which must be skipped for the dynamic_offset_idx
 		obj.dynamic_offsets()[binding_idx] = static_cast<dynamic_offset_t>(binding.offset);
 	}
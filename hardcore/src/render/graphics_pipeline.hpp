@@ -30,6 +30,7 @@ namespace ENGINE_NAMESPACE
 			descriptor_set_layouts(std::exchange(other.descriptor_set_layouts, VK_NULL_HANDLE)),
 			pipeline_layout(std::exchange(other.pipeline_layout, VK_NULL_HANDLE)),
 			handle(std::exchange(other.handle, VK_NULL_HANDLE)),
+			stages(std::move(other.stages)), extent(other.extent), dynamic_viewport(other.dynamic_viewport),
 			n_descriptor_pool_sizes{ std::exchange(other.n_descriptor_pool_sizes[0], 0), 
 				std::exchange(other.n_descriptor_pool_sizes[1], 0) },
 			descriptor_pool_sizes{ std::exchange(other.descriptor_pool_sizes[0], nullptr),
@@ -43,6 +44,7 @@ namespace ENGINE_NAMESPACE
 			n_dynamic_descriptors(std::exchange(other.n_dynamic_descriptors, 0)),
 			object_refs(std::move(other.object_refs)),
 			objects(std::move(other.objects)),
+			relocations(std::exchange(other.relocations, 0)),
 			cached_object_bindings(std::move(other.cached_object_bindings))
 		{}
 
@@ -54,6 +56,9 @@ namespace ENGINE_NAMESPACE
 			descriptor_set_layouts = std::exchange(other.descriptor_set_layouts, VK_NULL_HANDLE);
 			pipeline_layout = std::exchange(other.pipeline_layout, VK_NULL_HANDLE);
 			handle = std::exchange(other.handle, VK_NULL_HANDLE);
+			stages = std::move(other.stages);
+			extent = other.extent;
+			dynamic_viewport = other.dynamic_viewport;
 			n_descriptor_pool_sizes[0] = std::exchange(other.n_descriptor_pool_sizes[0], 0);
 			n_descriptor_pool_sizes[1] = std::exchange(other.n_descriptor_pool_sizes[1], 0);
 			descriptor_pool_sizes[0] = std::exchange(other.descriptor_pool_sizes[0], nullptr);
@@ -67,6 +72,7 @@ namespace ENGINE_NAMESPACE
 			n_dynamic_descriptors = std::exchange(other.n_dynamic_descriptors, 0);
 			object_refs = std::move(other.object_refs);
 			objects = std::move(other.objects);
+			relocations = std::exchange(other.relocations, 0);
 			cached_object_bindings = std::move(other.cached_object_bindings);
 			return *this;
 		}
@@ -74,6 +80,15 @@ namespace ENGINE_NAMESPACE
 		void record_commands(VkCommandBuffer& buffer, u8 current_frame);
 		void update_descriptor_sets(u8 previous_frame, u8 current_frame, u8 next_frame);
 
+		/**
+		 * @brief Recreates the pipeline from shaders reloaded in place, keeping its layout, descriptors and objects. The
+		 * reloaded shaders must have the same inputs and descriptors as before.
+		 * @param reloaded Shader library entries that have been reloaded.
+		 * @return Replaced handle, to be destroyed once no frame in flight uses it, or VK_NULL_HANDLE if the pipeline
+		 * uses none of the reloaded shaders.
+		*/
+		VkPipeline reload(const std::vector<const shader*>& reloaded);
+
 		std::size_t add(const mesh& object);
 		void remove(const mesh& object);
 
@@ -81,7 +96,7 @@ namespace ENGINE_NAMESPACE
 		inline void set_instances(std::size_t object_idx, u32 num) { objects[object_idx].properties().instances = num; }
 
 		template<typename Type, 
-			std::enable_if_t<std::is_base_of<resource, Type>::value && std::is_final<Type>::value, bool> = true>
+			std::enable_if_t<is_descriptor_buffer<Type>::value, bool> = true>
 		inline std::size_t set_descriptor(const mesh& object, u32 descriptor_idx, const Type& buffer)
 		{
 			auto it = object_refs.find(std::hash<resource>{}(object));
@@ -93,7 +108,7 @@ namespace ENGINE_NAMESPACE
 		}
 
 		template<typename Type,
-			std::enable_if_t<std::is_base_of<resource, Type>::value && std::is_final<Type>::value, bool> = true>
+			std::enable_if_t<is_descriptor_buffer<Type>::value, bool> = true>
 		inline void set_descriptor(std::size_t object_idx, u32 descriptor_idx, const Type& buffer)
 		{
 			INTERNAL_ASSERT(n_object_bindings > descriptor_idx, "Descriptor index out of bounds");
@@ -111,6 +126,8 @@ namespace ENGINE_NAMESPACE
 		graphics_pipeline(device& owner, const std::vector<const shader*>& shaders, const VkExtent2D& extent, 
 			bool dynamic_viewport);
 
+		VkPipeline create_handle(const std::vector<const shader*>& shaders) const;
+
 		inline bool type_match(u32 descriptor_idx, const uniform&) const noexcept
 		{ return object_binding_types[descriptor_idx] == VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC; }
 		inline bool type_match(u32 descriptor_idx, const unmapped_uniform&) const noexcept
@@ -123,6 +140,10 @@ namespace ENGINE_NAMESPACE
 		{ return object_binding_types[descriptor_idx] == VK_DESCRIPTOR_TYPE_STORAGE_BUFFER_DYNAMIC; }
 		inline bool type_match(u32 descriptor_idx, const dynamic_storage_vector&) const noexcept
 		{ return object_binding_types[descriptor_idx] == VK_DESCRIPTOR_TYPE_STORAGE_BUFFER_DYNAMIC; }
+		inline bool type_match(u32 descriptor_idx, const transient_uniform&) const noexcept
+		{ return object_binding_types[descriptor_idx] == VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC; }
+		inline bool type_match(u32 descriptor_idx, const transient_storage&) const noexcept
+		{ return object_binding_types[descriptor_idx] == VK_DESCRIPTOR_TYPE_STORAGE_BUFFER_DYNAMIC; }
 
 		buffer_binding_args get_binding(const uniform& resource) const;
 		buffer_binding_args get_binding(const unmapped_uniform& resource) const;
@@ -130,6 +151,8 @@ namespace ENGINE_NAMESPACE
 		buffer_binding_args get_binding(const dynamic_storage_array& resource) const;
 		buffer_binding_args get_binding(const storage_vector& resource) const;
 		buffer_binding_args get_binding(const dynamic_storage_vector& resource) const;
+		buffer_binding_args get_binding(const transient_uniform& buffer) const;
+		buffer_binding_args get_binding(const transient_storage& buffer) const;
 
 		void set_descriptor(std::size_t object_idx, u32 descriptor_idx, buffer_binding_args&& binding);
 
@@ -140,6 +163,11 @@ namespace ENGINE_NAMESPACE
 		VkPipelineLayout pipeline_layout = VK_NULL_HANDLE;
 		VkPipeline handle = VK_NULL_HANDLE;
 
+		//kept to recreate the pipeline on shader reloads, only dereferenced while they are owned by the shader library
+		std::vector<const shader*> stages;
+		VkExtent2D extent = {};
+		bool dynamic_viewport = true;
+
 		u32 push_data_size = 0;
 		VkShaderStageFlags push_flags = 0;
 
@@ -369,11 +397,23 @@ namespace ENGINE_NAMESPACE
 		std::unordered_map<std::size_t, std::size_t> object_refs; //TODO change key to memory_ref to avoid collisions
 		object_vector objects;
 
+		u64 relocations = 0; //device memory relocations the bindings are up to date with
+
 		std::vector<buffer_binding_args> cached_object_bindings;
 		std::vector<VkDescriptorBufferInfo> cached_buffer_infos;
 
 		static void draw_object(VkCommandBuffer& buffer, const task_properties& obj);
 
+		/**
+		 * @brief Checks whether the data of every buffer the object reads has been submitted to the transfer queue.
+		*/
+		bool drawable(device_memory& memory, const object_vector::object_ref& obj) const;
+
+		/**
+		 * @brief Points the bindings of allocations moved by the device memory at their new position.
+		*/
+		void refresh_bindings(u8 current_frame);
+
 		std::vector<VkWriteDescriptorSet> generate_descriptor_write(u8 current_frame);
 
 		inline static const char* debug_descriptor_type(VkDescriptorType type)
@@ -2,12 +2,22 @@
 
 #include <render/memory.hpp>
 #include <render/device.hpp>
+#include <render/renderer_internal.hpp>
 
 #include <debug/log_internal.hpp>
 
 namespace ENGINE_NAMESPACE
 {
 	const VkDeviceSize staging_buffer_size = MEGABYTES(8);
+	const VkDeviceSize staging_ring_size = staging_buffer_size * max_frames_in_flight; //shared by the frames in flight
+	const VkDeviceSize thread_staging_ring_size = MEGABYTES(4); //first ring of the threads other than the render thread
+	const VkDeviceSize stream_frame_budget = staging_buffer_size; //streamed bytes staged per frame
+	const VkDeviceSize upload_frame_budget = MEGABYTES(32); //staged bytes copied per frame, larger uploads are split
+	const VkDeviceSize transient_ring_size = MEGABYTES(4);
+	const VkDeviceSize download_ring_size = MEGABYTES(4); //first ring of the downloads, allocated on the first one
+	const VkBufferUsageFlags transient_ring_usage = VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT;
+	const VkDeviceSize defrag_frame_budget = MEGABYTES(2); //bytes moved by the defragmenter per frame
+	const float defrag_occupancy = 0.25f; //static pools used below this share are emptied into the other pools of their type
 
 	template<device_memory::buffer_t BType>
 	struct buffer { static_assert(BType < device_memory::buffer_t::NONE, "Unimplemented buffer type"); };
@@ -15,7 +25,8 @@ namespace ENGINE_NAMESPACE
 	struct buffer<device_memory::buffer_t::VERTEX>
 	{
 		static constexpr const char* debug_name = "VERTEX";
-		static const VkBufferUsageFlags usage = VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_VERTEX_BUFFER_BIT;
+		static const VkBufferUsageFlags usage = VK_BUFFER_USAGE_TRANSFER_SRC_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT |
+			VK_BUFFER_USAGE_VERTEX_BUFFER_BIT;
 		static const VkDeviceSize size = MEGABYTES(8);
 		static const VkBufferUsageFlags dynamic_usage = VK_BUFFER_USAGE_VERTEX_BUFFER_BIT;
 		static const VkDeviceSize dynamic_size = MEGABYTES(8);
@@ -24,7 +35,8 @@ namespace ENGINE_NAMESPACE
 	struct buffer<device_memory::buffer_t::INDEX>
 	{
 		static constexpr const char* debug_name = "INDEX";
-		static const VkBufferUsageFlags usage = VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_INDEX_BUFFER_BIT;
+		static const VkBufferUsageFlags usage = VK_BUFFER_USAGE_TRANSFER_SRC_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT |
+			VK_BUFFER_USAGE_INDEX_BUFFER_BIT;
 		static const VkDeviceSize size = MEGABYTES(8);
 		static const VkBufferUsageFlags dynamic_usage = VK_BUFFER_USAGE_INDEX_BUFFER_BIT;
 		static const VkDeviceSize dynamic_size = MEGABYTES(8);
@@ -33,7 +45,8 @@ namespace ENGINE_NAMESPACE
 	struct buffer<device_memory::buffer_t::UNIFORM>
 	{
 		static constexpr const char* debug_name = "UNIFORM";
-		static const VkBufferUsageFlags usage = VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT;
+		static const VkBufferUsageFlags usage = VK_BUFFER_USAGE_TRANSFER_SRC_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT |
+			VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT;
 		static const VkDeviceSize size = MEGABYTES(8);
 		static const VkBufferUsageFlags dynamic_usage = VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT;
 		static const VkDeviceSize dynamic_size = MEGABYTES(8);
@@ -42,7 +55,8 @@ namespace ENGINE_NAMESPACE
 	struct buffer<device_memory::buffer_t::STORAGE>
 	{
 		static constexpr const char* debug_name = "STORAGE";
-		static const VkBufferUsageFlags usage = VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT;
+		static const VkBufferUsageFlags usage = VK_BUFFER_USAGE_TRANSFER_SRC_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT |
+			VK_BUFFER_USAGE_STORAGE_BUFFER_BIT;
 		static const VkDeviceSize size = MEGABYTES(8);
 		static const VkBufferUsageFlags dynamic_usage = VK_BUFFER_USAGE_STORAGE_BUFFER_BIT;
 		static const VkDeviceSize dynamic_size = MEGABYTES(8);
@@ -76,54 +90,96 @@ namespace ENGINE_NAMESPACE
 	template<> struct get_texture_pool<false> { using type = texture_pool; };
 	//template<> struct get_texture_pool<true> { using type = dynamic_texture_pool; };
 
-	struct internal_ref
-	{
-		u8 pool_type = 0;
-		u32 pool = std::numeric_limits<u32>::max();
-		std::size_t offset = std::numeric_limits<std::size_t>::max();
-		std::size_t size = 0;
-	};
-
 	class mem_ref_internal : protected memory_ref
 	{
 	public:
-		static inline memory_ref create(u8 pool_type, u32 pool, std::size_t offset, std::size_t size) noexcept
+		static inline memory_ref create(u32 handle, u32 generation) noexcept
 		{
-			return mem_ref_internal(pool_type, pool, offset, size);
+			return mem_ref_internal(handle, generation);
 		}
 
-		static inline internal_ref extract(const memory_ref& ref) noexcept
-		{
-			const mem_ref_internal& iref = static_cast<const mem_ref_internal&>(ref);
-			return { iref.m_pool_type, iref.m_pool, iref.m_offset, iref.m_size };
-		}
+		static inline u32 handle(const memory_ref& ref) noexcept
+		{ return static_cast<const mem_ref_internal&>(ref).m_handle; }
+		static inline u32 generation(const memory_ref& ref) noexcept
+		{ return static_cast<const mem_ref_internal&>(ref).m_generation; }
 
 	private:
-		mem_ref_internal(u8 pool_type, u32 pool, std::size_t offset, std::size_t size) noexcept :
-			memory_ref(pool_type, pool, offset, size)
+		mem_ref_internal(u32 handle, u32 generation) noexcept :
+			memory_ref(handle, generation)
 		{ }
 	};
 
 	class mesh_internal : protected mesh
 	{
 	public:
-		static inline internal_ref extract_index_ref(const mesh& mesh) noexcept
+		static inline const memory_ref& index_ref(const mesh& mesh) noexcept
 		{
-			const mesh_internal& imesh = static_cast<const mesh_internal&>(mesh);
-			return mem_ref_internal::extract(imesh.index_ref);
+			return static_cast<const mesh_internal&>(mesh).mesh::index_ref;
 		}
 	};
 
 	class resource_internal : protected resource
 	{
 	public:
-		static inline internal_ref extract_ref(const resource& res) noexcept
+		static inline const memory_ref& ref(const resource& res) noexcept
+		{
+			return static_cast<const resource_internal&>(res).resource::ref;
+		}
+	};
+
+	class transient_internal : protected transient_buffer
+	{
+	public:
+		static inline void init(transient_buffer& buffer, void* host_ptr, std::size_t size, u32 ring, u64 offset,
+			u64 frame) noexcept
 		{
-			const resource_internal& ires = static_cast<const resource_internal&>(res);
-			return mem_ref_internal::extract(ires.ref);
+			transient_internal& ibuffer = static_cast<transient_internal&>(buffer);
+			ibuffer.host_ptr = host_ptr;
+			ibuffer.n_bytes = size;
+			ibuffer.ring = ring;
+			ibuffer.offset = offset;
+			ibuffer.frame = frame;
 		}
+
+		static inline u32 ring_idx(const transient_buffer& buffer) noexcept
+		{ return static_cast<const transient_internal&>(buffer).ring; }
+		static inline u64 offset(const transient_buffer& buffer) noexcept
+		{ return static_cast<const transient_internal&>(buffer).offset; }
+		static inline u64 frame(const transient_buffer& buffer) noexcept
+		{ return static_cast<const transient_internal&>(buffer).frame; }
 	};
 
+	memory_ref::~memory_ref()
+	{
+		release();
+	}
+
+	void memory_ref::release() noexcept
+	{
+		if (valid() && renderer::has_device())
+			renderer::get_device().get_memory().free(*this);
+
+		invalidate();
+	}
+
+	template<typename Pool>
+	inline void add_statistics(renderer::memory_stats& stats, VkDeviceSize& contiguous_free, const std::vector<Pool>& pools)
+	{
+		for (const Pool& pool : pools)
+		{
+			if (!pool.allocated()) continue;
+
+			const pool_usage usage = pool.usage();
+			stats.pools++;
+			stats.pool_size += pool.size();
+			stats.used += usage.used;
+			stats.free += usage.free;
+			stats.largest_free_range = std::max<u64>(stats.largest_free_range, usage.largest_free);
+			stats.free_ranges += usage.free_slots;
+			contiguous_free += usage.largest_free;
+		}
+	}
+
 	inline VkDeviceSize increase_to_fit(VkDeviceSize base, VkDeviceSize target)
 	{
 		//mathematical equivalent to a loop doubling base until it can fit target
@@ -133,7 +189,7 @@ namespace ENGINE_NAMESPACE
 
 	template<typename Pool>
 	inline bool search_buffer_pools(const std::vector<Pool>& pools, VkDeviceSize size, VkDeviceSize alignment,
-		u32& out_pool_idx, u32& out_slot_idx, VkDeviceSize& out_size_needed, VkDeviceSize& out_offset)
+		u32 excluded_pool, u32& out_pool_idx, u32& out_slot_idx, VkDeviceSize& out_size_needed, VkDeviceSize& out_offset)
 	{
 		static_assert(std::is_base_of<buffer_pool, Pool>::value, "Invalid pool type");
 
@@ -141,7 +197,8 @@ namespace ENGINE_NAMESPACE
 		u32 selected_slot_idx = std::numeric_limits<u32>::max();
 		for (const buffer_pool& pool : pools)
 		{
-			if (pool.search(size, alignment, selected_slot_idx, out_size_needed, out_offset))
+			if (selected_pool_idx != excluded_pool && 
+				pool.search(size, alignment, selected_slot_idx, out_size_needed, out_offset))
 				break;
 
 			selected_pool_idx++;
@@ -202,12 +259,59 @@ namespace ENGINE_NAMESPACE
 		}
 	}
 
+	template<typename Pool>
+	inline u32 add_pool(std::vector<Pool>& pools, Pool&& pool)
+	{
+		//released pools leave their slot behind, so that the indexes of the other pools stay valid
+		for (u32 i = 0; i < pools.size(); i++)
+		{
+			if (pools[i].allocated()) continue;
+
+			pools[i] = std::move(pool);
+			return i;
+		}
+
+		pools.push_back(std::move(pool));
+		return static_cast<u32>(pools.size() - 1);
+	}
+
+	inline const char* static_pool_name(u8 pool_type) noexcept
+	{
+		switch (pool_type)
+		{
+		case device_memory::VERTEX:		return "VERTEX";
+		case device_memory::INDEX:		return "INDEX";
+		case device_memory::UNIFORM:	return "UNIFORM";
+		case device_memory::STORAGE:	return "STORAGE";
+		case device_memory::UNIVERSAL:	return "UNIVERSAL";
+		default:						return "UNKNOWN";
+		}
+	}
+
+	bool device_memory::timeline_supported(VkPhysicalDevice physical_device)
+	{
+		VkPhysicalDeviceProperties properties;
+		vkGetPhysicalDeviceProperties(physical_device, &properties);
+		if (properties.apiVersion < VK_API_VERSION_1_2) return false;
+
+		VkPhysicalDeviceTimelineSemaphoreFeatures timeline_features = {};
+		timeline_features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_TIMELINE_SEMAPHORE_FEATURES;
+
+		VkPhysicalDeviceFeatures2 features = {};
+		features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
+		features.pNext = &timeline_features;
+		vkGetPhysicalDeviceFeatures2(physical_device, &features);
+
+		return timeline_features.timelineSemaphore;
+	}
+
 	void device_memory::init(VkPhysicalDevice physical_device, VkDevice device, u32 transfer_queue_idx,
 		const VkPhysicalDeviceLimits* limits, const u8* current_frame)
 	{
 		update_refs(device, limits, current_frame);
 
 		heap_manager = device_heap_manager(physical_device);
+		m_transfer_queue_idx = transfer_queue_idx;
 
 		VkCommandPoolCreateInfo pool_info = {};
 		pool_info.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
@@ -226,7 +330,7 @@ namespace ENGINE_NAMESPACE
 
 		//texture_pools.resize(heap_manager.mem_properties().memoryTypeCount);
 
-		m_upload_pools.push_back(upload_pool(device, heap_manager, staging_buffer_size));
+		thread_upload_pool(); //registers the render thread's pool first
 		m_tex_upload_pools.push_back(texture_upload_pool(device, heap_manager, staging_buffer_size));
 
 		for (u32 i = 0; i < max_frames_in_flight; i++)
@@ -246,12 +350,29 @@ namespace ENGINE_NAMESPACE
 			VK_CRASH_CHECK(vkCreateFence(device, &fence_info, nullptr, &m_upload_fences[i]), "Failed to create fence");
 			//VK_CRASH_CHECK(vkCreateFence(device, &fence_info, nullptr, &device_out[i].fence), "Failed to create fence");
 		}
+
+		if (timeline_supported(physical_device))
+		{
+			VkSemaphoreTypeCreateInfo type_info = {};
+			type_info.sType = VK_STRUCTURE_TYPE_SEMAPHORE_TYPE_CREATE_INFO;
+			type_info.semaphoreType = VK_SEMAPHORE_TYPE_TIMELINE;
+			type_info.initialValue = 0;
+
+			VkSemaphoreCreateInfo semaphore_info = {};
+			semaphore_info.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+			semaphore_info.pNext = &type_info;
+
+			VK_CRASH_CHECK(vkCreateSemaphore(device, &semaphore_info, nullptr, &m_upload_timeline),
+				"Failed to create timeline semaphore");
+		}
+		else
+		{
+			LOG_INTERNAL_INFO("[RENDERER] Timeline semaphores NOT supported, upload completion is tracked per frame");
+		}
 	}
 
 	void device_memory::terminate(VkDevice device, u8 current_frame)
 	{
-		unmap_ranges(device, current_frame);
-
 		for (buffer_pool& pool : vertex_pools) pool.free(device, heap_manager);
 		vertex_pools.clear();
 		for (buffer_pool& pool : index_pools) pool.free(device, heap_manager);
@@ -271,8 +392,22 @@ namespace ENGINE_NAMESPACE
 		for (texture_pool& pool : texture_pools) pool.free(device, heap_manager);
 		texture_pools.clear();
 
-		for (upload_pool& pool : m_upload_pools) pool.free(device, heap_manager);
+		m_streams.clear();
+		m_downloads.free(device, heap_manager);
+		m_released.clear();
+		for (std::vector<internal_ref>& released : m_reclaim) released.clear();
+
+		m_refs.clear();
+		m_free_refs.clear();
+		m_defrag = {};
+
+		for (transient_ring& ring : m_transient_rings) ring.free(device, heap_manager);
+		m_transient_rings.clear();
+
+		for (const std::unique_ptr<upload_pool>& pool : m_upload_pools) pool->free(device, heap_manager);
 		m_upload_pools.clear();
+		m_committed.clear();
+		m_transfer_cmds.clear();
 		for (texture_upload_pool& pool : m_tex_upload_pools) pool.free(device, heap_manager);
 		m_tex_upload_pools.clear();
 
@@ -285,12 +420,27 @@ namespace ENGINE_NAMESPACE
 			//vkDestroyFence(device, device_out[i].fence, nullptr);
 		}
 
+		if (m_upload_timeline != VK_NULL_HANDLE)
+			vkDestroySemaphore(device, m_upload_timeline, nullptr);
+		m_upload_timeline = VK_NULL_HANDLE;
+
 		vkDestroyCommandPool(device, cmd_pool, nullptr);
+		cmd_pool = VK_NULL_HANDLE; //marks the memory as terminated, later frees are ignored
+
+		heap_manager.terminate(device);
 	}
 
 	bool device_memory::upload(VkDevice device, VkQueue transfer_queue, u32 transfer_queue_idx, u8 current_frame)
 	{
-		if (!m_uploads_pending)
+		//held until the defragmenter's moves are recorded, so that no copy is resolved to a location moved after it
+		std::lock_guard<std::mutex> lock(m_access);
+
+		const u64 previous_ticket = m_submitted_ticket;
+		collect_uploads(device, current_frame);
+
+		//an upload is still submitted when the new tickets only had dropped copies, so that their completion is signaled
+		if (m_copies.empty() && m_transfer_cmds.empty() && !m_uploads_pending && m_defrag.moves.empty() &&
+			m_submitted_ticket == previous_ticket)
 			return false;
 
 		VkCommandBuffer& cmd_buffer = cmd_buffers[current_frame];
@@ -303,68 +453,499 @@ namespace ENGINE_NAMESPACE
 
 		vkBeginCommandBuffer(cmd_buffer, &begin_info);
 
-		for (upload_pool& pool : m_upload_pools)
-			pool.record_and_clear(cmd_buffer);
+		m_copies.record_and_clear(cmd_buffer);
+
+		if (m_transfer_cmds.size())
+		{
+			//the threads' copies may read what the staged ones wrote
+			VkMemoryBarrier barrier = {};
+			barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+			barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+			barrier.dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT | VK_ACCESS_TRANSFER_WRITE_BIT;
+
+			vkCmdPipelineBarrier(cmd_buffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0,
+				1, &barrier, 0, nullptr, 0, nullptr);
+
+			vkCmdExecuteCommands(cmd_buffer, static_cast<u32>(m_transfer_cmds.size()), m_transfer_cmds.data());
+			m_transfer_cmds.clear();
+		}
 
 		for (texture_upload_pool& pool : m_tex_upload_pools)
 			pool.record_and_clear_transfer(cmd_buffer, transfer_queue_idx);
 
+		if (m_defrag.moves.size())
+			record_defrag_moves(cmd_buffer);
+
 		vkEndCommandBuffer(cmd_buffer);
 
+		//timeline values must increase, uploads that complete no new ticket leave it be
+		const bool signal_timeline = m_upload_timeline != VK_NULL_HANDLE && m_submitted_ticket != previous_ticket;
+		const std::array<VkSemaphore, 2> signal_semaphores = { m_upload_semaphores[current_frame], m_upload_timeline };
+		const std::array<u64, 2> signal_values = { 0, m_submitted_ticket }; //the binary semaphore's value is ignored
+
+		VkTimelineSemaphoreSubmitInfo timeline_info = {};
+		timeline_info.sType = VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO;
+		timeline_info.signalSemaphoreValueCount = static_cast<u32>(signal_values.size());
+		timeline_info.pSignalSemaphoreValues = signal_values.data();
+
 		VkSubmitInfo submit_info = {};
 		submit_info.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+		submit_info.pNext = signal_timeline ? &timeline_info : nullptr;
 		submit_info.commandBufferCount = 1;
 		submit_info.pCommandBuffers = &cmd_buffer;
-		submit_info.signalSemaphoreCount = 1;
-		submit_info.pSignalSemaphores = &m_upload_semaphores[current_frame];
+		submit_info.signalSemaphoreCount = signal_timeline ? 2 : 1;
+		submit_info.pSignalSemaphores = signal_semaphores.data();
 
 		vkResetFences(device, 1, &m_upload_fences[current_frame]);
 		vkQueueSubmit(transfer_queue, 1, &submit_info, m_upload_fences[current_frame]);
+		m_frame_tickets[current_frame] = m_submitted_ticket;
 
 		m_uploads_pending = false;
 
 		return true;
 	}
 
-	void device_memory::map_ranges(VkDevice device, u8 current_frame)
+	void device_memory::collect_uploads(VkDevice device, u8 current_frame)
+	{
+		//the render thread is the one uploading, its staging has been written by now
+		commit(*m_upload_pools.front(), false);
+
+		//oldest first, the upload that does not fit in what is left of the budget is split and finished with the next
+		//frames, so that a large batch of uploads does not stall a single frame
+		VkDeviceSize budget = upload_frame_budget;
+		while (budget && m_committed.size())
+		{
+			upload_pool::staged_upload& upload = m_committed.front();
+			const ref_slot& slot = m_refs[upload.handle];
+			//the copy is dropped if the allocation was freed since it was staged
+			if (slot.generation == upload.generation)
+			{
+				const VkDeviceSize size = std::min(upload.size, budget);
+				const internal_ref& ref = slot.ref;
+
+				//resolved now, so that the copy lands where the allocation currently is
+				VkBufferCopy region = {};
+				region.srcOffset = upload.src_offset;
+				region.dstOffset = aligned_offset(ref.offset, offset_alignment(ref.pool_type)) + upload.offset;
+				region.size = size;
+				m_copies.push(upload.src, static_pools(ref.pool_type)[ref.pool].buffer(), region);
+
+				budget -= size;
+				if (size < upload.size)
+				{
+					upload.src_offset += size;
+					upload.offset += size;
+					upload.position += size;
+					upload.size -= size;
+					continue;
+				}
+			}
+
+			m_committed.pop_front();
+		}
+
+		//the tickets of textures and command buffers, handed out before the oldest queued upload, are submitted too
+		m_submitted_ticket = m_committed.empty() ? m_ticket : m_committed.front().ticket - 1;
+
+		//the queued uploads keep their staging past this frame
+		for (const upload_pool::staged_upload& upload : m_committed) upload.pool->hold(upload);
+
+		std::vector<upload_pool::pinned_ref> unpinned;
+		for (const std::unique_ptr<upload_pool>& pool : m_upload_pools)
+		{
+			pool->collect_commands(m_transfer_cmds, unpinned, current_frame);
+			pool->end_frame(device, heap_manager, current_frame);
+		}
+		for (const upload_pool::pinned_ref& pinned : unpinned) unpin(pinned);
+	}
+
+	u64 device_memory::commit(upload_pool& pool, bool last_only)
+	{
+		const std::size_t first = m_committed.size();
+		pool.commit(m_committed, last_only);
+
+		std::vector<VkMappedMemoryRange> ranges;
+		for (std::size_t i = first; i < m_committed.size(); i++)
+		{
+			upload_pool::staged_upload& upload = m_committed[i];
+			upload.ticket = ++m_ticket;
+
+			ref_slot& slot = m_refs[upload.handle];
+			if (slot.generation == upload.generation)
+			{
+				slot.uploading--;
+				slot.ticket = upload.ticket;
+				m_uploading--;
+			}
+
+			if (!heap_manager.host_coherent_upload_heap())
+				ranges.push_back(pool.mapped_range(upload, radd.limits->nonCoherentAtomSize));
+		}
+
+		if (ranges.size())
+			VK_CRASH_CHECK(vkFlushMappedMemoryRanges(radd.device, ranges.size(), ranges.data()), "Failed to flush memory ranges");
+
+		return m_ticket;
+	}
+
+	u64 device_memory::completed_ticket()
+	{
+		if (m_upload_timeline != VK_NULL_HANDLE && m_completed_ticket < m_submitted_ticket)
+		{
+			u64 value = 0;
+			VK_CRASH_CHECK(vkGetSemaphoreCounterValue(radd.device, m_upload_timeline, &value), 
+				"Failed to get semaphore value");
+			m_completed_ticket = std::max(m_completed_ticket, value);
+		}
+
+		return m_completed_ticket;
+	}
+
+	bool device_memory::upload_complete(u64 ticket)
+	{
+		std::lock_guard<std::mutex> lock(m_access);
+		return ticket <= completed_ticket();
+	}
+
+	u64 device_memory::last_ticket() const noexcept
+	{
+		std::lock_guard<std::mutex> lock(m_access);
+		return m_ticket;
+	}
+
+	bool device_memory::ready(const memory_ref& ref)
+	{
+		std::lock_guard<std::mutex> lock(m_access);
+		const u32 handle = mem_ref_internal::handle(ref);
+		resolve(ref);
+		return !m_refs[handle].uploading && m_refs[handle].ticket <= completed_ticket();
+	}
+
+	bool device_memory::drawable(std::size_t ref)
+	{
+		if (!ref) return true;
+
+		std::lock_guard<std::mutex> lock(m_access);
+		const u32 handle = static_cast<u32>(ref);
+		const u32 generation = static_cast<u32>(ref >> 32);
+		//freed since the arguments were resolved, the object is removed before it is drawn again
+		if (handle >= m_refs.size() || m_refs[handle].generation != generation) return true;
+
+		const ref_slot& slot = m_refs[handle];
+		return !slot.uploading && slot.ticket <= m_submitted_ticket;
+	}
+
+	bool device_memory::all_drawable()
+	{
+		std::lock_guard<std::mutex> lock(m_access);
+		return !m_uploading && m_submitted_ticket == m_ticket;
+	}
+
+	upload_pool& device_memory::thread_upload_pool()
+	{
+		const std::thread::id thread = std::this_thread::get_id();
+		for (const std::unique_ptr<upload_pool>& pool : m_upload_pools)
+		{
+			if (pool->owner() == thread) return *pool;
+		}
+
+		//the render thread registers first, its ring is shared by the frames in flight
+		const VkDeviceSize ring_size = m_upload_pools.empty() ? staging_ring_size : thread_staging_ring_size;
+		m_upload_pools.push_back(std::make_unique<upload_pool>(thread));
+		m_upload_pools.back()->add_ring(radd.device, heap_manager, ring_size);
+		return *m_upload_pools.back();
+	}
+
+	u64 device_memory::commit_staging()
+	{
+		std::lock_guard<std::mutex> lock(m_access);
+		return commit(thread_upload_pool(), false);
+	}
+
+	VkCommandBuffer device_memory::begin_transfer_commands()
+	{
+		upload_pool* pool;
+		VkCommandBuffer cmd_buffer;
+		{
+			std::lock_guard<std::mutex> lock(m_access);
+			pool = &thread_upload_pool();
+			cmd_buffer = pool->pop_commands();
+		}
+
+		if (cmd_buffer == VK_NULL_HANDLE)
+			cmd_buffer = pool->allocate_commands(radd.device, m_transfer_queue_idx);
+
+		{
+			std::lock_guard<std::mutex> lock(m_access);
+			pool->begin_commands(cmd_buffer);
+		}
+
+		//executed outside of any render pass, nothing is inherited
+		VkCommandBufferInheritanceInfo inheritance_info = {};
+		inheritance_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_INFO;
+
+		VkCommandBufferBeginInfo begin_info = {};
+		begin_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+		begin_info.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+		begin_info.pInheritanceInfo = &inheritance_info;
+
+		VK_CRASH_CHECK(vkBeginCommandBuffer(cmd_buffer, &begin_info), "Failed to begin command buffer");
+		return cmd_buffer;
+	}
+
+	void device_memory::record_copy(VkCommandBuffer cmd_buffer, const memory_ref& src, const memory_ref& dst,
+		VkDeviceSize size, VkDeviceSize src_offset, VkDeviceSize dst_offset)
+	{
+		VkBuffer src_buffer, dst_buffer;
+		VkBufferCopy region = {};
+		region.size = size;
+		{
+			std::lock_guard<std::mutex> lock(m_access);
+
+			const internal_ref& src_ref = resolve(src);
+			const internal_ref& dst_ref = resolve(dst);
+			INTERNAL_ASSERT(src_ref.pool_type >= VERTEX && src_ref.pool_type <= UNIVERSAL &&
+				dst_ref.pool_type >= VERTEX && dst_ref.pool_type <= UNIVERSAL, 
+				"Copies are only recorded between static buffers");
+			INTERNAL_ASSERT(src_offset + size <= src_ref.size && dst_offset + size <= dst_ref.size, "Copy out of bounds");
+
+			src_buffer = static_pools(src_ref.pool_type)[src_ref.pool].buffer();
+			dst_buffer = static_pools(dst_ref.pool_type)[dst_ref.pool].buffer();
+			region.srcOffset = aligned_offset(src_ref.offset, offset_alignment(src_ref.pool_type)) + src_offset;
+			region.dstOffset = aligned_offset(dst_ref.offset, offset_alignment(dst_ref.pool_type)) + dst_offset;
+
+			//the locations stay valid once pinned, the copy itself is recorded outside of the lock
+			upload_pool& pool = thread_upload_pool();
+			const u32 src_handle = mem_ref_internal::handle(src);
+			const u32 dst_handle = mem_ref_internal::handle(dst);
+			pool.pin(cmd_buffer, { src_handle, m_refs[src_handle].generation, false });
+			pool.pin(cmd_buffer, { dst_handle, m_refs[dst_handle].generation, true });
+			m_refs[src_handle].pinned++;
+			m_refs[dst_handle].pinned++;
+		}
+
+		vkCmdCopyBuffer(cmd_buffer, src_buffer, dst_buffer, 1, &region);
+	}
+
+	u64 device_memory::submit_transfer_commands(VkCommandBuffer cmd_buffer)
+	{
+		VK_CRASH_CHECK(vkEndCommandBuffer(cmd_buffer), "Failed to record command buffer");
+
+		std::lock_guard<std::mutex> lock(m_access);
+		const u64 ticket = ++m_ticket;
+		for (const upload_pool::pinned_ref& pinned : thread_upload_pool().submit_commands(cmd_buffer))
+		{
+			ref_slot& slot = m_refs[pinned.handle];
+			if (pinned.written && slot.generation == pinned.generation) slot.ticket = ticket;
+		}
+		return ticket;
+	}
+
+	void device_memory::stream_uploads()
+	{
+		//chunks are copied under the lock, the budget bounds how long the other threads can be held up
+		std::lock_guard<std::mutex> lock(m_access);
+
+		VkDeviceSize budget = stream_frame_budget;
+		for (std::size_t i = 0; i < m_streams.size();)
+		{
+			pending_stream& pending = m_streams[i];
+			const internal_ref ref = m_refs[pending.handle].ref;
+
+			//only chunks already read are taken, the render thread never waits on the disk while holding the lock
+			bool done = false;
+			io::stream_chunk chunk;
+			while (budget && pending.stream.ready())
+			{
+				if (!pending.stream.next(chunk))
+				{
+					done = true;
+					break;
+				}
+
+				if (ref.pool_type == TEXTURE)
+				{
+					//a texture is copied as a whole, its chunks are gathered until the stream ends
+					if (!pending.texture_data) pending.texture_data = std::make_unique<std::byte[]>(ref.size);
+					std::memcpy(pending.texture_data.get() + chunk.offset, chunk.data, chunk.size);
+				}
+				else
+				{
+					const std::span<std::byte> staging = reserve_upload(pending.handle, chunk.size, 
+						pending.offset + chunk.offset);
+					std::memcpy(staging.data(), chunk.data, chunk.size);
+				}
+
+				budget = chunk.size < budget ? budget - chunk.size : 0;
+			}
+
+			if (done)
+			{
+				if (pending.stream.failed())
+				{
+					LOG_INTERNAL_ERROR("Streamed upload failed, the destination was left incomplete");
+				}
+				else if (pending.texture_data)
+				{
+					std::memcpy(stage_texture_upload(pending.handle), pending.texture_data.get(), ref.size);
+				}
+
+				//the last chunks' staging keeps the allocation uploading until it is committed
+				m_refs[pending.handle].uploading--;
+				m_uploading--;
+				m_streams.erase(m_streams.begin() + i);
+			}
+			else
+			{
+				i++;
+			}
+		}
+	}
+
+	void device_memory::stream(const memory_ref& ref, io::file_stream&& stream, VkDeviceSize offset)
+	{
+		std::lock_guard<std::mutex> lock(m_access);
+
+		const internal_ref& iref = resolve(ref);
+		INTERNAL_ASSERT(offset + stream.size() <= iref.size, "Streamed data does not fit in the memory reference");
+		INTERNAL_ASSERT(iref.pool_type != TEXTURE || (offset == 0 && stream.size() == iref.size),
+			"Streamed texture data must cover the whole texture");
+
+		if (!stream.is_open()) return;
+
+		m_refs[mem_ref_internal::handle(ref)].uploading++;
+		m_uploading++;
+		m_streams.push_back({ .handle = mem_ref_internal::handle(ref), .offset = offset, .stream = std::move(stream) });
+	}
+
+	std::future<std::vector<std::byte>> device_memory::download(const memory_ref& ref, VkDeviceSize size, 
+		VkDeviceSize offset)
+	{
+		std::lock_guard<std::mutex> lock(m_access);
+
+		const internal_ref& iref = resolve(ref);
+		INTERNAL_ASSERT(iref.pool_type >= VERTEX && iref.pool_type <= STORAGE, "Only static buffers can be downloaded");
+		INTERNAL_ASSERT(offset + size <= iref.size, "Out of bounds memory access");
+
+		const u32 handle = mem_ref_internal::handle(ref);
+		return m_downloads.request(handle, m_refs[handle].generation, size, offset);
+	}
+
+	void device_memory::record_downloads(VkCommandBuffer cmd_buffer, u8 current_frame)
+	{
+		std::lock_guard<std::mutex> lock(m_access);
+
+		m_downloads.end_frame(radd.device, heap_manager, current_frame);
+
+		std::deque<download_pool::download>& requested = m_downloads.requested();
+		while (requested.size())
+		{
+			download_pool::download& download = requested.front();
+			const ref_slot& slot = m_refs[download.handle];
+			if (slot.generation != download.generation)
+			{
+				//freed before it could be copied
+				download.result.set_value({});
+				requested.pop_front();
+				continue;
+			}
+
+			if (m_downloads.ring_size() < download.size)
+			{
+				const VkDeviceSize ring_size = increase_to_fit(std::max(download_ring_size, 2 * m_downloads.ring_size()), 
+					download.size);
+				LOGF_INTERNAL_INFO("Download ring too small, allocating a new ring of {0} bytes", ring_size);
+				m_downloads.add_ring(radd.device, heap_manager, ring_size);
+			}
+			if (!m_downloads.reserve(download)) break; //the ring is full until the frames in flight complete
+
+			const internal_ref& ref = slot.ref;
+			VkBufferCopy region = {};
+			region.srcOffset = aligned_offset(ref.offset, offset_alignment(ref.pool_type)) + download.offset;
+			region.dstOffset = download.dst_offset;
+			region.size = download.size;
+			m_download_copies.push(static_pools(ref.pool_type)[ref.pool].buffer(), download.dst, region);
+
+			m_downloads.recorded(current_frame);
+		}
+
+		if (m_download_copies.empty()) return;
+
+		//the sources may have been written by the frame's shaders or by its uploads
+		VkMemoryBarrier barrier = {};
+		barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+		barrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT | VK_ACCESS_TRANSFER_WRITE_BIT;
+		barrier.dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+
+		vkCmdPipelineBarrier(cmd_buffer, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0,
+			1, &barrier, 0, nullptr, 0, nullptr);
+
+		m_download_copies.record_and_clear(cmd_buffer);
+
+		//makes the copies visible to the host once the frame's fence is signaled
+		barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+		barrier.dstAccessMask = VK_ACCESS_HOST_READ_BIT;
+
+		vkCmdPipelineBarrier(cmd_buffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_HOST_BIT, 0,
+			1, &barrier, 0, nullptr, 0, nullptr);
+	}
+
+	void device_memory::complete_downloads(u8 frame)
 	{
-		for (dynamic_buffer_pool& pool : d_vertex_pools)	pool.map(device, current_frame);
-		for (dynamic_buffer_pool& pool : d_index_pools)		pool.map(device, current_frame);
-		for (dynamic_buffer_pool& pool : d_uniform_pools)	pool.map(device, current_frame);
-		for (dynamic_buffer_pool& pool : d_storage_pools)	pool.map(device, current_frame);
+		std::lock_guard<std::mutex> lock(m_access);
+
+		if (!heap_manager.host_coherent_download_heap())
+		{
+			std::vector<VkMappedMemoryRange> ranges;
+			m_downloads.push_invalidate_ranges(ranges, frame, radd.limits->nonCoherentAtomSize);
+			if (ranges.size())
+				VK_CRASH_CHECK(vkInvalidateMappedMemoryRanges(radd.device, ranges.size(), ranges.data()), 
+					"Failed to invalidate memory ranges");
+		}
+
+		m_downloads.deliver(frame);
+	}
 
-		for (upload_pool& pool : m_upload_pools)				pool.map(device, current_frame);
-		for (texture_upload_pool& pool : m_tex_upload_pools)	pool.map(device, current_frame);
+	void device_memory::set_download_latency(u8 frames) noexcept
+	{
+		INTERNAL_ASSERT(frames >= 1 && frames <= max_frames_in_flight, "Invalid download latency");
+		std::lock_guard<std::mutex> lock(m_access);
+		m_download_latency = std::clamp<u8>(frames, 1, max_frames_in_flight);
 	}
 
-	void device_memory::unmap_ranges(VkDevice device, u8 current_frame)
+	void device_memory::select_frame(u8 current_frame)
 	{
-		for (dynamic_buffer_pool& pool : d_vertex_pools)	pool.unmap(device);
-		for (dynamic_buffer_pool& pool : d_index_pools)		pool.unmap(device);
-		for (dynamic_buffer_pool& pool : d_uniform_pools)	pool.unmap(device);
-		for (dynamic_buffer_pool& pool : d_storage_pools)	pool.unmap(device);
+		std::lock_guard<std::mutex> lock(m_access);
+
+		for (dynamic_buffer_pool& pool : d_vertex_pools)	pool.select_frame(current_frame);
+		for (dynamic_buffer_pool& pool : d_index_pools)		pool.select_frame(current_frame);
+		for (dynamic_buffer_pool& pool : d_uniform_pools)	pool.select_frame(current_frame);
+		for (dynamic_buffer_pool& pool : d_storage_pools)	pool.select_frame(current_frame);
 
-		for (upload_pool& pool : m_upload_pools)				pool.unmap(device);
-		for (texture_upload_pool& pool : m_tex_upload_pools)	pool.unmap(device);
+		for (texture_upload_pool& pool : m_tex_upload_pools)	pool.select_frame(current_frame);
 	}
 
 	void device_memory::flush_ranges(VkDevice device, u8 current_frame)
 	{
+		std::lock_guard<std::mutex> lock(m_access);
+
 		std::vector<VkMappedMemoryRange> ranges;
+		const VkDeviceSize atom_size = radd.limits->nonCoherentAtomSize;
 
+		//only the ranges written since the last flush, coherent heaps need none
 		if (!heap_manager.host_coherent_dynamic_heap())
 		{
-			dynamic_buffer_pool::push_flush_ranges(ranges, current_frame, d_vertex_pools);
-			dynamic_buffer_pool::push_flush_ranges(ranges, current_frame, d_index_pools);
-			dynamic_buffer_pool::push_flush_ranges(ranges, current_frame, d_uniform_pools);
-			dynamic_buffer_pool::push_flush_ranges(ranges, current_frame, d_storage_pools);
+			dynamic_buffer_pool::push_flush_ranges(ranges, current_frame, d_vertex_pools, atom_size);
+			dynamic_buffer_pool::push_flush_ranges(ranges, current_frame, d_index_pools, atom_size);
+			dynamic_buffer_pool::push_flush_ranges(ranges, current_frame, d_uniform_pools, atom_size);
+			dynamic_buffer_pool::push_flush_ranges(ranges, current_frame, d_storage_pools, atom_size);
+
+			for (const transient_ring& ring : m_transient_rings)
+				ring.push_flush_ranges(ranges, atom_size);
 		}
 
 		if (!heap_manager.host_coherent_upload_heap())
-		{
-			staging_pool::push_flush_ranges(ranges, current_frame, m_upload_pools);
-			staging_pool::push_flush_ranges(ranges, current_frame, m_tex_upload_pools);
-		}
+			staging_pool::push_flush_ranges(ranges, current_frame, m_tex_upload_pools, atom_size);
 
 		if (ranges.size())
 			VK_CRASH_CHECK(vkFlushMappedMemoryRanges(device, ranges.size(), ranges.data()), "Failed to flush memory ranges");
@@ -373,6 +954,335 @@ namespace ENGINE_NAMESPACE
 	void device_memory::sync(VkDevice device, u8 current_frame)
 	{
 		vkWaitForFences(device, 1, &m_upload_fences[current_frame], VK_TRUE, std::numeric_limits<u64>::max());
+
+		std::lock_guard<std::mutex> lock(m_access);
+		m_completed_ticket = std::max(m_completed_ticket, m_frame_tickets[current_frame]);
+	}
+
+	void device_memory::free(const memory_ref& ref) noexcept
+	{
+		if (cmd_pool == VK_NULL_HANDLE) return;
+
+		std::lock_guard<std::mutex> lock(m_access);
+
+		const u32 handle = mem_ref_internal::handle(ref);
+		ref_slot& slot = m_refs[handle];
+		INTERNAL_ASSERT(slot.generation == mem_ref_internal::generation(ref), "Stale memory reference");
+
+		std::erase_if(m_streams, [handle](const pending_stream& pending) { return pending.handle == handle; });
+
+		//the uploads still staged for it are dropped
+		m_uploading -= std::exchange(slot.uploading, 0);
+		slot.ticket = 0;
+
+		//generation 0 marks invalid references
+		if (++slot.generation == 0) slot.generation = 1;
+
+		//a command buffer still copies from or to it, the slot keeps the allocation until the last one is executed
+		if (slot.pinned) return;
+
+		m_released.push_back(std::exchange(slot.ref, {}));
+		m_free_refs.push_back(handle);
+	}
+
+	void device_memory::unpin(const upload_pool::pinned_ref& pinned)
+	{
+		ref_slot& slot = m_refs[pinned.handle];
+		if (--slot.pinned || slot.generation == pinned.generation) return;
+
+		//freed while pinned, the slot has not been reused and its generation has not moved since
+		m_released.push_back(std::exchange(slot.ref, {}));
+		m_free_refs.push_back(pinned.handle);
+	}
+
+	memory_ref device_memory::create_ref(const internal_ref& ref)
+	{
+		u32 handle;
+		if (m_free_refs.size())
+		{
+			handle = m_free_refs.back();
+			m_free_refs.pop_back();
+		}
+		else
+		{
+			handle = static_cast<u32>(m_refs.size());
+			m_refs.push_back({});
+		}
+
+		m_refs[handle].ref = ref;
+		return mem_ref_internal::create(handle, m_refs[handle].generation);
+	}
+
+	const internal_ref& device_memory::resolve(const memory_ref& ref) const noexcept
+	{
+		const u32 handle = mem_ref_internal::handle(ref);
+		INTERNAL_ASSERT(handle < m_refs.size() && m_refs[handle].generation == mem_ref_internal::generation(ref),
+			"Stale memory reference");
+		return m_refs[handle].ref;
+	}
+
+	std::vector<buffer_pool>& device_memory::static_pools(u8 pool_type) noexcept
+	{
+		switch (pool_type)
+		{
+		case INDEX:		return index_pools;
+		case UNIFORM:	return uniform_pools;
+		case STORAGE:	return storage_pools;
+		case UNIVERSAL:	return writable_pools;
+		default:
+			INTERNAL_ASSERT(pool_type == VERTEX, "Invalid static pool type");
+			return vertex_pools;
+		}
+	}
+
+	VkDeviceSize device_memory::offset_alignment(u8 pool_type) const noexcept
+	{
+		switch (pool_type)
+		{
+		case UNIFORM:	return offset_alignment<UNIFORM>();
+		case STORAGE:	return offset_alignment<STORAGE>();
+		case UNIVERSAL:	return offset_alignment<UNIVERSAL>();
+		default:		return offset_alignment<VERTEX>();
+		}
+	}
+
+	bool device_memory::refresh_binding(buffer_binding_args& args) noexcept
+	{
+		if (!args.ref) return false;
+
+		std::lock_guard<std::mutex> lock(m_access);
+
+		const u32 handle = static_cast<u32>(args.ref);
+		const u32 generation = static_cast<u32>(args.ref >> 32);
+		//freed since the arguments were resolved, the object is removed before it is drawn again
+		if (handle >= m_refs.size() || m_refs[handle].generation != generation) return false;
+
+		//only the static pools are defragmented
+		const internal_ref& ref = m_refs[handle].ref;
+		if (ref.pool_type < VERTEX || ref.pool_type > STORAGE) return false;
+
+		const VkBuffer buffer = static_pools(ref.pool_type)[ref.pool].buffer();
+		const VkDeviceSize offset = aligned_offset(ref.offset, offset_alignment(ref.pool_type));
+		if (args.buffer == buffer && args.offset == offset) return false;
+
+		args.buffer = buffer;
+		args.offset = offset;
+		return true;
+	}
+
+	void device_memory::release_empty_pools()
+	{
+		for (u8 pool_type = VERTEX; pool_type <= STORAGE; pool_type++)
+		{
+			std::vector<buffer_pool>& pools = static_pools(pool_type);
+			u32 live_pools = 0;
+			for (const buffer_pool& pool : pools) live_pools += pool.allocated();
+
+			//the last pool of a type is kept, so that allocating and freeing a single resource does not thrash
+			for (u32 i = 0; i < pools.size() && live_pools > 1; i++)
+			{
+				if (!pools[i].allocated() || !pools[i].empty()) continue;
+
+				LOGF_INTERNAL_INFO("Releasing empty pool {0} {1} of {2} bytes", static_pool_name(pool_type), i, 
+					pools[i].size());
+				pools[i].free(radd.device, heap_manager);
+				live_pools--;
+
+				if (m_defrag.pool_type == pool_type && m_defrag.pool == i)
+					m_defrag = {};
+			}
+		}
+	}
+
+	void device_memory::select_defrag_source()
+	{
+		if (m_defrag.pool_type != NONE) return;
+
+		//storage pools are written by shaders on the graphics queue, which a move on the transfer queue would race with
+		for (u8 pool_type = VERTEX; pool_type < STORAGE; pool_type++)
+		{
+			const std::vector<buffer_pool>& pools = static_pools(pool_type);
+
+			u32 source = std::numeric_limits<u32>::max();
+			float source_occupancy = defrag_occupancy;
+			u32 live_pools = 0;
+			for (u32 i = 0; i < pools.size(); i++)
+			{
+				if (!pools[i].allocated()) continue;
+
+				live_pools++;
+				const VkDeviceSize used = pools[i].usage().used;
+				const float occupancy = static_cast<float>(used) / static_cast<float>(pools[i].size());
+				if (used && occupancy < source_occupancy)
+				{
+					source = i;
+					source_occupancy = occupancy;
+				}
+			}
+
+			if (source == std::numeric_limits<u32>::max() || live_pools < 2) continue;
+
+			//the moved allocations must fit in the other pools, otherwise they would only be moved to a new pool
+			VkDeviceSize largest_free = 0;
+			for (u32 i = 0; i < pools.size(); i++)
+			{
+				if (i != source && pools[i].allocated())
+					largest_free = std::max(largest_free, pools[i].usage().largest_free);
+			}
+			if (largest_free < pools[source].usage().used) continue;
+
+			m_defrag.pool_type = pool_type;
+			m_defrag.pool = source;
+			for (u32 handle = 0; handle < m_refs.size(); handle++)
+			{
+				const ref_slot& slot = m_refs[handle];
+				if (slot.ref.pool_type == pool_type && slot.ref.pool == source)
+					m_defrag.moves.push_back({ handle, slot.generation });
+			}
+
+			LOGF_INTERNAL_INFO("Defragmenting pool {0} {1}, {2} allocations to move", static_pool_name(pool_type), 
+				source, m_defrag.moves.size());
+			return;
+		}
+	}
+
+	void device_memory::record_defrag_moves(VkCommandBuffer cmd_buffer)
+	{
+		//the moved ranges may have been written by the uploads recorded before
+		VkMemoryBarrier barrier = {};
+		barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+		barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+		barrier.dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+
+		vkCmdPipelineBarrier(cmd_buffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0,
+			1, &barrier, 0, nullptr, 0, nullptr);
+
+		const u8 pool_type = m_defrag.pool_type;
+		const VkDeviceSize alignment = offset_alignment(pool_type);
+		VkDeviceSize budget = defrag_frame_budget;
+		std::size_t i = m_defrag.moves.size();
+		while (budget && i)
+		{
+			const auto [handle, generation] = m_defrag.moves[--i];
+
+			//a thread's command buffer copies from or to it, it is moved with a later frame
+			if (m_refs[handle].generation == generation && m_refs[handle].pinned) continue;
+			m_defrag.moves.erase(m_defrag.moves.begin() + i);
+
+			//freed since the pool was selected, or freed while pinned and released since
+			const internal_ref old_ref = m_refs[handle].ref;
+			if (m_refs[handle].generation != generation || old_ref.pool_type != pool_type || 
+				old_ref.pool != m_defrag.pool)
+				continue;
+
+			internal_ref new_ref;
+			switch (pool_type)
+			{
+			case VERTEX:	new_ref = place_buffer<VERTEX, false>(old_ref.size); break;
+			case INDEX:		new_ref = place_buffer<INDEX, false>(old_ref.size); break;
+			case UNIFORM:	new_ref = place_buffer<UNIFORM, false>(old_ref.size); break;
+			case STORAGE:	new_ref = place_buffer<STORAGE, false>(old_ref.size); break;
+			default:
+				INTERNAL_ASSERT(false, "Invalid defragmented pool type");
+				break;
+			}
+
+			std::vector<buffer_pool>& pools = static_pools(pool_type);
+			VkBufferCopy region = {};
+			region.srcOffset = aligned_offset(old_ref.offset, alignment);
+			region.dstOffset = aligned_offset(new_ref.offset, alignment);
+			region.size = old_ref.size;
+			vkCmdCopyBuffer(cmd_buffer, pools[old_ref.pool].buffer(), pools[new_ref.pool].buffer(), 1, &region);
+
+			//the old range is reclaimed once the frames in flight, which may still read it, have completed
+			m_refs[handle].ref = new_ref;
+			m_released.push_back(old_ref);
+
+			m_relocations++;
+			m_relocated_bytes += old_ref.size;
+			budget = old_ref.size < budget ? budget - old_ref.size : 0;
+		}
+	}
+
+	void device_memory::reclaim(u8 current_frame)
+	{
+		std::lock_guard<std::mutex> lock(m_access);
+
+		std::vector<internal_ref>& reclaimed = m_reclaim[current_frame];
+		for (const internal_ref& ref : reclaimed)
+		{
+			switch (ref.pool_type)
+			{
+			case VERTEX:					vertex_pools[ref.pool].release_slot(ref.offset); break;
+			case INDEX:						index_pools[ref.pool].release_slot(ref.offset); break;
+			case UNIFORM:					uniform_pools[ref.pool].release_slot(ref.offset); break;
+			case STORAGE:					storage_pools[ref.pool].release_slot(ref.offset); break;
+			case UNIVERSAL:					writable_pools[ref.pool].release_slot(ref.offset); break;
+			case VERTEX | DYNAMIC_BIT:		d_vertex_pools[ref.pool].release_slot(ref.offset); break;
+			case INDEX | DYNAMIC_BIT:		d_index_pools[ref.pool].release_slot(ref.offset); break;
+			case UNIFORM | DYNAMIC_BIT:		d_uniform_pools[ref.pool].release_slot(ref.offset); break;
+			case STORAGE | DYNAMIC_BIT:		d_storage_pools[ref.pool].release_slot(ref.offset); break;
+			case TEXTURE:					texture_pools[ref.pool].release_slot(radd.device, ref.offset); break;
+			default:
+				INTERNAL_ASSERT(false, "Invalid memory reference pool type");
+				break;
+			}
+		}
+
+		//the bucket's storage is kept for the next frames
+		reclaimed.clear();
+		reclaimed.swap(m_released);
+
+		for (transient_ring& ring : m_transient_rings) ring.end_frame(current_frame);
+		for (std::size_t i = 0; i + 1 < m_transient_rings.size();)
+		{
+			//a replaced ring is empty once the last frame it was used in has completed
+			if (m_transient_rings[i].used())
+			{
+				i++;
+				continue;
+			}
+			m_transient_rings[i].free(radd.device, heap_manager);
+			m_transient_rings.erase(m_transient_rings.begin() + i);
+		}
+		m_transient_frame++;
+
+		release_empty_pools();
+		select_defrag_source();
+	}
+
+	renderer::memory_stats device_memory::statistics() const noexcept
+	{
+		std::lock_guard<std::mutex> lock(m_access);
+
+		renderer::memory_stats stats;
+		VkDeviceSize contiguous_free = 0;
+		add_statistics(stats, contiguous_free, vertex_pools);
+		add_statistics(stats, contiguous_free, index_pools);
+		add_statistics(stats, contiguous_free, uniform_pools);
+		add_statistics(stats, contiguous_free, storage_pools);
+		add_statistics(stats, contiguous_free, writable_pools);
+		add_statistics(stats, contiguous_free, d_vertex_pools);
+		add_statistics(stats, contiguous_free, d_index_pools);
+		add_statistics(stats, contiguous_free, d_uniform_pools);
+		add_statistics(stats, contiguous_free, d_storage_pools);
+		add_statistics(stats, contiguous_free, texture_pools);
+
+		for (const internal_ref& ref : m_released) stats.pending += ref.size;
+		for (const std::vector<internal_ref>& released : m_reclaim)
+			for (const internal_ref& ref : released) stats.pending += ref.size;
+
+		if (stats.free)
+			stats.fragmentation = 1.0f - static_cast<float>(contiguous_free) / static_cast<float>(stats.free);
+
+		stats.device_allocations = heap_manager.allocations();
+		stats.reserved = heap_manager.reserved();
+		const heap_budget main_budget = heap_manager.budget(device_heap_manager::heap::MAIN);
+		stats.budget = main_budget.budget;
+		stats.budget_usage = main_budget.usage;
+
+		stats.relocated = m_relocated_bytes;
+		return stats;
 	}
 
 	memory_ref device_memory::alloc_vertices(VkDeviceSize size)
@@ -409,14 +1319,61 @@ namespace ENGINE_NAMESPACE
 	memory_ref device_memory::alloc_dynamic_storage(const void* data, VkDeviceSize size)
 	{ return alloc_buffer<STORAGE, true>(data, size); }
 
-	void device_memory::upload_vertices(const memory_ref& ref, const void* data, VkDeviceSize size, VkDeviceSize offset)
-	{ this->submit_upload<VERTEX>(ref, data, size, offset); }
-	void device_memory::upload_indexes(const memory_ref& ref, const void* data, VkDeviceSize size, VkDeviceSize offset)
-	{ this->submit_upload<INDEX>(ref, data, size, offset); }
-	void device_memory::upload_uniform(const memory_ref& ref, const void* data, VkDeviceSize size, VkDeviceSize offset)
-	{ this->submit_upload<UNIFORM>(ref, data, size, offset); }
-	void device_memory::upload_storage(const memory_ref& ref, const void* data, VkDeviceSize size, VkDeviceSize offset)
-	{ this->submit_upload<STORAGE>(ref, data, size, offset); }
+	u64 device_memory::upload_vertices(const memory_ref& ref, const void* data, VkDeviceSize size, VkDeviceSize offset)
+	{ return this->submit_upload<VERTEX>(ref, data, size, offset); }
+	u64 device_memory::upload_indexes(const memory_ref& ref, const void* data, VkDeviceSize size, VkDeviceSize offset)
+	{ return this->submit_upload<INDEX>(ref, data, size, offset); }
+	u64 device_memory::upload_uniform(const memory_ref& ref, const void* data, VkDeviceSize size, VkDeviceSize offset)
+	{ return this->submit_upload<UNIFORM>(ref, data, size, offset); }
+	u64 device_memory::upload_storage(const memory_ref& ref, const void* data, VkDeviceSize size, VkDeviceSize offset)
+	{ return this->submit_upload<STORAGE>(ref, data, size, offset); }
+
+	std::span<std::byte> device_memory::stage_vertices(const memory_ref& ref, VkDeviceSize size, VkDeviceSize offset)
+	{ return this->stage_upload<VERTEX>(ref, size, offset); }
+	std::span<std::byte> device_memory::stage_indexes(const memory_ref& ref, VkDeviceSize size, VkDeviceSize offset)
+	{ return this->stage_upload<INDEX>(ref, size, offset); }
+	std::span<std::byte> device_memory::stage_uniform(const memory_ref& ref, VkDeviceSize size, VkDeviceSize offset)
+	{ return this->stage_upload<UNIFORM>(ref, size, offset); }
+	std::span<std::byte> device_memory::stage_storage(const memory_ref& ref, VkDeviceSize size, VkDeviceSize offset)
+	{ return this->stage_upload<STORAGE>(ref, size, offset); }
+	std::span<std::byte> device_memory::stage_texture(const memory_ref& ref)
+	{
+		//texture staging is handed to the upload as it is reserved, only the render thread can write to it between draws
+		std::lock_guard<std::mutex> lock(m_access);
+		const internal_ref& iref = resolve(ref);
+		return { static_cast<std::byte*>(stage_texture_upload(mem_ref_internal::handle(ref))), iref.size };
+	}
+
+	std::span<std::byte> device_memory::stage(const memory_ref& ref, VkDeviceSize size, VkDeviceSize offset)
+	{
+		std::lock_guard<std::mutex> lock(m_access);
+		const u8 pool_type = resolve(ref).pool_type;
+		INTERNAL_ASSERT(pool_type >= VERTEX && pool_type <= STORAGE, "Only static buffers can be staged");
+		return reserve_upload(mem_ref_internal::handle(ref), size, offset);
+	}
+
+	std::span<std::byte> device_memory::reserve_upload(u32 handle, VkDeviceSize size, VkDeviceSize offset)
+	{
+		INTERNAL_ASSERT(offset + size <= m_refs[handle].ref.size, "Out of bounds memory access");
+
+		upload_pool& pool = thread_upload_pool();
+		std::span<std::byte> staging = pool.reserve(handle, m_refs[handle].generation, size, offset);
+		if (!staging.data())
+		{
+			VkDeviceSize ring_size = 2 * pool.ring_size();
+			if (ring_size < size)
+				ring_size = increase_to_fit(ring_size, size);
+
+			LOGF_INTERNAL_INFO("Staging ring full, allocating a new ring of {0} bytes", ring_size);
+			pool.add_ring(radd.device, heap_manager, ring_size);
+			staging = pool.reserve(handle, m_refs[handle].generation, size, offset);
+		}
+
+		m_refs[handle].uploading++;
+		m_uploading++;
+
+		return staging;
+	}
 
 	void device_memory::memcpy_vertices(const memory_ref& ref, const void* data, VkDeviceSize size, VkDeviceSize offset)
 	{ this->memcpy<VERTEX>(ref, data, size, offset); }
@@ -450,9 +1407,18 @@ namespace ENGINE_NAMESPACE
 	{ return binding_args<STORAGE>(vector); }
 	buffer_binding_args device_memory::binding_args(const dynamic_storage_vector& vector) noexcept
 	{ return dynamic_binding_args<STORAGE>(vector); }
+	buffer_binding_args device_memory::binding_args(const transient_uniform& uniform) noexcept
+	{ return transient_binding_args(uniform); }
+	buffer_binding_args device_memory::binding_args(const transient_storage& storage) noexcept
+	{ return transient_binding_args(storage); }
+
+	void device_memory::alloc_transient_uniform(transient_buffer& out, VkDeviceSize size)
+	{ alloc_transient<UNIFORM>(out, size); }
+	void device_memory::alloc_transient_storage(transient_buffer& out, VkDeviceSize size)
+	{ alloc_transient<STORAGE>(out, size); }
 
 	template<device_memory::buffer_t BType, bool Dynamic>
-	inline memory_ref device_memory::alloc_buffer(VkDeviceSize size)
+	inline internal_ref device_memory::place_buffer(VkDeviceSize size)
 	{
 		using pool_t = typename get_buffer_pool<Dynamic>::type;
 		const VkDeviceSize alignment = offset_alignment<BType>();
@@ -469,24 +1435,29 @@ namespace ENGINE_NAMESPACE
 			pool_size = buffer<BType>::dynamic_size;
 		}
 
+		//the pool being defragmented takes no new allocations
+		const u32 excluded_pool = !Dynamic && m_defrag.pool_type == BType ? m_defrag.pool : std::numeric_limits<u32>::max();
+
 		u32 selected_pool_idx = 0;
 		u32 selected_slot_idx = 0;
 		VkDeviceSize size_needed = 0;
 		VkDeviceSize offset = 0;
 
-		if (!search_buffer_pools(*pools, size, alignment, selected_pool_idx, selected_slot_idx, size_needed, offset))
+		if (!search_buffer_pools(*pools, size, alignment, excluded_pool, 
+			selected_pool_idx, selected_slot_idx, size_needed, offset))
 		{
 			if (pool_size < size)
 				pool_size = increase_to_fit(pool_size, size);
 
 			if constexpr (!Dynamic || BType == buffer_t::UNIVERSAL)
 			{
-				pools->push_back(buffer_pool(radd.device, heap_manager, pool_size, buffer<BType>::usage));
+				selected_pool_idx = add_pool(*pools, buffer_pool(radd.device, heap_manager, pool_size, buffer<BType>::usage));
 			}
 			else
 			{
-				pools->push_back(dynamic_buffer_pool(radd.device, heap_manager, pool_size, buffer<BType>::dynamic_usage));
-				(*pools)[selected_pool_idx].map(radd.device, *radd.current_frame);
+				selected_pool_idx = add_pool(*pools, 
+					dynamic_buffer_pool(radd.device, heap_manager, pool_size, buffer<BType>::dynamic_usage));
+				(*pools)[selected_pool_idx].select_frame(*radd.current_frame);
 			}
 		}
 
@@ -497,7 +1468,14 @@ namespace ENGINE_NAMESPACE
 			size, selected_slot_idx, offset,
 			aligned_offset(offset, alignment), buffer<BType>::debug_name, selected_pool_idx);
 
-		return mem_ref_internal::create(BType, selected_pool_idx, offset, size);
+		return { static_cast<u8>(Dynamic ? BType | DYNAMIC_BIT : BType), selected_pool_idx, offset, size };
+	}
+
+	template<device_memory::buffer_t BType, bool Dynamic>
+	inline memory_ref device_memory::alloc_buffer(VkDeviceSize size)
+	{
+		std::lock_guard<std::mutex> lock(m_access);
+		return create_ref(place_buffer<BType, Dynamic>(size));
 	}
 
 	template<device_memory::buffer_t BType, bool Dynamic>
@@ -514,82 +1492,112 @@ namespace ENGINE_NAMESPACE
 	}
 
 	template<device_memory::buffer_t BType>
-	inline void device_memory::submit_upload(const memory_ref& ref, const void* data, VkDeviceSize size, VkDeviceSize offset)
+	inline u64 device_memory::submit_upload(const memory_ref& ref, const void* data, VkDeviceSize size, VkDeviceSize offset)
 	{
-		const internal_ref& iref = mem_ref_internal::extract(ref);
-		INTERNAL_ASSERT(iref.pool_type == BType, "Memory reference pool type and function pool type do not match");
-		INTERNAL_ASSERT(iref.offset + offset + size <= iref.size, "Out of bounds memory access");
-
-		std::size_t up_pool_idx = 0;
-		for (upload_pool& pool : m_upload_pools)
-		{
-			if (pool.size() + size <= pool.capacity())
-				break;
-
-			up_pool_idx++;
-		}
-
-		if (up_pool_idx == m_upload_pools.size())
-		{
-			VkDeviceSize up_pool_size = staging_buffer_size;
-			if (up_pool_size < size)
-				up_pool_size = increase_to_fit(up_pool_size, size);
-
-			m_upload_pools.push_back(upload_pool(radd.device, heap_manager, up_pool_size));
-			m_upload_pools[up_pool_idx].map(radd.device, *radd.current_frame);
-		}
-
-		upload_pool& up_pool = m_upload_pools[up_pool_idx];
+		//written outside of the lock, the reservation is only visible to the upload once committed
+		std::memcpy(stage_upload<BType>(ref, size, offset).data(), data, size);
 
-		if (!up_pool.has_batch(iref.pool_type, iref.pool))
-			up_pool.create_batch(iref.pool_type, iref.pool, static_pools<BType>()[iref.pool].buffer());
-
-		up_pool.submit(iref.pool_type, iref.pool, data, size, iref.offset + offset);
+		std::lock_guard<std::mutex> lock(m_access);
+		return commit(thread_upload_pool(), true);
+	}
 
-		m_uploads_pending = true;
+	template<device_memory::buffer_t BType>
+	inline std::span<std::byte> device_memory::stage_upload(const memory_ref& ref, VkDeviceSize size, 
+		VkDeviceSize offset)
+	{
+		std::lock_guard<std::mutex> lock(m_access);
+		INTERNAL_ASSERT(resolve(ref).pool_type == BType, "Memory reference pool type and function pool type do not match");
+		return reserve_upload(mem_ref_internal::handle(ref), size, offset);
 	}
 
 	template<device_memory::buffer_t BType>
 	inline void device_memory::memcpy(const memory_ref& ref, const void* data, VkDeviceSize size, VkDeviceSize offset)
 	{
-		const internal_ref& iref = mem_ref_internal::extract(ref);
-		INTERNAL_ASSERT(iref.pool_type == BType, "Memory reference pool type and function pool type do not match");
-		INTERNAL_ASSERT(iref.offset + offset + size <= iref.size, "Out of bounds memory access");
-		std::vector<dynamic_buffer_pool>& pools = dynamic_pools<BType>();
-		std::memcpy(static_cast<std::byte*>(pools[iref.pool].host_ptr()) + iref.offset + offset, data, size);
+		std::lock_guard<std::mutex> lock(m_access);
+		const internal_ref& iref = resolve(ref);
+		INTERNAL_ASSERT(iref.pool_type == (BType | DYNAMIC_BIT), "Memory reference pool type and function pool type do not match");
+		INTERNAL_ASSERT(offset + size <= iref.size, "Out of bounds memory access");
+		dynamic_buffer_pool& pool = dynamic_pools<BType>()[iref.pool];
+		const VkDeviceSize dst_offset = aligned_offset(iref.offset, offset_alignment<BType>()) + offset;
+		std::memcpy(static_cast<std::byte*>(pool.host_ptr()) + dst_offset, data, size);
+		pool.mark_dirty(dst_offset, size);
 	}
 
 	template<device_memory::buffer_t BType>
 	void device_memory::map(const memory_ref& ref, void**& out_map_ptr, std::size_t& out_offset) noexcept
 	{
-		const internal_ref& iref = mem_ref_internal::extract(ref);
+		std::lock_guard<std::mutex> lock(m_access);
+		const internal_ref& iref = resolve(ref);
 		out_offset = aligned_offset(iref.offset, offset_alignment<BType>());
-		out_map_ptr = &dynamic_pools<BType>()[iref.pool].host_ptr();
+		dynamic_buffer_pool& pool = dynamic_pools<BType>()[iref.pool];
+		pool.mark_mapped(out_offset, iref.size);
+		out_map_ptr = &pool.host_ptr();
 	}
 
 	buffer_binding_args device_memory::index_binding_args(const mesh& mesh) noexcept
 	{
 		INTERNAL_ASSERT(mesh.valid(), "Invalid mesh");
-		const internal_ref& ref = mesh_internal::extract_index_ref(mesh);
-		return { index_pools[ref.pool].buffer(), index_pools[ref.pool].size(), ref.offset, ref.size };
+		const memory_ref& mref = mesh_internal::index_ref(mesh);
+		std::lock_guard<std::mutex> lock(m_access);
+		const internal_ref& ref = resolve(mref);
+		return { index_pools[ref.pool].buffer(), index_pools[ref.pool].size(), ref.offset, ref.size, mref.hash() };
 	}
 
 	template<device_memory::buffer_t BType>
 	buffer_binding_args device_memory::binding_args(const resource& resource) noexcept
 	{
 		INTERNAL_ASSERT(resource.valid(), "Invalid resource");
-		const internal_ref& ref = resource_internal::extract_ref(resource);
+		const memory_ref& mref = resource_internal::ref(resource);
+		std::lock_guard<std::mutex> lock(m_access);
+		const internal_ref& ref = resolve(mref);
 		return { static_pools<BType>()[ref.pool].buffer(), 0, aligned_offset(ref.offset, offset_alignment<BType>()), 
-			ref.size };
+			ref.size, mref.hash() };
 	}
 
 	template<device_memory::buffer_t BType>
 	buffer_binding_args device_memory::dynamic_binding_args(const resource& resource) noexcept
 	{
 		INTERNAL_ASSERT(resource.valid(), "Invalid resource");
-		const internal_ref& ref = resource_internal::extract_ref(resource);
+		const memory_ref& mref = resource_internal::ref(resource);
+		std::lock_guard<std::mutex> lock(m_access);
+		const internal_ref& ref = resolve(mref);
 		dynamic_buffer_pool& pool = dynamic_pools<BType>()[ref.pool];
-		return { pool.buffer(), pool.size(), aligned_offset(ref.offset, offset_alignment<BType>()), ref.size };
+		return { pool.buffer(), pool.size(), aligned_offset(ref.offset, offset_alignment<BType>()), ref.size, 
+			mref.hash() };
+	}
+
+	template<device_memory::buffer_t BType>
+	inline void device_memory::alloc_transient(transient_buffer& out, VkDeviceSize size)
+	{
+		const VkDeviceSize alignment = offset_alignment<BType>();
+		VkDeviceSize offset = m_transient_rings.empty() ? transient_ring::invalid_offset :
+			m_transient_rings.back().allocate(size, alignment);
+
+		if (offset == transient_ring::invalid_offset)
+		{
+			VkDeviceSize ring_size = m_transient_rings.empty() ? transient_ring_size : 2 * m_transient_rings.back().size();
+			if (ring_size < size)
+				ring_size = increase_to_fit(ring_size, size);
+
+			LOGF_INTERNAL_INFO("Transient ring full, allocating a new ring of {0} bytes", ring_size);
+			std::lock_guard<std::mutex> lock(m_access); //the heap manager is shared with the other threads
+			m_transient_rings.push_back(transient_ring(radd.device, heap_manager, ring_size, transient_ring_usage,
+				device_heap_manager::heap::DYNAMIC));
+			offset = m_transient_rings.back().allocate(size, alignment);
+		}
+
+		const transient_ring& ring = m_transient_rings.back();
+		transient_internal::init(out, static_cast<std::byte*>(ring.host_ptr()) + offset, size,
+			static_cast<u32>(m_transient_rings.size() - 1), offset, m_transient_frame);
+	}
+
+	buffer_binding_args device_memory::transient_binding_args(const transient_buffer& buffer) noexcept
+	{
+		INTERNAL_ASSERT(buffer.valid(), "Invalid transient buffer");
+		INTERNAL_ASSERT(transient_internal::frame(buffer) == m_transient_frame,
+			"Transient buffer used after the frame it was allocated in");
+		const transient_ring& ring = m_transient_rings[transient_internal::ring_idx(buffer)];
+		return { ring.buffer(), 0, transient_internal::offset(buffer), buffer.size() };
 	}
 
 	template<bool Dynamic>
@@ -621,6 +1629,8 @@ namespace ENGINE_NAMESPACE
 		VkMemoryRequirements requirements;
 		texture_slot tex = create_texture(radd.device, image_info, requirements);
 
+		std::lock_guard<std::mutex> lock(m_access);
+
 		using pool_t = typename get_texture_pool<Dynamic>::type;
 		std::vector<pool_t>* pools;
 		VkDeviceSize pool_size;
@@ -666,12 +1676,22 @@ namespace ENGINE_NAMESPACE
 			requirements.size, selected_slot_idx, offset,
 			aligned_offset(offset, requirements.alignment), buffer<TEXTURE>::debug_name, selected_pool_idx);
 		
-		return mem_ref_internal::create(TEXTURE, selected_pool_idx, offset, requirements.size);
+		return create_ref({ TEXTURE, selected_pool_idx, offset, requirements.size });
 	}
 
-	void device_memory::submit_texture_upload(const memory_ref& ref, const void* data)
+	u64 device_memory::submit_texture_upload(const memory_ref& ref, const void* data)
 	{
-		const internal_ref& iref = mem_ref_internal::extract(ref);
+		//copied under the lock, as the copy is recorded as soon as it is reserved
+		std::lock_guard<std::mutex> lock(m_access);
+		const internal_ref& iref = resolve(ref);
+		const u32 handle = mem_ref_internal::handle(ref);
+		std::memcpy(stage_texture_upload(handle), data, iref.size);
+		return m_refs[handle].ticket;
+	}
+
+	void* device_memory::stage_texture_upload(u32 handle)
+	{
+		const internal_ref& iref = m_refs[handle].ref;
 		INTERNAL_ASSERT(iref.pool_type == TEXTURE, "Memory reference pool type and function pool type do not match");
 
 		VkDeviceSize size = iref.size;
@@ -691,16 +1711,17 @@ namespace ENGINE_NAMESPACE
 				up_pool_size = increase_to_fit(up_pool_size, size);
 
 			m_tex_upload_pools.push_back(texture_upload_pool(radd.device, heap_manager, up_pool_size));
-			m_tex_upload_pools[up_pool_idx].map(radd.device, *radd.current_frame);
+			m_tex_upload_pools[up_pool_idx].select_frame(*radd.current_frame);
 		}
 
 		texture_upload_pool& up_pool = m_tex_upload_pools[up_pool_idx];
 
 		const texture_pool& tex_pool = texture_pools[iref.pool];
 		const texture_slot& tex = tex_pool.tex_at(tex_pool.find_slot(iref.offset));
-		up_pool.buffer_image_copy(data, size, tex.image, VK_IMAGE_LAYOUT_GENERAL, tex.dims);
-		
 		m_uploads_pending = true;
+		m_refs[handle].ticket = ++m_ticket; //the copy is recorded by the next upload
+
+		return up_pool.reserve_buffer_image_copy(size, tex.image, VK_IMAGE_LAYOUT_GENERAL, tex.dims);
 	}
 
 	memory_ref device_memory::alloc_texture(u32 w, u32 h)
@@ -4,9 +4,15 @@
 #include "device_heap_manager.hpp"
 #include "resource_pool.hpp"
 #include "staging_pool.hpp"
+#include "transient_ring.hpp"
 
 #include <render/memory_ref.hpp>
 #include <render/resource.hpp>
+#include <render/renderer.hpp>
+#include <io/file_stream.hpp>
+
+#include <memory>
+#include <mutex>
 
 namespace ENGINE_NAMESPACE
 {
@@ -19,19 +25,43 @@ namespace ENGINE_NAMESPACE
 		const u8* current_frame;
 	};
 
+	struct internal_ref
+	{
+		u8 pool_type = 0;
+		u32 pool = std::numeric_limits<u32>::max();
+		std::size_t offset = std::numeric_limits<std::size_t>::max();
+		std::size_t size = 0;
+	};
+
 	struct buffer_binding_args
 	{
 		VkBuffer buffer;
 		VkDeviceSize frame_offset;
 		VkDeviceSize offset;
 		VkDeviceSize size;
+		std::size_t ref = 0; //hash of the memory reference the arguments were resolved from, 0 if none
 	};
 
+	/**
+	 * @brief Pools of device memory and the uploads to them. Allocating, freeing, uploading, staging and streaming static
+	 * resources can be done from any thread: the bookkeeping is guarded by a single lock held only briefly, while every
+	 * thread stages into its own rings and is merged into the frame's upload. Transient allocations, writes to dynamic
+	 * resources and the functions of the frame are left to the render thread, the one the memory was initialized on.
+	*/
 	class device_memory
 	{
 	public:
 		void init(VkPhysicalDevice physical_device, VkDevice device, u32 transfer_queue_idx, 
 			const VkPhysicalDeviceLimits* limits, const u8* current_frame);
+		/**
+		 * @brief Checks for timeline semaphores, which have to be enabled on the logical device for upload completion to
+		 * be tracked as it happens. Without them it is tracked through the frames' upload fences.
+		*/
+		static bool timeline_supported(VkPhysicalDevice physical_device);
+
+		/**
+		 * @brief Frees every pool, the other threads must no longer use the memory.
+		*/
 		void terminate(VkDevice device, u8 current_frame);
 
 		device_memory() = default;
@@ -48,8 +78,23 @@ namespace ENGINE_NAMESPACE
 			d_vertex_pools(std::move(other.d_vertex_pools)), d_index_pools(std::move(other.d_index_pools)),
 			d_uniform_pools(std::move(other.d_uniform_pools)), d_storage_pools(std::move(other.d_storage_pools)),
 			m_upload_semaphores(std::move(other.m_upload_semaphores)), m_upload_fences(std::move(other.m_upload_fences)),
-			m_upload_pools(std::move(other.m_upload_pools)), m_tex_upload_pools(std::move(other.m_tex_upload_pools)),
-			m_uploads_pending(std::exchange(other.m_uploads_pending, false))
+			m_transfer_queue_idx(std::exchange(other.m_transfer_queue_idx, 0)),
+			m_upload_pools(std::move(other.m_upload_pools)), m_committed(std::move(other.m_committed)),
+			m_copies(std::move(other.m_copies)), m_transfer_cmds(std::move(other.m_transfer_cmds)),
+			m_upload_timeline(std::exchange(other.m_upload_timeline, VK_NULL_HANDLE)),
+			m_ticket(std::exchange(other.m_ticket, 0)), m_submitted_ticket(std::exchange(other.m_submitted_ticket, 0)),
+			m_completed_ticket(std::exchange(other.m_completed_ticket, 0)), 
+			m_frame_tickets(std::exchange(other.m_frame_tickets, {})), m_uploading(std::exchange(other.m_uploading, 0)),
+			m_tex_upload_pools(std::move(other.m_tex_upload_pools)),
+			m_uploads_pending(std::exchange(other.m_uploads_pending, false)), m_streams(std::move(other.m_streams)),
+			m_downloads(std::move(other.m_downloads)), m_download_copies(std::move(other.m_download_copies)),
+			m_download_latency(std::exchange(other.m_download_latency, max_frames_in_flight)),
+			m_released(std::move(other.m_released)), m_reclaim(std::move(other.m_reclaim)),
+			m_transient_rings(std::move(other.m_transient_rings)),
+			m_transient_frame(std::exchange(other.m_transient_frame, 0)),
+			m_refs(std::move(other.m_refs)), m_free_refs(std::move(other.m_free_refs)),
+			m_defrag(std::move(other.m_defrag)), m_relocations(std::exchange(other.m_relocations, 0)),
+			m_relocated_bytes(std::exchange(other.m_relocated_bytes, 0))
 		{}
 		
 		inline void update_refs(VkDevice device, const VkPhysicalDeviceLimits* limits, const u8* current_frame) noexcept 
@@ -58,15 +103,86 @@ namespace ENGINE_NAMESPACE
 		//void update_largest_slots();
 		//void tick(); could maybe replace the above function and performa all updates and cleanup
 
+		/**
+		 * @brief Commits the render thread's pending uploads, then records and submits the merged copies of the oldest
+		 * committed uploads, up to a per frame budget, the secondary command buffers submitted by the threads and the
+		 * moves of the defragmenter. The submission signals the last ticket whose upload it completes.
+		 * @return True if a submission was made, which the frame's rendering has to wait on.
+		*/
 		bool upload(VkDevice device, VkQueue transfer_queue, u32 transfer_queue_idx, u8 current_frame);
-		//void flush_downloads();
 
-		void map_ranges(VkDevice device, u8 current_frame);
-		void unmap_ranges(VkDevice device, u8 current_frame);
+		/**
+		 * @brief Stages the chunks read so far by the pending streams, up to a per frame budget, so large files are
+		 * uploaded over several frames without being loaded whole in memory. Must be called while the staging pools
+		 * are mapped, before flushing them.
+		*/
+		void stream_uploads();
+
+		/**
+		 * @brief Records the copies of the requested downloads at the end of the frame's graphics commands, after the
+		 * shaders writing to their sources. Downloads that do not fit in the ring wait for the next frames. Must be
+		 * called once per frame, outside of a render pass.
+		*/
+		void record_downloads(VkCommandBuffer cmd_buffer, u8 current_frame);
+
+		/**
+		 * @brief Hands the data of the downloads recorded by a frame to their futures. Must be called once that frame's
+		 * fences have been waited on.
+		*/
+		void complete_downloads(u8 frame);
+
+		/**
+		 * @brief Frames between a download being recorded and its data being delivered. Below max_frames_in_flight, the
+		 * frame the download was recorded in is waited on when it is delivered.
+		*/
+		inline u8 download_latency() const noexcept { return m_download_latency; }
+		void set_download_latency(u8 frames) noexcept;
+
+		/**
+		 * @brief Points the host pointers of the dynamic and texture staging pools at the current frame's region. The
+		 * pools stay mapped for their whole lifetime, no memory is mapped or unmapped per frame.
+		*/
+		void select_frame(u8 current_frame);
+
+		/**
+		 * @brief Flushes the ranges written by the host for the current frame, when their heap is not host coherent.
+		 * The staged buffer uploads are flushed as they are committed instead. Must be called once per frame, after the
+		 * streams are staged and before the uploads are recorded.
+		*/
 		void flush_ranges(VkDevice device, u8 current_frame);
 
+		/**
+		 * @brief Waits on the current frame's previous upload, so its staging can be reused.
+		*/
 		void sync(VkDevice device, u8 current_frame);
 
+		/**
+		 * @brief Queues the memory of a reference to be returned to its pool by reclaim. Pending streams into it are
+		 * dropped.
+		*/
+		void free(const memory_ref& ref) noexcept;
+
+		/**
+		 * @brief Returns to their pools the allocations freed max_frames_in_flight frames ago, then holds back the ones
+		 * freed since the last call. Must be called right after waiting on the current frame's fences, so no frame still
+		 * in flight can read the reclaimed memory. Also ends the current frame's transient allocations, releases the
+		 * emptied static pools and picks the next pool to defragment.
+		*/
+		void reclaim(u8 current_frame);
+
+		/**
+		 * @brief Counts the allocations moved by the defragmenter, bindings resolved before it changed may be outdated.
+		*/
+		inline u64 relocations() const noexcept { return m_relocations; }
+
+		/**
+		 * @brief Resolves the binding arguments of a static buffer again, in case its allocation was moved.
+		 * @return True if the buffer or the offset changed.
+		*/
+		bool refresh_binding(buffer_binding_args& args) noexcept;
+
+		renderer::memory_stats statistics() const noexcept;
+
 		inline VkSemaphore upload_semaphore(u8 current_frame) { return m_upload_semaphores[current_frame]; }
 
 		memory_ref alloc_vertices(VkDeviceSize size);
@@ -89,15 +205,112 @@ namespace ENGINE_NAMESPACE
 		
 		memory_ref alloc_texture(u32 w, u32 h);
 
-		void upload_texture(const memory_ref& ref, const void* data)
+		/**
+		 * @brief Bumps transient memory for the current frame from the active ring. A full ring is replaced by a larger
+		 * one, and kept until the frames using it have completed.
+		*/
+		void alloc_transient_uniform(transient_buffer& out, VkDeviceSize size);
+		void alloc_transient_storage(transient_buffer& out, VkDeviceSize size);
+
+		u64 upload_texture(const memory_ref& ref, const void* data)
 		{
-			submit_texture_upload(ref, data);
+			return submit_texture_upload(ref, data);
 		}
 
-		void upload_vertices(const memory_ref& ref, const void* data, VkDeviceSize size, VkDeviceSize offset = 0);
-		void upload_indexes(const memory_ref& ref, const void* data, VkDeviceSize size, VkDeviceSize offset = 0);
-		void upload_uniform(const memory_ref& ref, const void* data, VkDeviceSize size, VkDeviceSize offset = 0);
-		void upload_storage(const memory_ref& ref, const void* data, VkDeviceSize size, VkDeviceSize offset = 0);
+		// uploads return their ticket, see upload_complete
+
+		u64 upload_vertices(const memory_ref& ref, const void* data, VkDeviceSize size, VkDeviceSize offset = 0);
+		u64 upload_indexes(const memory_ref& ref, const void* data, VkDeviceSize size, VkDeviceSize offset = 0);
+		u64 upload_uniform(const memory_ref& ref, const void* data, VkDeviceSize size, VkDeviceSize offset = 0);
+		u64 upload_storage(const memory_ref& ref, const void* data, VkDeviceSize size, VkDeviceSize offset = 0);
+
+		// reserve staging memory for an upload and return it, so the data can be written (or read from disk) in place,
+		// the memory is valid until the upload is committed, which happens with the next draw on the render thread and
+		// through commit_staging on the others
+
+		std::span<std::byte> stage_vertices(const memory_ref& ref, VkDeviceSize size, VkDeviceSize offset = 0);
+		std::span<std::byte> stage_indexes(const memory_ref& ref, VkDeviceSize size, VkDeviceSize offset = 0);
+		std::span<std::byte> stage_uniform(const memory_ref& ref, VkDeviceSize size, VkDeviceSize offset = 0);
+		std::span<std::byte> stage_storage(const memory_ref& ref, VkDeviceSize size, VkDeviceSize offset = 0);
+		std::span<std::byte> stage_texture(const memory_ref& ref);
+
+		/**
+		 * @brief Stages an upload to any static buffer, dispatching on the pool of the reference.
+		*/
+		std::span<std::byte> stage(const memory_ref& ref, VkDeviceSize size, VkDeviceSize offset = 0);
+
+		/**
+		 * @brief Hands the uploads staged by the calling thread over to the next frames, their data must be written.
+		 * @return Ticket of the last upload committed.
+		*/
+		u64 commit_staging();
+
+		/**
+		 * @brief Tickets are handed out in commit order, and an upload completes once every upload committed before it
+		 * has, so a ticket also covers the earlier ones.
+		 * @return True once the upload of the ticket, and of every earlier ticket, has been executed by the device.
+		*/
+		bool upload_complete(u64 ticket);
+
+		/**
+		 * @return Ticket of the last upload committed by any thread.
+		*/
+		u64 last_ticket() const noexcept;
+
+		/**
+		 * @return True once every upload to the allocation, including its streams, has been executed by the device.
+		*/
+		bool ready(const memory_ref& ref);
+
+		/**
+		 * @brief Checks that a binding's allocation has no upload left for the next frames, i.e. that the frame being
+		 * recorded, which waits on the frame's upload, can draw it.
+		 * @param ref Hash from the binding arguments, 0 for none.
+		*/
+		bool drawable(std::size_t ref);
+
+		/**
+		 * @brief Every allocation is drawable, the bindings do not need to be checked one by one.
+		*/
+		bool all_drawable();
+
+		/**
+		 * @brief Reads part of a static buffer back from the device, without waiting. The copy is recorded after the
+		 * next frame's draws, and its data is delivered download_latency frames later.
+		 * @return Future receiving the data, or an empty vector if the buffer was freed before it was copied.
+		*/
+		std::future<std::vector<std::byte>> download(const memory_ref& ref, VkDeviceSize size, VkDeviceSize offset = 0);
+
+		/**
+		 * @brief Begins a secondary command buffer from the calling thread's transfer command pool, so workers can
+		 * record their own copies, e.g. between buffers they allocated. It is executed by the next upload after the
+		 * staged copies, on the transfer queue.
+		*/
+		VkCommandBuffer begin_transfer_commands();
+
+		/**
+		 * @brief Records a copy between two static buffers into a command buffer begun by the calling thread. Both
+		 * locations are resolved now, and both allocations are pinned: the defragmenter does not move them, and a
+		 * freed one is not reused, until the command buffer has been executed.
+		*/
+		void record_copy(VkCommandBuffer cmd_buffer, const memory_ref& src, const memory_ref& dst, VkDeviceSize size,
+			VkDeviceSize src_offset = 0, VkDeviceSize dst_offset = 0);
+
+		/**
+		 * @brief Ends a command buffer begun by the calling thread and queues it for the next upload. It is recycled,
+		 * and its allocations unpinned, once the frame that executed it has completed.
+		 * @return Ticket of the command buffer, the allocations it copies to are ready once it is complete.
+		*/
+		u64 submit_transfer_commands(VkCommandBuffer cmd_buffer);
+
+		/**
+		 * @brief Uploads a file into a buffer or texture chunk by chunk over the next frames.
+		 * @param ref Destination, must stay allocated until the stream has been fully uploaded.
+		 * @param stream Opened stream, its size must fit in the destination. Textures are copied as a whole, so their
+		 * stream must cover the entire texture, which is gathered in host memory and staged once it has been read.
+		 * @param offset Position in the destination to write the streamed data to.
+		*/
+		void stream(const memory_ref& ref, io::file_stream&& stream, VkDeviceSize offset = 0);
 
 		void memcpy_vertices(const memory_ref& ref, const void* data, VkDeviceSize size, VkDeviceSize offset = 0);
 		void memcpy_indexes(const memory_ref& ref, const void* data, VkDeviceSize size, VkDeviceSize offset = 0);
@@ -117,6 +330,8 @@ namespace ENGINE_NAMESPACE
 		buffer_binding_args binding_args(const dynamic_storage_array& array) noexcept;
 		buffer_binding_args binding_args(const storage_vector& vector) noexcept;
 		buffer_binding_args binding_args(const dynamic_storage_vector& vector) noexcept;
+		buffer_binding_args binding_args(const transient_uniform& uniform) noexcept;
+		buffer_binding_args binding_args(const transient_storage& storage) noexcept;
 
 		enum buffer_t : u8
 		{
@@ -127,6 +342,8 @@ namespace ENGINE_NAMESPACE
 			STORAGE,
 			UNIVERSAL, //writable
 			TEXTURE,
+
+			DYNAMIC_BIT = 0x80, //added to the buffer type of allocations in dynamic pools
 		};
 
 	private:
@@ -159,6 +376,9 @@ namespace ENGINE_NAMESPACE
 		template<> inline VkDeviceSize offset_alignment<device_memory::UNIVERSAL>() const noexcept
 		{ return radd.limits->minStorageBufferOffsetAlignment; }
 
+		template<buffer_t BType, bool Dynamic>
+		internal_ref place_buffer(VkDeviceSize size);
+
 		template<buffer_t BType, bool Dynamic>
 		memory_ref alloc_buffer(VkDeviceSize size);
 
@@ -166,7 +386,10 @@ namespace ENGINE_NAMESPACE
 		memory_ref alloc_buffer(const void* data, VkDeviceSize size);
 
 		template<buffer_t BType>
-		void submit_upload(const memory_ref& ref, const void* data, VkDeviceSize size, VkDeviceSize offset);
+		u64 submit_upload(const memory_ref& ref, const void* data, VkDeviceSize size, VkDeviceSize offset);
+
+		template<buffer_t BType>
+		std::span<std::byte> stage_upload(const memory_ref& ref, VkDeviceSize size, VkDeviceSize offset);
 
 		template<buffer_t BType>
 		void memcpy(const memory_ref& ref, const void* data, VkDeviceSize size, VkDeviceSize offset);
@@ -179,10 +402,34 @@ namespace ENGINE_NAMESPACE
 		template<buffer_t BType>
 		buffer_binding_args dynamic_binding_args(const resource&) noexcept;
 
+		template<buffer_t BType>
+		void alloc_transient(transient_buffer& out, VkDeviceSize size);
+		buffer_binding_args transient_binding_args(const transient_buffer& buffer) noexcept;
+
 		template<bool Dynamic>
 		memory_ref alloc_texture(VkExtent3D extent, u32 layers, u32 mip_levels);
 
-		void submit_texture_upload(const memory_ref& ref, const void* data);
+		u64 submit_texture_upload(const memory_ref& ref, const void* data);
+		void* stage_texture_upload(u32 handle);
+
+		//the functions below expect the lock to be held
+
+		std::span<std::byte> reserve_upload(u32 handle, VkDeviceSize size, VkDeviceSize offset);
+		upload_pool& thread_upload_pool();
+		u64 commit(upload_pool& pool, bool last_only);
+		void collect_uploads(VkDevice device, u8 current_frame);
+		u64 completed_ticket();
+
+		memory_ref create_ref(const internal_ref& ref);
+		const internal_ref& resolve(const memory_ref& ref) const noexcept;
+		void unpin(const upload_pool::pinned_ref& pinned);
+
+		std::vector<buffer_pool>& static_pools(u8 pool_type) noexcept;
+		VkDeviceSize offset_alignment(u8 pool_type) const noexcept;
+
+		void release_empty_pools();
+		void select_defrag_source();
+		void record_defrag_moves(VkCommandBuffer cmd_buffer);
 
 		random_access_device_data radd;
 
@@ -215,8 +462,75 @@ namespace ENGINE_NAMESPACE
 
 		std::array<VkSemaphore, max_frames_in_flight> m_upload_semaphores;
 		std::array<VkFence, max_frames_in_flight> m_upload_fences;
-		std::vector<upload_pool> m_upload_pools;
+
+		//guards everything the other threads reach, the render thread's per frame work takes it too
+		mutable std::mutex m_access;
+
+		u32 m_transfer_queue_idx = 0;
+
+		//one per thread that staged, kept until the memory is terminated, the first one is the render thread's
+		std::vector<std::unique_ptr<upload_pool>> m_upload_pools;
+		std::deque<upload_pool::staged_upload> m_committed; //in ticket order, copied over the next frames
+		copy_list m_copies;
+		std::vector<VkCommandBuffer> m_transfer_cmds;
+
+		//signaled with the submitted ticket by every upload that completes new tickets, null if not supported
+		VkSemaphore m_upload_timeline = VK_NULL_HANDLE;
+		u64 m_ticket = 0; //last handed out
+		u64 m_submitted_ticket = 0; //every ticket up to it is in a submitted upload
+		u64 m_completed_ticket = 0; //every ticket up to it has been executed, as last seen
+		std::array<u64, max_frames_in_flight> m_frame_tickets = {}; //submitted ticket of each frame's upload
+		u32 m_uploading = 0; //sum of the slots' uploads
+
 		std::vector<texture_upload_pool> m_tex_upload_pools;
-		bool m_uploads_pending = false;
+		bool m_uploads_pending = false; //texture uploads only, the buffer uploads are collected from the threads
+
+		struct pending_stream
+		{
+			u32 handle; //resolved every frame, the destination can be moved while it is streamed
+			VkDeviceSize offset;
+			io::file_stream stream;
+			std::unique_ptr<std::byte[]> texture_data; //textures are staged once fully read
+		};
+
+		std::vector<pending_stream> m_streams;
+
+		download_pool m_downloads;
+		copy_list m_download_copies;
+		u8 m_download_latency = max_frames_in_flight; //frames between recording a download and delivering it
+
+		//freed during the current frame, then kept per frame until that frame's fences come around again
+		std::vector<internal_ref> m_released;
+		std::array<std::vector<internal_ref>, max_frames_in_flight> m_reclaim;
+
+		//allocations are bumped from the last ring, the others are freed once the frames using them have completed
+		std::vector<transient_ring> m_transient_rings;
+		u64 m_transient_frame = 0;
+
+		struct ref_slot
+		{
+			internal_ref ref;
+			u32 generation = 1; //bumped when the slot is freed, stale references no longer match it
+			u32 uploading = 0; //uploads staged but not committed, and streams in progress
+			u64 ticket = 0; //of the last upload committed to the allocation
+			u32 pinned = 0; //copies recorded by the threads' command buffers that have not been executed yet
+		};
+
+		//memory_ref handle => allocation, freed slots are reused
+		std::vector<ref_slot> m_refs;
+		std::vector<u32> m_free_refs;
+
+		//static pool being emptied into the other pools of its type, it takes no new allocations and is released once
+		//its last moved allocation has been reclaimed
+		struct defrag_state
+		{
+			u8 pool_type = NONE;
+			u32 pool = std::numeric_limits<u32>::max();
+			std::vector<std::pair<u32, u32>> moves; //<handle, generation> of the allocations left to move
+		};
+
+		defrag_state m_defrag;
+		u64 m_relocations = 0;
+		u64 m_relocated_bytes = 0;
 	};
 }
@@ -25,7 +25,9 @@ SET_DESCRIPTOR(Return, unmapped_uniform)		\
 SET_DESCRIPTOR(Return, storage_array)			\
 SET_DESCRIPTOR(Return, dynamic_storage_array)	\
 SET_DESCRIPTOR(Return, storage_vector)			\
-SET_DESCRIPTOR(Return, dynamic_storage_vector)	
+SET_DESCRIPTOR(Return, dynamic_storage_vector)	\
+SET_DESCRIPTOR(Return, transient_uniform)		\
+SET_DESCRIPTOR(Return, transient_storage)
 
 	SET_DESCRIPTORS(pipeline_t::RENDER);
 
@@ -33,7 +35,7 @@ SET_DESCRIPTOR(Return, dynamic_storage_vector)
 #undef SET_DESCRIPTOR
 
 	template<>
-	template<typename Resource, std::enable_if_t<std::is_base_of<resource, Resource>::value && std::is_final<Resource>::value, bool>>
+	template<typename Resource, std::enable_if_t<is_descriptor_buffer<Resource>::value, bool>>
 	volatile_pipeline_task_ref<pipeline_t::RENDER>& volatile_pipeline_task_ref<pipeline_t::RENDER>::t_set_descriptor(
 		u32 descriptor_idx, const Resource& buffer)
 	{
@@ -81,5 +83,7 @@ render_pipeline::vptr_t render_pipeline::set_descriptor(const mesh& object, u32
 	SET_DESCRIPTOR(dynamic_storage_array);
 	SET_DESCRIPTOR(storage_vector);
 	SET_DESCRIPTOR(dynamic_storage_vector);
+	SET_DESCRIPTOR(transient_uniform);
+	SET_DESCRIPTOR(transient_storage);
 #undef SET_DESCRIPTOR
 }
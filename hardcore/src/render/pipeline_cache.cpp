@@ -0,0 +1,130 @@
+#include <pch.hpp>
+
+#include <render/pipeline_cache.hpp>
+#include <io/file_internal.hpp>
+
+#include <cstring>
+
+#include <debug/log_internal.hpp>
+
+namespace ENGINE_NAMESPACE
+{
+	inline const std::filesystem::path& pipeline_cache_path()
+	{
+		static const std::filesystem::path path = io::cache_path("HARDCORE_PIPELINE_CACHE", "cache/pipelines.bin");
+		return path;
+	}
+
+	inline bool pipeline_cache_enabled()
+	{
+		static const bool is_enabled = io::cache_enabled("HARDCORE_NO_PIPELINE_CACHE");
+		return is_enabled;
+	}
+
+	void pipeline_cache::init(VkDevice device, const VkPhysicalDeviceProperties& properties)
+	{
+		vendor_id = properties.vendorID;
+		device_id = properties.deviceID;
+		std::memcpy(uuid.data(), properties.pipelineCacheUUID, VK_UUID_SIZE);
+
+		std::vector<u8> data;
+		if (pipeline_cache_enabled())
+		{
+			data = read_file();
+			if (!data.empty() && !validate(data))
+			{
+				//written by another driver version or device, the driver would reject it anyway
+				LOG_INTERNAL_INFO("[RENDERER] Discarding incompatible pipeline cache: " << pipeline_cache_path().string());
+				data.clear();
+			}
+		}
+
+		VkPipelineCacheCreateInfo cache_info = {};
+		cache_info.sType = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO;
+		cache_info.initialDataSize = data.size();
+		cache_info.pInitialData = data.empty() ? nullptr : data.data();
+
+		if (!data.empty())
+		{
+			if (vkCreatePipelineCache(device, &cache_info, nullptr, &cache) == VK_SUCCESS)
+			{
+				LOG_INTERNAL_INFO("[RENDERER] Loaded pipeline cache (" << data.size() << " bytes)");
+				return;
+			}
+
+			LOG_INTERNAL_WARN("[RENDERER] Failed to load pipeline cache: " << pipeline_cache_path().string());
+			cache_info.initialDataSize = 0;
+			cache_info.pInitialData = nullptr;
+		}
+
+		VK_CRASH_CHECK(vkCreatePipelineCache(device, &cache_info, nullptr, &cache), "Failed to create pipeline cache");
+	}
+
+	void pipeline_cache::terminate(VkDevice device)
+	{
+		if (cache == VK_NULL_HANDLE) return;
+
+		if (pipeline_cache_enabled())
+		{
+			//runs sharing the file may have stored pipelines this one never created
+			std::vector<u8> disk_data = read_file();
+			if (!disk_data.empty() && validate(disk_data))
+			{
+				VkPipelineCacheCreateInfo cache_info = {};
+				cache_info.sType = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO;
+				cache_info.initialDataSize = disk_data.size();
+				cache_info.pInitialData = disk_data.data();
+
+				VkPipelineCache disk_cache = VK_NULL_HANDLE;
+				if (vkCreatePipelineCache(device, &cache_info, nullptr, &disk_cache) == VK_SUCCESS)
+				{
+					vkMergePipelineCaches(device, cache, 1, &disk_cache);
+					vkDestroyPipelineCache(device, disk_cache, nullptr);
+				}
+			}
+
+			std::size_t size = 0;
+			std::vector<u8> data;
+			if (vkGetPipelineCacheData(device, cache, &size, nullptr) == VK_SUCCESS && size)
+			{
+				data.resize(size);
+				if (vkGetPipelineCacheData(device, cache, &size, data.data()) != VK_SUCCESS) data.clear();
+				else data.resize(size);
+			}
+
+			if (!data.empty() && io::write_file_atomic(pipeline_cache_path(), data.data(), data.size()))
+				LOG_INTERNAL_INFO("[RENDERER] Stored pipeline cache (" << data.size() << " bytes)");
+		}
+
+		vkDestroyPipelineCache(device, cache, nullptr);
+		cache = VK_NULL_HANDLE;
+	}
+
+	bool pipeline_cache::validate(const std::vector<u8>& data) const noexcept
+	{
+		//VkPipelineCacheHeaderVersionOne, read field by field since the data carries no alignment guarantee
+		const std::size_t header_size = 16 + VK_UUID_SIZE;
+		if (data.size() < header_size) return false;
+
+		u32 size, version, vendor, device;
+		std::memcpy(&size, data.data(), sizeof(u32));
+		std::memcpy(&version, data.data() + 4, sizeof(u32));
+		std::memcpy(&vendor, data.data() + 8, sizeof(u32));
+		std::memcpy(&device, data.data() + 12, sizeof(u32));
+
+		return size >= header_size && size <= data.size() && version == VK_PIPELINE_CACHE_HEADER_VERSION_ONE &&
+			vendor == vendor_id && device == device_id && std::memcmp(data.data() + 16, uuid.data(), VK_UUID_SIZE) == 0;
+	}
+
+	std::vector<u8> pipeline_cache::read_file() const
+	{
+		std::vector<u8> data;
+		std::ifstream file(pipeline_cache_path(), std::ios::in | std::ios::binary | std::ios::ate);
+		if (!file.is_open()) return data;
+
+		data.resize(static_cast<std::size_t>(file.tellg()));
+		file.seekg(0);
+		if (!file.read(reinterpret_cast<char*>(data.data()), data.size())) data.clear();
+		return data;
+	}
+}
@@ -0,0 +1,48 @@
+#pragma once
+
+#include "render_core.hpp"
+
+namespace ENGINE_NAMESPACE
+{
+	/**
+	 * @brief Device level VkPipelineCache, persisted across runs in HARDCORE_PIPELINE_CACHE (defaults to
+	 * cache/pipelines.bin). Setting HARDCORE_NO_PIPELINE_CACHE disables loading and storing, pipelines still share an
+	 * in memory cache.
+	*/
+	class pipeline_cache
+	{
+	public:
+		pipeline_cache() = default;
+
+		/**
+		 * @brief Creates the cache, seeded with the data on disk if it was written by the same driver and device.
+		 * @param properties Properties of the physical device the cache data is validated against.
+		*/
+		void init(VkDevice device, const VkPhysicalDeviceProperties& properties);
+
+		/**
+		 * @brief Merges the data written by other runs since init, stores the result atomically and destroys the cache.
+		*/
+		void terminate(VkDevice device);
+
+		inline VkPipelineCache handle() const noexcept { return cache; }
+
+		pipeline_cache(const pipeline_cache&) = delete;
+		pipeline_cache& operator=(const pipeline_cache&) = delete;
+
+		pipeline_cache(pipeline_cache&& other) noexcept : cache(std::exchange(other.cache, VK_NULL_HANDLE)),
+			vendor_id(other.vendor_id), device_id(other.device_id), uuid(other.uuid)
+		{
+		}
+
+	private:
+		VkPipelineCache cache = VK_NULL_HANDLE;
+
+		u32 vendor_id = 0;
+		u32 device_id = 0;
+		std::array<u8, VK_UUID_SIZE> uuid = {};
+
+		bool validate(const std::vector<u8>& data) const noexcept;
+		std::vector<u8> read_file() const;
+	};
+}
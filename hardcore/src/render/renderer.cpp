@@ -5,6 +5,7 @@
 #include <render/render_core.hpp>
 
 #include <core/static_client.hpp>
+#include <core/window.hpp>
 #include <core/window_internal.hpp>
 #include <debug/log_internal.hpp>
 
@@ -129,10 +130,11 @@ namespace ENGINE_NAMESPACE
 			app_info.applicationVersion = VK_MAKE_API_VERSION(0, client.major, client.minor, client.patch);
 			app_info.pEngineName = engine.name;
 			app_info.engineVersion = VK_MAKE_API_VERSION(0, engine.major, engine.minor, engine.patch);
-			app_info.apiVersion = VK_API_VERSION_1_1;
+			app_info.apiVersion = VK_API_VERSION_1_2;
 			uint32_t n_glfw_extensions = 0;
-			const char** glfw_extensions;
-			glfw_extensions = glfwGetRequiredInstanceExtensions(&n_glfw_extensions);	//gets required platform interface extensions
+			const char** glfw_extensions = nullptr;
+			if (!window::headless()) //no surface is created when headless, so no platform extensions are needed
+				glfw_extensions = glfwGetRequiredInstanceExtensions(&n_glfw_extensions);	//gets required platform interface extensions
 			std::vector<const char*> extensions(glfw_extensions, glfw_extensions + n_glfw_extensions);
 			if constexpr (enable_validation_layers)
 			{
@@ -213,14 +215,22 @@ namespace ENGINE_NAMESPACE
 					"Failed to create debug messenger");
 			}
 
-			GLFWwindow* window = window::get_handle();
-			VK_CRASH_CHECK(glfwCreateWindowSurface(instance, window, nullptr, &surface), "Failed to create window surface");
+			if (window::headless())
+			{
+				surface = VK_NULL_HANDLE; //devices render into offscreen images
+			}
+			else
+			{
+				GLFWwindow* window = window::get_handle();
+				VK_CRASH_CHECK(glfwCreateWindowSurface(instance, window, nullptr, &surface), "Failed to create window surface");
+			}
 
 			init_devices();
 		}
 
 		void terminate()
 		{
+			asset_registry_internal::clear();
 			devices.clear();
 
 			if (enable_validation_layers)
@@ -228,7 +238,7 @@ namespace ENGINE_NAMESPACE
 				destroy_debug_utils_messenger_EXT(instance, debug_messenger, nullptr);
 			}
 
-			vkDestroySurfaceKHR(instance, surface, nullptr);
+			if (surface != VK_NULL_HANDLE) vkDestroySurfaceKHR(instance, surface, nullptr);
 			vkDestroyInstance(instance, nullptr);
 
 			shader_library::clear();
@@ -236,6 +246,8 @@ namespace ENGINE_NAMESPACE
 
 		void tick()
 		{
+			asset_registry_internal::apply_reloads();
+			shader_library::apply_reloads();
 			devices[present_device_idx].draw();
 		}
 
@@ -243,5 +255,69 @@ namespace ENGINE_NAMESPACE
 		{
 			return devices[present_device_idx];
 		}
+
+		bool has_device() noexcept
+		{
+			return !devices.empty();
+		}
+
+		memory_stats memory_statistics()
+		{
+			if (devices.empty()) return {};
+			return get_device().get_memory().statistics();
+		}
+
+		upload_ticket commit_staging()
+		{
+			if (devices.empty()) return 0;
+			return get_device().get_memory().commit_staging();
+		}
+
+		upload_ticket last_upload_ticket()
+		{
+			if (devices.empty()) return 0;
+			return get_device().get_memory().last_ticket();
+		}
+
+		bool upload_complete(upload_ticket ticket)
+		{
+			if (devices.empty()) return true;
+			return get_device().get_memory().upload_complete(ticket);
+		}
+
+		void set_download_latency(u8 frames)
+		{
+			if (devices.empty()) return;
+			get_device().get_memory().set_download_latency(frames);
+		}
+
+		transfer_commands::transfer_commands()
+		{
+			if (devices.empty()) return;
+			m_cmd_buffer = get_device().get_memory().begin_transfer_commands();
+		}
+
+		transfer_commands::~transfer_commands()
+		{
+			if (m_cmd_buffer) submit();
+		}
+
+		void transfer_commands::copy(const unmapped_resource& src, unmapped_resource& dst, std::size_t size, 
+			std::size_t src_offset, std::size_t dst_offset)
+		{
+			INTERNAL_ASSERT(m_cmd_buffer || devices.empty(), "Transfer commands already submitted");
+			if (!m_cmd_buffer) return;
+
+			get_device().get_memory().record_copy(static_cast<VkCommandBuffer>(m_cmd_buffer), src.ref, dst.ref, size,
+				src_offset, dst_offset);
+		}
+
+		upload_ticket transfer_commands::submit()
+		{
+			if (!m_cmd_buffer) return 0;
+
+			const VkCommandBuffer cmd_buffer = static_cast<VkCommandBuffer>(std::exchange(m_cmd_buffer, nullptr));
+			return get_device().get_memory().submit_transfer_commands(cmd_buffer);
+		}
 	}
 }
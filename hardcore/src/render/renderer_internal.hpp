@@ -2,6 +2,8 @@
 
 #include "device.hpp"
 
+#include <render/asset.hpp>
+
 #include <core/core.hpp>
 
 namespace ENGINE_NAMESPACE
@@ -13,10 +15,34 @@ namespace ENGINE_NAMESPACE
 		void tick();
 
 		device& get_device();
+
+		/**
+		 * @brief False before init and after terminate, memory freed then has no pool left to return to.
+		*/
+		bool has_device() noexcept;
 	}
 
 	namespace shader_library
 	{
 		void clear();
+
+		bool owns(const shader* s);
+
+		/**
+		 * @brief Swaps in the shaders reloaded since the last call, and recreates the pipelines using them. Must be
+		 * called between frames.
+		*/
+		void apply_reloads();
 	}
+
+	class asset_registry_internal : protected asset_registry
+	{
+	public:
+		/**
+		 * @brief Rebuilds the assets whose files changed since the last call, then everything downstream of them.
+		 * Must be called between frames.
+		*/
+		static inline void apply_reloads() { asset_registry::apply_reloads(); }
+		static inline void clear() { asset_registry::clear(); }
+	};
 }
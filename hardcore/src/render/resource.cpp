@@ -2,12 +2,23 @@
 
 #include <render/resource.hpp>
 #include <render/renderer_internal.hpp>
+#include <render/mesh_format.hpp>
+#include <io/file.hpp>
+#include <io/mapped_file.hpp>
+#include <io/compression.hpp>
+
+#include <debug/log_internal.hpp>
 
 namespace ENGINE_NAMESPACE
 {
 	resource::~resource()
 	{
+		//the memory reference returns its memory to the pool by itself
+	}
 
+	bool resource::ready() const
+	{
+		return valid() && renderer::get_device().get_memory().ready(ref);
 	}
 
 	mesh::mesh(const void* data, std::size_t size, std::size_t offset, bool vertex_data_first,
@@ -79,6 +90,155 @@ namespace ENGINE_NAMESPACE
 			static_cast<u32>(vertex_data_size / layout.size()));
 	}
 
+	static_assert(static_cast<u8>(mesh_format::attribute_type::MAT4) == static_cast<u8>(data_layout::type::MAT4) &&
+		static_cast<u8>(mesh_format::component_type::UINT64) == static_cast<u8>(data_layout::component_type::UINT64) &&
+		static_cast<u8>(mesh_format::index_type::UINT32) == static_cast<u8>(mesh::index_format::UINT32),
+		"Mesh format values must match the engine types");
+
+	mesh mesh::load(const char* filepath)
+	{
+		io::mapped_file file(filepath, io::map_mode::READ_ONLY, io::SEQUENTIAL_BIT);
+		if (!file.is_open())
+		{
+			LOG_INTERNAL_ERROR("Failed to open mesh: " << filepath);
+			return mesh();
+		}
+
+		if (!io::is_compressed(file.data(), file.size())) return load(file.data(), file.size());
+
+		//compressed containers can't be used in place
+		std::size_t size;
+		void* data = read_binary_file(filepath, size);
+		if (!data) return mesh();
+
+		mesh result = load(data, size);
+		std::free(data);
+		return result;
+	}
+
+	mesh mesh::load(const void* data, std::size_t size)
+	{
+		const u8* bytes = static_cast<const u8*>(data);
+
+		mesh_format::header header;
+		if (size < sizeof(header))
+		{
+			LOG_INTERNAL_ERROR("Invalid mesh data, too small for a header");
+			return mesh();
+		}
+		std::memcpy(&header, bytes, sizeof(header));
+
+		const index_format format = static_cast<index_format>(header.index_format);
+		if (header.magic != mesh_format::magic || header.version != mesh_format::version ||
+			format > index_format::UINT32 || (format == index_format::NONE) != (header.n_indexes == 0) ||
+			!header.n_attributes || !header.n_vertices)
+		{
+			LOG_INTERNAL_ERROR("Invalid mesh data header");
+			return mesh();
+		}
+
+		//every size is checked against the data before anything is read from it
+		const u64 attributes_end = sizeof(header) + static_cast<u64>(header.n_attributes) * sizeof(mesh_format::attribute);
+		const u64 vertex_data_size = static_cast<u64>(header.n_vertices) * header.vertex_stride;
+		const u64 index_data_size = static_cast<u64>(header.n_indexes) * index_size(format);
+		if (attributes_end > size || header.vertex_offset < attributes_end || header.vertex_offset > size ||
+			size - header.vertex_offset < vertex_data_size || (format != index_format::NONE &&
+			(header.index_offset < header.vertex_offset + vertex_data_size || header.index_offset > size ||
+			size - header.index_offset < index_data_size)))
+		{
+			LOG_INTERNAL_ERROR("Invalid mesh data, sections out of bounds");
+			return mesh();
+		}
+
+		data_layout layout(header.n_attributes);
+		for (u8 i = 0; i < header.n_attributes; i++)
+		{
+			mesh_format::attribute attribute;
+			std::memcpy(&attribute, bytes + sizeof(header) + i * sizeof(attribute), sizeof(attribute));
+
+			if (attribute.type > static_cast<u8>(mesh_format::attribute_type::MAT4) ||
+				attribute.component_type > static_cast<u8>(mesh_format::component_type::UINT64))
+			{
+				LOG_INTERNAL_ERROR("Invalid mesh data, unsupported vertex attribute");
+				return mesh();
+			}
+			layout.set_type(i, static_cast<data_layout::type>(attribute.type),
+				static_cast<data_layout::component_type>(attribute.component_type));
+		}
+
+		if (layout.size() != header.vertex_stride)
+		{
+			LOG_INTERNAL_ERROR("Invalid mesh data, vertex stride does not match the vertex layout");
+			return mesh();
+		}
+
+		const u8* vertex_data = bytes + header.vertex_offset;
+		if (format == index_format::NONE)
+			return mesh(vertex_data, static_cast<std::size_t>(vertex_data_size), layout);
+
+		return mesh(vertex_data, static_cast<std::size_t>(vertex_data_size), bytes + header.index_offset,
+			static_cast<std::size_t>(index_data_size), format, layout);
+	}
+
+	bool mesh::ready() const
+	{
+		if (!resource::ready()) return false;
+		return index_t == index_format::NONE || renderer::get_device().get_memory().ready(index_ref);
+	}
+
+	std::span<std::byte> mesh::stage_vertices(std::size_t size, std::size_t offset)
+	{
+		return renderer::get_device().get_memory().stage_vertices(ref, size, offset);
+	}
+
+	std::span<std::byte> mesh::stage_indexes(std::size_t size, std::size_t offset)
+	{
+		INTERNAL_ASSERT(index_t != index_format::NONE, "Mesh has no indexes");
+		return renderer::get_device().get_memory().stage_indexes(index_ref, size, offset);
+	}
+
+	std::span<std::byte> unmapped_resource::stage(std::size_t size, std::size_t offset)
+	{
+		return renderer::get_device().get_memory().stage(ref, size, offset);
+	}
+
+	std::future<std::vector<std::byte>> unmapped_resource::download(std::size_t size, std::size_t offset)
+	{
+		return renderer::get_device().get_memory().download(ref, size, offset);
+	}
+
+	void unmapped_resource::stream(const char* filepath, u64 file_offset, std::size_t size, std::size_t offset)
+	{
+		renderer::get_device().get_memory().stream(ref, io::file_stream(filepath, file_offset, size), offset);
+	}
+
+	bool unmapped_resource::stage_compressed(const char* filepath, std::size_t offset)
+	{
+		io::mapped_file compressed(filepath, io::map_mode::READ_ONLY, io::SEQUENTIAL_BIT);
+		if (!compressed.is_open())
+		{
+			LOG_INTERNAL_ERROR("Failed to open file: " << filepath);
+			return false;
+		}
+
+		const u64 decompressed_size = io::decompressed_size(compressed.data(), compressed.size());
+		if (!decompressed_size || offset > size() || decompressed_size > size() - offset)
+		{
+			LOG_INTERNAL_ERROR("Not a compressed container, or too large for the resource: " << filepath);
+			return false;
+		}
+
+		std::span<std::byte> staging = stage(static_cast<std::size_t>(decompressed_size), offset);
+		if (!io::decompress(compressed.data(), compressed.size(), staging.data(), staging.size()))
+		{
+			//the staged range is uploaded either way
+			LOG_INTERNAL_ERROR("Failed to decompress file: " << filepath);
+			std::memset(staging.data(), 0, staging.size());
+			return false;
+		}
+		return true;
+	}
+
 	resizable_resource::resizable_resource(memory_ref&& ref, const data_layout& layout, u32 count)
 	{
 
@@ -165,4 +325,24 @@ namespace ENGINE_NAMESPACE
 	{
 		renderer::get_device().get_memory().upload_texture(ref, data);
 	}
+
+	transient_uniform::transient_uniform(std::size_t size)
+	{
+		renderer::get_device().get_memory().alloc_transient_uniform(*this, size);
+	}
+
+	transient_uniform::transient_uniform(const void* data, std::size_t size) : transient_uniform(size)
+	{
+		std::memcpy(host_ptr, data, size);
+	}
+
+	transient_storage::transient_storage(std::size_t size)
+	{
+		renderer::get_device().get_memory().alloc_transient_storage(*this, size);
+	}
+
+	transient_storage::transient_storage(const void* data, std::size_t size) : transient_storage(size)
+	{
+		std::memcpy(host_ptr, data, size);
+	}
 }
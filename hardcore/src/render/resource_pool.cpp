@@ -4,244 +4,108 @@
 
 namespace ENGINE_NAMESPACE
 {
-	const u32 initial_pool_slot_size = 16;
-	
 	resource_pool::resource_pool(VkDeviceSize size, bool per_frame_allocation) : 
-		m_size(size), m_slots(initial_pool_slot_size)
+		m_size(size), m_allocator(size)
 	{
-		m_slots[0].in_use = false;
-		m_slots[0].offset = 0;
-		m_slots[0].size = size;
-		m_largest_free_slot = 0;
-
-		for (u32 i = 1; i < m_slots.size(); i++)
-		{
-			m_slots[i].in_use = false;
-			m_slots[i].offset = size;
-			m_slots[i].size = 0;
-		}
-
 		this->m_per_frame_allocation = per_frame_allocation;
 	}
 
 	resource_pool::~resource_pool()
 	{
-		INTERNAL_ASSERT(m_memory == VK_NULL_HANDLE, "Resource pool not freed");
+		INTERNAL_ASSERT(m_allocation.memory == VK_NULL_HANDLE, "Resource pool not freed");
 	}
 
 	void resource_pool::free(VkDevice device, device_heap_manager& heap_manager)
 	{
-		if (m_memory != VK_NULL_HANDLE)
+		if (m_allocation.memory != VK_NULL_HANDLE)
 		{
-			heap_manager.free(device, m_memory);
-			m_slots.clear();
+			heap_manager.free(device, m_allocation);
+			m_allocator = tlsf_allocator();
+			m_size = 0;
 		}
 	}
 
-	//TODO could try making allocations more efficient my reducing the size of the alignment padding
 	bool resource_pool::search(VkDeviceSize size, VkDeviceSize alignment, 
 		u32& out_slot_idx, VkDeviceSize& out_size_needed, VkDeviceSize& out_offset) const
 	{
 		if (m_size < size)
 			return false;
 
-		constexpr u32 invalid_idx = std::numeric_limits<u32>::max();
-
-		// largest free slot is unknown, must check everything, look for smallest possible fit
-		// if possible, update largest free slot to reduce cost of future calls
-		if (m_slots[m_largest_free_slot].in_use)
-		{
-			VkDeviceSize largest_fit = 0;
-			u32 largest_idx = invalid_idx;
-			VkDeviceSize smallest_fit = std::numeric_limits<VkDeviceSize>::max();
-			u32 smallest_idx = invalid_idx;
-			VkDeviceSize smallest_offset = 0;
-			
-			VkDeviceSize offset = 0;
-			for (u32 i = 0; i < m_slots.size(); i++)
-			{
-				offset += m_slots[i].offset;
-
-				if (!m_slots[i].in_use)
-				{
-					if (largest_fit < m_slots[i].size)
-					{
-						largest_fit = m_slots[i].size;
-						largest_idx = i;
-					}
-					if (smallest_fit > m_slots[i].size && 
-						size + alignment_pad(m_slots[i].offset, alignment) <= m_slots[i].size)
-					{
-						smallest_fit = m_slots[i].size;
-						smallest_idx = i;
-						smallest_offset = offset;
-					}
-				}
-			}
-			
-			if (smallest_idx != invalid_idx)
-			{
-				if (largest_idx != invalid_idx && largest_idx != smallest_idx)
-					m_largest_free_slot = largest_idx;
-
-				out_slot_idx = smallest_idx;
-				out_size_needed = size + alignment_pad(m_slots[smallest_idx].offset, alignment);
-				out_offset = smallest_offset;
-				return true;
-			}
-			else
-			{
-				if (largest_idx != invalid_idx)
-					m_largest_free_slot = largest_idx;
-
-				return false;
-			}
-		}
-
-		// largest free slot is known, so if it is large enough, assign a slot in this pool, 
-		// otherwise move on to next pool
-		else
-		{
-			if (m_slots[m_largest_free_slot].size < size)
-				return false;
-
-			VkDeviceSize smallest_fit = std::numeric_limits<VkDeviceSize>::max();
-			u32 smallest_idx = invalid_idx;
-			VkDeviceSize smallest_offset = 0;
-
-			VkDeviceSize offset = 0;
-			for (u32 i = 0; i < m_slots.size(); i++)
-			{
-				offset += m_slots[i].offset;
-
-				if (!m_slots[i].in_use 
-					&& smallest_fit > m_slots[i].size
-					&& size + alignment_pad(m_slots[i].offset, alignment) <= m_slots[i].size)
-				{
-					smallest_fit = m_slots[i].size;
-					smallest_idx = i;
-					smallest_offset = offset;
-				}
-			}
-
-			out_slot_idx = smallest_idx;
-			out_size_needed = size + alignment_pad(m_slots[smallest_idx].offset, alignment);
-			out_offset = smallest_offset;
-			return true;
-		}
+		const tlsf_allocator::block_idx_t idx = m_allocator.search(size, alignment, out_size_needed);
+		if (idx == tlsf_allocator::invalid_block)
+			return false;
 
-		return false;
+		out_slot_idx = idx;
+		out_offset = m_allocator.offset(idx);
+		return true;
 	}
 
 	void resource_pool::fill_slot(u32 slot_idx, VkDeviceSize size)
 	{
-		INTERNAL_ASSERT(slot_idx < m_slots.size(), "Slot index out of bounds");
-		INTERNAL_ASSERT(size <= m_slots[slot_idx].size, "Allocation size greater than slot size");
-		INTERNAL_ASSERT(slot_idx == 0 ? true : m_slots[slot_idx - 1].in_use, "Slot before a selected slot must be in use.");
-
-		if (size < m_slots[slot_idx].size)
-		{
-			const u32 old_size = m_slots.size();
-			bool selected_last = slot_idx == (m_slots.size() - 1);
-
-			//resize needed
-			if (selected_last || (m_slots[slot_idx + 1].in_use && m_slots[m_slots.size() - 1].in_use))
-			{
-				push_back_empty();
-				m_slots[old_size].in_use = false;
-				m_slots[old_size].offset = m_slots[old_size - 1].offset + m_slots[old_size - 1].size;
-				m_slots[old_size].size = 0;
-			}
-
-			INTERNAL_ASSERT(m_slots[slot_idx + 1].in_use || !m_slots[slot_idx + 1].size,
-				"Slot after the selected slot must be either empty or in use");
-
-			//shift remaining slots one position and add new slot with the remaining unused memory
-			if (m_slots[slot_idx + 1].in_use)
-			{
-				u32 last_in_use = 0;
-				for (u32 i = old_size - 1; i > slot_idx; i--)
-				{
-					if (m_slots[i].in_use)
-					{
-						last_in_use = i;
-						break;
-					}
-				}
-				move_slots(slot_idx + 2, slot_idx + 1, last_in_use - slot_idx);
-			}
-
-			m_slots[slot_idx + 1].in_use = false;
-			m_slots[slot_idx + 1].offset = m_slots[slot_idx].offset + size;
-			m_slots[slot_idx + 1].size = m_slots[slot_idx].size - size;
-		}
+		m_allocator.allocate(slot_idx, size);
+	}
 
-		m_slots[slot_idx].in_use = true;
-		m_slots[slot_idx].size = size;
+	void resource_pool::release_slot(VkDeviceSize offset)
+	{
+		const bool released = m_allocator.free(offset);
+		INTERNAL_ASSERT(released, "No allocation starts at the released offset");
 	}
 
 	u32 resource_pool::find_slot(VkDeviceSize offset) const noexcept
 	{
-		VkDeviceSize total_offset = 0;
-		u32 i = 0;
-		for (; i < m_slots.size() && total_offset < offset; i++)
-			total_offset += m_slots[i].offset;
-
-		if (total_offset == offset)
-			return i;
-		else
-			return std::numeric_limits<u32>::max();
+		return m_allocator.find(offset);
+	}
+
+	pool_usage resource_pool::usage() const noexcept
+	{
+		return { m_allocator.used(), m_size - m_allocator.used(), m_allocator.largest_free(), m_allocator.free_blocks() };
 	}
 
 	buffer_pool::buffer_pool(VkDevice device, device_heap_manager& heap_manager,
 		VkDeviceSize size, VkBufferUsageFlags usage, device_heap_manager::heap heap, bool per_frame_allocation) :
 		resource_pool(size, per_frame_allocation)
 	{
-		heap_manager.alloc_buffer(device, m_memory, m_buffer, 
+		heap_manager.alloc_buffer(device, m_allocation, m_buffer, 
 			per_frame_allocation ? size * max_frames_in_flight : size, 
 			usage, heap);
 	}
 
 	void buffer_pool::free(VkDevice device, device_heap_manager& heap_manager)
 	{
-		if (m_memory != VK_NULL_HANDLE)
+		if (m_allocation.memory != VK_NULL_HANDLE)
 		{
 			vkDestroyBuffer(device, m_buffer, nullptr);
+			m_buffer = VK_NULL_HANDLE;
 			resource_pool::free(device, heap_manager);
 		}
 	}
 
-	void buffer_pool::push_back_empty()
+	void dynamic_buffer_pool::select_frame(u8 current_frame) noexcept
 	{
-		m_slots.push_back({});
-	}
-
-	void buffer_pool::move_slots(u32 dst, u32 src, u32 count)
-	{
-		std::memmove(&m_slots.data()[dst], &m_slots.data()[src], sizeof(*m_slots.data()) * count);
-	}
-
-	void dynamic_buffer_pool::map(VkDevice device, u8 current_frame)
-	{
-		VK_CRASH_CHECK(vkMapMemory(device, m_memory, m_size * current_frame, m_size, 0, &m_host_ptr), 
-			"Failed to map memory");
-	}
-
-	void dynamic_buffer_pool::unmap(VkDevice device)
-	{
-		INTERNAL_ASSERT(m_host_ptr != nullptr, "Memmory not mapped");
-		vkUnmapMemory(device, m_memory);
-		m_host_ptr = nullptr;
+		INTERNAL_ASSERT(m_allocation.host_ptr != nullptr, "Memory not host visible");
+		m_host_ptr = static_cast<std::byte*>(m_allocation.host_ptr) + m_size * current_frame;
 	}
 
 	void dynamic_buffer_pool::push_flush_ranges(std::vector<VkMappedMemoryRange>& ranges, u8 current_frame,
-		const std::vector<dynamic_buffer_pool>& pools)
+		std::vector<dynamic_buffer_pool>& pools, VkDeviceSize atom_size)
 	{
-		for (const dynamic_buffer_pool& pool : pools)
+		for (dynamic_buffer_pool& pool : pools)
 		{
-			//TODO skip pools with no allocations, need to track allocations somehow
+			if (!pool.allocated()) continue;
+
+			if (pool.empty())
+			{
+				pool.m_mapped_begin = no_range;
+				pool.m_mapped_end = 0;
+			}
+
+			const VkDeviceSize begin = std::min(pool.m_dirty_begin, pool.m_mapped_begin);
+			const VkDeviceSize end = std::max(pool.m_dirty_end, pool.m_mapped_end);
+			pool.m_dirty_begin = no_range;
+			pool.m_dirty_end = 0;
 
-			ranges.push_back(pool.mapped_range(current_frame));
+			if (begin < end)
+				ranges.push_back(pool.mapped_range(current_frame, begin, end, atom_size));
 		}
 	}
 
@@ -312,9 +176,9 @@ namespace ENGINE_NAMESPACE
 
 	texture_pool::texture_pool(VkDevice device, device_heap_manager& heap_manager, VkDeviceSize size,
 		u32 memory_type_bits, device_heap_manager::heap preferred_heap) :
-		resource_pool(size), m_texture_slots(initial_pool_slot_size)
+		resource_pool(size)
 	{
-		m_memory_type_idx = heap_manager.alloc_texture_memory(device, m_memory, size, preferred_heap, memory_type_bits);
+		m_memory_type_idx = heap_manager.alloc_texture_memory(device, m_allocation, size, preferred_heap, memory_type_bits);
 	}
 
 	void texture_pool::free(VkDevice device, device_heap_manager& heap_manager)
@@ -336,24 +200,28 @@ namespace ENGINE_NAMESPACE
 	{
 		resource_pool::fill_slot(slot_idx, size);
 
-		// resource_pool::fill_slot should perform any reallocation if necessary, so the slot should always exist
-
+		//textures are indexed like the allocator's blocks, which keep their index while allocated
+		if (m_texture_slots.size() <= slot_idx)
+			m_texture_slots.resize(slot_idx + 1);
 		m_texture_slots[slot_idx] = std::move(tex);
 
-		VK_CRASH_CHECK(vkBindImageMemory(device, m_texture_slots[slot_idx].image, m_memory,
-			aligned_offset(m_slots[slot_idx].offset, alignment)), "Failed to bind image to memory");
+		//the pool's range is aligned for any image, so aligning inside of it is enough
+		VK_CRASH_CHECK(vkBindImageMemory(device, m_texture_slots[slot_idx].image, m_allocation.memory,
+			m_allocation.offset + aligned_offset(m_allocator.offset(slot_idx), alignment)), "Failed to bind image to memory");
 	}
 
-	void texture_pool::push_back_empty()
+	void texture_pool::release_slot(VkDevice device, VkDeviceSize offset)
 	{
-		m_slots.push_back({});
-		m_texture_slots.push_back({});
-	}
+		const u32 slot_idx = find_slot(offset);
+		if (slot_idx != std::numeric_limits<u32>::max())
+		{
+			texture_slot& tex = m_texture_slots[slot_idx];
+			if (tex.view != VK_NULL_HANDLE) vkDestroyImageView(device, tex.view, nullptr);
+			vkDestroyImage(device, tex.image, nullptr);
+			tex = {};
+		}
 
-	void texture_pool::move_slots(u32 dst, u32 src, u32 count)
-	{
-		std::memmove(&m_slots.data()[dst], &m_slots.data()[src], sizeof(*m_slots.data()) * count);
-		std::memmove(&m_texture_slots.data()[dst], &m_texture_slots.data()[src], sizeof(*m_texture_slots.data()) * count);
+		resource_pool::release_slot(offset);
 	}
 
 	struct dynamic_texture
@@ -2,14 +2,16 @@
 
 #include "render_core.hpp"
 #include "device_heap_manager.hpp"
+#include "tlsf_allocator.hpp"
 
 namespace ENGINE_NAMESPACE
 {
-	struct memory_slot
+	struct pool_usage
 	{
-		bool in_use;
-		VkDeviceSize offset; //relative to previous slot
-		VkDeviceSize size;
+		VkDeviceSize used;
+		VkDeviceSize free;
+		VkDeviceSize largest_free;
+		u32 free_slots;
 	};
 
 	class resource_pool
@@ -20,11 +22,22 @@ namespace ENGINE_NAMESPACE
 		bool search(VkDeviceSize size, VkDeviceSize alignment, 
 			u32& out_slot_idx, VkDeviceSize& out_size_needed, VkDeviceSize& out_offset) const;
 		void fill_slot(u32 slot_idx, VkDeviceSize size);
-		// TODO cleanup function to remove excessive amount of empty slots maybe
+
+		/**
+		 * @brief Frees the slot starting at offset, and merges it with the free slots around it.
+		 * @param offset Offset of the slot, as returned by search.
+		*/
+		void release_slot(VkDeviceSize offset);
 		u32 find_slot(VkDeviceSize offset) const noexcept;
 
+		pool_usage usage() const noexcept;
+
 		inline VkDeviceSize size() const noexcept { return m_size; }
-		inline const memory_slot& operator[](u32 idx) const noexcept { return m_slots[idx]; }
+
+		//freed pools keep their index, so that the allocations of the other pools stay valid
+		inline bool allocated() const noexcept { return m_allocation.memory != VK_NULL_HANDLE; }
+		//slots released but not reclaimed yet still count as allocated
+		inline bool empty() const noexcept { return !m_allocator.allocations(); }
 
 	protected:
 		resource_pool() = default;
@@ -36,32 +49,27 @@ namespace ENGINE_NAMESPACE
 		resource_pool& operator=(const resource_pool&) = delete;
 
 		resource_pool(resource_pool&& other) noexcept :
-			m_memory(std::exchange(other.m_memory, VK_NULL_HANDLE)),
+			m_allocation(std::exchange(other.m_allocation, {})),
 			m_size(std::exchange(other.m_size, 0)),
-			m_slots(std::move(other.m_slots)),
-			m_largest_free_slot(std::exchange(other.m_largest_free_slot, 0))
+			m_allocator(std::exchange(other.m_allocator, {}))
 		{ }
 
 		inline resource_pool& operator=(resource_pool&& other) noexcept
 		{
-			INTERNAL_ASSERT(other.m_memory == VK_NULL_HANDLE, "Other resource pool not freed");
+			INTERNAL_ASSERT(m_allocation.memory == VK_NULL_HANDLE, "Resource pool not freed");
 			
-			m_memory = std::exchange(other.m_memory, VK_NULL_HANDLE);
+			m_allocation = std::exchange(other.m_allocation, {});
 			m_size = std::exchange(other.m_size, 0);
-			m_slots = std::move(other.m_slots);
-			m_largest_free_slot = std::exchange(other.m_largest_free_slot, 0);
+			m_allocator = std::exchange(other.m_allocator, {});
 			return *this;
 		}
 
-		virtual void push_back_empty() = 0;
-		virtual void move_slots(u32 dst, u32 src, u32 count) = 0;
-
-		VkDeviceMemory m_memory = VK_NULL_HANDLE;
+		device_allocation m_allocation;
 		VkDeviceSize m_size = 0;
 
-		std::vector<memory_slot> m_slots;
+		//slot indexes are the allocator's block indexes
+		tlsf_allocator m_allocator;
 
-		mutable u32 m_largest_free_slot = 0;
 		//TODO is this needed as a member variable?
 		bool m_per_frame_allocation = false;
 	};
@@ -95,9 +103,6 @@ namespace ENGINE_NAMESPACE
 			VkDeviceSize size, VkBufferUsageFlags usage, device_heap_manager::heap heap,
 			bool per_frame_allocation);
 
-		void push_back_empty() override;
-		void move_slots(u32 dst, u32 src, u32 count) override;
-
 		VkBuffer m_buffer = VK_NULL_HANDLE;
 	};
 
@@ -112,32 +117,76 @@ namespace ENGINE_NAMESPACE
 
 		dynamic_buffer_pool(dynamic_buffer_pool&& other) noexcept :
 			buffer_pool(std::move(other)),
-			m_host_ptr(std::exchange(other.m_host_ptr, nullptr))
+			m_host_ptr(std::exchange(other.m_host_ptr, nullptr)),
+			m_dirty_begin(std::exchange(other.m_dirty_begin, no_range)), m_dirty_end(std::exchange(other.m_dirty_end, 0)),
+			m_mapped_begin(std::exchange(other.m_mapped_begin, no_range)), m_mapped_end(std::exchange(other.m_mapped_end, 0))
 		{ }
 
 		inline dynamic_buffer_pool& operator=(dynamic_buffer_pool&& other) noexcept
 		{
 			m_host_ptr = std::exchange(other.m_host_ptr, nullptr);
+			m_dirty_begin = std::exchange(other.m_dirty_begin, no_range);
+			m_dirty_end = std::exchange(other.m_dirty_end, 0);
+			m_mapped_begin = std::exchange(other.m_mapped_begin, no_range);
+			m_mapped_end = std::exchange(other.m_mapped_end, 0);
 			buffer_pool::operator=(std::move(other));
 			return *this;
 		}
 
-		void map(VkDevice device, u8 current_frame);
-		void unmap(VkDevice device);
+		/**
+		 * @brief Points the host pointer at the current frame's region, the memory stays mapped by the heap manager for
+		 * the pool's whole lifetime.
+		*/
+		void select_frame(u8 current_frame) noexcept;
+
+		/**
+		 * @brief Marks part of the current frame's region as written by the host, to be flushed with the frame.
+		*/
+		inline void mark_dirty(VkDeviceSize offset, VkDeviceSize size) noexcept
+		{
+			m_dirty_begin = std::min(m_dirty_begin, offset);
+			m_dirty_end = std::max(m_dirty_end, offset + size);
+		}
+
+		/**
+		 * @brief Marks an allocation whose host pointer was handed out. It can be written without the pool knowing, so it
+		 * is flushed every frame until the pool is empty.
+		*/
+		inline void mark_mapped(VkDeviceSize offset, VkDeviceSize size) noexcept
+		{
+			m_mapped_begin = std::min(m_mapped_begin, offset);
+			m_mapped_end = std::max(m_mapped_end, offset + size);
+		}
 
+		/**
+		 * @brief Adds the ranges written in the current frame's region of every pool, then clears the dirty ranges.
+		 * @param atom_size Non coherent atom size, ranges are widened to multiples of it.
+		*/
 		static void push_flush_ranges(std::vector<VkMappedMemoryRange>& ranges, u8 current_frame,
-			const std::vector<dynamic_buffer_pool>& pools);
+			std::vector<dynamic_buffer_pool>& pools, VkDeviceSize atom_size);
 
 		inline void*& host_ptr() noexcept { return m_host_ptr; }
 
 	private:
-		inline VkMappedMemoryRange mapped_range(u8 current_frame) const noexcept
+		static constexpr VkDeviceSize no_range = std::numeric_limits<VkDeviceSize>::max();
+
+		//the frame's region starts at a multiple of the atom size, as the pool's size is one
+		inline VkMappedMemoryRange mapped_range(u8 current_frame, VkDeviceSize begin, VkDeviceSize end, 
+			VkDeviceSize atom_size) const noexcept
 		{
-			return { .sType = VK_STRUCTURE_TYPE_MAPPED_MEMORY_RANGE, .pNext = nullptr, .memory = m_memory, 
-				.offset = m_size * current_frame, .size = m_size };
+			begin = begin / atom_size * atom_size;
+			end = std::min((end + atom_size - 1) / atom_size * atom_size, m_size);
+			return { .sType = VK_STRUCTURE_TYPE_MAPPED_MEMORY_RANGE, .pNext = nullptr, .memory = m_allocation.memory, 
+				.offset = m_allocation.offset + m_size * current_frame + begin, .size = end - begin };
 		}
 
 		void* m_host_ptr = nullptr;
+
+		//relative to the frame's region, empty when begin >= end
+		VkDeviceSize m_dirty_begin = no_range;
+		VkDeviceSize m_dirty_end = 0;
+		VkDeviceSize m_mapped_begin = no_range;
+		VkDeviceSize m_mapped_end = 0;
 	};
 
 	struct texture_slot
@@ -164,13 +213,10 @@ namespace ENGINE_NAMESPACE
 		bool search(VkDeviceSize size, VkDeviceSize alignment, u32 memory_type_bits,
 			u32& out_slot_idx, VkDeviceSize& out_size_needed, VkDeviceSize& out_offset) const;
 		void fill_slot(VkDevice device, texture_slot&& tex, u32 slot_idx, VkDeviceSize size, VkDeviceSize alignment);
+		void release_slot(VkDevice device, VkDeviceSize offset);
 
 		const texture_slot& tex_at(u32 idx) const noexcept { return m_texture_slots[idx]; }
 
-	protected:
-		void push_back_empty() override;
-		void move_slots(u32 dst, u32 src, u32 count) override;
-
 	private:
 		u32 m_memory_type_idx = std::numeric_limits<u32>::max();
 		std::vector<texture_slot> m_texture_slots;
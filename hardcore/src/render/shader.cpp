@@ -2,9 +2,11 @@
 
 #include <render/renderer_internal.hpp>
 #include <render/shader.hpp>
+#include <render/shader_cache.hpp>
 
 #include <debug/log_internal.hpp>
 #include <io/file.hpp>
+#include <io/mapped_file.hpp>
 
 #include <shaderc/shaderc.h>
 #include <spirv_cross/spirv_reflect.hpp>
@@ -79,19 +81,32 @@ namespace ENGINE_NAMESPACE
 		return shaderc_glsl_infer_from_source;
 	}
 
-	inline void compile_shader(const char* code, std::size_t code_size, const char* entry_point, shader_t stage, 
-		const char* error_name, u32** out_data, std::size_t* out_datasize)
+	//compilers are expensive to create and safe to use from several threads, so a single one is kept for the whole run
+	struct shared_compiler
 	{
-		shaderc_compiler_t compiler = shaderc_compiler_initialize();
+		shaderc_compiler_t handle = shaderc_compiler_initialize();
+		~shared_compiler() { shaderc_compiler_release(handle); }
+	};
+
+	inline shaderc_compiler_t get_compiler()
+	{
+		static shared_compiler compiler;
+		return compiler.handle;
+	}
 
+	//part of the shader cache key, must describe every option set in compile_shader
+	static const char compile_options_desc[] = "default";
+
+	inline bool compile_shader(const char* code, std::size_t code_size, const char* entry_point, shader_t stage, 
+		const char* error_name, u32** out_data, std::size_t* out_datasize, bool reloading)
+	{
 		shaderc_compile_options_t options = shaderc_compile_options_initialize();
 		//TODO: add options, maybe
 
-		shaderc_compilation_result_t result = shaderc_compile_into_spv(compiler, code, code_size, to_shaderc(stage),
+		shaderc_compilation_result_t result = shaderc_compile_into_spv(get_compiler(), code, code_size, to_shaderc(stage),
 			error_name, entry_point, options);
 
 		shaderc_compile_options_release(options);
-		shaderc_compiler_release(compiler);
 
 		LOG_INTERNAL_ERROR(shaderc_result_get_error_message(result))
 
@@ -108,45 +123,45 @@ namespace ENGINE_NAMESPACE
 			break;
 		case shaderc_compilation_status_invalid_stage:  // error stage deduction
 			LOG_INTERNAL_ERROR("Failed to deduce correct shader stage. [" << error_name << ']')
-			DEBUG_BREAK;
 			break;
 		case shaderc_compilation_status_compilation_error:
 			LOG_INTERNAL_ERROR("Shader compilation failed due to code errors. [" << error_name << ']')
-			DEBUG_BREAK;
 			break;
 		case shaderc_compilation_status_internal_error:  // unexpected failure
 			LOG_INTERNAL_ERROR("Unexpected error during shader compilation. [" << error_name << ']')
-			DEBUG_BREAK;
 			break;
 		case shaderc_compilation_status_null_result_object: //this shouldn't happen
-			DEBUG_BREAK;
 			break;
 		case shaderc_compilation_status_invalid_assembly:
 			LOG_INTERNAL_ERROR("Invalid shader assembly. [" << error_name << ']')
-			DEBUG_BREAK;
 			break;
 		case shaderc_compilation_status_validation_error:
 			LOG_INTERNAL_ERROR("Shader compilation failed due to validation errors. [" << error_name << ']')
-			DEBUG_BREAK;
 			break;
 		case shaderc_compilation_status_transformation_error:
 			LOG_INTERNAL_ERROR("A transformation error has occured during shader compilation. [" << error_name << ']')
-			DEBUG_BREAK;
 			break;
 		case shaderc_compilation_status_configuration_error:
 			LOG_INTERNAL_ERROR("Invalid configuration for shader compilation. [" << error_name << ']')
-			DEBUG_BREAK;
 			break;
 		default:
 			INTERNAL_ASSERT(false, "Unhandled error in shader compilation");
 		}
 
+		const bool success = shaderc_result_get_compilation_status(result) == shaderc_compilation_status_success;
+		//errors are expected while a reloaded source is being edited
+		if (!success && !reloading)
+		{
+			DEBUG_BREAK;
+		}
+
 		std::size_t datasize = shaderc_result_get_length(result);
 		*out_data = static_cast<u32*>(ex_malloc(datasize));
 		memcpy(*out_data, shaderc_result_get_bytes(result), datasize);
 		*out_datasize = datasize;
 
 		shaderc_result_release(result);
+		return success;
 	}
 
 	struct input_resource
@@ -194,36 +209,100 @@ namespace ENGINE_NAMESPACE
 
 	shader::shader(const char* filename, const char* entry_point, const char* name, shader_t stage) :
 		stage(stage == shader_t::NONE ? stage_from_filename(filename) : stage), 
-		entry_point(create_cstr(entry_point)), _name(create_cstr(name))
+		entry_point(create_cstr(entry_point)), _name(create_cstr(name)), _source(create_cstr(filename))
 	{
-		std::size_t filesize = 0;
-		void* filedata = read_binary_file(filename, filesize);
-		
 		std::string fn(filename);
 		std::string extension = fn.substr(fn.rfind('.'));
 
 		//check if shader needs to be compiled
 		if (extension != shader_ext::SPIRV)
 		{
-			//TODO implement read text file and change the read function depending if there is a need to compile
-			compile_shader(static_cast<char*>(filedata), filesize, entry_point, this->stage, filename, &data, &size);
-
-			std::free(filedata);
+			//the source is only needed during compilation, so it is read straight from the mapping
+			io::mapped_file source(filename, io::map_mode::READ_ONLY, io::SEQUENTIAL_BIT);
+			if (!source.is_open())
+			{
+				CRASH("Failed to open shader source");
+			}
+			compile_cached(reinterpret_cast<const char*>(source.data()), source.size(), filename);
 		}
 		else
 		{
+			//SPIR-V is kept for the shader's whole lifetime and released with std::free, so it is copied instead of mapped
+			std::size_t filesize = 0;
+			void* filedata = read_binary_file(filename, filesize);
 			size = filesize;
 			data = static_cast<u32*>(filedata);
+			reflect();
 		}
-
-		reflect();
 	}
 
 	shader::shader(const char* name, const char* entry_point, shader_t stage, const char* code) :
 		_name(create_cstr(name)), entry_point(create_cstr(entry_point)), stage(stage)
 	{
-		compile_shader(code, std::strlen(code), entry_point, this->stage, name, &data, &size);
+		compile_cached(code, std::strlen(code), name);
+	}
+
+	bool shader::compile_cached(const char* code, std::size_t code_size, const char* error_name, bool reloading)
+	{
+		//a hit skips both compilation and reflection
+		const u64 key = shader_cache::key(code, code_size, stage, entry_point, compile_options_desc);
+		if (shader_cache::load(key, stage, entry_point, &data, &size, _inputs, _descriptors))
+		{
+			LOG_INTERNAL_INFO("Loaded cached shader:\t" << error_name)
+			return true;
+		}
+
+		const bool compiled = compile_shader(code, code_size, entry_point, stage, error_name, &data, &size, reloading);
+		if (!compiled && reloading) return false;
 		reflect();
+		if (compiled) shader_cache::store(key, stage, entry_point, data, size, _inputs, _descriptors);
+		return compiled;
+	}
+
+	bool shader::load_source(const char* filename, const char* entry_point, const char* name, shader_t stage)
+	{
+		INTERNAL_ASSERT(!data, "Shader must be empty");
+
+		this->stage = stage;
+		this->entry_point = create_cstr(entry_point);
+
+		bool loaded = false;
+		const std::string fn(filename);
+		if (fn.substr(fn.rfind('.')) != shader_ext::SPIRV)
+		{
+			io::mapped_file source(filename, io::map_mode::READ_ONLY, io::SEQUENTIAL_BIT);
+			if (source.is_open())
+				loaded = compile_cached(reinterpret_cast<const char*>(source.data()), source.size(), filename, true);
+		}
+		else
+		{
+			//the file may be halfway through a save, the reload is skipped until the next change
+			std::size_t filesize = 0;
+			data = static_cast<u32*>(try_read_binary_file(filename, filesize));
+			size = filesize;
+			if (data)
+			{
+				reflect();
+				loaded = true;
+			}
+		}
+
+		if (!loaded)
+		{
+			LOG_INTERNAL_WARN("Failed to reload shader:\t" << filename)
+			std::free(data);
+			std::free(this->entry_point);
+			data = nullptr;
+			size = 0;
+			this->entry_point = nullptr;
+			_inputs.clear();
+			_descriptors.clear();
+			return false;
+		}
+
+		_name = create_cstr(name);
+		_source = create_cstr(filename);
+		return true;
 	}
 
 	shader::~shader()
@@ -233,6 +312,7 @@ namespace ENGINE_NAMESPACE
 			std::free(data);
 			std::free(_name);
 			std::free(entry_point);
+			std::free(_source);
 			data = nullptr;
 		}
 	}
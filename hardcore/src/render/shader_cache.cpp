@@ -0,0 +1,217 @@
+#include <pch.hpp>
+
+#include <render/shader_cache.hpp>
+#include <io/file_internal.hpp>
+
+#include <shaderc/shaderc.h>
+
+#include <cstring>
+
+#include <debug/log_internal.hpp>
+
+//set by the build, the SPIR-V version alone does not change with compiler releases
+#ifndef SHADER_COMPILER_VERSION
+#define SHADER_COMPILER_VERSION "unknown"
+#endif // !SHADER_COMPILER_VERSION
+
+namespace ENGINE_NAMESPACE
+{
+	class layout_internal : protected data_layout
+	{
+	public:
+		static inline std::pair<type, component_type> value_at(const data_layout& layout, u8 index) noexcept
+		{
+			const value& v = static_cast<const layout_internal&>(layout)[index];
+			return { v.t, v.ct };
+		}
+	};
+
+	namespace shader_cache
+	{
+		//FNV-1a 64, chained over every part of the key
+		inline u64 hash_bytes(u64 hash, const void* data, std::size_t size) noexcept
+		{
+			const u8* bytes = static_cast<const u8*>(data);
+			for (std::size_t i = 0; i < size; i++)
+			{
+				hash ^= bytes[i];
+				hash *= 0x100000001b3ULL;
+			}
+			return hash;
+		}
+
+		template<typename Type>
+		inline void write_value(std::vector<u8>& buffer, Type value)
+		{
+			const std::size_t offset = buffer.size();
+			buffer.resize(offset + sizeof(Type));
+			std::memcpy(buffer.data() + offset, &value, sizeof(Type));
+		}
+
+		template<typename Type>
+		inline bool read_value(const std::vector<u8>& buffer, std::size_t& cursor, Type& out_value)
+		{
+			if (buffer.size() - cursor < sizeof(Type)) return false;
+			std::memcpy(&out_value, buffer.data() + cursor, sizeof(Type));
+			cursor += sizeof(Type);
+			return true;
+		}
+
+		const std::filesystem::path& cache_directory()
+		{
+			static const std::filesystem::path directory = io::cache_path("HARDCORE_SHADER_CACHE_DIR", "cache/shaders");
+			return directory;
+		}
+
+		inline bool enabled()
+		{
+			static const bool is_enabled = io::cache_enabled("HARDCORE_NO_SHADER_CACHE");
+			return is_enabled;
+		}
+
+		inline std::filesystem::path entry_path(u64 key)
+		{
+			char filename[32];
+			std::snprintf(filename, sizeof(filename), "%016llx.hcsc", static_cast<unsigned long long>(key));
+			return cache_directory() / filename;
+		}
+
+		u64 key(const char* code, std::size_t code_size, shader_t stage, const char* entry_point,
+			const char* options) noexcept
+		{
+			unsigned int spv_version = 0, spv_revision = 0;
+			shaderc_get_spv_version(&spv_version, &spv_revision);
+
+			u64 hash = 0xcbf29ce484222325ULL;
+			hash = hash_bytes(hash, &shader_cache_format::version, sizeof(shader_cache_format::version));
+			hash = hash_bytes(hash, &spv_version, sizeof(spv_version));
+			hash = hash_bytes(hash, &spv_revision, sizeof(spv_revision));
+			hash = hash_bytes(hash, SHADER_COMPILER_VERSION, sizeof(SHADER_COMPILER_VERSION));
+			hash = hash_bytes(hash, &stage, sizeof(stage));
+			//sizes included so that the boundaries between strings are part of the key
+			const std::size_t entry_point_size = std::strlen(entry_point), options_size = std::strlen(options);
+			hash = hash_bytes(hash, &entry_point_size, sizeof(entry_point_size));
+			hash = hash_bytes(hash, entry_point, entry_point_size);
+			hash = hash_bytes(hash, &options_size, sizeof(options_size));
+			hash = hash_bytes(hash, options, options_size);
+			hash = hash_bytes(hash, &code_size, sizeof(code_size));
+			return hash_bytes(hash, code, code_size);
+		}
+
+		bool load(u64 key, shader_t stage, const char* entry_point, u32** out_data, std::size_t* out_size,
+			std::vector<data_layout>& out_inputs, std::vector<shader::descriptor_data>& out_descriptors)
+		{
+			if (!enabled()) return false;
+
+			std::ifstream file(entry_path(key), std::ios::in | std::ios::binary | std::ios::ate);
+			if (!file.is_open()) return false;
+
+			std::vector<u8> buffer(static_cast<std::size_t>(file.tellg()));
+			file.seekg(0);
+			if (!file.read(reinterpret_cast<char*>(buffer.data()), buffer.size())) return false;
+
+			//a corrupted entry is a cache miss, the shader is compiled again and the entry overwritten
+			const auto invalid = [key]()
+			{
+				LOG_INTERNAL_WARN("Ignoring invalid shader cache entry: " << entry_path(key).string());
+				return false;
+			};
+
+			std::size_t cursor = 0;
+			shader_cache_format::header header;
+			const std::size_t entry_point_size = std::strlen(entry_point);
+			if (!read_value(buffer, cursor, header) || header.magic != shader_cache_format::magic ||
+				header.version != shader_cache_format::version || header.key != key ||
+				header.stage != static_cast<u8>(stage) || header.entry_point_size != entry_point_size ||
+				buffer.size() - cursor < static_cast<std::size_t>(header.entry_point_size) + header.code_size ||
+				std::memcmp(buffer.data() + cursor, entry_point, entry_point_size) != 0 ||
+				header.code_size % sizeof(u32) != 0)
+				return invalid();
+			cursor += entry_point_size;
+			const std::size_t code_offset = cursor;
+			cursor += header.code_size;
+
+			//the counts are checked against the smallest record sizes before anything is allocated from them
+			constexpr std::size_t min_input_size = sizeof(u8);
+			constexpr std::size_t descriptor_size = 3 * sizeof(u32) + 4 * sizeof(u8);
+			const std::size_t remaining = buffer.size() - cursor;
+			if (static_cast<u64>(header.n_inputs) * min_input_size > remaining ||
+				static_cast<u64>(header.n_descriptors) * descriptor_size > remaining - header.n_inputs * min_input_size)
+				return invalid();
+
+			std::vector<data_layout> inputs(header.n_inputs);
+			for (data_layout& layout : inputs)
+			{
+				u8 n_values;
+				if (!read_value(buffer, cursor, n_values) || buffer.size() - cursor < 2 * static_cast<std::size_t>(n_values))
+					return invalid();
+				layout = data_layout(n_values);
+				for (u8 i = 0; i < n_values; i++)
+				{
+					if (buffer[cursor] > static_cast<u8>(data_layout::type::MAT4x3) ||
+						buffer[cursor + 1] > static_cast<u8>(data_layout::component_type::UINT64))
+						return invalid();
+					layout.set_type(i, static_cast<data_layout::type>(buffer[cursor]),
+						static_cast<data_layout::component_type>(buffer[cursor + 1]));
+					cursor += 2;
+				}
+			}
+
+			std::vector<shader::descriptor_data> descriptors(header.n_descriptors);
+			for (shader::descriptor_data& descriptor : descriptors)
+			{
+				u8 type, reserved[3];
+				if (!read_value(buffer, cursor, descriptor.set) || !read_value(buffer, cursor, descriptor.binding) ||
+					!read_value(buffer, cursor, descriptor.count) || !read_value(buffer, cursor, type) ||
+					!read_value(buffer, cursor, reserved) || type > shader::SAMPLER_SHADOW)
+					return invalid();
+				descriptor.type = static_cast<shader::descriptor_t>(type);
+			}
+
+			*out_data = static_cast<u32*>(ex_malloc(header.code_size));
+			std::memcpy(*out_data, buffer.data() + code_offset, header.code_size);
+			*out_size = header.code_size;
+			out_inputs = std::move(inputs);
+			out_descriptors = std::move(descriptors);
+			return true;
+		}
+
+		void store(u64 key, shader_t stage, const char* entry_point, const u32* data, std::size_t size,
+			const std::vector<data_layout>& inputs, const std::vector<shader::descriptor_data>& descriptors)
+		{
+			if (!enabled()) return;
+
+			std::vector<u8> buffer;
+			const std::size_t entry_point_size = std::strlen(entry_point);
+			write_value(buffer, shader_cache_format::header{
+				.magic = shader_cache_format::magic, .version = shader_cache_format::version,
+				.stage = static_cast<u8>(stage), .reserved = 0, .key = key,
+				.entry_point_size = static_cast<u32>(entry_point_size), .code_size = static_cast<u32>(size),
+				.n_inputs = static_cast<u32>(inputs.size()), .n_descriptors = static_cast<u32>(descriptors.size()) });
+			buffer.insert(buffer.end(), entry_point, entry_point + entry_point_size);
+			buffer.insert(buffer.end(), reinterpret_cast<const u8*>(data), reinterpret_cast<const u8*>(data) + size);
+
+			for (const data_layout& layout : inputs)
+			{
+				write_value<u8>(buffer, layout.count());
+				for (u8 i = 0; i < layout.count(); i++)
+				{
+					const auto [t, ct] = layout_internal::value_at(layout, i);
+					write_value<u8>(buffer, static_cast<u8>(t));
+					write_value<u8>(buffer, static_cast<u8>(ct));
+				}
+			}
+
+			for (const shader::descriptor_data& descriptor : descriptors)
+			{
+				write_value<u32>(buffer, descriptor.set);
+				write_value<u32>(buffer, descriptor.binding);
+				write_value<u32>(buffer, descriptor.count);
+				write_value<u8>(buffer, static_cast<u8>(descriptor.type));
+				write_value<std::array<u8, 3>>(buffer, {});
+			}
+
+			io::write_file_atomic(entry_path(key), buffer.data(), buffer.size());
+		}
+	}
+}
@@ -0,0 +1,68 @@
+#pragma once
+
+#include <core/core.hpp>
+#include <render/shader.hpp>
+
+namespace ENGINE_NAMESPACE
+{
+	/*
+	 * Shader cache entry (.hcsc) layout, all values are stored in native (little endian) byte order:
+	 *	header:			u32 magic | u16 version | u8 stage | u8 reserved | u64 key | u32 entry point size | u32 SPIR-V size
+	 *					| u32 input count | u32 descriptor count
+	 *	entry point:	not null terminated
+	 *	SPIR-V:			compiled code
+	 *	inputs:			per input, u8 value count | (u8 type | u8 component type)[value count]
+	 *	descriptors:	per descriptor, u32 set | u32 binding | u32 count | u8 type | u8 reserved[3]
+	 * Entries are named after their key, so a source edit or compiler update only ever misses, stale entries are left
+	 * behind until the cache directory is cleared.
+	*/
+	namespace shader_cache_format
+	{
+		const u32 magic = 0x43534348; //"HCSC"
+		const u16 version = 1;
+
+		struct header
+		{
+			u32 magic;
+			u16 version;
+			u8 stage;
+			u8 reserved;
+			u64 key;
+			u32 entry_point_size;
+			u32 code_size;
+			u32 n_inputs;
+			u32 n_descriptors;
+		};
+
+		static_assert(sizeof(header) == 32, "Cache structures must not contain padding");
+	}
+
+	/**
+	 * @brief On disk cache of compiled and reflected shaders, stored in HARDCORE_SHADER_CACHE_DIR (defaults to
+	 * cache/shaders). Setting HARDCORE_NO_SHADER_CACHE disables it.
+	*/
+	namespace shader_cache
+	{
+		/**
+		 * @brief Computes the key of a shader, from everything affecting the compiled result.
+		 * @param options Description of the compile options, anything changing the output must change it.
+		 * @return Hash of the source, stage, entry point, compile options and compiler version.
+		*/
+		u64 key(const char* code, std::size_t code_size, shader_t stage, const char* entry_point,
+			const char* options) noexcept;
+
+		/**
+		 * @brief Loads a cached shader.
+		 * @param out_data Compiled code, allocated with malloc.
+		 * @return True on a hit, outputs are left untouched on a miss.
+		*/
+		bool load(u64 key, shader_t stage, const char* entry_point, u32** out_data, std::size_t* out_size,
+			std::vector<data_layout>& out_inputs, std::vector<shader::descriptor_data>& out_descriptors);
+
+		/**
+		 * @brief Stores a compiled shader, replacing the entry atomically so concurrent runs never read partial files.
+		*/
+		void store(u64 key, shader_t stage, const char* entry_point, const u32* data, std::size_t size,
+			const std::vector<data_layout>& inputs, const std::vector<shader::descriptor_data>& descriptors);
+	}
+}
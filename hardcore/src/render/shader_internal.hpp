@@ -38,6 +38,19 @@ namespace ENGINE_NAMESPACE
 
 		inline const std::vector<descriptor_data>& descriptors() const noexcept { return _descriptors; }
 
+		inline shader_t type() const noexcept { return stage; }
+		inline const char* entry() const noexcept { return entry_point; }
+
+		/**
+		 * @brief Builds a shader from a file, returning an empty shader instead of crashing on errors.
+		*/
+		static inline shader load(const char* filename, const char* entry_point, const char* name, shader_t stage)
+		{
+			shader res;
+			static_cast<internal_shader&>(res).load_source(filename, entry_point, name, stage);
+			return res;
+		}
+
 		static VkShaderModule create_shader_module(const shader& shader, VkDevice& handle, 
 			VkShaderStageFlagBits* out_stage, const char** out_entry_point);
 	};
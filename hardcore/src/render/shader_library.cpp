@@ -1,6 +1,12 @@
 #include <pch.hpp>
 
 #include <render/shader_library.hpp>
+#include <render/shader_internal.hpp>
+#include <render/renderer_internal.hpp>
+#include <io/file_watcher.hpp>
+#include <parallel/task.hpp>
+
+#include <debug/log_internal.hpp>
 
 std::unordered_map<std::string, ENGINE_NAMESPACE::shader> shaders;
 
@@ -8,10 +14,80 @@ namespace ENGINE_NAMESPACE
 {
 	namespace shader_library
 	{
+		struct pending_reload
+		{
+			std::string name;
+			u64 generation; //order in which the reloads were queued
+			std::future<shader> result;
+		};
+
+		struct reload_watcher
+		{
+			std::unique_ptr<io::file_watcher> files;
+
+			//normalized source path => names of the shaders built from it
+			std::unordered_map<std::string, std::vector<std::string>> sources;
+			std::vector<pending_reload> pending;
+			u64 next_generation = 0;
+
+			//shader name => generation of the most recent reload taken out of pending, older results are stale
+			std::unordered_map<std::string, u64> consumed;
+		};
+
+		reload_watcher watcher;
+
+		void watch(const shader& s)
+		{
+			if (!s.source()) return;
+
+			const std::filesystem::path path = io::file_watcher::normalize(s.source());
+			std::vector<std::string>& names = watcher.sources[path.string()];
+			if (std::find(names.begin(), names.end(), s.name()) == names.end()) names.push_back(s.name());
+			watcher.files->watch(path);
+		}
+
+		void queue_reload(const std::string& source)
+		{
+			auto it = watcher.sources.find(source);
+			if (it == watcher.sources.end()) return;
+
+			for (const std::string& name : it->second)
+			{
+				auto shader_it = shaders.find(name);
+				if (shader_it == shaders.end()) continue;
+
+				//copied, the library entry may be replaced while the task runs
+				const internal_shader& original = static_cast<const internal_shader&>(shader_it->second);
+				std::string filename = original.source(), entry_point = original.entry();
+				const shader_t stage = original.type();
+
+				LOG_INTERNAL_INFO("Reloading shader:\t" << name);
+				watcher.pending.push_back({ name, watcher.next_generation++, parallel::background_async<shader>([=]()
+					{
+						return internal_shader::load(filename.c_str(), entry_point.c_str(), name.c_str(), stage);
+					}) });
+			}
+		}
+
+		inline bool same_interface(const internal_shader& a, const internal_shader& b)
+		{
+			if (a.type() != b.type() || a.inputs() != b.inputs() || a.descriptors().size() != b.descriptors().size())
+				return false;
+
+			for (std::size_t i = 0; i < a.descriptors().size(); i++)
+			{
+				const shader::descriptor_data& x = a.descriptors()[i];
+				const shader::descriptor_data& y = b.descriptors()[i];
+				if (x.set != y.set || x.binding != y.binding || x.type != y.type || x.count != y.count) return false;
+			}
+			return true;
+		}
+
 		const shader& add(shader&& s)
 		{
 			const char* name = s.name();
 			shaders.insert(std::pair(name, std::move(s)));
+			if (watcher.files) watch(shaders[name]);
 			return shaders[name];
 		}
 
@@ -26,8 +102,101 @@ namespace ENGINE_NAMESPACE
 			return shaders.find(name) == shaders.end();
 		}
 
+		void hot_reload(bool enable)
+		{
+			if (enable == static_cast<bool>(watcher.files)) return;
+
+			if (enable)
+			{
+				watcher.files = std::make_unique<io::file_watcher>();
+				if (!watcher.files->is_open())
+				{
+					LOG_INTERNAL_WARN("Shader hot reload disabled");
+					watcher.files.reset();
+					return;
+				}
+				for (const auto& [name, s] : shaders) watch(s);
+				LOG_INTERNAL_INFO("Shader hot reload enabled");
+			}
+			else
+			{
+				//results of reloads still in flight are dropped
+				watcher.files.reset();
+				watcher.pending.clear();
+				watcher.sources.clear();
+				watcher.consumed.clear();
+			}
+		}
+
+		bool owns(const shader* s)
+		{
+			for (const auto& [name, entry] : shaders)
+				if (&entry == s) return true;
+			return false;
+		}
+
+		void apply_reloads()
+		{
+			if (!watcher.files) return;
+
+			std::set<std::string> changed;
+			watcher.files->poll(changed);
+			for (const std::string& source : changed) queue_reload(source);
+
+			std::vector<const shader*> reloaded;
+			for (std::size_t i = 0; i < watcher.pending.size();)
+			{
+				if (watcher.pending[i].result.wait_for(std::chrono::seconds(0)) != std::future_status::ready)
+				{
+					i++;
+					continue;
+				}
+
+				pending_reload reload = std::move(watcher.pending[i]);
+				watcher.pending.erase(watcher.pending.begin() + i);
+
+				//superseded by a more recent change to the same shader, still running or already taken out
+				const auto is_newer = [&reload](const pending_reload& p)
+				{
+					return p.name == reload.name && p.generation > reload.generation;
+				};
+				if (std::any_of(watcher.pending.begin(), watcher.pending.end(), is_newer)) continue;
+
+				u64& consumed = watcher.consumed[reload.name];
+				if (consumed > reload.generation) continue;
+				consumed = reload.generation;
+
+				shader result;
+				try
+				{
+					result = reload.result.get();
+				}
+				catch (const std::exception& e)
+				{
+					LOG_INTERNAL_WARN("Failed to reload shader:\t" << reload.name << " (" << e.what() << ')');
+					continue;
+				}
+
+				auto it = shaders.find(reload.name);
+				if (!result.source() || it == shaders.end()) continue;
+
+				if (!same_interface(static_cast<const internal_shader&>(result), static_cast<const internal_shader&>(it->second)))
+				{
+					LOG_INTERNAL_WARN("Inputs or descriptors of shader changed, restart to apply:\t" << reload.name);
+					continue;
+				}
+
+				//library entries are replaced in place, so pipelines still refer to the same shader
+				it->second = std::move(result);
+				reloaded.push_back(&it->second);
+			}
+
+			if (!reloaded.empty()) renderer::get_device().reload_graphics_pipelines(reloaded);
+		}
+
 		void clear()
 		{
+			hot_reload(false);
 			shaders.clear();
 		}
 	}
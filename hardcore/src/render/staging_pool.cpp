@@ -8,68 +8,360 @@ namespace ENGINE_NAMESPACE
 		VkBufferUsageFlags usage, device_heap_manager::heap heap) :
 		m_size(size), m_pending_size(0)
 	{
-		heap_manager.alloc_buffer(device, m_memory, m_buffer, size * max_frames_in_flight, usage, heap);
+		heap_manager.alloc_buffer(device, m_allocation, m_buffer, size * max_frames_in_flight, usage, heap);
 	}
 
 	staging_pool::~staging_pool()
 	{
-		INTERNAL_ASSERT(!m_host_ptr, "Staging pool not unmapped");
-		INTERNAL_ASSERT(m_memory == VK_NULL_HANDLE, "Staging pool not freed");
+		INTERNAL_ASSERT(m_allocation.memory == VK_NULL_HANDLE, "Staging pool not freed");
 	}
 
 	void staging_pool::free(VkDevice device, device_heap_manager& heap_manager)
 	{
-		if (m_memory != VK_NULL_HANDLE)
+		if (m_allocation.memory != VK_NULL_HANDLE)
 		{
 			vkDestroyBuffer(device, m_buffer, nullptr);
 			m_buffer = VK_NULL_HANDLE;
-			heap_manager.free(device, m_memory);
+			m_host_ptr = nullptr;
+			heap_manager.free(device, m_allocation);
 		}
 	}
 
-	void staging_pool::map(VkDevice device, u8 current_frame)
+	void staging_pool::select_frame(u8 current_frame) noexcept
 	{
-		VK_CRASH_CHECK(vkMapMemory(device, m_memory, m_size * current_frame, m_size, 0, &m_host_ptr),
-			"Failed to map memory");
+		m_host_ptr = static_cast<std::byte*>(m_allocation.host_ptr) + m_size * current_frame;
 	}
 
-	void staging_pool::unmap(VkDevice device)
+	void copy_list::record_and_clear(VkCommandBuffer& buffer)
 	{
-		INTERNAL_ASSERT(m_host_ptr != nullptr, "Memmory not mapped");
-		vkUnmapMemory(device, m_memory);
-		m_host_ptr = nullptr;
+		if (m_copies.empty())
+			return;
+
+		std::sort(m_copies.begin(), m_copies.end(), [](const buffer_copy& a, const buffer_copy& b)
+			{
+				if (a.dst != b.dst) return a.dst < b.dst;
+				if (a.region.dstOffset != b.region.dstOffset) return a.region.dstOffset < b.region.dstOffset;
+				return a.order < b.order;
+			});
+
+		for (std::size_t first = 0; first < m_copies.size();)
+		{
+			std::size_t last = first + 1;
+			while (last < m_copies.size() && m_copies[last].dst == m_copies[first].dst) last++;
+
+			record_destination(buffer, first, last);
+			first = last;
+		}
+
+		m_copies.clear();
 	}
 
-	void upload_pool::create_batch(u8 pool_type, std::size_t pool_idx, VkBuffer buffer)
+	void copy_list::record_destination(VkCommandBuffer& buffer, std::size_t first, std::size_t last)
 	{
-		INTERNAL_ASSERT(!has_batch(pool_type, pool_idx), "Batch already exists");
+		const VkBuffer dst = m_copies[first].dst;
+
+		//the destination regions of a copy command must not overlap
+		bool overlapping = false;
+		VkDeviceSize end = 0;
+		for (std::size_t i = first; i < last && !overlapping; i++)
+		{
+			overlapping = m_copies[i].region.dstOffset < end;
+			end = std::max(end, m_copies[i].region.dstOffset + m_copies[i].region.size);
+		}
+
+		if (overlapping)
+		{
+			//rare, e.g. a resource updated twice in a frame: copied one by one in staging order, so the last one wins
+			std::sort(m_copies.begin() + first, m_copies.begin() + last, 
+				[](const buffer_copy& a, const buffer_copy& b) { return a.order < b.order; });
+
+			VkMemoryBarrier barrier = {};
+			barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+			barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+			barrier.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+
+			for (std::size_t i = first; i < last; i++)
+			{
+				if (i != first)
+				{
+					vkCmdPipelineBarrier(buffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 
+						1, &barrier, 0, nullptr, 0, nullptr);
+				}
+				vkCmdCopyBuffer(buffer, m_copies[i].src, dst, 1, &m_copies[i].region);
+			}
+			return;
+		}
+
+		//contiguous copies from the same ring become a single region, the source changes only when a ring was replaced
+		m_regions.clear();
+		VkBuffer src = m_copies[first].src;
+		for (std::size_t i = first; i < last; i++)
+		{
+			const buffer_copy& copy = m_copies[i];
+			if (copy.src != src)
+			{
+				vkCmdCopyBuffer(buffer, src, dst, static_cast<u32>(m_regions.size()), m_regions.data());
+				m_regions.clear();
+				src = copy.src;
+			}
 
-		m_pending_copies.insert({ { pool_type, pool_idx }, { buffer, std::vector<VkBufferCopy>() } });
+			if (m_regions.size())
+			{
+				VkBufferCopy& previous = m_regions.back();
+				if (previous.srcOffset + previous.size == copy.region.srcOffset &&
+					previous.dstOffset + previous.size == copy.region.dstOffset)
+				{
+					previous.size += copy.region.size;
+					continue;
+				}
+			}
+			m_regions.push_back(copy.region);
+		}
+
+		vkCmdCopyBuffer(buffer, src, dst, static_cast<u32>(m_regions.size()), m_regions.data());
 	}
 
-	void upload_pool::submit(u8 pool_type, std::size_t pool_idx, const void* data, VkDeviceSize size, VkDeviceSize offset)
+	upload_pool::~upload_pool()
 	{
-		INTERNAL_ASSERT(m_pending_size + size <= m_size, "Out of bounds memory access");
-		INTERNAL_ASSERT(has_batch(pool_type, pool_idx), "Batch does not exist");
+		INTERNAL_ASSERT(m_rings.empty(), "Upload pool not freed");
+	}
+
+	void upload_pool::free(VkDevice device, device_heap_manager& heap_manager)
+	{
+		for (transient_ring& ring : m_rings) ring.free(device, heap_manager);
+		m_rings.clear();
+		m_pending.clear();
+		m_holds.clear();
+
+		//destroying the pool frees its command buffers
+		if (m_cmd_pool != VK_NULL_HANDLE)
+			vkDestroyCommandPool(device, m_cmd_pool, nullptr);
+		m_cmd_pool = VK_NULL_HANDLE;
+		m_free_cmds.clear();
+		m_recording_cmds.clear();
+		m_submitted_cmds.clear();
+		for (std::vector<recorded_commands>& executing : m_executing_cmds) executing.clear();
+	}
+
+	void upload_pool::add_ring(VkDevice device, device_heap_manager& heap_manager, VkDeviceSize size)
+	{
+		m_rings.push_back(transient_ring(device, heap_manager, size, VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+			device_heap_manager::heap::UPLOAD));
+		m_holds.push_back(transient_ring::no_hold);
+	}
 
-		m_pending_copies[{ pool_type, pool_idx }].regions.push_back({ 
-			.srcOffset = m_pending_size, .dstOffset = offset, .size = size });
+	std::span<std::byte> upload_pool::reserve(u32 handle, u32 generation, VkDeviceSize size, VkDeviceSize offset)
+	{
+		INTERNAL_ASSERT(m_rings.size(), "Upload pool has no ring");
 
-		std::memcpy(static_cast<std::byte*>(m_host_ptr) + m_pending_size, data, size);
+		transient_ring& ring = m_rings.back();
+		const VkDeviceSize src_offset = ring.allocate(size, staging_alignment);
+		if (src_offset == transient_ring::invalid_offset) return {};
 
-		m_pending_size += size;
+		m_pending.push_back({ .pool = this, .src = ring.buffer(), .src_offset = src_offset, .size = size, 
+			.handle = handle, .generation = generation, .offset = offset, .position = ring.head() - size });
+
+		return { static_cast<std::byte*>(ring.host_ptr()) + src_offset, static_cast<std::size_t>(size) };
 	}
 
-	void upload_pool::record_and_clear(VkCommandBuffer& buffer)
+	void upload_pool::commit(std::deque<staged_upload>& queue, bool last_only)
 	{
-		if (!m_pending_size)
-			return;
+		const std::size_t first = last_only ? m_pending.size() - 1 : 0;
+		queue.insert(queue.end(), m_pending.begin() + first, m_pending.end());
+		m_pending.erase(m_pending.begin() + first, m_pending.end());
+	}
 
-		for (const auto& [key, data] : m_pending_copies)
-			vkCmdCopyBuffer(buffer, m_buffer, data.buffer, data.regions.size(), data.regions.data());
-		
-		m_pending_copies.clear();
-		m_pending_size = 0;
+	void upload_pool::hold(const staged_upload& upload) noexcept
+	{
+		for (std::size_t i = 0; i < m_rings.size(); i++)
+		{
+			if (m_rings[i].buffer() == upload.src)
+			{
+				m_holds[i] = std::min(m_holds[i], upload.position);
+				return;
+			}
+		}
+		INTERNAL_ASSERT(false, "Staged upload from an unknown ring");
+	}
+
+	VkMappedMemoryRange upload_pool::mapped_range(const staged_upload& upload, VkDeviceSize atom_size) const noexcept
+	{
+		//queued uploads are never in a freed ring, their ring's tail is held behind them until they are copied
+		const auto ring = std::find_if(m_rings.begin(), m_rings.end(),
+			[&upload](const transient_ring& ring) { return ring.buffer() == upload.src; });
+		INTERNAL_ASSERT(ring != m_rings.end(), "Staged upload from an unknown ring");
+
+		return ring->mapped_range(upload.src_offset, upload.size, atom_size);
+	}
+
+	void upload_pool::end_frame(VkDevice device, device_heap_manager& heap_manager, u8 current_frame)
+	{
+		//the pending uploads are still being written, the frame only releases the space before the oldest of them
+		for (const staged_upload& upload : m_pending) hold(upload);
+
+		for (std::size_t i = 0; i < m_rings.size(); i++)
+		{
+			m_rings[i].end_frame(current_frame, m_holds[i]);
+			m_holds[i] = transient_ring::no_hold;
+		}
+
+		for (std::size_t i = 0; i + 1 < m_rings.size();)
+		{
+			//a replaced ring is empty once the last frame it was used in has completed
+			if (m_rings[i].used())
+			{
+				i++;
+				continue;
+			}
+			m_rings[i].free(device, heap_manager);
+			m_rings.erase(m_rings.begin() + i);
+			m_holds.erase(m_holds.begin() + i);
+		}
+	}
+
+	void upload_pool::collect_commands(std::vector<VkCommandBuffer>& cmd_buffers, std::vector<pinned_ref>& unpinned,
+		u8 current_frame)
+	{
+		std::vector<recorded_commands>& executing = m_executing_cmds[current_frame];
+		for (const recorded_commands& commands : executing)
+		{
+			m_free_cmds.push_back(commands.cmd_buffer);
+			unpinned.insert(unpinned.end(), commands.pinned.begin(), commands.pinned.end());
+		}
+		executing.clear();
+
+		for (recorded_commands& commands : m_submitted_cmds)
+		{
+			cmd_buffers.push_back(commands.cmd_buffer);
+			executing.push_back(std::move(commands));
+		}
+		m_submitted_cmds.clear();
+	}
+
+	void upload_pool::pin(VkCommandBuffer cmd_buffer, const pinned_ref& ref)
+	{
+		auto it = std::find_if(m_recording_cmds.begin(), m_recording_cmds.end(),
+			[cmd_buffer](const recorded_commands& commands) { return commands.cmd_buffer == cmd_buffer; });
+		INTERNAL_ASSERT(it != m_recording_cmds.end(), "Command buffer not begun by this thread");
+		it->pinned.push_back(ref);
+	}
+
+	const std::vector<upload_pool::pinned_ref>& upload_pool::submit_commands(VkCommandBuffer cmd_buffer)
+	{
+		auto it = std::find_if(m_recording_cmds.begin(), m_recording_cmds.end(),
+			[cmd_buffer](const recorded_commands& commands) { return commands.cmd_buffer == cmd_buffer; });
+		INTERNAL_ASSERT(it != m_recording_cmds.end(), "Command buffer not begun by this thread");
+
+		m_submitted_cmds.push_back(std::move(*it));
+		m_recording_cmds.erase(it);
+		return m_submitted_cmds.back().pinned;
+	}
+
+	VkCommandBuffer upload_pool::allocate_commands(VkDevice device, u32 queue_idx)
+	{
+		if (m_cmd_pool == VK_NULL_HANDLE)
+		{
+			VkCommandPoolCreateInfo pool_info = {};
+			pool_info.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+			pool_info.queueFamilyIndex = queue_idx;
+			pool_info.flags = VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT;
+
+			VK_CRASH_CHECK(vkCreateCommandPool(device, &pool_info, nullptr, &m_cmd_pool), 
+				"Failed to create command pool");
+		}
+
+		VkCommandBufferAllocateInfo cmd_buffer_info = {};
+		cmd_buffer_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+		cmd_buffer_info.level = VK_COMMAND_BUFFER_LEVEL_SECONDARY;
+		cmd_buffer_info.commandPool = m_cmd_pool;
+		cmd_buffer_info.commandBufferCount = 1;
+
+		VkCommandBuffer cmd_buffer;
+		VK_CRASH_CHECK(vkAllocateCommandBuffers(device, &cmd_buffer_info, &cmd_buffer), 
+			"Failed to allocate command buffers");
+		return cmd_buffer;
+	}
+
+	download_pool::~download_pool()
+	{
+		INTERNAL_ASSERT(m_rings.empty(), "Download pool not freed");
+	}
+
+	void download_pool::free(VkDevice device, device_heap_manager& heap_manager)
+	{
+		for (transient_ring& ring : m_rings) ring.free(device, heap_manager);
+		m_rings.clear();
+		m_requested.clear();
+		for (std::vector<download>& recorded : m_recorded) recorded.clear();
+	}
+
+	void download_pool::add_ring(VkDevice device, device_heap_manager& heap_manager, VkDeviceSize size)
+	{
+		m_rings.push_back(transient_ring(device, heap_manager, size, VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+			device_heap_manager::heap::DOWNLOAD));
+	}
+
+	std::future<std::vector<std::byte>> download_pool::request(u32 handle, u32 generation, VkDeviceSize size,
+		VkDeviceSize offset)
+	{
+		m_requested.push_back({ .handle = handle, .generation = generation, .offset = offset, .size = size });
+		return m_requested.back().result.get_future();
+	}
+
+	bool download_pool::reserve(download& download) noexcept
+	{
+		INTERNAL_ASSERT(m_rings.size(), "Download pool has no ring");
+
+		transient_ring& ring = m_rings.back();
+		const VkDeviceSize dst_offset = ring.allocate(download.size, upload_pool::staging_alignment);
+		if (dst_offset == transient_ring::invalid_offset) return false;
+
+		download.dst = ring.buffer();
+		download.dst_offset = dst_offset;
+		return true;
+	}
+
+	void download_pool::push_invalidate_ranges(std::vector<VkMappedMemoryRange>& ranges, u8 frame, 
+		VkDeviceSize atom_size) const
+	{
+		for (const download& download : m_recorded[frame])
+			ranges.push_back(find_ring(download.dst).mapped_range(download.dst_offset, download.size, atom_size));
+	}
+
+	void download_pool::deliver(u8 frame)
+	{
+		for (download& download : m_recorded[frame])
+		{
+			const std::byte* data = static_cast<const std::byte*>(find_ring(download.dst).host_ptr()) + download.dst_offset;
+			download.result.set_value(std::vector<std::byte>(data, data + download.size));
+		}
+		m_recorded[frame].clear();
+	}
+
+	void download_pool::end_frame(VkDevice device, device_heap_manager& heap_manager, u8 current_frame)
+	{
+		for (transient_ring& ring : m_rings) ring.end_frame(current_frame);
+		for (std::size_t i = 0; i + 1 < m_rings.size();)
+		{
+			//a replaced ring is empty once the last frame it was used in has completed
+			if (m_rings[i].used())
+			{
+				i++;
+				continue;
+			}
+			m_rings[i].free(device, heap_manager);
+			m_rings.erase(m_rings.begin() + i);
+		}
+	}
+
+	const transient_ring& download_pool::find_ring(VkBuffer buffer) const noexcept
+	{
+		//recorded downloads are never in a freed ring, the rings are only freed once their frames have completed
+		const auto ring = std::find_if(m_rings.begin(), m_rings.end(),
+			[buffer](const transient_ring& ring) { return ring.buffer() == buffer; });
+		INTERNAL_ASSERT(ring != m_rings.end(), "Download from an unknown ring");
+
+		return *ring;
 	}
 
 	inline VkImageMemoryBarrier layout_transition(VkImage image, VkImageLayout old_layout, VkImageLayout new_layout,
@@ -99,6 +391,14 @@ namespace ENGINE_NAMESPACE
 	void texture_upload_pool::buffer_image_copy(const void* data, VkDeviceSize size,
 		VkImage image, VkImageLayout layout, VkExtent3D image_dims)
 	{
+		std::memcpy(reserve_buffer_image_copy(size, image, layout, image_dims), data, size);
+	}
+
+	void* texture_upload_pool::reserve_buffer_image_copy(VkDeviceSize size, VkImage image, VkImageLayout layout,
+		VkExtent3D image_dims)
+	{
+		INTERNAL_ASSERT(m_pending_size + size <= m_size, "Out of bounds memory access");
+
 		VkBufferImageCopy* regions = t_malloc<VkBufferImageCopy>(1);
 		regions->bufferOffset = m_pending_size;
 		regions->bufferRowLength = 0;
@@ -124,7 +424,9 @@ namespace ENGINE_NAMESPACE
 				.filter = VK_FILTER_MAX_ENUM // n/a
 			});
 
-		std::memcpy(static_cast<std::byte*>(m_host_ptr) + m_pending_size, data, size);
+		void* dst = static_cast<std::byte*>(m_host_ptr) + m_pending_size;
+		m_pending_size += size;
+		return dst;
 	}
 
 	void texture_upload_pool::record_and_clear_transfer(VkCommandBuffer& buffer, u32 queue_idx)
@@ -2,6 +2,11 @@
 
 #include "render_core.hpp"
 #include "device_heap_manager.hpp"
+#include "transient_ring.hpp"
+
+#include <deque>
+#include <future>
+#include <span>
 
 namespace ENGINE_NAMESPACE
 {
@@ -15,22 +20,29 @@ namespace ENGINE_NAMESPACE
 	public:
 		void free(VkDevice device, device_heap_manager& heap_manager);
 
-		void map(VkDevice device, u8 current_frame);
-		void unmap(VkDevice device);
+		/**
+		 * @brief Points the host pointer at the current frame's region, the memory stays mapped by the heap manager
+		 * for the pool's whole lifetime.
+		*/
+		void select_frame(u8 current_frame) noexcept;
 
 		inline VkDeviceSize capacity() const noexcept { return m_size; }
 		inline VkDeviceSize size() const noexcept { return m_pending_size; }
 
+		/**
+		 * @brief Adds the range staged in the current frame's region of every pool, pools with nothing staged are skipped.
+		 * @param atom_size Non coherent atom size, ranges are widened to multiples of it.
+		*/
 		template<StagingPoolType T>
 		static void push_flush_ranges(std::vector<VkMappedMemoryRange>& ranges, u8 current_frame, 
-			const std::vector<T>& pools) // this function has to be a template as the vector contains values
+			const std::vector<T>& pools, VkDeviceSize atom_size) // this function has to be a template as the vector contains values
 		{
 			for (const auto& pool : pools)
 			{
 				if (!pool.m_pending_size)
 					continue;
 
-				ranges.push_back(pool.mapped_range(current_frame));
+				ranges.push_back(pool.mapped_range(current_frame, atom_size));
 			}
 		}
 
@@ -44,7 +56,7 @@ namespace ENGINE_NAMESPACE
 		staging_pool& operator=(const staging_pool&) = delete;
 
 		staging_pool(staging_pool&& other) noexcept :
-			m_memory(std::exchange(other.m_memory, VK_NULL_HANDLE)),
+			m_allocation(std::exchange(other.m_allocation, {})),
 			m_buffer(std::exchange(other.m_buffer, VK_NULL_HANDLE)),
 			m_host_ptr(std::exchange(other.m_host_ptr, nullptr)),
 			m_size(std::exchange(other.m_size, 0)),
@@ -53,10 +65,9 @@ namespace ENGINE_NAMESPACE
 
 		inline staging_pool& operator=(staging_pool&& other) noexcept
 		{
-			INTERNAL_ASSERT(!m_host_ptr, "Other staging pool not unmapped");
-			INTERNAL_ASSERT(m_memory == VK_NULL_HANDLE, "Other staging pool not freed");
+			INTERNAL_ASSERT(m_allocation.memory == VK_NULL_HANDLE, "Other staging pool not freed");
 
-			m_memory = std::exchange(other.m_memory, VK_NULL_HANDLE);
+			m_allocation = std::exchange(other.m_allocation, {});
 			m_buffer = std::exchange(other.m_buffer, VK_NULL_HANDLE);
 			m_host_ptr = std::exchange(other.m_host_ptr, nullptr);
 			m_size = std::exchange(other.m_size, 0);
@@ -64,60 +75,281 @@ namespace ENGINE_NAMESPACE
 			return *this;
 		}
 
-		inline VkMappedMemoryRange mapped_range(u8 current_frame) const noexcept
+		//the pending data starts at the region's beginning, which is a multiple of the atom size
+		inline VkMappedMemoryRange mapped_range(u8 current_frame, VkDeviceSize atom_size) const noexcept
 		{
-			return { .sType = VK_STRUCTURE_TYPE_MAPPED_MEMORY_RANGE, .pNext = nullptr, .memory = m_memory,
-				.offset = m_size * current_frame, .size = m_size };
+			return { .sType = VK_STRUCTURE_TYPE_MAPPED_MEMORY_RANGE, .pNext = nullptr, .memory = m_allocation.memory,
+				.offset = m_allocation.offset + m_size * current_frame, 
+				.size = std::min((m_pending_size + atom_size - 1) / atom_size * atom_size, m_size) };
 		}
 
 
-		VkDeviceMemory m_memory = VK_NULL_HANDLE;
+		device_allocation m_allocation;
 		VkBuffer m_buffer = VK_NULL_HANDLE;
 		void* m_host_ptr = nullptr;
 		VkDeviceSize m_size;
 		VkDeviceSize m_pending_size;
 	};
 
-	class upload_pool : public staging_pool
+	/**
+	 * @brief Flat list of buffer copies, sorted by destination and merged when contiguous once they are recorded.
+	*/
+	class copy_list
 	{
 	public:
-		upload_pool() = default;
-		upload_pool(VkDevice device, device_heap_manager& heap_manager, VkDeviceSize size) :
-			staging_pool(device, heap_manager, size, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, device_heap_manager::heap::UPLOAD)
-		{}
+		inline void push(VkBuffer src, VkBuffer dst, const VkBufferCopy& region)
+		{ m_copies.push_back({ .src = src, .dst = dst, .region = region, .order = static_cast<u32>(m_copies.size()) }); }
+
+		inline bool empty() const noexcept { return m_copies.empty(); }
+
+		void record_and_clear(VkCommandBuffer& buffer);
+
+	private:
+		struct buffer_copy
+		{
+			VkBuffer src;
+			VkBuffer dst;
+			VkBufferCopy region;
+			u32 order; //overlapping copies to the same destination are recorded in the order they were pushed
+		};
+
+		void record_destination(VkCommandBuffer& buffer, std::size_t first, std::size_t last);
+
+		std::vector<buffer_copy> m_copies;
+		std::vector<VkBufferCopy> m_regions; //merged regions of one vkCmdCopyBuffer, kept for the next frames
+	};
+
+	/**
+	 * @brief Staging of one thread: rings of persistently mapped memory the thread writes its uploads to in place, and
+	 * the secondary transfer command buffers it records. Staged uploads are pending until the thread commits them to the
+	 * device memory's queue, which copies them over the next frames. Only the owning thread writes to its reservations
+	 * and records its command buffers, every other call must be made under the lock of the device memory.
+	*/
+	class upload_pool
+	{
+	public:
+		//keeps the staged data aligned for the producers writing to it
+		static constexpr VkDeviceSize staging_alignment = 16;
+
+		//the destination is resolved when the upload is recorded, as its allocation can be moved or freed meanwhile
+		struct staged_upload
+		{
+			upload_pool* pool;
+			VkBuffer src;
+			VkDeviceSize src_offset;
+			VkDeviceSize size;
+			u32 handle; //memory reference of the destination
+			u32 generation;
+			VkDeviceSize offset; //position in the destination allocation
+			u64 position; //of the data left to copy in the ring, which holds its tail behind it until then
+			u64 ticket = 0; //given once committed
+		};
+
+		//allocation a transfer command buffer copies from or to, it is not moved nor reused until the buffer has been
+		//executed
+		struct pinned_ref
+		{
+			u32 handle;
+			u32 generation;
+			bool written; //destination of a copy
+		};
+
+		explicit upload_pool(std::thread::id owner) : m_owner(owner) {}
+		~upload_pool();
+
+		upload_pool(const upload_pool&) = delete;
+		upload_pool& operator=(const upload_pool&) = delete;
+
+		void free(VkDevice device, device_heap_manager& heap_manager);
 
-		inline bool has_batch(u8 pool_type, std::size_t pool_idx) const
+		/**
+		 * @brief Replaces the ring staging is bumped from, the previous rings are freed once the frames using them
+		 * have completed.
+		 * @param size Multiple of the staging alignment and of the non coherent atom size.
+		*/
+		void add_ring(VkDevice device, device_heap_manager& heap_manager, VkDeviceSize size);
+
+		/**
+		 * @brief Reserves staging memory for an upload, the owning thread writes the data straight into it.
+		 * @return Mapped memory valid until the upload is committed and recorded, or an empty span with no data if the
+		 * ring is full.
+		*/
+		std::span<std::byte> reserve(u32 handle, u32 generation, VkDeviceSize size, VkDeviceSize offset);
+
+		/**
+		 * @brief Moves the pending uploads to the back of a queue, their data must have been written.
+		 * @param last_only Commits the last reservation only, the others may still be written to.
+		*/
+		void commit(std::deque<staged_upload>& queue, bool last_only);
+
+		/**
+		 * @brief Keeps the staging of a committed upload that has not been fully copied yet from being released with
+		 * this frame.
+		*/
+		void hold(const staged_upload& upload) noexcept;
+
+		/**
+		 * @brief Range of the memory block a staged upload was written to.
+		*/
+		VkMappedMemoryRange mapped_range(const staged_upload& upload, VkDeviceSize atom_size) const noexcept;
+
+		/**
+		 * @brief Ends the frame of every ring and frees the replaced rings that are no longer used. Must be called once
+		 * per frame, after the frame's uploads have been collected and the queued ones held. The tail of each ring
+		 * stops at its oldest pending or held upload, the space copied before it is released with the frame.
+		*/
+		void end_frame(VkDevice device, device_heap_manager& heap_manager, u8 current_frame);
+
+		/**
+		 * @brief Recycles the command buffers executed by the frame that last used the current frame's index, then moves
+		 * the submitted ones to the current frame's upload. Must be called right after waiting on the current frame's
+		 * fences.
+		 * @param unpinned Receives the allocations the recycled command buffers pinned.
+		*/
+		void collect_commands(std::vector<VkCommandBuffer>& cmd_buffers, std::vector<pinned_ref>& unpinned, 
+			u8 current_frame);
+
+		/**
+		 * @return A recycled secondary command buffer, or VK_NULL_HANDLE if none is free.
+		*/
+		inline VkCommandBuffer pop_commands() noexcept
 		{
-			return m_pending_copies.contains({ pool_type, pool_idx });
+			if (m_free_cmds.empty()) return VK_NULL_HANDLE;
+
+			const VkCommandBuffer cmd_buffer = m_free_cmds.back();
+			m_free_cmds.pop_back();
+			return cmd_buffer;
 		}
 
-		void create_batch(u8 pool_type, std::size_t pool_idx, VkBuffer buffer);
-		void submit(u8 pool_type, std::size_t pool_idx, const void* data, VkDeviceSize size, VkDeviceSize offset);
+		/**
+		 * @brief Allocates a secondary command buffer, creating the command pool on first use. Only called by the owning
+		 * thread, which externally synchronizes the pool, it does not need the lock.
+		*/
+		VkCommandBuffer allocate_commands(VkDevice device, u32 queue_idx);
 
-		void record_and_clear(VkCommandBuffer& buffer);
+		inline void begin_commands(VkCommandBuffer cmd_buffer) { m_recording_cmds.push_back({ cmd_buffer, {} }); }
+
+		/**
+		 * @brief Pins an allocation for a command buffer being recorded, the caller counts the pin in its slot.
+		*/
+		void pin(VkCommandBuffer cmd_buffer, const pinned_ref& ref);
 
-		//static void push_flush_ranges(std::vector<VkMappedMemoryRange>& ranges, u8 current_frame,
-		//	const std::vector<upload_pool>& pools);
+		/**
+		 * @brief Queues a recorded command buffer for the next upload.
+		 * @return Allocations pinned by the command buffer.
+		*/
+		const std::vector<pinned_ref>& submit_commands(VkCommandBuffer cmd_buffer);
+
+		inline VkDeviceSize ring_size() const noexcept { return m_rings.size() ? m_rings.back().size() : 0; }
+		inline std::thread::id owner() const noexcept { return m_owner; }
 
 	private:
-		typedef std::pair<u8, std::size_t> dst_pool; //<pool_type, pool_idx>
+		std::thread::id m_owner;
+		std::vector<transient_ring> m_rings;
+		std::vector<staged_upload> m_pending; //reserved, still being written by the owning thread
+		std::vector<u64> m_holds; //per ring, position of the oldest upload not copied yet, reset every frame
 
-		//not part of the engine API, so it's unnecessary to implement the std version of hash
-		struct hash
+		VkCommandPool m_cmd_pool = VK_NULL_HANDLE;
+		struct recorded_commands
 		{
-			inline std::size_t operator()(const dst_pool& key) const noexcept
-			{
-				return static_cast<std::size_t>((static_cast<u64>(key.second) << (sizeof(key.first) * 8)) ^ key.first);
-			}
+			VkCommandBuffer cmd_buffer;
+			std::vector<pinned_ref> pinned;
 		};
 
-		struct dst_data
+		std::vector<VkCommandBuffer> m_free_cmds;
+		std::vector<recorded_commands> m_recording_cmds;
+		std::vector<recorded_commands> m_submitted_cmds;
+		std::array<std::vector<recorded_commands>, max_frames_in_flight> m_executing_cmds;
+	};
+
+	/**
+	 * @brief Readbacks of static buffers. Their copies are recorded at the end of a frame into rings of persistently
+	 * mapped, host cached memory, and the data is handed to the requester once the frame has completed. Every call must
+	 * be made under the lock of the device memory.
+	*/
+	class download_pool
+	{
+	public:
+		//the source is resolved when the copy is recorded, as its allocation can be moved or freed meanwhile
+		struct download
 		{
-			VkBuffer buffer = VK_NULL_HANDLE;
-			std::vector<VkBufferCopy> regions;
+			u32 handle; //memory reference of the source
+			u32 generation;
+			VkDeviceSize offset; //position in the source allocation
+			VkDeviceSize size;
+			std::promise<std::vector<std::byte>> result;
+
+			VkBuffer dst = VK_NULL_HANDLE; //ring the data is copied to, once recorded
+			VkDeviceSize dst_offset = 0;
 		};
 
-		std::unordered_map<dst_pool, dst_data, hash> m_pending_copies;
+		download_pool() = default;
+		~download_pool();
+
+		download_pool(const download_pool&) = delete;
+		download_pool& operator=(const download_pool&) = delete;
+
+		download_pool(download_pool&&) = default;
+
+		/**
+		 * @brief Frees the rings, the downloads still pending are dropped and their futures left without a value.
+		*/
+		void free(VkDevice device, device_heap_manager& heap_manager);
+
+		/**
+		 * @brief Replaces the ring the downloads are bumped from, the previous rings are freed once the frames using
+		 * them have completed.
+		*/
+		void add_ring(VkDevice device, device_heap_manager& heap_manager, VkDeviceSize size);
+
+		std::future<std::vector<std::byte>> request(u32 handle, u32 generation, VkDeviceSize size, VkDeviceSize offset);
+
+		/**
+		 * @brief Downloads waiting to be recorded, oldest first.
+		*/
+		inline std::deque<download>& requested() noexcept { return m_requested; }
+
+		/**
+		 * @brief Reserves ring memory for a download to be copied to.
+		 * @return False if the ring is full.
+		*/
+		bool reserve(download& download) noexcept;
+
+		/**
+		 * @brief Moves the oldest requested download, whose copy has been recorded, to the current frame.
+		*/
+		inline void recorded(u8 current_frame)
+		{
+			m_recorded[current_frame].push_back(std::move(m_requested.front()));
+			m_requested.pop_front();
+		}
+
+		/**
+		 * @brief Adds the ranges the downloads of a frame were copied to.
+		*/
+		void push_invalidate_ranges(std::vector<VkMappedMemoryRange>& ranges, u8 frame, VkDeviceSize atom_size) const;
+
+		/**
+		 * @brief Hands the data of a frame's downloads to their futures. Must be called once the frame has completed,
+		 * after invalidating its ranges.
+		*/
+		void deliver(u8 frame);
+
+		/**
+		 * @brief Ends the frame of every ring and frees the replaced rings that are no longer used. Must be called once
+		 * per frame, after waiting on the current frame's fences.
+		*/
+		void end_frame(VkDevice device, device_heap_manager& heap_manager, u8 current_frame);
+
+		inline VkDeviceSize ring_size() const noexcept { return m_rings.size() ? m_rings.back().size() : 0; }
+		inline bool empty() const noexcept { return m_requested.empty(); }
+
+	private:
+		const transient_ring& find_ring(VkBuffer buffer) const noexcept;
+
+		std::vector<transient_ring> m_rings;
+		std::deque<download> m_requested;
+		std::array<std::vector<download>, max_frames_in_flight> m_recorded; //copied by the frame, not delivered yet
 	};
 
 	class texture_upload_pool : public staging_pool
@@ -130,6 +362,7 @@ namespace ENGINE_NAMESPACE
 
 		void buffer_image_copy(const void* data, VkDeviceSize size, 
 			VkImage image, VkImageLayout layout, VkExtent3D image_dims);
+		void* reserve_buffer_image_copy(VkDeviceSize size, VkImage image, VkImageLayout layout, VkExtent3D image_dims);
 		//void image_copy();
 		//void depth_stencil_copy();
 		//void image_blit();
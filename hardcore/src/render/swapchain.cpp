@@ -88,6 +88,11 @@ namespace ENGINE_NAMESPACE
 				std::min(capabilities.maxImageExtent.height, _extent.height));
 		}
 
+		update_viewport();
+	}
+
+	inline void swapchain::update_viewport()
+	{
 		_viewport = {};
 		_viewport.x = 0.0f;
 		_viewport.y = 0.0f;
@@ -201,8 +206,123 @@ namespace ENGINE_NAMESPACE
 		}
 	}
 
+	inline void swapchain::create_offscreen_images(VkPhysicalDevice physical_device, VkDevice device)
+	{
+		int width, height;
+		window::get_dimensions(&width, &height);
+		_extent = {
+			static_cast<u32>(std::max(width, 1)),
+			static_cast<u32>(std::max(height, 1))
+		};
+		update_viewport();
+
+		VkPhysicalDeviceMemoryProperties memory_properties;
+		vkGetPhysicalDeviceMemoryProperties(physical_device, &memory_properties);
+
+		images = t_malloc<VkImage>(n_images);
+		image_views = t_malloc<VkImageView>(n_images);
+		image_memory = t_malloc<VkDeviceMemory>(n_images);
+		for (u32 i = 0; i < n_images; i++)
+		{
+			VkImageCreateInfo image_info = {};
+			image_info.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+			image_info.imageType = VK_IMAGE_TYPE_2D;
+			image_info.format = surface_format.format;
+			image_info.extent = { _extent.width, _extent.height, 1 };
+			image_info.mipLevels = 1;
+			image_info.arrayLayers = 1;
+			image_info.samples = VK_SAMPLE_COUNT_1_BIT;
+			image_info.tiling = VK_IMAGE_TILING_OPTIMAL;
+			image_info.usage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT; //transfer src for readbacks
+			image_info.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+			image_info.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+
+			VK_CRASH_CHECK(vkCreateImage(device, &image_info, nullptr, &images[i]), "Failed to create offscreen image");
+
+			VkMemoryRequirements requirements;
+			vkGetImageMemoryRequirements(device, images[i], &requirements);
+
+			u32 type_idx = std::numeric_limits<u32>::max();
+			for (u32 t = 0; t < memory_properties.memoryTypeCount; t++)
+			{
+				if ((requirements.memoryTypeBits & BIT(t)) &&
+					(memory_properties.memoryTypes[t].propertyFlags & VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT))
+				{
+					type_idx = t;
+					break;
+				}
+			}
+			if (type_idx == std::numeric_limits<u32>::max())
+			{
+				CRASH("No suitable memory type for offscreen images");
+			}
+
+			VkMemoryAllocateInfo alloc_info = {};
+			alloc_info.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+			alloc_info.allocationSize = requirements.size;
+			alloc_info.memoryTypeIndex = type_idx;
+
+			VK_CRASH_CHECK(vkAllocateMemory(device, &alloc_info, nullptr, &image_memory[i]), 
+				"Failed to allocate offscreen image memory");
+			VK_CRASH_CHECK(vkBindImageMemory(device, images[i], image_memory[i], 0), "Failed to bind offscreen image memory");
+
+			VkImageViewCreateInfo view_create_info = {};
+			view_create_info.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+			view_create_info.image = images[i];
+			view_create_info.viewType = VK_IMAGE_VIEW_TYPE_2D;
+			view_create_info.format = surface_format.format;
+			view_create_info.components.r = VK_COMPONENT_SWIZZLE_IDENTITY;
+			view_create_info.components.g = VK_COMPONENT_SWIZZLE_IDENTITY;
+			view_create_info.components.b = VK_COMPONENT_SWIZZLE_IDENTITY;
+			view_create_info.components.a = VK_COMPONENT_SWIZZLE_IDENTITY;
+			view_create_info.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+			view_create_info.subresourceRange.baseMipLevel = 0;
+			view_create_info.subresourceRange.levelCount = 1;
+			view_create_info.subresourceRange.baseArrayLayer = 0;
+			view_create_info.subresourceRange.layerCount = 1;
+
+			VK_CRASH_CHECK(vkCreateImageView(device, &view_create_info, nullptr, &image_views[i]),
+				"Failed to create image view");
+		}
+	}
+
+	inline void swapchain::destroy_offscreen_images(VkDevice device)
+	{
+		for (u32 i = 0; i < n_images; i++)
+		{
+			vkDestroyImageView(device, image_views[i], nullptr);
+			vkDestroyImage(device, images[i], nullptr);
+			vkFreeMemory(device, image_memory[i], nullptr);
+		}
+		std::free(image_views);
+		std::free(images);
+		std::free(image_memory);
+		image_views = nullptr;
+		images = nullptr;
+		image_memory = nullptr;
+	}
+
+	void swapchain::init_offscreen(VkPhysicalDevice physical_device, VkDevice device)
+	{
+		surface_format = { VK_FORMAT_B8G8R8A8_UNORM, VK_COLOR_SPACE_SRGB_NONLINEAR_KHR };
+		present_mode = VK_PRESENT_MODE_IMMEDIATE_KHR; //never presented, frames are only bound by the frame fences
+		handle = VK_NULL_HANDLE;
+
+		//one image per frame in flight, the image index is always the current frame
+		n_images = max_frames_in_flight;
+		create_offscreen_images(physical_device, device);
+
+		LOG_INTERNAL_INFO("[RENDERER] Offscreen target: " << _extent.width << 'x' << _extent.height << " ; frames: " << n_images);
+	}
+
 	void swapchain::terminate(VkDevice device)
 	{
+		if (offscreen())
+		{
+			destroy_offscreen_images(device);
+			return;
+		}
+
 		while (!old_swapchains.empty()) //this shouldnt be needed, but just in case
 		{
 			old_swapchain& old = old_swapchains.front();
@@ -225,6 +345,15 @@ namespace ENGINE_NAMESPACE
 	void swapchain::recreate(VkPhysicalDevice physical_device, VkDevice device, VkSurfaceKHR surface,
 		u8 current_frame)
 	{
+		if (offscreen())
+		{
+			//headless resizes are rare, stalling is simpler than deferring the destruction of the old images
+			vkDeviceWaitIdle(device);
+			destroy_offscreen_images(device);
+			create_offscreen_images(physical_device, device);
+			return;
+		}
+
 		old_swapchain old = {};
 		old.handle = handle;
 		old.n_images = n_images;
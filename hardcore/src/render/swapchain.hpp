@@ -11,6 +11,8 @@ namespace ENGINE_NAMESPACE
 	public:
 		void init(VkPhysicalDevice physical_device, VkDevice device, VkSurfaceKHR surface,
 			u32 graphics_queue_idx, u32 present_queue_idx);
+		//headless variant, renders into device local images owned by the swapchain, which are never presented
+		void init_offscreen(VkPhysicalDevice physical_device, VkDevice device);
 		void terminate(VkDevice device);
 		void recreate(VkPhysicalDevice physical_device, VkDevice device, VkSurfaceKHR surface,
 			u8 current_frame);
@@ -19,6 +21,8 @@ namespace ENGINE_NAMESPACE
 		~swapchain();
 
 		inline const VkSwapchainKHR& vk_handle() const noexcept { return handle; }
+		inline bool offscreen() const noexcept { return image_memory != nullptr; }
+		inline const VkImage* image_handles() const noexcept { return images; }
 		inline u32 size() const noexcept { return n_images; }
 		inline VkFormat image_format() const noexcept { return surface_format.format; }
 		inline const VkImageView* views() const noexcept { return image_views; }
@@ -28,7 +32,7 @@ namespace ENGINE_NAMESPACE
 		inline const VkRect2D& scissor() const noexcept { return _scissor; }
 
 	private:
-		VkSwapchainKHR handle;
+		VkSwapchainKHR handle = VK_NULL_HANDLE;
 
 		VkSurfaceFormatKHR surface_format;
 		VkPresentModeKHR present_mode;
@@ -44,10 +48,11 @@ namespace ENGINE_NAMESPACE
 		VkImage* images = nullptr;
 		u32 n_images;
 		VkImageView* image_views = nullptr;
+		VkDeviceMemory* image_memory = nullptr; //only used by offscreen targets
 
 		struct old_swapchain
 		{
-			VkSwapchainKHR handle;
+			VkSwapchainKHR handle = VK_NULL_HANDLE;
 			u32 n_images;
 			VkImageView* image_views;
 			u8 deletion_frame;
@@ -56,5 +61,9 @@ namespace ENGINE_NAMESPACE
 		std::queue<old_swapchain> old_swapchains;
 
 		void update_dimensions(VkSurfaceCapabilitiesKHR& capabilities);
+		void update_viewport();
+
+		void create_offscreen_images(VkPhysicalDevice physical_device, VkDevice device);
+		void destroy_offscreen_images(VkDevice device);
 	};
 }
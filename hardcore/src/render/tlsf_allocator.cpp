@@ -0,0 +1,208 @@
+#include <pch.hpp>
+
+#include <render/tlsf_allocator.hpp>
+
+#include <bit>
+
+namespace ENGINE_NAMESPACE
+{
+	tlsf_allocator::tlsf_allocator(u64 size) : m_size(size)
+	{
+		for (std::array<block_idx_t, sl_count>& lists : heads) lists.fill(invalid_block);
+
+		if (!size) return;
+
+		const block_idx_t idx = new_block();
+		blocks[idx] = { 0, size, invalid_block, invalid_block, invalid_block, invalid_block, true };
+		insert_free(idx);
+	}
+
+	tlsf_allocator::block_idx_t tlsf_allocator::search(u64 size, u64 alignment, u64& out_size_needed) const noexcept
+	{
+		if (!size) size = 1;
+
+		//any block of at least size + alignment - 1 bytes can be aligned, whatever its offset
+		u64 request = alignment > 1 ? size + alignment - 1 : size;
+		if (request > m_size - m_used) return invalid_block;
+
+		//rounded up to the next class, every block from there on fits
+		if (request >= sl_count)
+			request += BIT(std::bit_width(request) - 1 - sl_bits) - 1;
+
+		u32 fl, sl;
+		mapping(request, fl, sl);
+		if (fl >= fl_count) return invalid_block;
+
+		const block_idx_t idx = find_suitable(fl, sl);
+		if (idx != invalid_block)
+			out_size_needed = size + (alignment ? (alignment - (blocks[idx].offset % alignment)) % alignment : 0);
+		return idx;
+	}
+
+	u64 tlsf_allocator::allocate(block_idx_t idx, u64 size)
+	{
+		if (!size) size = 1;
+		INTERNAL_ASSERT(idx < blocks.size() && blocks[idx].free, "Allocating a block that is not free");
+		INTERNAL_ASSERT(size <= blocks[idx].size, "Allocation size greater than block size");
+
+		remove_free(idx);
+
+		if (size < blocks[idx].size)
+		{
+			//may reallocate the blocks, so no references are held across it
+			const block_idx_t rest = new_block();
+			block& b = blocks[idx];
+			blocks[rest] = { b.offset + size, b.size - size, idx, b.next_physical, invalid_block, invalid_block, true };
+
+			if (b.next_physical != invalid_block) blocks[b.next_physical].prev_physical = rest;
+			b.next_physical = rest;
+			b.size = size;
+			insert_free(rest);
+		}
+
+		block& b = blocks[idx];
+		b.free = false;
+		m_used += b.size;
+		allocated[b.offset] = idx;
+		return b.offset;
+	}
+
+	bool tlsf_allocator::free(u64 offset)
+	{
+		auto it = allocated.find(offset);
+		if (it == allocated.end()) return false;
+
+		block_idx_t idx = it->second;
+		allocated.erase(it);
+		m_used -= blocks[idx].size;
+		blocks[idx].free = true;
+
+		const block_idx_t next = blocks[idx].next_physical;
+		if (next != invalid_block && blocks[next].free)
+		{
+			remove_free(next);
+			blocks[idx].size += blocks[next].size;
+			blocks[idx].next_physical = blocks[next].next_physical;
+			if (blocks[idx].next_physical != invalid_block) blocks[blocks[idx].next_physical].prev_physical = idx;
+			release_block(next);
+		}
+
+		const block_idx_t prev = blocks[idx].prev_physical;
+		if (prev != invalid_block && blocks[prev].free)
+		{
+			remove_free(prev);
+			blocks[prev].size += blocks[idx].size;
+			blocks[prev].next_physical = blocks[idx].next_physical;
+			if (blocks[prev].next_physical != invalid_block) blocks[blocks[prev].next_physical].prev_physical = prev;
+			release_block(idx);
+			idx = prev;
+		}
+
+		insert_free(idx);
+		return true;
+	}
+
+	tlsf_allocator::block_idx_t tlsf_allocator::find(u64 offset) const noexcept
+	{
+		auto it = allocated.find(offset);
+		return it != allocated.end() ? it->second : invalid_block;
+	}
+
+	u64 tlsf_allocator::largest_free() const noexcept
+	{
+		if (!fl_bitmap) return 0;
+
+		const u32 fl = std::bit_width(fl_bitmap) - 1;
+		const u32 sl = std::bit_width(sl_bitmaps[fl]) - 1;
+
+		u64 largest = 0;
+		for (block_idx_t idx = heads[fl][sl]; idx != invalid_block; idx = blocks[idx].next_free)
+			largest = std::max(largest, blocks[idx].size);
+		return largest;
+	}
+
+	void tlsf_allocator::mapping(u64 size, u32& out_fl, u32& out_sl) noexcept
+	{
+		if (size < sl_count)
+		{
+			out_fl = 0;
+			out_sl = static_cast<u32>(size);
+		}
+		else
+		{
+			const u32 log2 = std::bit_width(size) - 1;
+			out_fl = log2 - sl_bits + 1;
+			out_sl = static_cast<u32>(size >> (log2 - sl_bits)) - sl_count;
+		}
+	}
+
+	tlsf_allocator::block_idx_t tlsf_allocator::find_suitable(u32 fl, u32 sl) const noexcept
+	{
+		u32 sl_map = sl_bitmaps[fl] & (~0U << sl);
+		if (!sl_map)
+		{
+			//fl + 1 is at most fl_count, which is below 64
+			const u64 fl_map = fl_bitmap & (~0ULL << (fl + 1));
+			if (!fl_map) return invalid_block;
+
+			fl = std::countr_zero(fl_map);
+			sl_map = sl_bitmaps[fl];
+		}
+
+		return heads[fl][std::countr_zero(sl_map)];
+	}
+
+	void tlsf_allocator::insert_free(block_idx_t idx) noexcept
+	{
+		u32 fl, sl;
+		mapping(blocks[idx].size, fl, sl);
+
+		block& b = blocks[idx];
+		b.prev_free = invalid_block;
+		b.next_free = heads[fl][sl];
+		if (b.next_free != invalid_block) blocks[b.next_free].prev_free = idx;
+		heads[fl][sl] = idx;
+
+		fl_bitmap |= BIT(static_cast<u64>(fl));
+		sl_bitmaps[fl] |= BIT(sl);
+		n_free_blocks++;
+	}
+
+	void tlsf_allocator::remove_free(block_idx_t idx) noexcept
+	{
+		u32 fl, sl;
+		mapping(blocks[idx].size, fl, sl);
+
+		const block& b = blocks[idx];
+		if (b.prev_free != invalid_block) blocks[b.prev_free].next_free = b.next_free;
+		else heads[fl][sl] = b.next_free;
+		if (b.next_free != invalid_block) blocks[b.next_free].prev_free = b.prev_free;
+
+		if (heads[fl][sl] == invalid_block)
+		{
+			sl_bitmaps[fl] &= ~BIT(sl);
+			if (!sl_bitmaps[fl]) fl_bitmap &= ~BIT(static_cast<u64>(fl));
+		}
+		n_free_blocks--;
+	}
+
+	tlsf_allocator::block_idx_t tlsf_allocator::new_block()
+	{
+		if (unused_head != invalid_block)
+		{
+			const block_idx_t idx = unused_head;
+			unused_head = blocks[idx].next_free;
+			return idx;
+		}
+
+		blocks.push_back({});
+		return static_cast<block_idx_t>(blocks.size() - 1);
+	}
+
+	void tlsf_allocator::release_block(block_idx_t idx) noexcept
+	{
+		blocks[idx].free = false;
+		blocks[idx].next_free = unused_head;
+		unused_head = idx;
+	}
+}
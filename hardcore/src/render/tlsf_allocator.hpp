@@ -0,0 +1,114 @@
+#pragma once
+
+#include <core/core.hpp>
+
+#include <array>
+#include <limits>
+#include <unordered_map>
+#include <vector>
+
+namespace ENGINE_NAMESPACE
+{
+	/**
+	 * @brief Two level segregated fit allocator over a range of offsets, it only hands out offsets and never touches
+	 * the memory behind them. Free blocks are sorted in size classes (a power of 2, split in 32 linear steps) whose
+	 * lists are indexed by two bitmaps, so searching, allocating and freeing are O(1). Freed blocks are merged with
+	 * their free neighbours right away. Not thread safe.
+	*/
+	class tlsf_allocator
+	{
+	public:
+		typedef u32 block_idx_t;
+		static constexpr block_idx_t invalid_block = std::numeric_limits<block_idx_t>::max();
+
+		tlsf_allocator() = default;
+
+		/**
+		 * @brief Creates an allocator with a single free block, at index 0, covering the whole range.
+		 * @param size Size of the managed range.
+		*/
+		explicit tlsf_allocator(u64 size);
+
+		/**
+		 * @brief Finds a free block that can hold size bytes at the given alignment. Only size classes where every
+		 * block fits are looked at, so a fitting block in the class just below the request can be passed over.
+		 * @param size Size of the allocation.
+		 * @param alignment Alignment of the allocation, 0 or a power of 2.
+		 * @param out_size_needed Size plus the padding needed to align the start of the block.
+		 * @return Index of the block, invalid_block if no block fits.
+		*/
+		block_idx_t search(u64 size, u64 alignment, u64& out_size_needed) const noexcept;
+
+		/**
+		 * @brief Allocates the start of a free block found by search, the rest of the block stays free.
+		 * @param idx Index of the block.
+		 * @param size Size to allocate, at most the size of the block.
+		 * @return Offset of the allocation, the block keeps its index while allocated.
+		*/
+		u64 allocate(block_idx_t idx, u64 size);
+
+		/**
+		 * @brief Frees the allocation starting at offset, and merges it with the free blocks around it.
+		 * @return False if no allocation starts at offset.
+		*/
+		bool free(u64 offset);
+
+		/**
+		 * @brief Looks up an allocation from its offset.
+		 * @return Index of the allocated block, invalid_block if no allocation starts at offset.
+		*/
+		block_idx_t find(u64 offset) const noexcept;
+
+		/**
+		 * @brief Size of the largest free block, walks the list of the largest size class.
+		*/
+		u64 largest_free() const noexcept;
+
+		inline u64 offset(block_idx_t idx) const noexcept { return blocks[idx].offset; }
+		inline u64 size() const noexcept { return m_size; }
+		inline u64 used() const noexcept { return m_used; }
+		inline u32 free_blocks() const noexcept { return n_free_blocks; }
+		inline u32 allocations() const noexcept { return static_cast<u32>(allocated.size()); }
+
+	private:
+		static constexpr u32 sl_bits = 5;
+		static constexpr u32 sl_count = BIT(sl_bits);
+		//sizes below sl_count have one class each in the first level, the others one level per power of 2
+		static constexpr u32 fl_count = 64 - sl_bits + 1;
+
+		struct block
+		{
+			u64 offset;
+			u64 size;
+			block_idx_t prev_physical;
+			block_idx_t next_physical;
+			block_idx_t prev_free;
+			block_idx_t next_free; //also links unused blocks
+			bool free;
+		};
+
+		static void mapping(u64 size, u32& out_fl, u32& out_sl) noexcept;
+
+		block_idx_t find_suitable(u32 fl, u32 sl) const noexcept;
+
+		void insert_free(block_idx_t idx) noexcept;
+		void remove_free(block_idx_t idx) noexcept;
+
+		block_idx_t new_block();
+		void release_block(block_idx_t idx) noexcept;
+
+		u64 m_size = 0;
+		u64 m_used = 0;
+		u32 n_free_blocks = 0;
+
+		std::vector<block> blocks;
+		block_idx_t unused_head = invalid_block;
+
+		u64 fl_bitmap = 0;
+		std::array<u32, fl_count> sl_bitmaps = {};
+		std::array<std::array<block_idx_t, sl_count>, fl_count> heads;
+
+		//offset => allocated block
+		std::unordered_map<u64, block_idx_t> allocated;
+	};
+}
@@ -0,0 +1,95 @@
+#include <pch.hpp>
+
+#include <render/transient_ring.hpp>
+
+namespace ENGINE_NAMESPACE
+{
+	transient_ring::transient_ring(VkDevice device, device_heap_manager& heap_manager, VkDeviceSize size,
+		VkBufferUsageFlags usage, device_heap_manager::heap heap) : m_size(size)
+	{
+		heap_manager.alloc_buffer(device, m_allocation, m_buffer, size, usage, heap);
+		m_host_ptr = m_allocation.host_ptr;
+	}
+
+	transient_ring::~transient_ring()
+	{
+		INTERNAL_ASSERT(m_allocation.memory == VK_NULL_HANDLE, "Transient ring not freed");
+	}
+
+	void transient_ring::free(VkDevice device, device_heap_manager& heap_manager)
+	{
+		if (m_allocation.memory != VK_NULL_HANDLE)
+		{
+			m_host_ptr = nullptr;
+			vkDestroyBuffer(device, m_buffer, nullptr);
+			m_buffer = VK_NULL_HANDLE;
+			heap_manager.free(device, m_allocation);
+		}
+	}
+
+	VkDeviceSize transient_ring::allocate(VkDeviceSize size, VkDeviceSize alignment) noexcept
+	{
+		if (size > m_size) return invalid_offset;
+
+		//the size is a multiple of the alignment, so an aligned position is also an aligned offset
+		u64 position = alignment ? (m_head + alignment - 1) & ~(alignment - 1) : m_head;
+		VkDeviceSize offset = position % m_size;
+		if (offset + size > m_size)
+		{
+			position += m_size - offset;
+			offset = 0;
+		}
+
+		if (position + size - m_tail > m_size) return invalid_offset;
+
+		m_head = position + size;
+		return offset;
+	}
+
+	void transient_ring::end_frame(u8 current_frame, u64 hold) noexcept
+	{
+		//frames complete in order and holds only move forward, so the tail never moves back
+		m_tail = std::max(m_tail, m_frame_ends[current_frame]);
+
+		m_flush_begin = m_frame_begin;
+		m_flush_end = m_head;
+		m_frame_ends[current_frame] = std::min(m_head, hold);
+		m_frame_begin = m_head;
+	}
+
+	void transient_ring::push_flush_ranges(std::vector<VkMappedMemoryRange>& ranges, VkDeviceSize atom_size) const
+	{
+		if (m_flush_begin == m_flush_end) return;
+
+		//ranges are relative to the memory block, the allocation's offset is a multiple of the atom size
+		const VkDeviceSize first = m_flush_begin % m_size;
+		const VkDeviceSize begin = first / atom_size * atom_size;
+		const VkDeviceSize end = first + (m_flush_end - m_flush_begin);
+
+		const auto push = [&](VkDeviceSize from, VkDeviceSize to)
+			{
+				ranges.push_back({ .sType = VK_STRUCTURE_TYPE_MAPPED_MEMORY_RANGE, .pNext = nullptr,
+					.memory = m_allocation.memory, .offset = m_allocation.offset + from,
+					.size = std::min((to + atom_size - 1) / atom_size * atom_size, m_size) - from });
+			};
+
+		if (end <= m_size)
+		{
+			push(begin, end);
+		}
+		else
+		{
+			push(begin, m_size);
+			push(0, end - m_size);
+		}
+	}
+
+	VkMappedMemoryRange transient_ring::mapped_range(VkDeviceSize offset, VkDeviceSize size, 
+		VkDeviceSize atom_size) const noexcept
+	{
+		const VkDeviceSize begin = offset / atom_size * atom_size;
+		const VkDeviceSize end = std::min((offset + size + atom_size - 1) / atom_size * atom_size, m_size);
+		return { .sType = VK_STRUCTURE_TYPE_MAPPED_MEMORY_RANGE, .pNext = nullptr, .memory = m_allocation.memory,
+			.offset = m_allocation.offset + begin, .size = end - begin };
+	}
+}
@@ -0,0 +1,113 @@
+#pragma once
+
+#include "render_core.hpp"
+#include "device_heap_manager.hpp"
+
+namespace ENGINE_NAMESPACE
+{
+	/**
+	 * @brief Ring of persistently mapped memory for data that only lives for one frame, such as transient buffers or
+	 * staged uploads. Allocations are bumped from the head, and each frame remembers where its allocations end, so that
+	 * the tail can catch up once the frame's fences have been waited on. The client can keep allocating before the
+	 * frame's fences are waited on, as the space still read by frames in flight is never handed out.
+	*/
+	class transient_ring
+	{
+	public:
+		static constexpr VkDeviceSize invalid_offset = std::numeric_limits<VkDeviceSize>::max();
+		static constexpr u64 no_hold = std::numeric_limits<u64>::max();
+
+		transient_ring() = default;
+
+		/**
+		 * @brief Allocates the ring, in memory kept mapped by the heap manager.
+		 * @param size Size of the ring, must be a multiple of every alignment it is allocated with and of the non
+		 * coherent atom size.
+		*/
+		transient_ring(VkDevice device, device_heap_manager& heap_manager, VkDeviceSize size, VkBufferUsageFlags usage,
+			device_heap_manager::heap heap);
+		~transient_ring();
+
+		transient_ring(const transient_ring&) = delete;
+		transient_ring& operator=(const transient_ring&) = delete;
+
+		transient_ring(transient_ring&& other) noexcept :
+			m_allocation(std::exchange(other.m_allocation, {})),
+			m_buffer(std::exchange(other.m_buffer, VK_NULL_HANDLE)),
+			m_host_ptr(std::exchange(other.m_host_ptr, nullptr)),
+			m_size(std::exchange(other.m_size, 0)),
+			m_head(std::exchange(other.m_head, 0)), m_tail(std::exchange(other.m_tail, 0)),
+			m_frame_begin(std::exchange(other.m_frame_begin, 0)), m_frame_ends(std::exchange(other.m_frame_ends, {})),
+			m_flush_begin(std::exchange(other.m_flush_begin, 0)), m_flush_end(std::exchange(other.m_flush_end, 0))
+		{}
+
+		inline transient_ring& operator=(transient_ring&& other) noexcept
+		{
+			INTERNAL_ASSERT(m_allocation.memory == VK_NULL_HANDLE, "Transient ring not freed");
+
+			m_allocation = std::exchange(other.m_allocation, {});
+			m_buffer = std::exchange(other.m_buffer, VK_NULL_HANDLE);
+			m_host_ptr = std::exchange(other.m_host_ptr, nullptr);
+			m_size = std::exchange(other.m_size, 0);
+			m_head = std::exchange(other.m_head, 0);
+			m_tail = std::exchange(other.m_tail, 0);
+			m_frame_begin = std::exchange(other.m_frame_begin, 0);
+			m_frame_ends = std::exchange(other.m_frame_ends, {});
+			m_flush_begin = std::exchange(other.m_flush_begin, 0);
+			m_flush_end = std::exchange(other.m_flush_end, 0);
+			return *this;
+		}
+
+		void free(VkDevice device, device_heap_manager& heap_manager);
+
+		/**
+		 * @brief Bumps the head past size bytes at the given alignment, allocations never wrap around the end of the
+		 * ring.
+		 * @param alignment Power of 2, or 0.
+		 * @return Offset of the allocation in the buffer, invalid_offset if the ring is full.
+		*/
+		VkDeviceSize allocate(VkDeviceSize size, VkDeviceSize alignment) noexcept;
+
+		/**
+		 * @brief Releases the allocations of the frame that last used the current frame's index, then hands the
+		 * allocations made since the last call over to the current frame. Must be called right after waiting on the
+		 * current frame's fences, once per frame.
+		 * @param hold Position of the oldest allocation still in use past the current frame, the tail will not move
+		 * beyond it when the frame is released.
+		*/
+		void end_frame(u8 current_frame, u64 hold = no_hold) noexcept;
+
+		/**
+		 * @brief Adds the ranges written by the frame ended last.
+		 * @param atom_size Non coherent atom size, ranges are widened to multiples of it.
+		*/
+		void push_flush_ranges(std::vector<VkMappedMemoryRange>& ranges, VkDeviceSize atom_size) const;
+
+		/**
+		 * @brief Range of the memory block covering part of the buffer, widened to multiples of the atom size.
+		*/
+		VkMappedMemoryRange mapped_range(VkDeviceSize offset, VkDeviceSize size, VkDeviceSize atom_size) const noexcept;
+
+		inline VkBuffer buffer() const noexcept { return m_buffer; }
+		inline void* host_ptr() const noexcept { return m_host_ptr; }
+		inline VkDeviceSize size() const noexcept { return m_size; }
+		inline VkDeviceSize used() const noexcept { return m_head - m_tail; }
+		inline u64 head() const noexcept { return m_head; }
+
+	private:
+		device_allocation m_allocation;
+		VkBuffer m_buffer = VK_NULL_HANDLE;
+		void* m_host_ptr = nullptr;
+		VkDeviceSize m_size = 0;
+
+		//positions only ever grow, the offset in the buffer is the position modulo the size
+		u64 m_head = 0;
+		u64 m_tail = 0;
+
+		u64 m_frame_begin = 0;
+		std::array<u64, max_frames_in_flight> m_frame_ends = {};
+
+		u64 m_flush_begin = 0;
+		u64 m_flush_end = 0;
+	};
+}
@@ -0,0 +1,238 @@
+#include <hardcore/render/mesh_format.hpp>
+
+#include <array>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <limits>
+#include <map>
+#include <sstream>
+#include <string>
+#include <tuple>
+#include <vector>
+
+using namespace hc;
+
+struct obj_data
+{
+	std::vector<std::array<float, 3>> positions;
+	std::vector<std::array<float, 2>> uvs;
+	std::vector<std::array<float, 3>> normals;
+
+	//position, uv and normal indexes of every triangle corner, 0 based, -1 when absent
+	std::vector<std::array<i64, 3>> corners;
+};
+
+static void print_usage()
+{
+	std::cerr << "usage: hcmesh <input.obj> <output.hcmesh>\n"
+		"Converts a Wavefront OBJ mesh into a binary mesh, polygons are triangulated and identical vertices merged.\n"
+		"Vertices hold a vec3 position, then a vec2 uv and a vec3 normal if every face provides them.\n";
+}
+
+//OBJ indexes are 1 based, negative indexes count back from the last element read
+static bool resolve_index(const std::string& token, std::size_t count, i64& out_index)
+{
+	if (token.empty())
+	{
+		out_index = -1;
+		return true;
+	}
+
+	char* end;
+	const long long index = std::strtoll(token.c_str(), &end, 10);
+	if (*end || !index) return false;
+
+	out_index = index > 0 ? index - 1 : static_cast<i64>(count) + index;
+	return out_index >= 0 && out_index < static_cast<i64>(count);
+}
+
+static bool parse_obj(std::istream& input, obj_data& obj)
+{
+	std::string line;
+	for (std::size_t line_number = 1; std::getline(input, line); line_number++)
+	{
+		std::istringstream stream(line);
+		std::string keyword;
+		stream >> keyword;
+
+		if (keyword == "v")
+		{
+			std::array<float, 3>& p = obj.positions.emplace_back();
+			stream >> p[0] >> p[1] >> p[2];
+		}
+		else if (keyword == "vt")
+		{
+			std::array<float, 2>& uv = obj.uvs.emplace_back();
+			stream >> uv[0] >> uv[1];
+		}
+		else if (keyword == "vn")
+		{
+			std::array<float, 3>& n = obj.normals.emplace_back();
+			stream >> n[0] >> n[1] >> n[2];
+		}
+		else if (keyword == "f")
+		{
+			std::vector<std::array<i64, 3>> polygon;
+			for (std::string vertex; stream >> vertex;)
+			{
+				//v, v/vt, v//vn or v/vt/vn
+				std::array<std::string, 3> tokens;
+				std::size_t slot = 0;
+				for (const char c : vertex)
+				{
+					if (c == '/') slot++;
+					else if (slot < tokens.size()) tokens[slot] += c;
+				}
+
+				std::array<i64, 3>& corner = polygon.emplace_back();
+				if (slot >= tokens.size() || tokens[0].empty() ||
+					!resolve_index(tokens[0], obj.positions.size(), corner[0]) ||
+					!resolve_index(tokens[1], obj.uvs.size(), corner[1]) ||
+					!resolve_index(tokens[2], obj.normals.size(), corner[2]))
+				{
+					std::cerr << "hcmesh: invalid face vertex '" << vertex << "' on line " << line_number << '\n';
+					return false;
+				}
+			}
+
+			if (polygon.size() < 3)
+			{
+				std::cerr << "hcmesh: face with less than 3 vertices on line " << line_number << '\n';
+				return false;
+			}
+
+			//triangle fan, faces are expected to be convex
+			for (std::size_t i = 1; i + 1 < polygon.size(); i++)
+			{
+				obj.corners.push_back(polygon[0]);
+				obj.corners.push_back(polygon[i]);
+				obj.corners.push_back(polygon[i + 1]);
+			}
+		}
+
+		if (stream.fail() && !stream.eof())
+		{
+			std::cerr << "hcmesh: invalid values on line " << line_number << '\n';
+			return false;
+		}
+	}
+	return true;
+}
+
+template<typename Type>
+static inline void append(std::vector<u8>& buffer, const Type& value)
+{
+	const std::size_t offset = buffer.size();
+	buffer.resize(offset + sizeof(Type));
+	std::memcpy(buffer.data() + offset, &value, sizeof(Type));
+}
+
+int main(int argc, char** argv)
+{
+	if (argc != 3)
+	{
+		print_usage();
+		return 1;
+	}
+
+	obj_data obj;
+	{
+		std::ifstream file(argv[1]);
+		if (!file.is_open())
+		{
+			std::cerr << "hcmesh: failed to open " << argv[1] << '\n';
+			return 1;
+		}
+		if (!parse_obj(file, obj)) return 1;
+	}
+
+	if (obj.corners.empty())
+	{
+		std::cerr << "hcmesh: " << argv[1] << " has no faces\n";
+		return 1;
+	}
+
+	bool has_uvs = true, has_normals = true;
+	for (const std::array<i64, 3>& corner : obj.corners)
+	{
+		has_uvs &= corner[1] >= 0;
+		has_normals &= corner[2] >= 0;
+	}
+
+	std::vector<mesh_format::attribute> attributes;
+	attributes.push_back({ static_cast<u8>(mesh_format::attribute_type::VEC3), static_cast<u8>(mesh_format::component_type::FLOAT32) });
+	if (has_uvs)
+		attributes.push_back({ static_cast<u8>(mesh_format::attribute_type::VEC2), static_cast<u8>(mesh_format::component_type::FLOAT32) });
+	if (has_normals)
+		attributes.push_back({ static_cast<u8>(mesh_format::attribute_type::VEC3), static_cast<u8>(mesh_format::component_type::FLOAT32) });
+
+	//identical position, uv and normal combinations share a vertex
+	std::map<std::tuple<i64, i64, i64>, u32> unique_vertices;
+	std::vector<u8> vertices;
+	std::vector<u32> indexes;
+	indexes.reserve(obj.corners.size());
+	for (const std::array<i64, 3>& corner : obj.corners)
+	{
+		const std::tuple<i64, i64, i64> key(corner[0], has_uvs ? corner[1] : -1, has_normals ? corner[2] : -1);
+		auto [it, inserted] = unique_vertices.try_emplace(key, static_cast<u32>(unique_vertices.size()));
+		if (inserted)
+		{
+			append(vertices, obj.positions[corner[0]]);
+			if (has_uvs) append(vertices, obj.uvs[corner[1]]);
+			if (has_normals) append(vertices, obj.normals[corner[2]]);
+		}
+		indexes.push_back(it->second);
+	}
+
+	mesh_format::header header = {};
+	header.magic = mesh_format::magic;
+	header.version = mesh_format::version;
+	header.n_attributes = static_cast<u8>(attributes.size());
+	header.n_vertices = static_cast<u32>(unique_vertices.size());
+	header.n_indexes = static_cast<u32>(indexes.size());
+	header.vertex_stride = static_cast<u32>(vertices.size() / unique_vertices.size());
+
+	//16 bit indexes whenever they are enough, halves the index data
+	std::vector<u8> index_data;
+	if (unique_vertices.size() <= std::numeric_limits<u16>::max() + 1ULL)
+	{
+		header.index_format = static_cast<u8>(mesh_format::index_type::UINT16);
+		for (const u32 index : indexes) append(index_data, static_cast<u16>(index));
+	}
+	else
+	{
+		header.index_format = static_cast<u8>(mesh_format::index_type::UINT32);
+		for (const u32 index : indexes) append(index_data, index);
+	}
+
+	header.vertex_offset = mesh_format::align_up(sizeof(header) + attributes.size() * sizeof(mesh_format::attribute),
+		mesh_format::data_alignment);
+	header.index_offset = mesh_format::align_up(header.vertex_offset + vertices.size(), mesh_format::data_alignment);
+	const u64 file_size = header.index_offset + index_data.size();
+
+	std::vector<u8> output_data(static_cast<std::size_t>(file_size), 0);
+	std::memcpy(output_data.data(), &header, sizeof(header));
+	std::memcpy(output_data.data() + sizeof(header), attributes.data(), attributes.size() * sizeof(mesh_format::attribute));
+	std::memcpy(output_data.data() + header.vertex_offset, vertices.data(), vertices.size());
+	std::memcpy(output_data.data() + header.index_offset, index_data.data(), index_data.size());
+
+	std::ofstream output(argv[2], std::ios::out | std::ios::binary | std::ios::trunc);
+	if (!output.is_open())
+	{
+		std::cerr << "hcmesh: failed to open " << argv[2] << " for writing\n";
+		return 1;
+	}
+
+	output.write(reinterpret_cast<const char*>(output_data.data()), output_data.size());
+	if (!output)
+	{
+		std::cerr << "hcmesh: failed to write " << argv[2] << '\n';
+		return 1;
+	}
+
+	std::cout << "hcmesh: " << argv[1] << " " << header.n_vertices << " vertices, " << header.n_indexes << " indexes -> "
+		<< file_size << " bytes\n";
+	return 0;
+}
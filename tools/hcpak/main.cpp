@@ -0,0 +1,157 @@
+#include <hardcore/io/pak_format.hpp>
+
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+using namespace hc;
+
+struct pak_input
+{
+	std::string name;
+	std::filesystem::path path;
+	u64 hash;
+	u64 size;
+};
+
+static void print_usage()
+{
+	std::cerr << "usage: hcpak <output.hcpak> <base directory> <files... | @list file>\n"
+		"Entries are named after their path relative to the base directory.\n";
+}
+
+static bool collect_inputs(const std::filesystem::path& base_dir, const char* arg, std::vector<pak_input>& inputs)
+{
+	std::vector<std::filesystem::path> paths;
+	if (arg[0] == '@')
+	{
+		std::ifstream list(arg + 1);
+		if (!list.is_open())
+		{
+			std::cerr << "hcpak: failed to open list file " << arg + 1 << '\n';
+			return false;
+		}
+		for (std::string line; std::getline(list, line);)
+		{
+			if (!line.empty() && line.back() == '\r') line.pop_back();
+			if (!line.empty()) paths.emplace_back(line);
+		}
+	}
+	else
+	{
+		paths.emplace_back(arg);
+	}
+
+	for (const std::filesystem::path& path : paths)
+	{
+		const std::filesystem::path full_path = path.is_absolute() ? path : base_dir / path;
+		std::error_code error;
+		const u64 size = std::filesystem::file_size(full_path, error);
+		if (error)
+		{
+			std::cerr << "hcpak: cannot read " << full_path.string() << ": " << error.message() << '\n';
+			return false;
+		}
+
+		pak_input& input = inputs.emplace_back();
+		input.path = full_path;
+		input.name = std::filesystem::relative(full_path, base_dir).generic_string();
+		input.hash = pak_format::hash(input.name);
+		input.size = size;
+	}
+	return true;
+}
+
+int main(int argc, char** argv)
+{
+	if (argc < 4)
+	{
+		print_usage();
+		return 1;
+	}
+
+	const std::filesystem::path base_dir = std::filesystem::absolute(argv[2]);
+	std::vector<pak_input> inputs;
+	for (int i = 3; i < argc; i++)
+	{
+		if (!collect_inputs(base_dir, argv[i], inputs)) return 1;
+	}
+
+	std::sort(inputs.begin(), inputs.end(), [](const pak_input& a, const pak_input& b)
+		{ return a.hash != b.hash ? a.hash < b.hash : a.name < b.name; });
+	for (std::size_t i = 1; i < inputs.size(); i++)
+	{
+		if (inputs[i].name == inputs[i - 1].name)
+		{
+			std::cerr << "hcpak: duplicate entry " << inputs[i].name << '\n';
+			return 1;
+		}
+	}
+
+	pak_format::header header = {};
+	header.magic = pak_format::magic;
+	header.version = pak_format::version;
+	header.n_entries = static_cast<u32>(inputs.size());
+	header.alignment = pak_format::default_alignment;
+
+	std::vector<pak_format::entry> entries(inputs.size());
+	std::string names;
+	for (std::size_t i = 0; i < inputs.size(); i++)
+	{
+		entries[i].hash = inputs[i].hash;
+		entries[i].size = inputs[i].size;
+		entries[i].name_offset = static_cast<u32>(names.size());
+		entries[i].name_size = static_cast<u32>(inputs[i].name.size());
+		names += inputs[i].name;
+	}
+	header.names_size = names.size();
+
+	u64 offset = sizeof(header) + entries.size() * sizeof(pak_format::entry) + names.size();
+	for (pak_format::entry& entry : entries)
+	{
+		offset = pak_format::align_up(offset, header.alignment);
+		entry.offset = offset;
+		offset += entry.size;
+	}
+
+	std::ofstream output(argv[1], std::ios::out | std::ios::binary | std::ios::trunc);
+	if (!output.is_open())
+	{
+		std::cerr << "hcpak: failed to open " << argv[1] << " for writing\n";
+		return 1;
+	}
+
+	output.write(reinterpret_cast<const char*>(&header), sizeof(header));
+	output.write(reinterpret_cast<const char*>(entries.data()), entries.size() * sizeof(pak_format::entry));
+	output.write(names.data(), names.size());
+
+	std::vector<char> buffer;
+	for (std::size_t i = 0; i < inputs.size(); i++)
+	{
+		const u64 padding = entries[i].offset - static_cast<u64>(output.tellp());
+		buffer.assign(padding, 0);
+		output.write(buffer.data(), buffer.size());
+
+		std::ifstream input(inputs[i].path, std::ios::in | std::ios::binary);
+		buffer.resize(entries[i].size);
+		if (!input.read(buffer.data(), buffer.size()))
+		{
+			std::cerr << "hcpak: failed to read " << inputs[i].path.string() << '\n';
+			return 1;
+		}
+		output.write(buffer.data(), buffer.size());
+	}
+
+	if (!output)
+	{
+		std::cerr << "hcpak: failed to write " << argv[1] << '\n';
+		return 1;
+	}
+
+	std::cout << "hcpak: packed " << inputs.size() << " entries into " << argv[1] << '\n';
+	return 0;
+}
@@ -0,0 +1,182 @@
+#include <hardcore/io/compressed_format.hpp>
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <limits>
+#include <string>
+#include <vector>
+
+using namespace hc;
+
+//LZ4 block format constants, see the LZ4 block format description
+const std::size_t min_match = 4;
+const std::size_t last_literals = 5; //the last 5 bytes of a block are always literals
+const std::size_t match_find_limit = 12; //the last match must start at least 12 bytes before the end of a block
+const std::size_t max_offset = 65535;
+const u32 hash_bits = 16;
+
+static inline u32 read32(const u8* p)
+{
+	u32 value;
+	std::memcpy(&value, p, sizeof(value));
+	return value;
+}
+
+static inline u32 hash_sequence(u32 sequence)
+{
+	return (sequence * 2654435761U) >> (32 - hash_bits);
+}
+
+static void write_length(std::vector<u8>& out, std::size_t length)
+{
+	for (; length >= 255; length -= 255) out.push_back(255);
+	out.push_back(static_cast<u8>(length));
+}
+
+static void write_sequence(std::vector<u8>& out, const u8* literals, std::size_t n_literals, std::size_t offset,
+	std::size_t match_length)
+{
+	const std::size_t match_code = match_length ? match_length - min_match : 0;
+	out.push_back(static_cast<u8>((std::min<std::size_t>(n_literals, 15) << 4) | std::min<std::size_t>(match_code, 15)));
+	if (n_literals >= 15) write_length(out, n_literals - 15);
+	out.insert(out.end(), literals, literals + n_literals);
+
+	//the last sequence has no match
+	if (!match_length) return;
+	out.push_back(static_cast<u8>(offset));
+	out.push_back(static_cast<u8>(offset >> 8));
+	if (match_code >= 15) write_length(out, match_code - 15);
+}
+
+//greedy single pass LZ4 block compressor, trades ratio for simplicity, decompression speed is unaffected
+static std::vector<u8> lz4_compress_block(const u8* src, std::size_t size)
+{
+	std::vector<u8> out;
+	out.reserve(size + size / 255 + 16);
+
+	std::vector<u32> table(std::size_t(1) << hash_bits, std::numeric_limits<u32>::max());
+	std::size_t anchor = 0;
+	std::size_t pos = 0;
+
+	while (size > match_find_limit && pos + match_find_limit < size)
+	{
+		const u32 sequence = read32(src + pos);
+		u32& entry = table[hash_sequence(sequence)];
+		const std::size_t candidate = entry;
+		entry = static_cast<u32>(pos);
+
+		if (candidate == std::numeric_limits<u32>::max() || pos - candidate > max_offset || read32(src + candidate) != sequence)
+		{
+			pos++;
+			continue;
+		}
+
+		std::size_t match_length = min_match;
+		while (pos + match_length < size - last_literals && src[candidate + match_length] == src[pos + match_length])
+			match_length++;
+
+		write_sequence(out, src + anchor, pos - anchor, pos - candidate, match_length);
+		pos += match_length;
+		anchor = pos;
+	}
+
+	write_sequence(out, src + anchor, size - anchor, 0, 0);
+	return out;
+}
+
+static void print_usage()
+{
+	std::cerr << "usage: hcz <input> <output> [block size in KiB]\n"
+		"Compresses a file into a .hcz container of independently compressed LZ4 blocks.\n";
+}
+
+int main(int argc, char** argv)
+{
+	if (argc < 3 || argc > 4)
+	{
+		print_usage();
+		return 1;
+	}
+
+	u32 block_size = compressed_format::default_block_size;
+	if (argc == 4)
+	{
+		const unsigned long kib = std::strtoul(argv[3], nullptr, 10);
+		if (!kib || kib > KILOBYTES(64))
+		{
+			std::cerr << "hcz: invalid block size " << argv[3] << '\n';
+			return 1;
+		}
+		block_size = static_cast<u32>(KILOBYTES(kib));
+	}
+
+	//the whole input is read first, so the output may overwrite it
+	std::vector<u8> input;
+	{
+		std::ifstream file(argv[1], std::ios::in | std::ios::binary);
+		if (!file.is_open())
+		{
+			std::cerr << "hcz: failed to open " << argv[1] << '\n';
+			return 1;
+		}
+		input.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+	}
+
+	if (input.size() >= sizeof(compressed_format::header) && read32(input.data()) == compressed_format::magic)
+	{
+		std::cerr << "hcz: " << argv[1] << " is already compressed\n";
+		return 1;
+	}
+
+	compressed_format::header header = {};
+	header.magic = compressed_format::magic;
+	header.version = compressed_format::version;
+	header.codec = compressed_format::LZ4;
+	header.block_size = block_size;
+	header.n_blocks = static_cast<u32>((input.size() + block_size - 1) / block_size);
+	header.size = input.size();
+
+	std::vector<compressed_format::block> blocks(header.n_blocks);
+	std::vector<std::vector<u8>> data(header.n_blocks);
+	u64 offset = sizeof(header) + blocks.size() * sizeof(compressed_format::block);
+	for (u32 i = 0; i < header.n_blocks; i++)
+	{
+		const u8* src = input.data() + static_cast<std::size_t>(i) * block_size;
+		const std::size_t size = std::min<std::size_t>(block_size, input.size() - static_cast<std::size_t>(i) * block_size);
+
+		data[i] = lz4_compress_block(src, size);
+		if (data[i].size() >= size)
+		{
+			data[i].assign(src, src + size);
+			blocks[i].flags = compressed_format::STORED_BIT;
+		}
+		blocks[i].offset = offset;
+		blocks[i].compressed_size = static_cast<u32>(data[i].size());
+		offset += data[i].size();
+	}
+
+	std::ofstream output(argv[2], std::ios::out | std::ios::binary | std::ios::trunc);
+	if (!output.is_open())
+	{
+		std::cerr << "hcz: failed to open " << argv[2] << " for writing\n";
+		return 1;
+	}
+
+	output.write(reinterpret_cast<const char*>(&header), sizeof(header));
+	output.write(reinterpret_cast<const char*>(blocks.data()), blocks.size() * sizeof(compressed_format::block));
+	for (const std::vector<u8>& block : data)
+		output.write(reinterpret_cast<const char*>(block.data()), block.size());
+
+	if (!output)
+	{
+		std::cerr << "hcz: failed to write " << argv[2] << '\n';
+		return 1;
+	}
+
+	std::cout << "hcz: " << argv[1] << " " << input.size() << " -> " << offset << " bytes\n";
+	return 0;
+}